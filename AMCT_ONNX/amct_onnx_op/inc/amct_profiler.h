@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief amct_profiler head file
+ *
+ * @file amct_profiler.h
+ *
+ * @version 1.0
+ */
+
+#ifndef AMCT_PROFILER_H
+#define AMCT_PROFILER_H
+
+#include <cstdint>
+#include <string>
+
+#include "perf_counters.h"
+
+namespace AmctCommon {
+// output path prefix, "1" writes amct_profile_<pid>_<n>.json and amct_profile_<pid>_<n>.trace.json in the cwd
+constexpr const char* PROFILE_ENV = "AMCT_PROFILE";
+// trace events kept per thread, the oldest are overwritten; the JSON summary always covers every event
+constexpr const char* PROFILE_RING_SIZE_ENV = "AMCT_PROFILE_RING_SIZE";
+constexpr uint32_t DEFAULT_PROFILE_RING_SIZE = 65536;
+
+extern const bool g_profileEnabled;
+
+inline bool ProfilingEnabled()
+{
+    return g_profileEnabled;
+}
+
+uint64_t ProfileNowNs();
+// new blocks of the calling thread's scratch arena, taken into the enclosing scopes; other heap allocations such as
+// std::vector growth are not counted
+void ProfileCountScratchBlock(uint64_t bytes);
+
+/**
+ * @ingroup quantize lib
+ * @brief: times one phase of the op running on this thread, e.g. fp16 conversion or record I/O.
+ * Op and phase names must be string literals. Costs a single branch when profiling is disabled.
+ */
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* phase, uint64_t elements = 0, uint64_t bytes = 0)
+    {
+        if (ProfilingEnabled()) {
+            Begin(nullptr, phase, elements, bytes);
+        }
+    }
+    ~ProfileScope()
+    {
+        if (active_) {
+            End();
+        }
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    void AddWork(uint64_t elements, uint64_t bytes)
+    {
+        elements_ += elements;
+        bytes_ += bytes;
+    }
+
+protected:
+    ProfileScope() = default;
+    void Begin(const char* op, const char* phase, uint64_t elements, uint64_t bytes);
+    void End();
+
+    bool active_{false};
+    bool isOp_{false};
+    const char* op_{nullptr};
+    const char* prevOp_{nullptr};
+    const char* phase_{nullptr};
+    uint64_t startNs_{0};
+    uint64_t elements_{0};
+    uint64_t bytes_{0};
+    uint64_t scratchStart_{0};
+    uint64_t scratchBytesStart_{0};
+    bool perfValid_{false};
+    PerfCounterValues perfStart_;
+};
+
+/**
+ * @ingroup quantize lib
+ * @brief: times one Compute of an op, the phase scopes inside it are attributed to the op.
+ */
+class ProfileOpScope : public ProfileScope {
+public:
+    explicit ProfileOpScope(const char* op)
+    {
+        if (ProfilingEnabled()) {
+            Begin(op, "compute", 0, 0);
+        }
+    }
+};
+
+/**
+ * @ingroup quantize lib
+ * @brief: member of every kernel, the profile is written when the last kernel is destroyed (session end).
+ */
+class ProfileKernelRef {
+public:
+    ProfileKernelRef();
+    ~ProfileKernelRef();
+    ProfileKernelRef(const ProfileKernelRef&) = delete;
+    ProfileKernelRef& operator=(const ProfileKernelRef&) = delete;
+};
+
+/**
+ * @ingroup quantize lib
+ * @brief: write the summary and trace of the events since the previous dump.
+ * Safe while kernels are running and never blocks them: each thread's ring and stats are copied with a seqlock
+ * read against their owner, the dump retries while a scope is ending. min / max of a scope that ends during the
+ * dump may be left out of both dumps, counts and totals never are.
+ * @return prefix of the written files, empty if profiling is disabled or nothing was recorded
+ */
+std::string DumpProfile();
+} // namespace AmctCommon
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+int AmctDumpProfile();
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AMCT_PROFILER_H
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief amct_thread_pool head file
+ *
+ * @file amct_thread_pool.h
+ *
+ * @version 1.0
+ */
+
+#ifndef AMCT_THREAD_POOL_H
+#define AMCT_THREAD_POOL_H
+
+#include <cstdint>
+#include <functional>
+
+namespace AmctCommon {
+constexpr const char* NUM_THREADS_ENV = "AMCT_NUM_THREADS";
+constexpr const char* GRAIN_SIZE_ENV = "AMCT_GRAIN_SIZE";
+constexpr const char* SERIAL_THRESHOLD_ENV = "AMCT_SERIAL_THRESHOLD";
+constexpr const char* PIN_THREADS_ENV = "AMCT_PIN_THREADS";
+constexpr int64_t DEFAULT_GRAIN_SIZE = 16384;
+constexpr int64_t DEFAULT_SERIAL_THRESHOLD = 32768;
+
+/**
+ * @ingroup quantize lib
+ * @brief: parallel execution settings, read once from the environment.
+ * numThreads: AMCT_NUM_THREADS, threads working on one loop including the caller, default the number of cores.
+ * The AMCT pool runs next to the ORT intra-op pool, which the custom op API of the supported onnxruntime releases
+ * does not expose to kernels. With intra_op_num_threads > 1 keep AMCT_NUM_THREADS + intra_op_num_threads within
+ * the cores, e.g. AMCT_NUM_THREADS=1 when the session already uses every core.
+ * grainSize: AMCT_GRAIN_SIZE, elements of one chunk.
+ * serialThreshold: AMCT_SERIAL_THRESHOLD, loops up to this length run on the calling thread.
+ * pinThreads: AMCT_PIN_THREADS=1 pins every pool thread to one core.
+ */
+struct ParallelConfig {
+    int numThreads;
+    int64_t grainSize;
+    int64_t serialThreshold;
+    bool pinThreads;
+};
+
+const ParallelConfig& GetParallelConfig();
+
+using ParallelRange = std::function<void(int64_t begin, int64_t end)>;
+
+/**
+ * @ingroup quantize lib
+ * @brief: run fn over [0, length) split into chunks of the grain size.
+ * The chunks run on the AMCT pool shared by every session of the process. The caller always works on its own loop,
+ * so concurrent and nested loops make progress even if the pool is busy. fn must not throw.
+ */
+void ParallelFor(int64_t length, const ParallelRange& fn);
+void ParallelFor(int64_t length, int64_t grainSize, const ParallelRange& fn);
+
+/**
+ * @ingroup quantize lib
+ * @brief: run fn over [0, taskNum) one task per chunk, for loops over coarse items such as the images of a batch.
+ * Unlike ParallelFor the serial threshold does not apply, a single task runs on the calling thread.
+ */
+void ParallelForTasks(int64_t taskNum, const ParallelRange& fn);
+} // namespace AmctCommon
+
+#endif // AMCT_THREAD_POOL_H
@@ -20,6 +20,7 @@
 #define AMCT_UTILS_H
 #include <fstream>
 #include <string>
+#include <vector>
 #include "custom_op_library.h"
 #include "util.h"
 
@@ -56,6 +57,16 @@ inline void CheckStatus(const OrtApi &api, OrtStatus* status)
 
 std::string GetStringAttr(const OrtApi& api, const OrtKernelInfo* info, const std::string& attrName);
 
+// optional attributes: graphs generated by older amct versions do not carry them, fall back to default
+int64_t GetInt64AttrOrDefault(const OrtApi& api, const OrtKernelInfo* info, const std::string& attrName,
+    int64_t defaultValue);
+float GetFloatAttrOrDefault(const OrtApi& api, const OrtKernelInfo* info, const std::string& attrName,
+    float defaultValue);
+std::string GetStringAttrOrDefault(const OrtApi& api, const OrtKernelInfo* info, const std::string& attrName,
+    const std::string& defaultValue);
+std::vector<float> GetFloatsAttrOrDefault(const OrtApi& api, const OrtKernelInfo* info, const std::string& attrName,
+    const std::vector<float>& defaultValue);
+
 template <typename T>
 inline T* GetTensorMutableData(const OrtApi& api, OrtValue* value)
 {
@@ -20,10 +20,23 @@
 #define ASCEND_ANTIQUANT_KERNEL_H
 
 #include "custom_op_library.h"
+#include "amct_profiler.h"
+#include "fp8_quant.h"
+
+// what the int8 input of the op holds
+enum class AntiQuantSource {
+    INT8,
+    // two int4 values per byte, only for AscendAntiQuantInt4 or src_type "INT4"
+    INT4,
+    // fp8 bits, FP8_E4M3 unless src_type is "FP8_E5M2"
+    FP8
+};
 
 struct AntiQuantKernel {
 public:
-    AntiQuantKernel(const OrtApi& api, const OrtKernelInfo* info);
+    // source: what the op holds; AscendAntiQuant passes INT8 and src_type may pick another, the int4 and fp8 ops
+    // reject a src_type of another source
+    AntiQuantKernel(const OrtApi& api, const OrtKernelInfo* info, AntiQuantSource source = AntiQuantSource::INT8);
     ~AntiQuantKernel() {}
 #if ORT_API_VERSION >= 16
     OrtStatusPtr ComputeV2(OrtKernelContext* context);
@@ -35,6 +48,11 @@ private:
     float scaleData_{0};
     float offsetData_{0};
     int64_t quantBits_{0};
+    AntiQuantSource source_{AntiQuantSource::INT8};
+    // INT4 source: unpacked_dim is the unpacked last axis, twice the packed one if 0
+    int64_t unpackedDim_{0};
+    AmctCommon::Fp8Format fp8Format_{AmctCommon::Fp8Format::E4M3};
+    AmctCommon::ProfileKernelRef profileRef_;
 };
 
 #endif // ASCEND_ANTIQUANT_KERNEL_H
\ No newline at end of file
@@ -20,6 +20,13 @@
 #define ASCEND_DEQUANT_KERNEL_H
 
 #include "custom_op_library.h"
+#include "amct_profiler.h"
+
+// channel-wise params split the data shape into chwSize elements per sample and hwSize per channel
+void GetShapeInfo(bool channelWise,
+                  std::vector<int64_t> shapeInfo,
+                  int64_t& hwSize,
+                  int64_t& chwSize);
 
 struct AscendDequantKernel {
 public:
@@ -32,8 +39,8 @@ public:
 
 private:
     OrtApi api_;
-    DequantParam dequantParam_;
     std::string fakeQuantPrecisionMode_{""};
+    AmctCommon::ProfileKernelRef profileRef_;
 };
 
 #endif // ASCEND_DEQUANT_KERNEL_H
\ No newline at end of file
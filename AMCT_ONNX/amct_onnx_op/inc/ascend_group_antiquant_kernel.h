@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief AMCT custom ops
+ *
+ * @file ascend_group_antiquant_kernel.h
+ *
+ * @version 1.0
+ */
+#ifndef ASCEND_GROUP_ANTIQUANT_KERNEL_H
+#define ASCEND_GROUP_ANTIQUANT_KERNEL_H
+
+#include "custom_op_library.h"
+#include "amct_profiler.h"
+
+struct AscendGroupAntiQuantKernel {
+public:
+    AscendGroupAntiQuantKernel(const OrtApi& api, const OrtKernelInfo* info);
+    ~AscendGroupAntiQuantKernel() {}
+#if ORT_API_VERSION >= 16
+    OrtStatusPtr ComputeV2(OrtKernelContext* context);
+#endif
+    void Compute(OrtKernelContext* context);
+
+private:
+    OrtApi api_;
+    int64_t groupSize_{0};
+    int64_t axis_{-1};
+    AmctCommon::ProfileKernelRef profileRef_;
+};
+
+#endif // ASCEND_GROUP_ANTIQUANT_KERNEL_H
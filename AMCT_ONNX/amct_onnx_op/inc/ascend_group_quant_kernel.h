@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief AMCT custom ops
+ *
+ * @file ascend_group_quant_kernel.h
+ *
+ * @version 1.0
+ */
+#ifndef ASCEND_GROUP_QUANT_KERNEL_H
+#define ASCEND_GROUP_QUANT_KERNEL_H
+
+#include <map>
+#include "custom_op_library.h"
+#include "dequant_quant.h"
+#include "amct_profiler.h"
+
+// reads the scale (input 1) and offset (input 2) of a group-wise op on x (input 0), the groups run along axis
+bool GetGroupQuantParam(const OrtApi& api, OrtKernelContext* context, int64_t axis, int64_t groupSize,
+    GroupQuantParam& groupParam);
+
+struct AscendGroupQuantKernel {
+public:
+    AscendGroupQuantKernel(const OrtApi& api, const OrtKernelInfo* info);
+    ~AscendGroupQuantKernel() {}
+#if ORT_API_VERSION >= 16
+    OrtStatusPtr ComputeV2(OrtKernelContext* context);
+#endif
+    void Compute(OrtKernelContext* context);
+
+private:
+    OrtApi api_;
+    int64_t groupSize_{0};
+    int64_t axis_{-1};
+    std::string dstType_{""};
+    std::string fakeQuantPrecisionMode_{""};
+
+    const std::map<std::string, int64_t> dstType2QuantBits_ = {
+        {"INT4", 4},
+        {"INT8", 8}
+    };
+    AmctCommon::ProfileKernelRef profileRef_;
+};
+
+#endif // ASCEND_GROUP_QUANT_KERNEL_H
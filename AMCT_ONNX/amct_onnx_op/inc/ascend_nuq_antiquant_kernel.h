@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief AMCT custom ops
+ *
+ * @file ascend_nuq_antiquant_kernel.h
+ *
+ * @version 1.0
+ */
+#ifndef ASCEND_NUQ_ANTIQUANT_KERNEL_H
+#define ASCEND_NUQ_ANTIQUANT_KERNEL_H
+
+#include "custom_op_library.h"
+#include "amct_profiler.h"
+
+// nuq weights kept as uint8 codes, dequantized by table lookup of the centroids at inference
+struct AscendNuqAntiQuantKernel {
+public:
+    AscendNuqAntiQuantKernel(const OrtApi& api, const OrtKernelInfo* info);
+    ~AscendNuqAntiQuantKernel() {}
+#if ORT_API_VERSION >= 16
+    OrtStatusPtr ComputeV2(OrtKernelContext* context);
+#endif
+    void Compute(OrtKernelContext* context);
+
+private:
+    OrtApi api_;
+    // channel axis of 2-D [channel, num_steps] centroids, unused for 1-D per-tensor centroids
+    int64_t axis_{0};
+    // 8 for a code per byte, 4 for two codes per byte along the last axis
+    int64_t codeBits_{8};
+    // last axis length before 4 bit packing, 0 takes twice the packed length
+    int64_t unpackedDim_{0};
+    AmctCommon::ProfileKernelRef profileRef_;
+};
+
+#endif // ASCEND_NUQ_ANTIQUANT_KERNEL_H
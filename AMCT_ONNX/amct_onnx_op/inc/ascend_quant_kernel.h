@@ -20,11 +20,16 @@
 #define ASCEND_QUANT_KERNEL_H
 
 #include <map>
+#include <vector>
 #include "custom_op_library.h"
+#include "amct_profiler.h"
+
+constexpr int64_t INT4_QUANT_BITS = 4;
 
 struct AscendQuantKernel {
 public:
-    AscendQuantKernel(const OrtApi& api, const OrtKernelInfo* info);
+    AscendQuantKernel(const OrtApi& api, const OrtKernelInfo* info,
+        ONNXTensorElementDataType outputType = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED);
     ~AscendQuantKernel() {}
 #if ORT_API_VERSION >= 16
     OrtStatusPtr ComputeV2(OrtKernelContext* context);
@@ -37,11 +42,20 @@ private:
     float offsetData_{0};
     std::string dstType_{""};
     std::string fakeQuantPrecisionMode_{""};
+    // INT4 with int8 output is stored packed, two values per byte along the last axis
+    ONNXTensorElementDataType outputType_{ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED};
+    // FP8 dst types only: per-channel scales along axis replace scale when given
+    std::vector<float> channelScales_;
+    int64_t axis_{1};
 
     const std::map<std::string, int64_t> dstType2QuantBits_ = {
+        {"INT4", INT4_QUANT_BITS},
         {"INT8", 8},
         {"INT16", 16}
     };
+    AmctCommon::ProfileKernelRef profileRef_;
+
+    void ComputeFp8(OrtKernelContext* context, int64_t fp8Format);
 };
 
 #endif // ASCEND_QUANT_KERNEL_H
\ No newline at end of file
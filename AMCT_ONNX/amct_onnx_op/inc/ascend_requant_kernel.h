@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief AMCT custom ops
+ *
+ * @file ascend_requant_kernel.h
+ *
+ * @version 1.0
+ */
+#ifndef ASCEND_REQUANT_KERNEL_H
+#define ASCEND_REQUANT_KERNEL_H
+
+#include "custom_op_library.h"
+#include "amct_profiler.h"
+
+// int32 accumulators to the int8 input of the next layer, AscendDequant and AscendQuant in one pass
+struct AscendRequantKernel {
+public:
+    AscendRequantKernel(const OrtApi& api, const OrtKernelInfo* info);
+    ~AscendRequantKernel() {}
+#if ORT_API_VERSION >= 16
+    OrtStatusPtr ComputeV2(OrtKernelContext* context);
+#endif
+    void Compute(OrtKernelContext* context);
+
+private:
+    OrtApi api_;
+    // quant scale and offset of the next layer, as on its AscendQuant
+    float scaleData_{0};
+    float offsetData_{0};
+    AmctCommon::ProfileKernelRef profileRef_;
+};
+
+#endif // ASCEND_REQUANT_KERNEL_H
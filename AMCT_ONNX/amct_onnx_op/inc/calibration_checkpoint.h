@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief calibration_checkpoint head file
+ *
+ * @file calibration_checkpoint.h
+ *
+ * @version 1.0
+ */
+
+#ifndef CALIBRATION_CHECKPOINT_H
+#define CALIBRATION_CHECKPOINT_H
+
+#include <string>
+
+#include "calibration_state.h"
+
+namespace AmctCommon {
+constexpr const char* CHECKPOINT_DIR_ENV = "AMCT_CHECKPOINT_DIR";
+constexpr const char* CHECKPOINT_INTERVAL_ENV = "AMCT_CHECKPOINT_INTERVAL";
+constexpr const char* CHECKPOINT_RESUME_ENV = "AMCT_CHECKPOINT_RESUME";
+constexpr int64_t DEFAULT_CHECKPOINT_INTERVAL = 10;
+
+/**
+ * @ingroup quantize lib
+ * @brief: checkpoint of one calibration op in AMCT_CHECKPOINT_DIR, every AMCT_CHECKPOINT_INTERVAL batches.
+ * Snapshots are written by a background thread in the calibration state format and removed once the op is
+ * finalized. Resuming is opt-in: only with AMCT_CHECKPOINT_RESUME=1 does a new session with the same op attributes
+ * resume from the snapshot. A resumed op has already counted the first k batches, so the driver must skip them and
+ * feed batch k + 1 first; AmctGetCheckpointResumedBatches reports k. Without the opt-in the snapshot is ignored and
+ * overwritten.
+ */
+class CalibrationCheckpoint {
+public:
+    void Init(CalibratorType type, const std::string& layerName);
+
+    bool Enabled() const
+    {
+        return !fileName_.empty();
+    }
+    bool Due(int64_t currentBatch) const
+    {
+        return Enabled() && interval_ > 0 && currentBatch % interval_ == 0;
+    }
+
+    /**
+     * @brief: replace state by the checkpoint if resuming is requested, it has the same op attributes and is not
+     * finished. The resumed batch count is reported by AmctGetCheckpointResumedBatches, 0 if not resumed.
+     * @param [in|out] state: op attributes in, resumed state out.
+     * @param [in] batchNum: number of calibration batches of the op.
+     * @return whether the state was resumed
+     */
+    bool Resume(CalibrationState& state, int64_t batchNum) const;
+    // queue the snapshot, the calling thread does not wait for the file write
+    void Save(CalibrationState&& state) const;
+    void Remove() const;
+
+private:
+    bool ResumeFromFile(CalibrationState& state, int64_t batchNum) const;
+
+    std::string layerName_;
+    std::string calibrator_;
+    std::string fileName_;
+    int64_t interval_{DEFAULT_CHECKPOINT_INTERVAL};
+};
+
+/**
+ * @ingroup quantize lib
+ * @brief: wait until every queued checkpoint is written.
+ */
+void FlushCalibrationCheckpoints();
+} // namespace AmctCommon
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/**
+ * @ingroup quantize lib
+ * @brief: number of batches a checkpointed calibration op of the layer resumed from; the calibration driver must
+ * skip that many batches before feeding the session.
+ * @param [in] layerName: first object layer of the op.
+ * @param [in] calibrator: calibrator of the op as in the checkpoint file name: ifmr, hfmg, search_n or search_n_v2.
+ * @param [out] batchCount: resumed batch count, 0 if the op calibrates from the beginning.
+ * @return succ, RECORD_NOT_EXIT_ERROR if no checkpointed op of that calibrator was created for the layer
+ */
+int AmctGetCheckpointResumedBatches(const char* layerName, const char* calibrator, int64_t* batchCount);
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CALIBRATION_CHECKPOINT_H
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief calibration_partials head file
+ *
+ * @file calibration_partials.h
+ *
+ * @version 1.0
+ */
+
+#ifndef CALIBRATION_PARTIALS_H
+#define CALIBRATION_PARTIALS_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "calibration_state.h"
+
+namespace AmctCommon {
+enum class PartialsOrder {
+    // the reduction does not depend on the order of the batches, e.g. IFMR data that is sorted before the search
+    ANY,
+    // batches are folded into one state in batch order, e.g. HFMG histograms whose range grows with the data
+    BATCH
+};
+
+/**
+ * @ingroup quantize lib
+ * @brief: partial states of a calibration op whose Compute may run concurrently, every call claims a batch number.
+ * PartialsOrder::ANY accumulates a batch into the partial state of the calling thread, so the reductions of
+ * different threads run in parallel, and merges the partials with MergeCalibrationState once every batch is finished.
+ * PartialsOrder::BATCH keeps the update of a batch in a slot until the batches before it are folded, then folds the
+ * ready slots into a single state in batch order, so the result equals a serial run for any number of threads.
+ */
+class CalibrationPartials {
+public:
+    // op attributes every new partial starts from
+    void Init(const CalibrationState& prototype, PartialsOrder order = PartialsOrder::ANY);
+
+    // initial holds batches 1..batch, e.g. resumed from a checkpoint; call before the first Compute
+    void Reset(int64_t batch, CalibrationState&& initial);
+
+    // batch number of the calling Compute, starts from 1
+    int64_t Claim()
+    {
+        return claimed_.fetch_add(1) + 1;
+    }
+
+    /**
+     * @brief: run update(partial) on the partial of the calling thread, or on the folded state once the batches
+     * before this one are folded, and mark the batch finished.
+     * @param [in] batch: claimed batch number.
+     * @param [in] update: called as update(CalibrationState& partial), concurrently with other threads' updates for
+     * PartialsOrder::ANY. For PartialsOrder::BATCH it may run later on another thread, so it must own its data.
+     * @return number of finished batches, counting this one; when it reaches the batch count every batch is folded
+     */
+    template <typename F>
+    int64_t Accumulate(int64_t batch, F&& update)
+    {
+        if (order_ == PartialsOrder::BATCH) {
+            auto task = std::make_shared<typename std::decay<F>::type>(std::forward<F>(update));
+            return Fold(batch, [task](CalibrationState& state) { (*task)(state); });
+        }
+        std::shared_lock<std::shared_timed_mutex> gate(gate_);
+        Partial& partial = ThreadPartial(batch);
+        update(partial.state);
+        return MarkFinished(batch);
+    }
+
+    // mark a failed batch finished without accumulating it
+    int64_t Skip(int64_t batch);
+
+    /**
+     * @brief: merged copy of the partials for a checkpoint, taken while no update runs.
+     * @param [in|out] state: op attributes in, snapshot out.
+     * @return false if a later batch finished before an earlier one, the snapshot would not be batches 1..n
+     */
+    bool Snapshot(CalibrationState& state);
+
+    /**
+     * @brief: merge every partial into state and drop them, called once every batch is finished.
+     * @param [in|out] state: op attributes in, merged state out.
+     * @return succ/fail
+     */
+    Status Merge(CalibrationState& state);
+
+private:
+    struct Partial {
+        int64_t firstBatch;
+        CalibrationState state;
+    };
+
+    Partial& ThreadPartial(int64_t batch);
+    int64_t MarkFinished(int64_t batch);
+    int64_t Fold(int64_t batch, std::function<void(CalibrationState&)> update);
+    std::vector<Partial*> OrderedPartials();
+
+    CalibrationState prototype_;
+    PartialsOrder order_{PartialsOrder::ANY};
+    std::atomic<int64_t> claimed_{0};
+    // shared by the updates, exclusive for snapshots and the final merge
+    std::shared_timed_mutex gate_;
+    std::mutex partialsMutex_;
+    std::map<std::thread::id, std::unique_ptr<Partial>> partials_;
+    std::unique_ptr<Partial> initial_;
+    std::mutex finishedMutex_;
+    int64_t finished_{0};
+    // batches 1..finishedPrefix_ are finished, later finished batches wait in finishedAhead_
+    int64_t finishedPrefix_{0};
+    std::set<int64_t> finishedAhead_;
+    // PartialsOrder::BATCH: batches 1..foldedBatches_ are in folded_, updates of later batches wait in slots_
+    std::mutex foldMutex_;
+    CalibrationState folded_;
+    int64_t foldedBatches_{0};
+    std::map<int64_t, std::function<void(CalibrationState&)>> slots_;
+};
+} // namespace AmctCommon
+
+#endif // CALIBRATION_PARTIALS_H
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief calibration_state head file
+ *
+ * @file calibration_state.h
+ *
+ * @version 1.0
+ */
+
+#ifndef CALIBRATION_STATE_H
+#define CALIBRATION_STATE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "util.h"
+#include "ifmr.h"
+#include "hfmg.h"
+
+namespace AmctCommon {
+constexpr char CALIBRATION_STATE_MAGIC[8] = {'A', 'M', 'C', 'T', 'C', 'S', 'T', '\0'};
+constexpr uint32_t CALIBRATION_STATE_VERSION = 2;
+constexpr const char* PARTIAL_STATE_DIR_ENV = "AMCT_PARTIAL_STATE_DIR";
+
+enum class CalibratorType : uint32_t {
+    IFMR = 1,
+    HFMG = 2,
+    SEARCH_N = 3,
+    SEARCH_N_V2 = 4,
+    DMQ_BALANCE = 5
+};
+
+/**
+ * @ingroup quantize lib
+ * @brief: what the finalize step writes to the record file, same as the kernel would.
+ */
+struct CalibrationRecordInfo {
+    std::vector<std::string> objectLayerNames;
+    std::string inputStamp;
+    int opDtype;
+    std::string fakeQuantPrecisionMode;
+    // FP8_E4M3 / FP8_E5M2 for IFMR and HFMG searching an fp8 scale, empty otherwise
+    std::string dstType;
+};
+
+/**
+ * @ingroup quantize lib
+ * @brief: accumulated state of one calibration op, everything needed to finalize it.
+ * Only the members of the calibrator type are used:
+ *   IFMR:        ifmrParam, data followed by dataChunks (every accumulated element, IfmrQuant is exact on it)
+ *   HFMG:        hfmgParam, bins
+ *   SEARCH_N:    deqScale, channelData (accumulated data per channel)
+ *   SEARCH_N_V2: isBroadcast, channelData (accumulated error per channel and shift bit)
+ *   DMQ_BALANCE: migrationStrength, channelNum, actMax and wtsMax (per-channel abs max of the last batch, like
+ *                the serial op; merging shards takes the max of their last batches)
+ */
+struct CalibrationState {
+    CalibratorType type;
+    uint64_t batchCount{0};
+    CalibrationRecordInfo recordInfo;
+    IfmrParam ifmrParam;
+    HfmgAlgoParam hfmgParam;
+    bool isBroadcast{false};
+    float migrationStrength{0};
+    uint32_t channelNum{0};
+    std::vector<float> data;
+    // read only batches shared with the kernel, so a snapshot copies pointers instead of the elements
+    std::vector<std::shared_ptr<const std::vector<float>>> dataChunks;
+    std::vector<DataBin<float>> bins;
+    std::vector<float> deqScale;
+    std::vector<std::vector<float>> channelData;
+    std::vector<float> actMax;
+    std::vector<float> wtsMax;
+};
+
+Status SaveCalibrationState(const std::string& fileName, const CalibrationState& state);
+Status LoadCalibrationState(const std::string& fileName, CalibrationState& state);
+
+/**
+ * @ingroup quantize lib
+ * @brief: merge the state of another shard into dst, both must come from the same op with the same attributes.
+ * Data accumulated in order (IFMR, SEARCH_N) is appended, so merging shards in order equals one serial run.
+ */
+Status MergeCalibrationState(const CalibrationState& src, CalibrationState& dst);
+
+/**
+ * @ingroup quantize lib
+ * @brief: whether two states come from the same op with the same attributes.
+ */
+bool CalibrationStateMatches(const CalibrationState& lhs, const CalibrationState& rhs);
+
+/**
+ * @ingroup quantize lib
+ * @brief: run the calibration algorithm on the state and write its result to the record file.
+ */
+Status FinalizeCalibrationState(const CalibrationState& state, const std::string& recordFileName);
+
+/**
+ * @ingroup quantize lib
+ * @brief: append the IFMR dataChunks to data and release them.
+ */
+void FlattenDataChunks(CalibrationState& state);
+
+/**
+ * @ingroup quantize lib
+ * @brief: per-channel abs max of data laid out as [channelNum, -1].
+ */
+void ChannelAbsMax(const float* data, size_t length, uint32_t channelNum, std::vector<float>& absMax);
+
+/**
+ * @ingroup quantize lib
+ * @brief: directory set in AMCT_PARTIAL_STATE_DIR, empty if partial states are not requested.
+ */
+std::string GetPartialStateDir();
+const char* CalibratorTypeName(CalibratorType type);
+std::string GetCalibrationStateFileName(const std::string& dir, const std::string& layerName, CalibratorType type);
+
+/**
+ * @ingroup quantize lib
+ * @brief: save the state of a calibration op into stateDir, named after its first object layer.
+ */
+Status SavePartialCalibrationState(const std::string& stateDir, const CalibrationState& state);
+} // namespace AmctCommon
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/**
+ * @ingroup quantize lib
+ * @brief: merge the partial states of one op from several calibration processes and finalize it once.
+ * @param [in] stateFiles: partial state files, merged in the given order.
+ * @param [in] stateNum: number of state files.
+ * @param [in] recordFileName: record file to write the result.
+ * @param [in] mergedStateFile: file to save the merged state, may be nullptr.
+ * @return succ/fail
+ */
+int AmctMergeCalibrationStates(const char* const* stateFiles, int stateNum, const char* recordFileName,
+    const char* mergedStateFile);
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CALIBRATION_STATE_H
@@ -31,6 +31,8 @@ constexpr uint32_t FP32_EXP_SHIFT = 23;
 constexpr uint32_t FP32_FRAC_SHIFT = 13;
 constexpr uint32_t FP32_DENORMAL_EXP = 127 - 14;
 constexpr uint32_t FP32_NORMAL_EXP = 127 - 15;
+// bfloat16 is the upper half of the fp32 bits
+constexpr uint32_t BF16_SHIFT = 16;
 
 union CastTransData {
     float x;
@@ -39,6 +41,8 @@ union CastTransData {
 
 float Fp16ToFp32(uint16_t inputData);
 uint16_t Fp32ToFp16(float inputData);
+float Bf16ToFp32(uint16_t inputData);
+uint16_t Fp32ToBf16(float inputData);
 float CastToFP16PrecisionCPU(float inputData);
 float CastToS19CPU(float data);
 float FakeFp16PrecisionDataCPU(float data);
@@ -53,6 +57,16 @@ struct DataCastToFloat16Functor {
     void operator()(const T* in, uint16_t* out, int length) const;
 };
 
+template <typename Device, typename T>
+struct DataCastToBFloat16Functor {
+    void operator()(const T* in, uint16_t* out, int length) const;
+};
+
+template <typename Device, typename T>
+struct DataCastFromBFloat16Functor {
+    void operator()(const uint16_t* in, T* out, int length) const;
+};
+
 template <typename Device, typename T>
 struct DataCastToFp16Precision {
     void operator()(const T* in, float* out, int length) const;
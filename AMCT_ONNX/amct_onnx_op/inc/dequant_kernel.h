@@ -20,6 +20,7 @@
 #define DEQUANT_KERNEL_H
 
 #include "custom_op_library.h"
+#include "amct_profiler.h"
 
 struct DequantKernel {
 public:
@@ -33,6 +34,7 @@ public:
 private:
     OrtApi api_;
     DequantParam dequantParam_;
+    AmctCommon::ProfileKernelRef profileRef_;
 };
 
 #endif // DEQUANT_KERNEL_H
\ No newline at end of file
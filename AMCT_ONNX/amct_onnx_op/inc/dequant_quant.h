@@ -54,6 +54,39 @@ struct InputDataParam {
     int64_t fakePrecisionMode;
 };
 
+// group-wise scales of a tensor viewed as [outerSize, axisSize, innerSize], every groupSize elements along the axis
+// share one scale and offset, stored as [outerSize, axisSize / groupSize, innerSize] so that they are read in order
+struct GroupQuantParam {
+    int64_t outerSize;
+    int64_t axisSize;
+    int64_t innerSize;
+    int64_t groupSize;
+    const float* scale;
+    const float* offset;
+};
+
+// nuq weights stored as codes into a table of numSteps centroids, y = centroids[c * numSteps + code] with c the
+// channel of y in [outer, channelNum, innerSize], a single channel is per-tensor. Rows of rowLength codes along the
+// last axis start on a new byte, codeBits 4 packs two codes per byte like int4 storage
+struct NuqLutParam {
+    int64_t numSteps;
+    int64_t codeBits;
+    int64_t rowLength;
+    int64_t channelNum;
+    int64_t innerSize;
+    const float* centroids;
+};
+
+// AscendDequant params of the producing layer and the AscendQuant scale and offset of the next one, channels of
+// the int32 data are laid out as [outer, channelNum, innerSize] like AscendDequant, a single channel is per-tensor
+struct RequantParam {
+    int64_t channelNum;
+    int64_t innerSize;
+    const uint64_t* paramData;
+    float scale;
+    int64_t offset;
+};
+
 struct FakeCalParams {
     int64_t fakePrecisonMode;
     float scale;
@@ -82,6 +115,55 @@ int FakeAntiQuantCuda(InputDataParam inputDataParam,
 int FakeAntiQuant(InputDataParam param,
                   float scaleData);
 
+// int4 storage: two values per byte, the even element of a pair in the low nibble, rows of rowLength elements
+// start on a new byte, so a row takes (rowLength + 1) / 2 bytes and param.length counts the unpacked elements
+int QuantPackInt4(InputDataParam inputDataParam,
+                  int64_t rowLength,
+                  float scale,
+                  int64_t offset);
+
+int AntiQuantUnpackInt4(InputDataParam inputDataParam,
+                        int64_t rowLength,
+                        float scaleData);
+
+int FakeGroupQuant(InputDataParam inputDataParam,
+                   int64_t quantBits,
+                   GroupQuantParam groupParam);
+
+// y = (x - offset) * scale with the scale and offset of the group of x
+int FakeGroupAntiQuant(InputDataParam inputDataParam,
+                       GroupQuantParam groupParam);
+
+// fp8 fake quantization, y = fp8(x * scale[c]) with c the channel of x in [outer, channelNum, innerSize], a single
+// channel is per-tensor. fp8Format is an AmctCommon::Fp8Format, int8 output holds the fp8 bits
+int FakeQuantFp8(InputDataParam inputDataParam,
+                 int64_t fp8Format,
+                 const float* scale,
+                 int64_t channelNum,
+                 int64_t innerSize);
+
+// y = fp8 value of the int8 bits of x * scale
+int FakeAntiQuantFp8(InputDataParam inputDataParam,
+                     int64_t fp8Format,
+                     float scaleData);
+
+// int8 quantization with runtime ranges: rows of rowLength elements get their own scale and offset, a single row
+// is per-tensor quantization. scale and offset receive the dequantization parameters, x = (y - offset) * scale
+int DynamicQuant(InputDataParam inputDataParam,
+                 int64_t rowLength,
+                 bool symmetric,
+                 float* scale,
+                 float* offset);
+
+// y = centroid of the code of x, param.length counts the codes, codes past the table take its last centroid
+int NuqLutAntiQuant(InputDataParam inputDataParam,
+                    NuqLutParam nuqParam);
+
+// int32 to int8 without float data: AscendDequant then AscendQuant folded into a fixed point multiplier and shift
+// per channel, rounding half to even like the float composition
+int Requant(InputDataParam inputDataParam,
+            RequantParam requantParam);
+
 int ParseParamData(DequantParam& dequantParam);
 
 int ParseParamDataCuda(DequantParam& dequantParam);
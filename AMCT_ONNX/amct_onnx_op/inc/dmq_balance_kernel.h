@@ -20,11 +20,12 @@
 #define DMQ_BALANCE_KERNEL_H
 
 #include "custom_op_library.h"
+#include "amct_profiler.h"
 
 struct DMQBalanceKernel {
 public:
     DMQBalanceKernel(const OrtApi& api, const OrtKernelInfo* info);
-    ~DMQBalanceKernel() {}
+    ~DMQBalanceKernel();
 #if ORT_API_VERSION >= 16
     OrtStatusPtr ComputeV2(OrtKernelContext* context);
 #endif
@@ -32,11 +33,21 @@ public:
 
 private:
     void GetInput(OrtKernelContext* context, uint32_t index, std::vector<float> &inputData);
+    void UpdatePartialState(const std::vector<float>& actData, const std::vector<float>& wtsData);
+    void SavePartialState();
     OrtApi api_;
     float migrationStrength_{0};
     uint32_t channelNum_{0};
     std::string objectLayerName_;
     std::string recordFileName_;
+    // per-channel abs max of the last batch, only kept for partial calibration states; the state is saved once,
+    // at batch batchNum_, or when the kernel is released if the graph has no batch_num
+    int64_t batchNum_{0};
+    std::string stateDir_;
+    uint64_t batchCount_{0};
+    std::vector<float> actMax_;
+    std::vector<float> wtsMax_;
+    AmctCommon::ProfileKernelRef profileRef_;
 };
 
 #endif // DMQ_BALANCE_KERNEL_H
@@ -19,7 +19,17 @@
 #ifndef DUMP_KERNEL_H
 #define DUMP_KERNEL_H
 
+#include <atomic>
+
 #include "custom_op_library.h"
+#include "amct_profiler.h"
+
+// RAW dumps the full tensor, STATS only its summary, SAMPLED every k-th batch and/or a subsample of the elements
+enum class DumpMode {
+    RAW = 0,
+    STATS = 1,
+    SAMPLED = 2,
+};
 
 struct DUMPKernel {
 public:
@@ -31,15 +41,26 @@ public:
     void Compute(OrtKernelContext* context);
 
 private:
+    std::string GetDumpFileName(std::string objectLayerName, int64_t batch, const std::string& suffix);
     void DumpData(const void* x, const int inputSize, const std::vector<int32_t>& inputShapeFlt,
-        std::string objectLayerName);
+        std::string objectLayerName, int64_t batch);
+    void DumpStats(const void* x, size_t inputSize, int opDtype, const std::vector<int64_t>& inputShape,
+        int64_t batch);
+    void DumpSampledData(const void* x, size_t inputSize, int opDtype, int64_t batch);
     OrtApi api_;
     int64_t bathNum_{0};
-    int64_t currentBatch_{0};
+    // Compute may run concurrently, each call claims its own batch number
+    std::atomic<int64_t> currentBatch_{0};
     std::string recordFileName_;
     std::vector<std::string> objectLayerNames_;
     std::string dumpDir_;
     std::string dumpStamp_;
+    DumpMode dumpMode_{DumpMode::RAW};
+    int64_t dumpInterval_{1};
+    int64_t sampleStride_{1};
+    std::string sampleDtype_;
+    int64_t histBins_{0};
+    AmctCommon::ProfileKernelRef profileRef_;
 };
 
 #endif // DUMP_KERNEL_H
\ No newline at end of file
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief dump_stats head file
+ *
+ * @file dump_stats.h
+ *
+ * @version 1.0
+ */
+
+#ifndef DUMP_STATS_H
+#define DUMP_STATS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "util.h"
+
+namespace AmctCommon {
+constexpr unsigned int DEFAULT_HIST_BINS = 128;
+constexpr float INT8_SAMPLE_MAX = 127.0f;
+
+/**
+ * @ingroup quantize lib
+ * @brief: summary of a tensor (or of one channel of it).
+ */
+struct TensorStats {
+    uint64_t count;
+    float minValue;
+    float maxValue;
+    double mean;
+    double variance;
+    double zeroRatio;
+};
+
+/**
+ * @ingroup quantize lib
+ * @brief: layout of the data to summarize, viewed as [outerNum, channelNum, innerNum].
+ */
+struct DumpStatsParam {
+    int64_t outerNum;
+    int64_t channelNum;
+    int64_t innerNum;
+    unsigned int histBins;
+};
+
+struct DumpStatsResult {
+    TensorStats tensorStats;
+    std::vector<TensorStats> channelStats;
+    // histogram of the whole tensor over [tensorStats.minValue, tensorStats.maxValue]
+    std::vector<uint64_t> hist;
+};
+
+/**
+  * @ingroup quantize lib
+  * @brief: compute per-tensor and per-channel statistics and the tensor histogram.
+  * @param [in] data: input data, length outerNum * channelNum * innerNum.
+  * @param [in] param: data layout and histogram bins.
+  * @param [out] result: statistics.
+  * @return succ/fail
+  */
+Status ComputeDumpStats(const float* data, const DumpStatsParam& param, DumpStatsResult& result);
+
+/**
+  * @ingroup quantize lib
+  * @brief: write the statistics as text file.
+  * @param [in] fileName: file to write.
+  * @param [in] shape: shape of the summarized tensor.
+  * @param [in] result: statistics.
+  * @return succ/fail
+  */
+Status WriteDumpStats(const std::string& fileName, const std::vector<int64_t>& shape, const DumpStatsResult& result);
+
+/**
+  * @ingroup quantize lib
+  * @brief: take every stride-th element of data.
+  * @param [in] data: input data.
+  * @param [in] length: input data length.
+  * @param [in] stride: sample stride, 1 keeps all elements.
+  * @param [out] sampleData: sampled elements.
+  */
+template <typename T>
+void SampleData(const T* data, size_t length, size_t stride, std::vector<T>& sampleData);
+
+/**
+  * @ingroup quantize lib
+  * @brief: symmetric int8 downcast of the sampled data.
+  * @param [in] data: input data.
+  * @param [in] length: input data length.
+  * @param [out] int8Data: quantized data.
+  * @return scale, data ~= int8Data * scale
+  */
+float DowncastToInt8(const float* data, size_t length, int8_t* int8Data);
+} // namespace AmctCommon
+
+#endif // DUMP_STATS_H
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief fp8_quant head file
+ *
+ * @file fp8_quant.h
+ *
+ * @version 1.0
+ */
+
+#ifndef FP8_QUANT_H
+#define FP8_QUANT_H
+
+#include <cstdint>
+#include <string>
+
+namespace AmctCommon {
+/**
+ * @ingroup quantize lib
+ * @brief: 8 bit floating point formats, E4M3 without inf (max 448) and E5M2 (max 57344).
+ * Values are rounded to nearest even and saturate to the largest finite value, nan stays nan.
+ */
+enum class Fp8Format : int64_t {
+    E4M3 = 0,
+    E5M2 = 1
+};
+
+// dst_type "FP8_E4M3" or "FP8_E5M2", returns false for any other type
+bool GetFp8Format(const std::string& dstType, Fp8Format& format);
+const char* GetFp8TypeName(Fp8Format format);
+float GetFp8MaxValue(Fp8Format format);
+
+// out = fp8(in * scale) as float
+void Fp8RoundKernel(const float* in, float* out, int64_t length, float scale, Fp8Format format);
+// out = bits of fp8(in * scale)
+void Fp8EncodeKernel(const float* in, uint8_t* out, int64_t length, float scale, Fp8Format format);
+// out = value of the fp8 bits * scale
+void Fp8DecodeKernel(const uint8_t* in, float* out, int64_t length, float scale, Fp8Format format);
+
+/**
+ * @ingroup quantize lib
+ * @brief: turn the record scale and offset of an integer range search with numBits into the fp8 record scale of
+ * the same range, x = fp8 * scale, the offset becomes 0.
+ */
+void IntScaleToFp8Scale(unsigned int numBits, Fp8Format format, float& scale, int& offset);
+} // namespace AmctCommon
+
+#endif // FP8_QUANT_H
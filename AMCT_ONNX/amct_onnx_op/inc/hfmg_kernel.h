@@ -19,13 +19,25 @@
 #ifndef HFMG_KERNEL_H
 #define HFMG_KERNEL_H
 
+#include <atomic>
+#include <memory>
+
 #include "hfmg.h"
+#include "calibration_partials.h"
+#include "calibration_checkpoint.h"
 #include "custom_op_library.h"
+#include "amct_profiler.h"
+
+// input of one batch converted to float32, merged into the histogram once the batches before it are merged
+struct HfmgBatch {
+    std::vector<float> data;
+    int inputTypeId;
+};
 
 struct HFMGKernel {
 public:
     HFMGKernel(const OrtApi& api, const OrtKernelInfo* info);
-    ~HFMGKernel() {}
+    ~HFMGKernel();
 #if ORT_API_VERSION >= 16
     OrtStatusPtr ComputeV2(OrtKernelContext* context);
 #endif
@@ -34,20 +46,38 @@ public:
 private:
     void UpdateMinMax(const float* inputData, const int count, float& min, float& max);
 
-    void DumpData(const void* x, const int inputSize, const std::vector<int32_t>& inputShapeFlt);
+    void DumpData(const void* x, const int inputSize, const std::vector<int32_t>& inputShapeFlt, int64_t batch);
+
+    std::unique_ptr<HfmgBatch> PrepareBatch(OrtKernelContext* context, int64_t batch, float* out);
+
+    void AccumulateBatch(const HfmgBatch& batchData, AmctCommon::CalibrationState& state);
+
+    void FinishBatch(int64_t finishedBatches);
+
+    void SaveCheckpoint();
+
+    void DoCalibration();
+
+    void ReleaseRecordWriter();
+
+    void GetCalibrationState(AmctCommon::CalibrationState& state);
+
+    void SavePartialState(const AmctCommon::CalibrationState& state);
 
-    int Accumlate(OrtKernelContext* context);
+    void ResumeFromCheckpoint();
 
     OrtApi api_;
     int64_t bathNum_{0};
-    int64_t currentBatch_{0};
+    // histogram of the batches, updated in batch order whichever thread runs them
+    AmctCommon::CalibrationPartials partials_;
+    std::atomic<float> outputScale_{0};
     AmctCommon::HfmgAlgoParam hfmgAlgoParam_;
     util::FloatData scale_;
     float scaleData_{0};
     util::IntData offset_;
     int offsetData_{0};
-    std::vector<AmctCommon::DataBin<float>> dataBins_;
     std::string recordFileName_;
+    bool recordWriterReleased_{false};
     std::vector<std::string> objectLayerNames_;
     bool needDump_;
     std::string dumpDir_;
@@ -55,6 +85,10 @@ private:
     int inputTypeId_{0};
     int64_t checkCriterion;
     std::string fakeQuantPrecisionMode_;
+    // FP8_E4M3 / FP8_E5M2 turns the searched integer range into an fp8 scale
+    std::string dstType_;
+    AmctCommon::CalibrationCheckpoint checkpoint_;
+    AmctCommon::ProfileKernelRef profileRef_;
 };
 
 
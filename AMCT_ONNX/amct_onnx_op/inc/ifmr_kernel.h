@@ -19,39 +19,64 @@
 #ifndef IFMR_KERNEL_H
 #define IFMR_KERNEL_H
 
+#include <atomic>
+#include <memory>
+
 #include "ifmr.h"
+#include "calibration_partials.h"
+#include "calibration_checkpoint.h"
 #include "custom_op_library.h"
+#include "amct_profiler.h"
+
+// input of one batch converted to float32, kept as one data chunk of the calling thread's partial state
+struct IfmrBatch {
+    std::vector<float> data;
+    int opDtype;
+};
 
 struct IFMRKernel {
 public:
     IFMRKernel(const OrtApi& api, const OrtKernelInfo* info);
-    ~IFMRKernel() {}
+    ~IFMRKernel();
 #if ORT_API_VERSION >= 16
     OrtStatusPtr ComputeV2(OrtKernelContext* context);
 #endif
     void Compute(OrtKernelContext* context);
 
 private:
-    void DoCalibration(float* out);
+    std::unique_ptr<IfmrBatch> PrepareBatch(OrtKernelContext* context, int64_t batch);
+    void FinishBatch(int64_t finishedBatches);
+    void SaveCheckpoint();
+    void DoCalibration();
+    void ReleaseRecordWriter();
+    void GetCalibrationState(AmctCommon::CalibrationState& state);
+    void SavePartialState(const AmctCommon::CalibrationState& state);
+    void ResumeFromCheckpoint();
     void DumpData(const void* x, const int inputSize, const std::vector<int32_t>& inputShapeFlt,
-        std::string objectLayerName);
+        std::string objectLayerName, int64_t batch);
 
     OrtApi api_;
-    std::vector<float> accumulateData_{};
     int64_t bathNum_{0};
-    int64_t currentBatch_{0};
+    // converted batches of each calling thread, only concatenated once for the final search
+    AmctCommon::CalibrationPartials partials_;
+    std::atomic<float> outputScale_{0};
     AmctCommon::IfmrParam ifmrParam_;
     util::FloatData scale_;
     float scaleData_{0};
     util::IntData offset_;
     int offsetData_{0};
     std::string recordFileName_;
+    bool recordWriterReleased_{false};
     std::vector<std::string> objectLayerNames_;
     std::string dumpDir_;
     std::string inputStamp_ = "data";
     int opDtype_{0};
     int64_t checkCriterion;
     std::string fakeQuantPrecisionMode_;
+    // FP8_E4M3 / FP8_E5M2 turns the searched integer range into an fp8 scale
+    std::string dstType_;
+    AmctCommon::CalibrationCheckpoint checkpoint_;
+    AmctCommon::ProfileKernelRef profileRef_;
 };
 
 #endif // IFMR_KERNEL_H
\ No newline at end of file
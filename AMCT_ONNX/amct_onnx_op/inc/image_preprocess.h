@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief image_preprocess head file
+ *
+ * @file image_preprocess.h
+ *
+ * @version 1.0
+ */
+
+#ifndef IMAGE_PREPROCESS_H
+#define IMAGE_PREPROCESS_H
+
+#include <cstdint>
+#include <string>
+
+namespace AmctCommon {
+constexpr int64_t PREPROCESS_MAX_CHANNEL = 4;
+
+/**
+ * @ingroup quantize lib
+ * @brief: one pass bilinear resize, pad, normalize and HWC to CHW of uint8 images [batch, inHeight, inWidth, channel].
+ * The image is resized to resizedHeight x resizedWidth, output pixel (y, x) reads the resized pixel
+ * (y + cropTop, x + cropLeft) and pixels outside of the resized image get padValue, so a negative crop is the
+ * letterbox border. A channel of value v becomes v * alpha[c] + beta[c], the quantized output
+ * rint(value * quantScale) + quantOffset clipped to int8.
+ */
+struct PreprocessParam {
+    int64_t batchSize;
+    int64_t inHeight;
+    int64_t inWidth;
+    int64_t channel;
+    int64_t outHeight;
+    int64_t outWidth;
+    int64_t resizedHeight;
+    int64_t resizedWidth;
+    int64_t cropTop;
+    int64_t cropLeft;
+    float padValue;
+    float alpha[PREPROCESS_MAX_CHANNEL];
+    float beta[PREPROCESS_MAX_CHANNEL];
+    // reverse the channel order, BGR images of cv2 to RGB
+    bool swapChannel;
+    float quantScale;
+    float quantOffset;
+};
+
+/**
+ * @ingroup quantize lib
+ * @brief: set the resized size and crop of param from its input and output size.
+ * mode "letterbox": keep the aspect ratio and pad to the output like letterbox() of det_utils.py.
+ * mode "center_crop": resize the short side to resizeShort (the output short side if 0) and crop the center,
+ * as torchvision Resize + CenterCrop of the ResNet scripts.
+ * mode "stretch": resize to the output size.
+ */
+int SetPreprocessGeometry(const std::string& mode, int64_t resizeShort, PreprocessParam& param);
+
+int ImagePreprocess(const uint8_t* images, const PreprocessParam& param, float* output);
+int ImagePreprocessFp16(const uint8_t* images, const PreprocessParam& param, uint16_t* output);
+int ImagePreprocessInt8(const uint8_t* images, const PreprocessParam& param, int8_t* output);
+} // namespace AmctCommon
+
+#endif // IMAGE_PREPROCESS_H
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief AMCT custom ops
+ *
+ * @file image_preprocess_kernel.h
+ *
+ * @version 1.0
+ */
+#ifndef IMAGE_PREPROCESS_KERNEL_H
+#define IMAGE_PREPROCESS_KERNEL_H
+
+#include <string>
+#include <vector>
+
+#include "custom_op_library.h"
+#include "amct_profiler.h"
+#include "image_preprocess.h"
+
+struct ImagePreprocessKernel {
+public:
+    ImagePreprocessKernel(const OrtApi& api, const OrtKernelInfo* info);
+    ~ImagePreprocessKernel() {}
+#if ORT_API_VERSION >= 16
+    OrtStatusPtr ComputeV2(OrtKernelContext* context);
+#endif
+    void Compute(OrtKernelContext* context);
+
+private:
+    OrtApi api_;
+    int64_t outHeight_{0};
+    int64_t outWidth_{0};
+    std::string resizeMode_;
+    int64_t resizeShort_{0};
+    float padValue_{0};
+    float pixelScale_{0};
+    std::vector<float> mean_;
+    std::vector<float> std_;
+    bool swapChannel_{false};
+    // quantization of the int8 output, same as the attributes of AscendQuant
+    float quantScale_{1};
+    float quantOffset_{0};
+    AmctCommon::ProfileKernelRef profileRef_;
+};
+
+#endif // IMAGE_PREPROCESS_KERNEL_H
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief perf_counters head file
+ *
+ * @file perf_counters.h
+ *
+ * @version 1.0
+ */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstdint>
+
+namespace AmctCommon {
+// "1" adds hardware counters to the AMCT_PROFILE output, Linux only
+constexpr const char* PERF_COUNTERS_ENV = "AMCT_PERF_COUNTERS";
+
+struct PerfCounterValues {
+    uint64_t cycles{0};
+    uint64_t instructions{0};
+    uint64_t cacheMisses{0};
+    uint64_t branchMisses{0};
+};
+
+bool PerfCountersEnabled();
+
+/**
+ * @ingroup quantize lib
+ * @brief: read the user space counters of the calling thread, the counters are opened on the first call of a thread.
+ * Values are scaled up when the kernel multiplexed the counters. The counters only follow their own thread, so the
+ * counts that pool threads spent on this thread's ParallelFor chunks are added through AddWorkerPerfCounters.
+ * @param [out] values: counts since the counters of this thread were opened, plus the worker counts added so far
+ * @return false if the counters are disabled or not available, e.g. perf_event_paranoid forbids them
+ */
+bool ReadPerfCounters(PerfCounterValues& values);
+
+/**
+ * @ingroup quantize lib
+ * @brief: credit the counts of other threads working for the calling thread, called after a parallel loop.
+ */
+void AddWorkerPerfCounters(const PerfCounterValues& values);
+} // namespace AmctCommon
+
+#endif // PERF_COUNTERS_H
@@ -20,6 +20,7 @@
 #define QUANT_KERNEL_H
 
 #include "custom_op_library.h"
+#include "amct_profiler.h"
 
 struct QuantKernel {
 public:
@@ -35,6 +36,7 @@ private:
     float scaleData_{0};
     int64_t offsetData_{0};
     int64_t quantBits_{0};
+    AmctCommon::ProfileKernelRef profileRef_;
 };
 
 #endif // QUANT_KERNEL_H
\ No newline at end of file
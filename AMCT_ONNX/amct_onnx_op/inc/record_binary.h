@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief record_binary head file
+ *
+ * @file record_binary.h
+ *
+ * @version 1.0
+ */
+
+#ifndef RECORD_BINARY_H
+#define RECORD_BINARY_H
+
+#include <cstdint>
+#include <string>
+
+#include "record_store.h"
+
+namespace AmctCommon {
+constexpr char RECORD_BINARY_MAGIC[8] = {'A', 'M', 'C', 'T', 'R', 'E', 'C', '\0'};
+constexpr uint32_t RECORD_BINARY_VERSION = 1;
+constexpr uint32_t RECORD_BINARY_ENDIAN_TAG = 0x01020304;
+
+/**
+ * Binary record file layout, every section 8 bytes aligned:
+ *   RecordBinaryHeader
+ *   RecordBinaryLayer[layerNum]     layers in text file order
+ *   RecordBinaryField[fieldNum]     fields of layer i are [firstField, firstField + fieldNum)
+ *   uint32_t[bucketNum]             open addressing hash index of the keys, layer index + 1, 0 for empty
+ *   char[stringSize]                keys, field names and text values
+ *   float[floatNum]                 values of float fields, one contiguous run per field
+ *   int32_t[intNum]                 values of int fields, one contiguous run per field
+ * Only the float32 scale fields written by the kernels (scale_d, scale_w, scale_h, tensor_balance_factor) go to the
+ * float pool; any other non-integer number is kept as text, so a text -> binary -> text round trip does not round
+ * double values to float.
+ */
+struct RecordBinaryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t endianTag;
+    uint32_t layerNum;
+    uint32_t fieldNum;
+    uint32_t bucketNum;
+    uint32_t reserved;
+    uint64_t layerOffset;
+    uint64_t fieldOffset;
+    uint64_t bucketOffset;
+    uint64_t stringOffset;
+    uint64_t stringSize;
+    uint64_t floatOffset;
+    uint64_t floatNum;
+    uint64_t intOffset;
+    uint64_t intNum;
+};
+
+struct RecordBinaryLayer {
+    uint64_t keyHash;
+    uint32_t keyOffset;
+    uint32_t keyLength;
+    uint32_t firstField;
+    uint32_t fieldNum;
+};
+
+enum class RecordFieldType : uint32_t {
+    FLOAT = 1,
+    INT = 2,
+    // value kept as its text literal, quotes or nested braces included
+    TEXT = 3
+};
+
+/**
+ * @ingroup quantize lib
+ * @brief: a run of consecutive "name: value" lines of the same name.
+ * For FLOAT/INT fields count values start at index dataOffset of the float/int pool,
+ * for TEXT fields the single value is count bytes at dataOffset of the string pool.
+ */
+struct RecordBinaryField {
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    RecordFieldType type;
+    uint32_t count;
+    uint64_t dataOffset;
+};
+
+uint64_t HashRecordKey(const char* key, size_t length);
+
+/**
+ * @ingroup quantize lib
+ * @brief: read only view of a memory mapped binary record file.
+ */
+class RecordBinaryReader {
+public:
+    RecordBinaryReader() = default;
+    ~RecordBinaryReader();
+    RecordBinaryReader(const RecordBinaryReader&) = delete;
+    RecordBinaryReader& operator=(const RecordBinaryReader&) = delete;
+
+    Status Open(const std::string& fileName);
+    void Close();
+
+    uint32_t LayerNum() const
+    {
+        return header_ == nullptr ? 0 : header_->layerNum;
+    }
+    std::string LayerKey(uint32_t layer) const;
+    // index of the layer, -1 if not exist
+    int64_t FindLayer(const std::string& key) const;
+    const RecordBinaryField* FindField(uint32_t layer, const std::string& name) const;
+
+    Status GetFloatField(uint32_t layer, const std::string& name, const float*& data, size_t& count) const;
+    Status GetIntField(uint32_t layer, const std::string& name, const int32_t*& data, size_t& count) const;
+
+    // rebuild the generic record content, used to convert back to text
+    Status ToRecordFile(RecordFile& recordFile) const;
+
+private:
+    Status Validate() const;
+    std::string String(uint64_t offset, uint64_t length) const;
+
+    const char* base_{nullptr};
+    size_t size_{0};
+    const RecordBinaryHeader* header_{nullptr};
+    const RecordBinaryLayer* layers_{nullptr};
+    const RecordBinaryField* fields_{nullptr};
+    const uint32_t* buckets_{nullptr};
+    const char* strings_{nullptr};
+    const float* floats_{nullptr};
+    const int32_t* ints_{nullptr};
+};
+
+Status WriteRecordBinary(const std::string& fileName, const RecordFile& recordFile);
+Status ConvertRecordTextToBinary(const std::string& textFileName, const std::string& binaryFileName);
+Status ConvertRecordBinaryToText(const std::string& binaryFileName, const std::string& textFileName);
+} // namespace AmctCommon
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/**
+ * @ingroup quantize lib
+ * @brief: convert a text record file to the binary record format.
+ * @return succ/fail
+ */
+int AmctRecordTextToBinary(const char* textFileName, const char* binaryFileName);
+
+/**
+ * @ingroup quantize lib
+ * @brief: convert a binary record file back to the text record format.
+ * @return succ/fail
+ */
+int AmctRecordBinaryToText(const char* binaryFileName, const char* textFileName);
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RECORD_BINARY_H
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief record_parser head file
+ *
+ * @file record_parser.h
+ *
+ * @version 1.0
+ */
+
+#ifndef RECORD_PARSER_H
+#define RECORD_PARSER_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "util.h"
+
+namespace AmctCommon {
+/**
+ * @ingroup quantize lib
+ * @brief: non owning view of a piece of the record text.
+ */
+struct StringRef {
+    StringRef() = default;
+    StringRef(const char* dataIn, size_t sizeIn) : data(dataIn), size(sizeIn) {}
+    explicit StringRef(const std::string& str) : data(str.data()), size(str.size()) {}
+
+    bool operator==(const StringRef& other) const
+    {
+        return size == other.size && (size == 0 || memcmp(data, other.data, size) == 0);
+    }
+    bool operator!=(const StringRef& other) const
+    {
+        return !(*this == other);
+    }
+    std::string ToString() const
+    {
+        return std::string(data, size);
+    }
+
+    const char* data{nullptr};
+    size_t size{0};
+};
+
+/**
+ * @ingroup quantize lib
+ * @brief: one "name: value" line, value keeps its text literal (quotes or nested braces included).
+ */
+struct RecordFieldView {
+    StringRef name;
+    StringRef value;
+};
+
+/**
+ * @ingroup quantize lib
+ * @brief: one "record { ... }" entry, key without its quotes (escape sequences are kept).
+ */
+struct RecordLayerView {
+    StringRef key;
+    uint32_t firstField;
+    uint32_t fieldNum;
+};
+
+/**
+ * @ingroup quantize lib
+ * @brief: parse a decimal float literal in [begin, end) with the result strtof would give.
+ * Literals with at most 19 significant digits and a small exponent are parsed in place,
+ * the others fall back to strtof.
+ * @return false if [begin, end) is not a complete float literal
+ */
+bool ParseFloatFast(const char* begin, const char* end, float& value);
+bool ParseIntFast(const char* begin, const char* end, int64_t& value);
+
+/**
+ * @ingroup quantize lib
+ * @brief: indexed view of a text record file.
+ * One linear pass over the (memory mapped) text collects the layers and fields without copying any string,
+ * afterwards a layer is found by key in O(1) and the values of a field are converted on request.
+ */
+class RecordTextView {
+public:
+    RecordTextView() = default;
+    ~RecordTextView();
+    RecordTextView(const RecordTextView&) = delete;
+    RecordTextView& operator=(const RecordTextView&) = delete;
+
+    // map the file, the views stay valid until Close or destruction
+    Status Open(const std::string& fileName);
+    // parse a caller owned buffer, the views point into it
+    Status Parse(const char* text, size_t length);
+    void Close();
+
+    uint32_t LayerNum() const
+    {
+        return static_cast<uint32_t>(layers_.size());
+    }
+    const RecordLayerView& Layer(uint32_t index) const
+    {
+        return layers_[index];
+    }
+    // first layer with the key, nullptr if not exist
+    const RecordLayerView* FindLayer(const StringRef& key) const;
+
+    const RecordFieldView* FieldBegin(const RecordLayerView& layer) const
+    {
+        return fields_.data() + layer.firstField;
+    }
+    const RecordFieldView* FieldEnd(const RecordLayerView& layer) const
+    {
+        return fields_.data() + layer.firstField + layer.fieldNum;
+    }
+    const RecordFieldView* FindField(const RecordLayerView& layer, const StringRef& name) const;
+
+    /**
+     * @brief: values of every "name:" line of the layer, in file order.
+     * @param [out] data: values, at most capacity of them are written.
+     * @param [out] count: number of values of the field, may be larger than capacity.
+     * @return succ, RECORD_NOT_EXIT_ERROR if no such field, BAD_FORMAT_ERROR if a value is not a number
+     */
+    Status GetFloats(const RecordLayerView& layer, const StringRef& name, float* data, size_t capacity,
+        size_t& count) const;
+    Status GetInts(const RecordLayerView& layer, const StringRef& name, int* data, size_t capacity,
+        size_t& count) const;
+    Status GetFloats(const RecordLayerView& layer, const StringRef& name, std::vector<float>& data) const;
+    Status GetInts(const RecordLayerView& layer, const StringRef& name, std::vector<int>& data) const;
+
+private:
+    void BuildIndex();
+
+    const char* mapped_{nullptr};
+    size_t mappedSize_{0};
+    std::vector<RecordLayerView> layers_;
+    std::vector<RecordFieldView> fields_;
+    std::vector<uint32_t> buckets_;
+};
+} // namespace AmctCommon
+
+#endif // RECORD_PARSER_H
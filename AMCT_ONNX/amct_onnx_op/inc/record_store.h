@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief record_store head file
+ *
+ * @file record_store.h
+ *
+ * @version 1.0
+ */
+
+#ifndef RECORD_STORE_H
+#define RECORD_STORE_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "util.h"
+
+namespace AmctCommon {
+// set to 1 to flush every layer as soon as its kernel records it instead of once per record file
+constexpr const char* RECORD_LAYER_FLUSH_ENV = "AMCT_RECORD_LAYER_FLUSH";
+
+/**
+ * @ingroup quantize lib
+ * @brief: one "name: value" line of a record, value keeps its text literal (quotes included).
+ * A nested message "name { ... }" keeps its braces in value.
+ */
+struct RecordField {
+    std::string name;
+    std::string value;
+};
+
+/**
+ * @ingroup quantize lib
+ * @brief: one "record { key: ... value { ... } }" entry, fields in file order.
+ */
+struct LayerRecord {
+    std::string key;
+    std::vector<RecordField> fields;
+};
+
+/**
+ * @ingroup quantize lib
+ * @brief: content of a text record file, layers in file order.
+ */
+struct RecordFile {
+    std::vector<LayerRecord> layers;
+    std::map<std::string, size_t> layerIndex;
+
+    LayerRecord& GetOrAddLayer(const std::string& key);
+    const LayerRecord* FindLayer(const std::string& key) const;
+};
+
+Status ParseRecordText(const char* text, size_t length, RecordFile& recordFile);
+Status LoadRecordFile(const std::string& fileName, RecordFile& recordFile);
+std::string SerializeRecordText(const RecordFile& recordFile);
+
+/**
+ * @ingroup quantize lib
+ * @brief: overwrite the fields of dst which also appear in src, append the others.
+ */
+void MergeLayerRecord(const LayerRecord& src, LayerRecord& dst);
+
+/**
+ * @ingroup quantize lib
+ * @brief: process-wide store of calibration records.
+ * Kernels write into memory and a record file is flushed once, when the last writer registered on it is released,
+ * on an explicit Flush or FlushAll (AmctFlushRecordFiles) and when the process exits. With AMCT_RECORD_LAYER_FLUSH=1
+ * every layer is flushed as soon as its kernel records it. A flush takes an advisory lock, merges into the current
+ * file content and replaces the file atomically, so several calibration processes can share one record file.
+ */
+class RecordStore {
+public:
+    static RecordStore& Instance();
+
+    void AcquireWriter(const std::string& fileName);
+    Status ReleaseWriter(const std::string& fileName);
+
+    template <typename T>
+    Status RecordScaleOffset(const std::string& fileName, const std::string& layerName,
+        const util::RecordData<T>& recordData);
+
+    template <typename T>
+    Status RecordRepeatData(const std::string& fileName, const std::string& layerName, const std::vector<T>& data,
+        const std::string& dataType);
+
+    Status RecordLayer(const std::string& fileName, const LayerRecord& layerRecord);
+    Status Flush(const std::string& fileName);
+    Status FlushAll();
+
+    ~RecordStore();
+
+private:
+    struct FileEntry {
+        std::mutex mutex;
+        int writers{0};
+        RecordFile pending;
+    };
+    RecordStore();
+    FileEntry& GetEntry(const std::string& fileName);
+    Status FlushEntry(const std::string& fileName, FileEntry& entry);
+
+    std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<FileEntry>> files_;
+    bool layerFlush_{false};
+};
+} // namespace AmctCommon
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/**
+ * @ingroup quantize lib
+ * @brief: flush every record file with pending records.
+ * @return succ/fail
+ */
+int AmctFlushRecordFiles();
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RECORD_STORE_H
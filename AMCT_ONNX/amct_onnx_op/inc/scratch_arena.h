@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief scratch_arena head file
+ *
+ * @file scratch_arena.h
+ *
+ * @version 1.0
+ */
+
+#ifndef SCRATCH_ARENA_H
+#define SCRATCH_ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+namespace AmctCommon {
+constexpr size_t SCRATCH_ALIGNMENT = 64;
+// blocks from this size on are mapped separately and advised to use transparent huge pages
+constexpr size_t SCRATCH_HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+// most bytes an idle arena keeps for the next call, in MB
+constexpr const char* SCRATCH_RETAIN_ENV = "AMCT_SCRATCH_RETAIN_MB";
+constexpr size_t DEFAULT_SCRATCH_RETAIN_MB = 256;
+// an idle arena is trimmed to the largest footprint of its last SCRATCH_TRIM_INTERVAL calls
+constexpr size_t SCRATCH_TRIM_INTERVAL = 64;
+
+/**
+ * @ingroup quantize lib
+ * @brief: growable bump allocator for the temporary buffers of one Compute.
+ * Memory is released in LIFO order through ScratchScope and kept for the next call; once the arena is empty again
+ * its blocks are merged into one block of the bytes actually used, so the steady state needs no allocation at all.
+ * The idle arena keeps at most AMCT_SCRATCH_RETAIN_MB, and every SCRATCH_TRIM_INTERVAL calls it shrinks to the
+ * largest footprint of those calls, so one large input does not pin its peak for the lifetime of the thread.
+ * One arena per thread, it is not thread safe.
+ */
+class ScratchArena {
+public:
+    struct Mark {
+        size_t block;
+        size_t offset;
+    };
+
+    static ScratchArena& ThreadLocal();
+
+    ScratchArena() = default;
+    ~ScratchArena();
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    // uninitialized, SCRATCH_ALIGNMENT aligned memory of size bytes
+    void* Allocate(size_t size);
+    Mark GetMark() const
+    {
+        return {current_, blocks_.empty() ? 0 : blocks_[current_].used};
+    }
+    void Release(const Mark& mark);
+
+    size_t Capacity() const;
+
+private:
+    struct Block {
+        char* data;
+        size_t size;
+        size_t used;
+        bool mapped;
+    };
+
+    static Block NewBlock(size_t size);
+    static void FreeBlock(Block& block);
+    static size_t RetainLimit();
+
+    size_t Footprint() const;
+    // called once the arena is empty again
+    void Recycle();
+    void Rebuild(size_t size);
+
+    std::vector<Block> blocks_;
+    size_t current_{0};
+    // largest footprint of the running call and of the running trim interval
+    size_t callPeak_{0};
+    size_t intervalPeak_{0};
+    size_t idleCalls_{0};
+};
+
+/**
+ * @ingroup quantize lib
+ * @brief: scratch allocations of the thread arena, released when the scope ends.
+ */
+class ScratchScope {
+public:
+    ScratchScope() : arena_(ScratchArena::ThreadLocal()), mark_(arena_.GetMark()) {}
+    ~ScratchScope()
+    {
+        arena_.Release(mark_);
+    }
+    ScratchScope(const ScratchScope&) = delete;
+    ScratchScope& operator=(const ScratchScope&) = delete;
+
+    template <typename T>
+    T* Allocate(size_t count)
+    {
+        return static_cast<T*>(arena_.Allocate(sizeof(T) * count));
+    }
+
+private:
+    ScratchArena& arena_;
+    ScratchArena::Mark mark_;
+};
+} // namespace AmctCommon
+
+#endif // SCRATCH_ARENA_H
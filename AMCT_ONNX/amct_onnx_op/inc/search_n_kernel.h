@@ -19,8 +19,19 @@
 #ifndef SEARCH_N_KERNEL_H
 #define SEARCH_N_KERNEL_H
 
+#include <memory>
+
 #include "search_n.h"
+#include "calibration_partials.h"
 #include "custom_op_library.h"
+#include "amct_profiler.h"
+#include "calibration_checkpoint.h"
+
+// input of one batch stored by channel, deqScale is only read from the inputs of the last batch
+struct SearchNBatch {
+    std::vector<std::vector<float>> data;
+    std::vector<float> deqScale;
+};
 
 struct SearchNKernel {
 public:
@@ -32,15 +43,28 @@ public:
     void Compute(OrtKernelContext* context);
 
 private:
+    std::unique_ptr<SearchNBatch> PrepareBatch(OrtKernelContext* context, int64_t batch);
+    void FinishBatch(int64_t finishedBatches);
+    void SaveCheckpoint();
+    void DoCalibration();
     void RecordShiftBit(const std::vector<int>& bestN);
+    void ReleaseRecordWriter();
+    void GetCalibrationState(AmctCommon::CalibrationState& state);
+    void SavePartialState(const AmctCommon::CalibrationState& state);
+    void ResumeFromCheckpoint();
     Status CheckChannelNum(size_t coutNum, size_t scaleWSize, std::string layerNames);
 
     OrtApi api_;
-    std::vector<std::vector<float>> accumulateData_{};
     int64_t batchNum_{0};
-    int64_t current_batch_{0};
+    // per-channel data of the batches, appended in batch order whichever thread runs them
+    AmctCommon::CalibrationPartials partials_;
+    // inputs of the final batch, read by the thread that claimed it
+    std::vector<float> deqScale_;
     std::string recordFileName_;
+    bool recordWriterReleased_{false};
     std::vector<std::string> objectLayerNames_;
+    AmctCommon::CalibrationCheckpoint checkpoint_;
+    AmctCommon::ProfileKernelRef profileRef_;
 };
 
 void StoreInputTensorToND(const float* inputData,
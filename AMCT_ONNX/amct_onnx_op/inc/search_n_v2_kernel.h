@@ -19,8 +19,20 @@
 #ifndef SEARCH_N_V2_KERNEL_H
 #define SEARCH_N_V2_KERNEL_H
 
+#include <memory>
+
 #include "search_n_v2.h"
+#include "calibration_partials.h"
 #include "custom_op_library.h"
+#include "amct_profiler.h"
+#include "calibration_checkpoint.h"
+
+// input of one batch stored by channel with its deqScale, its errors are added after those of earlier batches
+struct SearchNV2Batch {
+    std::vector<std::vector<float>> data;
+    std::vector<float> deqScale;
+    std::vector<int64_t> inputShape;
+};
 
 struct SearchNV2Kernel {
 public:
@@ -32,15 +44,26 @@ public:
     void Compute(OrtKernelContext* context);
 
 private:
+    std::unique_ptr<SearchNV2Batch> PrepareBatch(OrtKernelContext* context);
+    void AccumulateBatch(SearchNV2Batch& batchData, AmctCommon::CalibrationState& state);
+    void FinishBatch(int64_t finishedBatches);
+    void SaveCheckpoint();
+    void DoCalibration();
     void RecordShiftBit(const std::vector<int>& bestN);
+    void ReleaseRecordWriter();
+    void GetCalibrationState(AmctCommon::CalibrationState& state);
+    void SavePartialState(const AmctCommon::CalibrationState& state);
+    void ResumeFromCheckpoint();
     Status CheckChannelNum(size_t coutNum, size_t scaleWSize, std::string layerNames);
     OrtApi api_;
     int64_t batchNum_{0};
-    int64_t current_batch_{0};
-    bool isBroadcast_{false};
-    std::vector<std::vector<float>> searchNError_;
+    // searchN errors of the batches, summed in batch order whichever thread runs them
+    AmctCommon::CalibrationPartials partials_;
     std::string recordFileName_;
+    bool recordWriterReleased_{false};
     std::vector<std::string> objectLayerNames_;
+    AmctCommon::CalibrationCheckpoint checkpoint_;
+    AmctCommon::ProfileKernelRef profileRef_;
 };
 
 #endif // SEARCH_N_V2_KERNEL_H
\ No newline at end of file
@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief softmax_topk head file
+ *
+ * @file softmax_topk.h
+ *
+ * @version 1.0
+ */
+
+#ifndef SOFTMAX_TOPK_H
+#define SOFTMAX_TOPK_H
+
+#include <cstdint>
+
+namespace AmctCommon {
+/**
+ * @ingroup quantize lib
+ * @brief: softmax over the last axis of logits [rowNum, classNum] and the topK most probable classes of every row,
+ * by descending probability, the lower class first on ties.
+ * probabilities, indices: [rowNum, topK], topK must not exceed classNum.
+ */
+int SoftmaxTopK(const float* logits, int64_t rowNum, int64_t classNum, int64_t topK, float* probabilities,
+    int64_t* indices);
+} // namespace AmctCommon
+
+#endif // SOFTMAX_TOPK_H
@@ -158,7 +158,8 @@ struct QuantFactors {
 
 /**
  * @ingroup quantize lib
- * @brief: record data: scale, offset, repeat data, data or weight, opDtype, numBits
+ * @brief: record data: scale, offset, repeat data, data or weight, opDtype, numBits,
+ * quantType recorded instead of "INT<numBits>" when not empty
  */
 template <typename T>
 struct RecordData {
@@ -169,6 +170,7 @@ struct RecordData {
     int opDtype;
     unsigned int numBits;
     std::string fakequantPrecisionMode;
+    std::string quantType;
 };
 
 enum WeightFormat {
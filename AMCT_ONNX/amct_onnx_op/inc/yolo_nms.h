@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief yolo_nms head file
+ *
+ * @file yolo_nms.h
+ *
+ * @version 1.0
+ */
+
+#ifndef YOLO_NMS_H
+#define YOLO_NMS_H
+
+#include <cstdint>
+
+namespace AmctCommon {
+// columns of one detection: x1, y1, x2, y2, conf, cls
+constexpr int64_t NMS_DETECTION_SIZE = 6;
+// columns of one prediction before the class scores: x, y, w, h, obj
+constexpr int64_t NMS_BOX_SIZE = 5;
+// same as max_wh of the python post-processing, offsets the boxes of each class so that classes never overlap
+constexpr float NMS_MAX_WH = 7680.0f;
+
+/**
+ * @ingroup quantize lib
+ * @brief: settings of YoloNms, the defaults of non_max_suppression in det_utils.py.
+ * rowSize: columns of one prediction, 5 + classNum + mask columns.
+ */
+struct YoloNmsParam {
+    int64_t batchSize;
+    int64_t boxNum;
+    int64_t rowSize;
+    int64_t classNum;
+    float confThres;
+    float iouThres;
+    int64_t maxDet;
+    int64_t maxNms;
+    bool multiLabel;
+    bool agnostic;
+};
+
+/**
+ * @ingroup quantize lib
+ * @brief: confidence filter, xywh to xyxy and batched per class NMS of the YOLO output [batch, boxNum, rowSize],
+ * the images of the batch are processed in parallel.
+ * detections: [batch, maxDet, 6], kept boxes by descending conf, rows after detectionNum[i] are zero.
+ */
+int YoloNms(const float* prediction, const YoloNmsParam& param, float* detections, int64_t* detectionNum);
+} // namespace AmctCommon
+
+#endif // YOLO_NMS_H
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief AMCT custom ops
+ *
+ * @file yolo_nms_kernel.h
+ *
+ * @version 1.0
+ */
+#ifndef YOLO_NMS_KERNEL_H
+#define YOLO_NMS_KERNEL_H
+
+#include "custom_op_library.h"
+#include "amct_profiler.h"
+#include "yolo_nms.h"
+
+constexpr size_t YOLO_NMS_OUTPUT_TYPE_COUNT = 2;
+
+struct YoloNmsKernel {
+public:
+    YoloNmsKernel(const OrtApi& api, const OrtKernelInfo* info);
+    ~YoloNmsKernel() {}
+#if ORT_API_VERSION >= 16
+    OrtStatusPtr ComputeV2(OrtKernelContext* context);
+#endif
+    void Compute(OrtKernelContext* context);
+
+private:
+    OrtApi api_;
+    float confThres_{0};
+    float iouThres_{0};
+    int64_t maxDet_{0};
+    int64_t maxNms_{0};
+    int64_t maskNum_{0};
+    bool multiLabel_{false};
+    bool agnostic_{false};
+    AmctCommon::ProfileKernelRef profileRef_;
+};
+
+#endif // YOLO_NMS_KERNEL_H
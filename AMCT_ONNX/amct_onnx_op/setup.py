@@ -190,7 +190,31 @@ def get_src_inc_list(use_cuda):
            os.path.join(CUD_DIR, 'src/search_n_v2_kernel.cpp'),
            os.path.join(CUD_DIR, 'src/dmq_balance_kernel.cpp'),
            os.path.join(CUD_DIR, 'src/amct_utils.cpp'),
-           os.path.join(CUD_DIR, 'src/dump_kernel.cpp')]
+           os.path.join(CUD_DIR, 'src/bfloat16_cast.cpp'),
+           os.path.join(CUD_DIR, 'src/fp8_quant.cpp'),
+           os.path.join(CUD_DIR, 'src/dump_kernel.cpp'),
+           os.path.join(CUD_DIR, 'src/dump_stats.cpp'),
+           os.path.join(CUD_DIR, 'src/record_store.cpp'),
+           os.path.join(CUD_DIR, 'src/record_binary.cpp'),
+           os.path.join(CUD_DIR, 'src/record_parser.cpp'),
+           os.path.join(CUD_DIR, 'src/calibration_state.cpp'),
+           os.path.join(CUD_DIR, 'src/calibration_checkpoint.cpp'),
+           os.path.join(CUD_DIR, 'src/calibration_partials.cpp'),
+           os.path.join(CUD_DIR, 'src/amct_thread_pool.cpp'),
+           os.path.join(CUD_DIR, 'src/scratch_arena.cpp'),
+           os.path.join(CUD_DIR, 'src/amct_profiler.cpp'),
+           os.path.join(CUD_DIR, 'src/perf_counters.cpp'),
+           os.path.join(CUD_DIR, 'src/yolo_nms.cpp'),
+           os.path.join(CUD_DIR, 'src/yolo_nms_kernel.cpp'),
+           os.path.join(CUD_DIR, 'src/image_preprocess.cpp'),
+           os.path.join(CUD_DIR, 'src/image_preprocess_kernel.cpp'),
+           os.path.join(CUD_DIR, 'src/softmax_topk.cpp'),
+           os.path.join(CUD_DIR, 'src/softmax_topk_kernel.cpp'),
+           os.path.join(CUD_DIR, 'src/ascend_group_quant_kernel.cpp'),
+           os.path.join(CUD_DIR, 'src/ascend_group_antiquant_kernel.cpp'),
+           os.path.join(CUD_DIR, 'src/dynamic_ascend_quant_kernel.cpp'),
+           os.path.join(CUD_DIR, 'src/ascend_nuq_antiquant_kernel.cpp'),
+           os.path.join(CUD_DIR, 'src/ascend_requant_kernel.cpp')]
     inc = [os.path.join(CUD_DIR, 'inc/')]
     if use_cuda:
         src.append(os.path.join(CUD_DIR, 'src/dequant_quant_impl.cu'))
@@ -0,0 +1,595 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief amct_profiler C++ implementation
+ *
+ * @file amct_profiler.cpp
+ *
+ * @version 1.0
+ */
+
+#include "amct_profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "util.h"
+
+namespace AmctCommon {
+namespace {
+constexpr size_t PHASE_TABLE_SIZE = 256;
+constexpr double NS_PER_US = 1000.0;
+constexpr double NS_PER_MS = 1000000.0;
+
+const char* GetProfilePrefixEnv()
+{
+    const char* value = getenv(PROFILE_ENV);
+    if (value == nullptr || value[0] == '\0' || std::string(value) == "0") {
+        return nullptr;
+    }
+    return value;
+}
+
+struct ProfileEvent {
+    const char* op;
+    const char* phase;
+    uint64_t startNs;
+    uint64_t durationNs;
+    uint64_t elements;
+    uint64_t bytes;
+    uint64_t scratchBlocks;
+};
+
+// totals of one (op, phase) as read by DumpProfile
+struct PhaseStat {
+    const char* op{nullptr};
+    const char* phase{nullptr};
+    uint64_t count{0};
+    uint64_t totalNs{0};
+    // dump epoch of the scopes minNs and maxNs cover
+    uint64_t epoch{0};
+    uint64_t minNs{0};
+    uint64_t maxNs{0};
+    uint64_t elements{0};
+    uint64_t bytes{0};
+    uint64_t scratchBlocks{0};
+    uint64_t scratchBytes{0};
+    // scopes measured with hardware counters and their totals
+    uint64_t perfCount{0};
+    uint64_t cycles{0};
+    uint64_t instructions{0};
+    uint64_t cacheMisses{0};
+    uint64_t branchMisses{0};
+};
+
+// written by the owner thread only and read by DumpProfile, relaxed atomics compile to plain loads and stores
+using SharedCounter = std::atomic<uint64_t>;
+using SharedName = std::atomic<const char*>;
+
+inline uint64_t LoadShared(const SharedCounter& counter)
+{
+    return counter.load(std::memory_order_relaxed);
+}
+
+inline void StoreShared(SharedCounter& counter, uint64_t value)
+{
+    counter.store(value, std::memory_order_relaxed);
+}
+
+inline void AddShared(SharedCounter& counter, uint64_t value)
+{
+    StoreShared(counter, LoadShared(counter) + value);
+}
+
+struct SharedEvent {
+    SharedName op{nullptr};
+    SharedName phase{nullptr};
+    SharedCounter startNs{0};
+    SharedCounter durationNs{0};
+    SharedCounter elements{0};
+    SharedCounter bytes{0};
+    SharedCounter scratchBlocks{0};
+
+    ProfileEvent Load() const
+    {
+        return {op.load(std::memory_order_relaxed), phase.load(std::memory_order_relaxed), LoadShared(startNs),
+            LoadShared(durationNs), LoadShared(elements), LoadShared(bytes), LoadShared(scratchBlocks)};
+    }
+};
+
+// totals of one (op, phase) since the thread started, only minNs and maxNs start over with every dump epoch
+struct SharedStat {
+    SharedName op{nullptr};
+    SharedName phase{nullptr};
+    SharedCounter count{0};
+    SharedCounter totalNs{0};
+    SharedCounter epoch{0};
+    SharedCounter minNs{0};
+    SharedCounter maxNs{0};
+    SharedCounter elements{0};
+    SharedCounter bytes{0};
+    SharedCounter scratchBlocks{0};
+    SharedCounter scratchBytes{0};
+    SharedCounter perfCount{0};
+    SharedCounter cycles{0};
+    SharedCounter instructions{0};
+    SharedCounter cacheMisses{0};
+    SharedCounter branchMisses{0};
+
+    void Load(PhaseStat& stat) const
+    {
+        stat.op = op.load(std::memory_order_relaxed);
+        stat.phase = phase.load(std::memory_order_relaxed);
+        stat.count = LoadShared(count);
+        stat.totalNs = LoadShared(totalNs);
+        stat.epoch = LoadShared(epoch);
+        stat.minNs = LoadShared(minNs);
+        stat.maxNs = LoadShared(maxNs);
+        stat.elements = LoadShared(elements);
+        stat.bytes = LoadShared(bytes);
+        stat.scratchBlocks = LoadShared(scratchBlocks);
+        stat.scratchBytes = LoadShared(scratchBytes);
+        stat.perfCount = LoadShared(perfCount);
+        stat.cycles = LoadShared(cycles);
+        stat.instructions = LoadShared(instructions);
+        stat.cacheMisses = LoadShared(cacheMisses);
+        stat.branchMisses = LoadShared(branchMisses);
+    }
+};
+
+// bumped by every dump, starts at 1 so that an unused stat (epoch 0) never matches
+std::atomic<uint64_t> g_dumpEpoch{1};
+
+struct ThreadProfile {
+    uint32_t tid{0};
+    // only touched by the owner thread
+    const char* currentOp{nullptr};
+    uint64_t scratchBlocks{0};
+    uint64_t scratchBytes{0};
+    // the ring slot and stats are written by the owner alone at the end of a scope. seq is odd while it writes
+    // and seq / 2 events have been written so far; DumpProfile reads against seq like a seqlock and retries
+    // instead of blocking, so the owner never waits
+    SharedCounter seq{0};
+    uint64_t ringSize{0};
+    std::unique_ptr<SharedEvent[]> ring;
+    SharedCounter droppedStats{0};
+    SharedStat stats[PHASE_TABLE_SIZE];
+    // only touched by DumpProfile under the dump mutex: what the previous dumps reported
+    uint64_t dumpedEvents{0};
+    uint64_t dumpedDropped{0};
+    std::vector<PhaseStat> dumpedStats;
+
+    // owner only
+    SharedStat* FindStat(const char* op, const char* phase)
+    {
+        size_t hash = (reinterpret_cast<uintptr_t>(op) * 31u + reinterpret_cast<uintptr_t>(phase)) >> 3;
+        for (size_t probe = 0; probe < PHASE_TABLE_SIZE; ++probe) {
+            SharedStat& stat = stats[(hash + probe) % PHASE_TABLE_SIZE];
+            const char* statPhase = stat.phase.load(std::memory_order_relaxed);
+            if (statPhase == nullptr) {
+                stat.op.store(op, std::memory_order_relaxed);
+                stat.phase.store(phase, std::memory_order_relaxed);
+                return &stat;
+            }
+            if (statPhase == phase && stat.op.load(std::memory_order_relaxed) == op) {
+                return &stat;
+            }
+        }
+        return nullptr;
+    }
+};
+
+class ProfileRegistry {
+public:
+    static ProfileRegistry& Instance()
+    {
+        static ProfileRegistry registry;
+        return registry;
+    }
+
+    ThreadProfile& Current()
+    {
+        thread_local std::shared_ptr<ThreadProfile> profile;
+        if (profile == nullptr) {
+            profile = std::make_shared<ThreadProfile>();
+            profile->ringSize = ringSize_;
+            profile->ring.reset(new SharedEvent[ringSize_]);
+            std::lock_guard<std::mutex> lock(mutex_);
+            profile->tid = static_cast<uint32_t>(threads_.size());
+            threads_.push_back(profile);
+        }
+        return *profile;
+    }
+
+    std::vector<std::shared_ptr<ThreadProfile>> Threads()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return threads_;
+    }
+
+    std::mutex& DumpMutex()
+    {
+        return dumpMutex_;
+    }
+
+private:
+    ProfileRegistry()
+    {
+        const char* ringSize = getenv(PROFILE_RING_SIZE_ENV);
+        int64_t size = ringSize == nullptr ? DEFAULT_PROFILE_RING_SIZE : atoll(ringSize);
+        ringSize_ = static_cast<uint32_t>(std::max<int64_t>(size, 1));
+    }
+
+    uint32_t ringSize_{DEFAULT_PROFILE_RING_SIZE};
+    std::mutex mutex_;
+    std::mutex dumpMutex_;
+    std::vector<std::shared_ptr<ThreadProfile>> threads_;
+};
+
+struct PhaseTotal {
+    uint64_t count{0};
+    uint64_t totalNs{0};
+    uint64_t minNs{UINT64_MAX};
+    uint64_t maxNs{0};
+    uint64_t elements{0};
+    uint64_t bytes{0};
+    uint64_t scratchBlocks{0};
+    uint64_t scratchBytes{0};
+    uint64_t perfCount{0};
+    uint64_t perfElements{0};
+    uint64_t perfBytes{0};
+    PerfCounterValues counters;
+};
+
+double Ratio(double numerator, uint64_t denominator)
+{
+    return denominator == 0 ? 0.0 : numerator / static_cast<double>(denominator);
+}
+
+void WriteCounters(std::ofstream& out, const PhaseTotal& total)
+{
+    const PerfCounterValues& counters = total.counters;
+    const double perKilo = 1000.0;
+    out << ", \"cycles\": " << counters.cycles << ", \"instructions\": " << counters.instructions
+        << ", \"cache_misses\": " << counters.cacheMisses << ", \"branch_misses\": " << counters.branchMisses
+        << ", \"ipc\": " << Ratio(counters.instructions, counters.cycles)
+        << ", \"bytes_per_cycle\": " << Ratio(total.perfBytes, counters.cycles)
+        << ", \"cache_misses_per_kilo_element\": " << Ratio(counters.cacheMisses * perKilo, total.perfElements)
+        << ", \"branch_misses_per_kilo_element\": " << Ratio(counters.branchMisses * perKilo, total.perfElements);
+}
+
+void WriteSummary(const std::string& fileName, const std::map<std::pair<std::string, std::string>, PhaseTotal>& totals,
+    size_t threadNum, uint64_t droppedStats)
+{
+    std::ofstream out(fileName);
+    CHECK_TRUE_RETURN_WITH_LOG(!out.is_open(), "Fail to open profile file %s.\n", fileName.c_str());
+    out << "{\n  \"pid\": " << getpid() << ",\n  \"threads\": " << threadNum << ",\n  \"dropped_phases\": "
+        << droppedStats << ",\n  \"phases\": [";
+    bool first = true;
+    for (const auto& item : totals) {
+        const PhaseTotal& total = item.second;
+        double seconds = static_cast<double>(total.totalNs) / (NS_PER_MS * 1000.0);
+        out << (first ? "\n" : ",\n") << "    {\"op\": \"" << item.first.first << "\", \"phase\": \""
+            << item.first.second << "\", \"count\": " << total.count
+            << ", \"total_ms\": " << static_cast<double>(total.totalNs) / NS_PER_MS
+            << ", \"mean_us\": " << static_cast<double>(total.totalNs) / NS_PER_US / total.count
+            << ", \"min_us\": " << static_cast<double>(total.minNs) / NS_PER_US
+            << ", \"max_us\": " << static_cast<double>(total.maxNs) / NS_PER_US
+            << ", \"elements\": " << total.elements << ", \"bytes\": " << total.bytes
+            << ", \"gbytes_per_s\": " << (seconds > 0 ? static_cast<double>(total.bytes) / seconds / 1e9 : 0.0)
+            << ", \"scratch_blocks\": " << total.scratchBlocks << ", \"scratch_block_bytes\": " << total.scratchBytes;
+        if (total.perfCount != 0) {
+            WriteCounters(out, total);
+        }
+        out << "}";
+        first = false;
+    }
+    out << "\n  ]\n}\n";
+}
+
+struct ThreadEvents {
+    uint32_t tid;
+    std::vector<ProfileEvent> events;
+};
+
+void WriteTrace(const std::string& fileName, const std::vector<ThreadEvents>& threads)
+{
+    std::ofstream out(fileName);
+    CHECK_TRUE_RETURN_WITH_LOG(!out.is_open(), "Fail to open profile file %s.\n", fileName.c_str());
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    bool first = true;
+    int pid = getpid();
+    for (const auto& thread : threads) {
+        for (const ProfileEvent& event : thread.events) {
+            out << (first ? "\n" : ",\n") << "{\"name\": \"" << event.phase << "\", \"cat\": \"" << event.op
+                << "\", \"ph\": \"X\", \"pid\": " << pid << ", \"tid\": " << thread.tid
+                << ", \"ts\": " << static_cast<double>(event.startNs) / NS_PER_US
+                << ", \"dur\": " << static_cast<double>(event.durationNs) / NS_PER_US
+                << ", \"args\": {\"elements\": " << event.elements << ", \"bytes\": " << event.bytes
+                << ", \"scratch_blocks\": " << event.scratchBlocks << "}}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+}
+
+void AddStat(const PhaseStat& stat, PhaseTotal& total)
+{
+    total.count += stat.count;
+    total.totalNs += stat.totalNs;
+    total.minNs = std::min(total.minNs, stat.minNs);
+    total.maxNs = std::max(total.maxNs, stat.maxNs);
+    total.elements += stat.elements;
+    total.bytes += stat.bytes;
+    total.scratchBlocks += stat.scratchBlocks;
+    total.scratchBytes += stat.scratchBytes;
+    if (stat.perfCount != 0) {
+        // derived metrics only use the work of the scopes that were measured
+        total.perfCount += stat.perfCount;
+        total.perfElements += stat.elements * stat.perfCount / stat.count;
+        total.perfBytes += stat.bytes * stat.perfCount / stat.count;
+        total.counters.cycles += stat.cycles;
+        total.counters.instructions += stat.instructions;
+        total.counters.cacheMisses += stat.cacheMisses;
+        total.counters.branchMisses += stat.branchMisses;
+    }
+}
+
+// consistent copy of the stats of one thread, retried while the owner is writing them
+uint64_t ReadThreadStats(const ThreadProfile& thread, std::vector<PhaseStat>& stats)
+{
+    stats.resize(PHASE_TABLE_SIZE);
+    while (true) {
+        uint64_t seq = thread.seq.load(std::memory_order_acquire);
+        if ((seq & 1) != 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (size_t i = 0; i < PHASE_TABLE_SIZE; ++i) {
+            thread.stats[i].Load(stats[i]);
+        }
+        uint64_t droppedStats = LoadShared(thread.droppedStats);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (thread.seq.load(std::memory_order_relaxed) == seq) {
+            return droppedStats;
+        }
+    }
+}
+
+// events written since the previous dump; slots the owner overwrote during the copy are left out
+void ReadThreadEvents(ThreadProfile& thread, ThreadEvents& events)
+{
+    uint64_t seq = thread.seq.load(std::memory_order_acquire);
+    // an odd seq means event seq / 2 is being written into the slot of event seq / 2 - ringSize
+    uint64_t written = seq / 2;
+    uint64_t reused = written + (seq & 1);
+    uint64_t first = std::max(thread.dumpedEvents, reused > thread.ringSize ? reused - thread.ringSize : 0);
+    std::vector<ProfileEvent> copied;
+    copied.reserve(written - std::min(first, written));
+    for (uint64_t i = first; i < written; ++i) {
+        copied.push_back(thread.ring[i % thread.ringSize].Load());
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t seqAfter = thread.seq.load(std::memory_order_relaxed);
+    // event i is intact unless the write of event i + ringSize started
+    uint64_t valid = first;
+    while (valid < written && 2 * (valid + thread.ringSize) + 1 <= seqAfter) {
+        ++valid;
+    }
+    events.tid = thread.tid;
+    events.events.assign(copied.begin() + static_cast<std::ptrdiff_t>(valid - first), copied.end());
+    thread.dumpedEvents = written;
+}
+
+// what one thread did since the previous dump, the owner may be inside a scope meanwhile
+void TakeThreadProfile(ThreadProfile& thread, std::map<std::pair<std::string, std::string>, PhaseTotal>& totals,
+    uint64_t& droppedStats, ThreadEvents& events)
+{
+    std::vector<PhaseStat> stats;
+    uint64_t dropped = ReadThreadStats(thread, stats);
+    droppedStats += dropped - thread.dumpedDropped;
+    thread.dumpedDropped = dropped;
+    thread.dumpedStats.resize(PHASE_TABLE_SIZE);
+    for (size_t i = 0; i < PHASE_TABLE_SIZE; ++i) {
+        PhaseStat& stat = stats[i];
+        PhaseStat& dumped = thread.dumpedStats[i];
+        if (stat.phase != nullptr && stat.count != dumped.count) {
+            PhaseStat delta = stat;
+            delta.count -= dumped.count;
+            delta.totalNs -= dumped.totalNs;
+            delta.elements -= dumped.elements;
+            delta.bytes -= dumped.bytes;
+            delta.scratchBlocks -= dumped.scratchBlocks;
+            delta.scratchBytes -= dumped.scratchBytes;
+            delta.perfCount -= dumped.perfCount;
+            delta.cycles -= dumped.cycles;
+            delta.instructions -= dumped.instructions;
+            delta.cacheMisses -= dumped.cacheMisses;
+            delta.branchMisses -= dumped.branchMisses;
+            AddStat(delta, totals[std::make_pair(std::string(stat.op), std::string(stat.phase))]);
+        }
+        dumped = stat;
+    }
+    ReadThreadEvents(thread, events);
+}
+
+std::atomic<int> g_liveKernels{0};
+std::atomic<int> g_dumpIndex{0};
+
+// writes what is left at process exit, constructed after the registry so that it is destroyed before it
+struct ProfileExitWriter {
+    ProfileExitWriter()
+    {
+        if (g_profileEnabled) {
+            (void)ProfileRegistry::Instance();
+        }
+    }
+    ~ProfileExitWriter()
+    {
+        if (g_profileEnabled) {
+            (void)DumpProfile();
+        }
+    }
+};
+}
+
+const bool g_profileEnabled = GetProfilePrefixEnv() != nullptr;
+
+namespace {
+ProfileExitWriter g_profileExitWriter;
+}
+
+uint64_t ProfileNowNs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void ProfileCountScratchBlock(uint64_t bytes)
+{
+    if (!ProfilingEnabled()) {
+        return;
+    }
+    ThreadProfile& profile = ProfileRegistry::Instance().Current();
+    ++profile.scratchBlocks;
+    profile.scratchBytes += bytes;
+}
+
+void ProfileScope::Begin(const char* op, const char* phase, uint64_t elements, uint64_t bytes)
+{
+    ThreadProfile& profile = ProfileRegistry::Instance().Current();
+    if (op != nullptr) {
+        isOp_ = true;
+        prevOp_ = profile.currentOp;
+        profile.currentOp = op;
+        op_ = op;
+    } else {
+        op_ = profile.currentOp == nullptr ? "amct" : profile.currentOp;
+    }
+    phase_ = phase;
+    elements_ = elements;
+    bytes_ = bytes;
+    scratchStart_ = profile.scratchBlocks;
+    scratchBytesStart_ = profile.scratchBytes;
+    active_ = true;
+    perfValid_ = ReadPerfCounters(perfStart_);
+    startNs_ = ProfileNowNs();
+}
+
+void ProfileScope::End()
+{
+    uint64_t duration = ProfileNowNs() - startNs_;
+    PerfCounterValues perfEnd;
+    bool perfValid = perfValid_ && ReadPerfCounters(perfEnd);
+    ThreadProfile& profile = ProfileRegistry::Instance().Current();
+    uint64_t scratchBlocks = profile.scratchBlocks - scratchStart_;
+    uint64_t scratchBytes = profile.scratchBytes - scratchBytesStart_;
+    uint64_t epoch = g_dumpEpoch.load(std::memory_order_relaxed);
+    uint64_t seq = LoadShared(profile.seq);
+    StoreShared(profile.seq, seq + 1);
+    std::atomic_thread_fence(std::memory_order_release);
+    SharedEvent& event = profile.ring[(seq / 2) % profile.ringSize];
+    event.op.store(op_, std::memory_order_relaxed);
+    event.phase.store(phase_, std::memory_order_relaxed);
+    StoreShared(event.startNs, startNs_);
+    StoreShared(event.durationNs, duration);
+    StoreShared(event.elements, elements_);
+    StoreShared(event.bytes, bytes_);
+    StoreShared(event.scratchBlocks, scratchBlocks);
+    SharedStat* stat = profile.FindStat(op_, phase_);
+    if (stat == nullptr) {
+        AddShared(profile.droppedStats, 1);
+    } else {
+        if (LoadShared(stat->epoch) != epoch) {
+            StoreShared(stat->epoch, epoch);
+            StoreShared(stat->minNs, duration);
+            StoreShared(stat->maxNs, duration);
+        } else {
+            StoreShared(stat->minNs, std::min(LoadShared(stat->minNs), duration));
+            StoreShared(stat->maxNs, std::max(LoadShared(stat->maxNs), duration));
+        }
+        AddShared(stat->count, 1);
+        AddShared(stat->totalNs, duration);
+        AddShared(stat->elements, elements_);
+        AddShared(stat->bytes, bytes_);
+        AddShared(stat->scratchBlocks, scratchBlocks);
+        AddShared(stat->scratchBytes, scratchBytes);
+        if (perfValid) {
+            AddShared(stat->perfCount, 1);
+            AddShared(stat->cycles, perfEnd.cycles - perfStart_.cycles);
+            AddShared(stat->instructions, perfEnd.instructions - perfStart_.instructions);
+            AddShared(stat->cacheMisses, perfEnd.cacheMisses - perfStart_.cacheMisses);
+            AddShared(stat->branchMisses, perfEnd.branchMisses - perfStart_.branchMisses);
+        }
+    }
+    profile.seq.store(seq + 2, std::memory_order_release);
+    if (isOp_) {
+        profile.currentOp = prevOp_;
+    }
+    active_ = false;
+}
+
+ProfileKernelRef::ProfileKernelRef()
+{
+    if (ProfilingEnabled()) {
+        g_liveKernels.fetch_add(1);
+    }
+}
+
+ProfileKernelRef::~ProfileKernelRef()
+{
+    if (ProfilingEnabled() && g_liveKernels.fetch_sub(1) == 1) {
+        (void)DumpProfile();
+    }
+}
+
+std::string DumpProfile()
+{
+    const char* prefixEnv = GetProfilePrefixEnv();
+    if (!ProfilingEnabled() || prefixEnv == nullptr) {
+        return "";
+    }
+    ProfileRegistry& registry = ProfileRegistry::Instance();
+    std::lock_guard<std::mutex> lock(registry.DumpMutex());
+    std::vector<std::shared_ptr<ThreadProfile>> threads = registry.Threads();
+    std::map<std::pair<std::string, std::string>, PhaseTotal> totals;
+    uint64_t droppedStats = 0;
+    std::vector<ThreadEvents> events(threads.size());
+    for (size_t i = 0; i < threads.size(); ++i) {
+        TakeThreadProfile(*threads[i], totals, droppedStats, events[i]);
+    }
+    // scopes ending from here on start new min / max
+    g_dumpEpoch.fetch_add(1, std::memory_order_relaxed);
+    if (totals.empty()) {
+        return "";
+    }
+    std::string prefix = std::string(prefixEnv) == "1" ? "amct_profile" : prefixEnv;
+    prefix += "_" + std::to_string(getpid()) + "_" + std::to_string(g_dumpIndex.fetch_add(1));
+    WriteSummary(prefix + ".json", totals, threads.size(), droppedStats);
+    WriteTrace(prefix + ".trace.json", events);
+    return prefix;
+}
+} // namespace AmctCommon
+
+int AmctDumpProfile()
+{
+    return AmctCommon::DumpProfile().empty() ? AmctCommon::RECORD_FILE_ERROR : AmctCommon::SUCCESS;
+}
@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief amct_thread_pool C++ implementation
+ *
+ * @file amct_thread_pool.cpp
+ *
+ * @version 1.0
+ */
+
+#include "amct_thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "amct_profiler.h"
+#include "util.h"
+
+namespace AmctCommon {
+namespace {
+int64_t GetInt64Env(const char* name, int64_t defaultValue)
+{
+    const char* value = getenv(name);
+    if (value == nullptr || value[0] == '\0') {
+        return defaultValue;
+    }
+    char* end = nullptr;
+    long long result = strtoll(value, &end, 10);
+    if (end == value || *end != '\0') {
+        LOG_ERROR("Ignore invalid %s=%s.\n", name, value);
+        return defaultValue;
+    }
+    return static_cast<int64_t>(result);
+}
+
+// one ParallelFor loop, chunks are claimed by the caller and any pool thread that joins
+struct ParallelJob {
+    const ParallelRange* fn;
+    int64_t length;
+    int64_t grainSize;
+    int64_t chunkNum;
+    std::atomic<int64_t> next{0};
+    std::atomic<int64_t> done{0};
+    // pool threads working on the job, guarded by the pool mutex
+    int workers{0};
+    std::mutex mutex;
+    std::condition_variable cond;
+
+    // run one chunk, false if every chunk is already claimed
+    bool RunChunk()
+    {
+        int64_t chunk = next.fetch_add(1);
+        if (chunk >= chunkNum) {
+            return false;
+        }
+        int64_t begin = chunk * grainSize;
+        (*fn)(begin, std::min(length, begin + grainSize));
+        if (done.fetch_add(1) + 1 == chunkNum) {
+            std::lock_guard<std::mutex> lock(mutex);
+            cond.notify_all();
+        }
+        return true;
+    }
+};
+
+class ThreadPool {
+public:
+    static ThreadPool& Instance()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    void Run(ParallelJob& job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            StartWorkers();
+            jobs_.push_back(&job);
+        }
+        cond_.notify_all();
+        while (job.RunChunk()) {
+        }
+        {
+            std::unique_lock<std::mutex> lock(job.mutex);
+            job.cond.wait(lock, [&job] { return job.done.load() == job.chunkNum; });
+        }
+        // the job lives on the caller stack, wait until no pool thread refers to it
+        std::unique_lock<std::mutex> lock(mutex_);
+        RemoveJob(&job);
+        idleCond_.wait(lock, [&job] { return job.workers == 0; });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cond_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+private:
+    ThreadPool() = default;
+
+    void StartWorkers()
+    {
+        if (!workers_.empty()) {
+            return;
+        }
+        const ParallelConfig& config = GetParallelConfig();
+        for (int i = 1; i < config.numThreads; ++i) {
+            workers_.emplace_back(&ThreadPool::WorkerLoop, this, i, config.pinThreads);
+        }
+    }
+
+    void RemoveJob(ParallelJob* job)
+    {
+        auto it = std::find(jobs_.begin(), jobs_.end(), job);
+        if (it != jobs_.end()) {
+            jobs_.erase(it);
+        }
+    }
+
+    void WorkerLoop(int index, bool pinThread)
+    {
+        if (pinThread) {
+            PinCurrentThread(index);
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cond_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+            if (stop_) {
+                return;
+            }
+            ParallelJob* job = jobs_.front();
+            ++job->workers;
+            lock.unlock();
+            while (job->RunChunk()) {
+            }
+            lock.lock();
+            // every chunk is claimed, later workers move on to the next job
+            RemoveJob(job);
+            --job->workers;
+            idleCond_.notify_all();
+        }
+    }
+
+    static void PinCurrentThread(int index)
+    {
+#ifdef __linux__
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+            return;
+        }
+        std::vector<int> cpus;
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &allowed)) {
+                cpus.push_back(cpu);
+            }
+        }
+        if (cpus.empty()) {
+            return;
+        }
+        cpu_set_t target;
+        CPU_ZERO(&target);
+        CPU_SET(cpus[static_cast<size_t>(index) % cpus.size()], &target);
+        (void)pthread_setaffinity_np(pthread_self(), sizeof(target), &target);
+#else
+        (void)index;
+#endif
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::condition_variable idleCond_;
+    std::deque<ParallelJob*> jobs_;
+    std::vector<std::thread> workers_;
+    bool stop_{false};
+};
+
+void RunJob(int64_t length, int64_t grainSize, const ParallelRange& fn)
+{
+    ParallelJob job;
+    job.fn = &fn;
+    job.length = length;
+    job.grainSize = grainSize;
+    job.chunkNum = (length + grainSize - 1) / grainSize;
+    ThreadPool::Instance().Run(job);
+}
+
+// counts of the chunks that other threads ran for the caller
+struct WorkerCounters {
+    std::mutex mutex;
+    PerfCounterValues values;
+
+    void Add(const PerfCounterValues& start, const PerfCounterValues& end)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        values.cycles += end.cycles - start.cycles;
+        values.instructions += end.instructions - start.instructions;
+        values.cacheMisses += end.cacheMisses - start.cacheMisses;
+        values.branchMisses += end.branchMisses - start.branchMisses;
+    }
+};
+
+void RunParallel(int64_t length, int64_t grainSize, const ParallelRange& fn)
+{
+    if (!ProfilingEnabled() || !PerfCountersEnabled()) {
+        RunJob(length, grainSize, fn);
+        return;
+    }
+    // hardware counters are per thread, so the profile scopes of the caller would miss the pool threads' work
+    std::thread::id caller = std::this_thread::get_id();
+    WorkerCounters workerCounters;
+    ParallelRange measured = [&fn, &workerCounters, caller](int64_t begin, int64_t end) {
+        PerfCounterValues start;
+        if (std::this_thread::get_id() == caller || !ReadPerfCounters(start)) {
+            fn(begin, end);
+            return;
+        }
+        fn(begin, end);
+        PerfCounterValues stop;
+        if (ReadPerfCounters(stop)) {
+            workerCounters.Add(start, stop);
+        }
+    };
+    RunJob(length, grainSize, measured);
+    AddWorkerPerfCounters(workerCounters.values);
+}
+}
+
+const ParallelConfig& GetParallelConfig()
+{
+    static const ParallelConfig config = [] {
+        int64_t cores = std::max<int64_t>(static_cast<int64_t>(std::thread::hardware_concurrency()), 1);
+        ParallelConfig result;
+        result.numThreads = static_cast<int>(std::max<int64_t>(GetInt64Env(NUM_THREADS_ENV, cores), 1));
+        result.grainSize = std::max<int64_t>(GetInt64Env(GRAIN_SIZE_ENV, DEFAULT_GRAIN_SIZE), 1);
+        result.serialThreshold = std::max<int64_t>(GetInt64Env(SERIAL_THRESHOLD_ENV, DEFAULT_SERIAL_THRESHOLD), 0);
+        result.pinThreads = GetInt64Env(PIN_THREADS_ENV, 0) != 0;
+        return result;
+    }();
+    return config;
+}
+
+void ParallelFor(int64_t length, const ParallelRange& fn)
+{
+    ParallelFor(length, GetParallelConfig().grainSize, fn);
+}
+
+void ParallelFor(int64_t length, int64_t grainSize, const ParallelRange& fn)
+{
+    if (length <= 0) {
+        return;
+    }
+    const ParallelConfig& config = GetParallelConfig();
+    grainSize = std::max<int64_t>(grainSize, 1);
+    if (config.numThreads <= 1 || length <= config.serialThreshold || length <= grainSize) {
+        fn(0, length);
+        return;
+    }
+    RunParallel(length, grainSize, fn);
+}
+
+void ParallelForTasks(int64_t taskNum, const ParallelRange& fn)
+{
+    if (taskNum <= 0) {
+        return;
+    }
+    if (GetParallelConfig().numThreads <= 1 || taskNum == 1) {
+        fn(0, taskNum);
+        return;
+    }
+    RunParallel(taskNum, 1, fn);
+}
+} // namespace AmctCommon
@@ -89,8 +89,12 @@ namespace AmctUtils {
             auto castIn = reinterpret_cast<const uint16_t*>(inputData);
             util::DataCastToFloat32Functor<util::CPUDevice, uint16_t>()(castIn, saveData, dataLength);
             return;
+        } else if (dataId == ONNX_TENSOR_ELEMENT_DATA_TYPE_BFLOAT16) {
+            auto castIn = reinterpret_cast<const uint16_t*>(inputData);
+            util::DataCastFromBFloat16Functor<util::CPUDevice, float>()(castIn, saveData, dataLength);
+            return;
         } else {
-            ORT_CXX_API_THROW("AMCT cannot accept types other than float and float16.", ORT_FAIL);
+            ORT_CXX_API_THROW("AMCT cannot accept types other than float, float16 and bfloat16.", ORT_FAIL);
         }
     }
     std::string GetStringAttr(const OrtApi& api, const OrtKernelInfo* info, const std::string& attrName)
@@ -108,4 +112,64 @@ namespace AmctUtils {
         return customOpApi.KernelInfoGetAttribute<std::string>(info, attrName.c_str());
 #endif
     }
+
+    int64_t GetInt64AttrOrDefault(const OrtApi& api, const OrtKernelInfo* info, const std::string& attrName,
+        int64_t defaultValue)
+    {
+        int64_t attrValue = defaultValue;
+        OrtStatus* status = api.KernelInfoGetAttribute_int64(info, attrName.c_str(), &attrValue);
+        if (status != nullptr) {
+            api.ReleaseStatus(status);
+            return defaultValue;
+        }
+        return attrValue;
+    }
+
+    float GetFloatAttrOrDefault(const OrtApi& api, const OrtKernelInfo* info, const std::string& attrName,
+        float defaultValue)
+    {
+        float attrValue = defaultValue;
+        OrtStatus* status = api.KernelInfoGetAttribute_float(info, attrName.c_str(), &attrValue);
+        if (status != nullptr) {
+            api.ReleaseStatus(status);
+            return defaultValue;
+        }
+        return attrValue;
+    }
+
+    std::string GetStringAttrOrDefault(const OrtApi& api, const OrtKernelInfo* info, const std::string& attrName,
+        const std::string& defaultValue)
+    {
+        size_t size = 0;
+        OrtStatus* status = api.KernelInfoGetAttribute_string(info, attrName.c_str(), nullptr, &size);
+        if (status != nullptr) {
+            api.ReleaseStatus(status);
+            return defaultValue;
+        }
+        if (size == 0) {
+            return defaultValue;
+        }
+        std::string attrValue;
+        attrValue.resize(size);
+        CheckStatus(api, api.KernelInfoGetAttribute_string(info, attrName.c_str(), &attrValue[0], &size));
+        attrValue.resize(size - 1);
+        return TrimTailSpace(attrValue);
+    }
+
+    std::vector<float> GetFloatsAttrOrDefault(const OrtApi& api, const OrtKernelInfo* info,
+        const std::string& attrName, const std::vector<float>& defaultValue)
+    {
+        size_t size = 0;
+        OrtStatus* status = api.KernelInfoGetAttributeArray_float(info, attrName.c_str(), nullptr, &size);
+        if (status != nullptr) {
+            api.ReleaseStatus(status);
+            return defaultValue;
+        }
+        if (size == 0) {
+            return defaultValue;
+        }
+        std::vector<float> attrValue(size);
+        CheckStatus(api, api.KernelInfoGetAttributeArray_float(info, attrName.c_str(), attrValue.data(), &size));
+        return attrValue;
+    }
 }
@@ -20,13 +20,45 @@
 
 #include "amct_utils.h"
 #include "dequant_quant.h"
+#include "fp8_quant.h"
 #include "ascend_antiquant_kernel.h"
 #include "util.h"
 #include "cast_util.h"
 
-AntiQuantKernel::AntiQuantKernel(const OrtApi &api, const OrtKernelInfo *info) : api_(api)
+namespace {
+constexpr int64_t INT4_PER_BYTE = 2;
+}
+
+AntiQuantKernel::AntiQuantKernel(const OrtApi &api, const OrtKernelInfo *info, AntiQuantSource source)
+    : api_(api), source_(source)
 {
     AmctUtils::CheckStatus(api_, api_.KernelInfoGetAttribute_float(info, "scale", &scaleData_));
+    unpackedDim_ = AmctUtils::GetInt64AttrOrDefault(api_, info, "unpacked_dim", 0);
+    auto srcType = AmctUtils::GetStringAttrOrDefault(api_, info, "src_type", "");
+    srcType = AmctUtils::TrimTailSpace(srcType);
+    AntiQuantSource requested = source;
+    if (srcType == "INT8") {
+        requested = AntiQuantSource::INT8;
+    } else if (srcType == "INT4") {
+        requested = AntiQuantSource::INT4;
+    } else if (AmctCommon::GetFp8Format(srcType, fp8Format_)) {
+        requested = AntiQuantSource::FP8;
+    } else if (!srcType.empty()) {
+        ORT_CXX_API_THROW("AscendAntiQuant src_type must be INT8, INT4, FP8_E4M3 or FP8_E5M2.",
+            ORT_INVALID_ARGUMENT);
+    }
+    if (source != AntiQuantSource::INT8 && requested != source) {
+        ORT_CXX_API_THROW("AscendAntiQuant src_type contradicts the AscendAntiQuantInt4 or AscendAntiQuantFp8 op.",
+            ORT_INVALID_ARGUMENT);
+    }
+    source_ = requested;
+#ifdef USE_CUDA
+    // int4 and fp8 run on the host, AscendAntiQuant itself is registered on the cuda execution provider
+    if (source_ != AntiQuantSource::INT8 && source == AntiQuantSource::INT8) {
+        ORT_CXX_API_THROW("AscendAntiQuant src_type INT4 or FP8 needs the AscendAntiQuantInt4 or AscendAntiQuantFp8 "
+            "op in cuda builds.", ORT_INVALID_ARGUMENT);
+    }
+#endif
 }
 
 #if ORT_API_VERSION >= 16
@@ -39,6 +71,7 @@ OrtStatusPtr AntiQuantKernel::ComputeV2(OrtKernelContext* context)
 
 void AntiQuantKernel::Compute(OrtKernelContext* context)
 {
+    AmctCommon::ProfileOpScope profile("AscendAntiQuant");
     // Setup inputs
     const OrtValue* inputX = AmctUtils::GetKernelInput(api_, context, 0);
     OrtTensorTypeAndShapeInfo* inputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, inputX);
@@ -51,6 +84,20 @@ void AntiQuantKernel::Compute(OrtKernelContext* context)
 
     // Setup output
     OrtTensorDimensions dimensions(api_, inputX);
+    if (source_ != AntiQuantSource::INT8 && inputTensorType != ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8) {
+        ORT_CXX_API_THROW("AscendAntiQuant int4 and fp8 input must be held in an int8 tensor.", ORT_INVALID_ARGUMENT);
+    }
+    int64_t rowLength = 1;
+    if (source_ == AntiQuantSource::INT4 && !dimensions.empty()) {
+        int64_t packedRow = dimensions.back();
+        rowLength = unpackedDim_ > 0 ? unpackedDim_ : packedRow * INT4_PER_BYTE;
+        if ((rowLength + 1) / INT4_PER_BYTE != packedRow) {
+            ORT_CXX_API_THROW("AscendAntiQuant unpacked_dim does not match the packed int4 input.",
+                ORT_INVALID_ARGUMENT);
+        }
+        dimensions.back() = rowLength;
+        inputSize = inputSize / static_cast<size_t>(packedRow) * static_cast<size_t>(rowLength);
+    }
     OrtValue* output = AmctUtils::GetKernelOutput(api_, context, 0, dimensions.data(), dimensions.size());
     void* y = AmctUtils::GetTensorMutableData<void>(api_, output);
 
@@ -60,7 +107,22 @@ void AntiQuantKernel::Compute(OrtKernelContext* context)
 
     InputDataParam params = {
         x, y, static_cast<int64_t>(inputTensorType), static_cast<int64_t>(outputTensorType), inputSize};
-    // do real calculate
+    // do real calculate, the int4 and fp8 ops are registered on the CPU execution provider only, so their data is
+    // on the host in cuda builds as well
+    if (source_ == AntiQuantSource::FP8) {
+        auto ret = FakeAntiQuantFp8(params, static_cast<int64_t>(fp8Format_), scaleData_);
+        if (ret != 0) {
+            LOG_ERROR("Do AscendAntiquant fp8 compute failed, error code: %d.\n", ret);
+        }
+        return;
+    }
+    if (source_ == AntiQuantSource::INT4) {
+        auto ret = AntiQuantUnpackInt4(params, rowLength, scaleData_);
+        if (ret != 0) {
+            LOG_ERROR("Do AscendAntiquant int4 compute failed, error code: %d.\n", ret);
+        }
+        return;
+    }
 #ifdef USE_CUDA
     auto ret = FakeAntiQuantCuda(params, scaleData_);
     if (ret != 0) {
@@ -21,6 +21,7 @@
 #include "amct_utils.h"
 #include "dequant_quant.h"
 #include "ascend_dequant_kernel.h"
+#include "scratch_arena.h"
 #include "util.h"
 
 
@@ -55,6 +56,7 @@ OrtStatusPtr AscendDequantKernel::ComputeV2(OrtKernelContext* context)
 
 void AscendDequantKernel::Compute(OrtKernelContext* context)
 {
+    AmctCommon::ProfileOpScope profile("AscendDequant");
     // Setup inputs input 0: data
     const OrtValue* inputX = AmctUtils::GetKernelInput(api_, context, 0);
     const void* x = AmctUtils::GetTensorData<void>(api_, inputX);
@@ -85,17 +87,14 @@ void AscendDequantKernel::Compute(OrtKernelContext* context)
     OrtTensorTypeAndShapeInfo* outputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, output);
     ONNXTensorElementDataType outputTensorType = AmctUtils::GetTensorEleType(api_, outputInfo);
     api_.ReleaseTensorTypeAndShapeInfo(outputInfo);
-    //  fake dequant compute
-    std::vector<float> shiftValueHost(paramSize);
-    std::vector<float> deqScaleHost(paramSize);
-    dequantParam_.paramSize = paramSize;
-    dequantParam_.chwSize = chwSize;
-    dequantParam_.hwSize = hwSize;
-    dequantParam_.clipMode = CLIP_32;
-    dequantParam_.paramData = paramData;
-    dequantParam_.shiftValue = shiftValueHost.data();
-    dequantParam_.deqScale = deqScaleHost.data();
-    dequantParam_.channelWise = channelWise;
+    //  fake dequant compute, the kernel is shared by concurrent calls so the params are local
+    DequantParam dequantParam = {};
+    dequantParam.paramSize = paramSize;
+    dequantParam.chwSize = chwSize;
+    dequantParam.hwSize = hwSize;
+    dequantParam.clipMode = CLIP_32;
+    dequantParam.paramData = paramData;
+    dequantParam.channelWise = channelWise;
     int64_t fakePrecisionMode = 0;
     if (fakeQuantPrecisionMode_ == "FORCE_FP16_QUANT") {
         fakePrecisionMode = util::FORCE_FP16_QUANT;
@@ -104,18 +103,21 @@ void AscendDequantKernel::Compute(OrtKernelContext* context)
         x, y, static_cast<int64_t>(inputTensorType), static_cast<int64_t>(outputTensorType), inputSize, fakePrecisionMode};
 
 #ifdef USE_CUDA
-    int ret = FakeDequantCuda(params, dequantParam_);
+    int ret = FakeDequantCuda(params, dequantParam);
     if (ret != 0) {
         LOG_ERROR("Do AscendDequant cuda compute failed, error code: %d.\n", ret);
         return;
     }
 #else
-    int ret = ParseParamData(dequantParam_);
+    AmctCommon::ScratchScope scratch;
+    dequantParam.shiftValue = scratch.Allocate<float>(paramSize);
+    dequantParam.deqScale = scratch.Allocate<float>(paramSize);
+    int ret = ParseParamData(dequantParam);
     if (ret != 0) {
         LOG_ERROR("Do ParseParamData failed, error code: %d.\n", ret);
         return;
     }
-    ret = FakeDequant(params, dequantParam_);
+    ret = FakeDequant(params, dequantParam);
     if (ret != 0) {
         LOG_ERROR("Do AscendDequant compute failed, error code: %d.\n", ret);
         return;
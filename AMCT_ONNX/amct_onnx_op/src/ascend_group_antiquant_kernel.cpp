@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief AMCT custom ops
+ *
+ * @file ascend_group_antiquant_kernel.cpp
+ *
+ * @version 1.0
+ */
+
+#include "amct_utils.h"
+#include "dequant_quant.h"
+#include "ascend_group_quant_kernel.h"
+#include "ascend_group_antiquant_kernel.h"
+#include "util.h"
+
+AscendGroupAntiQuantKernel::AscendGroupAntiQuantKernel(const OrtApi &api, const OrtKernelInfo *info) : api_(api)
+{
+    AmctUtils::CheckStatus(api_, api_.KernelInfoGetAttribute_int64(info, "group_size", &groupSize_));
+    axis_ = AmctUtils::GetInt64AttrOrDefault(api_, info, "axis", -1);
+}
+
+#if ORT_API_VERSION >= 16
+OrtStatusPtr AscendGroupAntiQuantKernel::ComputeV2(OrtKernelContext* context)
+{
+    Compute(context);
+    return api_.CreateStatus(ORT_OK, "Success");
+}
+#endif
+
+void AscendGroupAntiQuantKernel::Compute(OrtKernelContext* context)
+{
+    AmctCommon::ProfileOpScope profile("AscendGroupAntiQuant");
+    // Setup inputs, x is int8 weights or their fake quantized float values
+    const OrtValue* inputX = AmctUtils::GetKernelInput(api_, context, 0);
+    OrtTensorTypeAndShapeInfo* inputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, inputX);
+    size_t inputSize = AmctUtils::GetElementCount(api_, inputInfo);
+    AmctUtils::CheckTensorNotEmpty(inputSize);
+    ONNXTensorElementDataType inputTensorType = AmctUtils::GetTensorEleType(api_, inputInfo);
+    api_.ReleaseTensorTypeAndShapeInfo(inputInfo);
+    const void* x = AmctUtils::GetTensorData<void>(api_, inputX);
+
+    GroupQuantParam groupParam;
+    if (!GetGroupQuantParam(api_, context, axis_, groupSize_, groupParam)) {
+        return;
+    }
+
+    // Setup output
+    OrtTensorDimensions dimensions(api_, inputX);
+    OrtValue* output = AmctUtils::GetKernelOutput(api_, context, 0, dimensions.data(), dimensions.size());
+    OrtTensorTypeAndShapeInfo* outputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, output);
+    ONNXTensorElementDataType outputTensorType = AmctUtils::GetTensorEleType(api_, outputInfo);
+    api_.ReleaseTensorTypeAndShapeInfo(outputInfo);
+    void* y = AmctUtils::GetTensorMutableData<void>(api_, output);
+
+    InputDataParam params = {
+        x, y, static_cast<int64_t>(inputTensorType), static_cast<int64_t>(outputTensorType), inputSize, 0};
+    int ret = FakeGroupAntiQuant(params, groupParam);
+    if (ret != 0) {
+        LOG_ERROR("Do AscendGroupAntiQuant compute failed, error code: %d.\n", ret);
+    }
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief AMCT custom ops
+ *
+ * @file ascend_group_quant_kernel.cpp
+ *
+ * @version 1.0
+ */
+
+#include "amct_utils.h"
+#include "ascend_group_quant_kernel.h"
+#include "util.h"
+
+namespace {
+size_t GetInputElementCount(const OrtApi& api, OrtKernelContext* context, size_t index)
+{
+    OrtTensorTypeAndShapeInfo* info = AmctUtils::GetTensorTypeAndShapeInfo(api,
+        AmctUtils::GetKernelInput(api, context, index));
+    size_t elementCount = AmctUtils::GetElementCount(api, info);
+    api.ReleaseTensorTypeAndShapeInfo(info);
+    return elementCount;
+}
+}
+
+bool GetGroupQuantParam(const OrtApi& api, OrtKernelContext* context, int64_t axis, int64_t groupSize,
+    GroupQuantParam& groupParam)
+{
+    OrtTensorDimensions dimensions(api, AmctUtils::GetKernelInput(api, context, 0));
+    int64_t rank = static_cast<int64_t>(dimensions.size());
+    if (axis < -rank || axis >= rank) {
+        LOG_ERROR("Group quant axis %lld is out of range for rank %lld.\n", static_cast<long long>(axis),
+            static_cast<long long>(rank));
+        return false;
+    }
+    axis = axis < 0 ? axis + rank : axis;
+    groupParam.outerSize = 1;
+    groupParam.innerSize = 1;
+    for (int64_t i = 0; i < axis; ++i) {
+        groupParam.outerSize *= dimensions[i];
+    }
+    for (int64_t i = axis + 1; i < rank; ++i) {
+        groupParam.innerSize *= dimensions[i];
+    }
+    groupParam.axisSize = dimensions[axis];
+    groupParam.groupSize = groupSize;
+    if (groupSize <= 0 || groupParam.axisSize % groupSize != 0) {
+        LOG_ERROR("Group size %lld does not divide the quantized axis of size %lld.\n",
+            static_cast<long long>(groupSize), static_cast<long long>(groupParam.axisSize));
+        return false;
+    }
+    size_t scaleNum = static_cast<size_t>(groupParam.outerSize * (groupParam.axisSize / groupSize) *
+        groupParam.innerSize);
+    if (GetInputElementCount(api, context, 1) != scaleNum || GetInputElementCount(api, context, NUM_TWO) != scaleNum) {
+        LOG_ERROR("Group quant needs %zu scales and offsets, one per group.\n", scaleNum);
+        return false;
+    }
+    groupParam.scale = AmctUtils::GetTensorData<float>(api, AmctUtils::GetKernelInput(api, context, 1));
+    groupParam.offset = AmctUtils::GetTensorData<float>(api, AmctUtils::GetKernelInput(api, context, NUM_TWO));
+    return true;
+}
+
+AscendGroupQuantKernel::AscendGroupQuantKernel(const OrtApi &api, const OrtKernelInfo *info) : api_(api)
+{
+    AmctUtils::CheckStatus(api_, api_.KernelInfoGetAttribute_int64(info, "group_size", &groupSize_));
+    axis_ = AmctUtils::GetInt64AttrOrDefault(api_, info, "axis", -1);
+    auto dstType = AmctUtils::GetStringAttrOrDefault(api_, info, "dst_type", "INT8");
+    dstType_ = AmctUtils::TrimTailSpace(dstType);
+    auto fakeQuantPrecisionMode = AmctUtils::GetStringAttrOrDefault(api_, info, "fakequant_precision_mode", "");
+    fakeQuantPrecisionMode_ = AmctUtils::TrimTailSpace(fakeQuantPrecisionMode);
+}
+
+#if ORT_API_VERSION >= 16
+OrtStatusPtr AscendGroupQuantKernel::ComputeV2(OrtKernelContext* context)
+{
+    Compute(context);
+    return api_.CreateStatus(ORT_OK, "Success");
+}
+#endif
+
+void AscendGroupQuantKernel::Compute(OrtKernelContext* context)
+{
+    AmctCommon::ProfileOpScope profile("AscendGroupQuant");
+    // Setup inputs
+    const OrtValue* inputX = AmctUtils::GetKernelInput(api_, context, 0);
+    OrtTensorTypeAndShapeInfo* inputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, inputX);
+    size_t inputSize = AmctUtils::GetElementCount(api_, inputInfo);
+    AmctUtils::CheckTensorNotEmpty(inputSize);
+    ONNXTensorElementDataType inputTensorType = AmctUtils::GetTensorEleType(api_, inputInfo);
+    api_.ReleaseTensorTypeAndShapeInfo(inputInfo);
+    const void* x = AmctUtils::GetTensorData<void>(api_, inputX);
+
+    auto quantBitsItem = dstType2QuantBits_.find(dstType_);
+    if (quantBitsItem == dstType2QuantBits_.end()) {
+        LOG_ERROR("Cannot support AscendGroupQuant with \"dst_type\": %s.\n", dstType_.c_str());
+        return;
+    }
+    GroupQuantParam groupParam;
+    if (!GetGroupQuantParam(api_, context, axis_, groupSize_, groupParam)) {
+        return;
+    }
+
+    // Setup output, int8 output holds int4 values unpacked
+    OrtTensorDimensions dimensions(api_, inputX);
+    OrtValue* output = AmctUtils::GetKernelOutput(api_, context, 0, dimensions.data(), dimensions.size());
+    OrtTensorTypeAndShapeInfo* outputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, output);
+    ONNXTensorElementDataType outputTensorType = AmctUtils::GetTensorEleType(api_, outputInfo);
+    api_.ReleaseTensorTypeAndShapeInfo(outputInfo);
+    void* y = AmctUtils::GetTensorMutableData<void>(api_, output);
+
+    int64_t fakePrecisionMode = 0;
+    if (fakeQuantPrecisionMode_ == "FORCE_FP16_QUANT") {
+        fakePrecisionMode = util::FORCE_FP16_QUANT;
+    }
+    InputDataParam params = {x, y, static_cast<int64_t>(inputTensorType), static_cast<int64_t>(outputTensorType),
+        inputSize, fakePrecisionMode};
+    // registered on the CPU execution provider only, so the data is on the host in cuda builds as well
+    int ret = FakeGroupQuant(params, quantBitsItem->second, groupParam);
+    if (ret != 0) {
+        LOG_ERROR("Do AscendGroupQuant compute failed, error code: %d.\n", ret);
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief AMCT custom ops
+ *
+ * @file ascend_nuq_antiquant_kernel.cpp
+ *
+ * @version 1.0
+ */
+
+#include "amct_utils.h"
+#include "dequant_quant.h"
+#include "ascend_nuq_antiquant_kernel.h"
+#include "util.h"
+
+namespace {
+constexpr int64_t PACKED_CODE_BITS = 4;
+constexpr int64_t CODES_PER_BYTE = 2;
+}
+
+AscendNuqAntiQuantKernel::AscendNuqAntiQuantKernel(const OrtApi &api, const OrtKernelInfo *info) : api_(api)
+{
+    axis_ = AmctUtils::GetInt64AttrOrDefault(api_, info, "axis", 0);
+    codeBits_ = AmctUtils::GetInt64AttrOrDefault(api_, info, "code_bits", 8);
+    unpackedDim_ = AmctUtils::GetInt64AttrOrDefault(api_, info, "unpacked_dim", 0);
+}
+
+#if ORT_API_VERSION >= 16
+OrtStatusPtr AscendNuqAntiQuantKernel::ComputeV2(OrtKernelContext* context)
+{
+    Compute(context);
+    return api_.CreateStatus(ORT_OK, "Success");
+}
+#endif
+
+void AscendNuqAntiQuantKernel::Compute(OrtKernelContext* context)
+{
+    AmctCommon::ProfileOpScope profile("AscendNuqAntiQuant");
+    // Setup inputs, x holds the codes and centroids is [num_steps] or [channel, num_steps]
+    const OrtValue* inputX = AmctUtils::GetKernelInput(api_, context, 0);
+    OrtTensorTypeAndShapeInfo* inputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, inputX);
+    size_t inputSize = AmctUtils::GetElementCount(api_, inputInfo);
+    AmctUtils::CheckTensorNotEmpty(inputSize);
+    ONNXTensorElementDataType inputTensorType = AmctUtils::GetTensorEleType(api_, inputInfo);
+    api_.ReleaseTensorTypeAndShapeInfo(inputInfo);
+    const void* x = AmctUtils::GetTensorData<void>(api_, inputX);
+    const OrtValue* inputCentroids = AmctUtils::GetKernelInput(api_, context, 1);
+    OrtTensorDimensions centroidDims(api_, inputCentroids);
+
+    OrtTensorDimensions dimensions(api_, inputX);
+    int64_t rank = static_cast<int64_t>(dimensions.size());
+    NuqLutParam nuqParam = {0, codeBits_, 1, 1, 1, AmctUtils::GetTensorData<float>(api_, inputCentroids)};
+    if (rank > 0) {
+        nuqParam.rowLength = dimensions.back();
+    }
+    if (codeBits_ == PACKED_CODE_BITS && rank > 0) {
+        int64_t packedRow = dimensions.back();
+        nuqParam.rowLength = unpackedDim_ > 0 ? unpackedDim_ : packedRow * CODES_PER_BYTE;
+        if ((nuqParam.rowLength + 1) / CODES_PER_BYTE != packedRow) {
+            ORT_CXX_API_THROW("AscendNuqAntiQuant unpacked_dim does not match the packed codes.", ORT_INVALID_ARGUMENT);
+        }
+        dimensions.back() = nuqParam.rowLength;
+        inputSize = inputSize / static_cast<size_t>(packedRow) * static_cast<size_t>(nuqParam.rowLength);
+    }
+    if (centroidDims.size() == 1) {
+        nuqParam.numSteps = centroidDims[0];
+        nuqParam.innerSize = static_cast<int64_t>(inputSize);
+    } else if (centroidDims.size() == NUM_TWO && axis_ >= -rank && axis_ < rank) {
+        int64_t axis = axis_ < 0 ? axis_ + rank : axis_;
+        if (dimensions[axis] != centroidDims[0]) {
+            ORT_CXX_API_THROW("AscendNuqAntiQuant needs one row of centroids per channel.", ORT_INVALID_ARGUMENT);
+        }
+        nuqParam.channelNum = centroidDims[0];
+        nuqParam.numSteps = centroidDims[1];
+        for (int64_t i = axis + 1; i < rank; ++i) {
+            nuqParam.innerSize *= dimensions[i];
+        }
+    } else {
+        ORT_CXX_API_THROW("AscendNuqAntiQuant centroids must be [num_steps] or [channel, num_steps] of axis.",
+            ORT_INVALID_ARGUMENT);
+    }
+
+    // Setup output
+    OrtValue* output = AmctUtils::GetKernelOutput(api_, context, 0, dimensions.data(), dimensions.size());
+    OrtTensorTypeAndShapeInfo* outputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, output);
+    ONNXTensorElementDataType outputTensorType = AmctUtils::GetTensorEleType(api_, outputInfo);
+    api_.ReleaseTensorTypeAndShapeInfo(outputInfo);
+    void* y = AmctUtils::GetTensorMutableData<void>(api_, output);
+
+    InputDataParam params = {
+        x, y, static_cast<int64_t>(inputTensorType), static_cast<int64_t>(outputTensorType), inputSize, 0};
+    int ret = NuqLutAntiQuant(params, nuqParam);
+    if (ret != 0) {
+        LOG_ERROR("Do AscendNuqAntiQuant compute failed, error code: %d.\n", ret);
+    }
+}
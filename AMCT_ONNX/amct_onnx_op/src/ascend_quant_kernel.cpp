@@ -20,19 +20,34 @@
 #include "amct_utils.h"
 #include "cast_util.h"
 #include "dequant_quant.h"
+#include "fp8_quant.h"
 #include "ascend_quant_kernel.h"
 #include "util.h"
 #include <vector>
 
 using namespace util;
 
-AscendQuantKernel::AscendQuantKernel(const OrtApi &api, const OrtKernelInfo *info) : api_(api)
+AscendQuantKernel::AscendQuantKernel(const OrtApi &api, const OrtKernelInfo *info,
+    ONNXTensorElementDataType outputType) : api_(api), outputType_(outputType)
 {
     AmctUtils::CheckStatus(api_, api_.KernelInfoGetAttribute_float(info, "scale", &scaleData_));
     AmctUtils::CheckStatus(api_, api_.KernelInfoGetAttribute_float(info, "offset", &offsetData_));
     dstType_ = AmctUtils::GetStringAttr(api_, info, "dst_type");
     auto fakeQuantPrecisionMode = AmctUtils::GetStringAttr(api_, info, "fakequant_precision_mode");
     fakeQuantPrecisionMode_ = AmctUtils::TrimTailSpace(fakeQuantPrecisionMode);
+    channelScales_ = AmctUtils::GetFloatsAttrOrDefault(api_, info, "scales", {});
+    axis_ = AmctUtils::GetInt64AttrOrDefault(api_, info, "axis", 1);
+#ifdef USE_CUDA
+    // packing and fp8 run on the host, AscendQuant itself is registered on the cuda execution provider
+    auto trimedDstType = AmctUtils::TrimTailSpace(dstType_);
+    if (trimedDstType == "INT4" && outputType_ == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8) {
+        ORT_CXX_API_THROW("AscendQuant packed int4 output is not supported in cuda builds.", ORT_INVALID_ARGUMENT);
+    }
+    AmctCommon::Fp8Format fp8Format;
+    if (AmctCommon::GetFp8Format(trimedDstType, fp8Format)) {
+        ORT_CXX_API_THROW("AscendQuant fp8 \"dst_type\" is not supported in cuda builds.", ORT_INVALID_ARGUMENT);
+    }
+#endif
 }
 
 #if ORT_API_VERSION >= 16
@@ -45,6 +60,7 @@ OrtStatusPtr AscendQuantKernel::ComputeV2(OrtKernelContext* context)
 
 void AscendQuantKernel::Compute(OrtKernelContext* context)
 {
+    AmctCommon::ProfileOpScope profile("AscendQuant");
     // Setup inputs
     const OrtValue* inputX = AmctUtils::GetKernelInput(api_, context, 0);
 
@@ -55,8 +71,27 @@ void AscendQuantKernel::Compute(OrtKernelContext* context)
     const void* x = AmctUtils::GetTensorData<void>(api_, inputX);
     ONNXTensorElementDataType inputTensorType = AmctUtils::GetTensorEleType(api_, inputInfo);
 
+    int64_t offsetData = static_cast<int64_t>(offsetData_);
+    auto trimedDstType = AmctUtils::TrimTailSpace(dstType_);
+    AmctCommon::Fp8Format fp8Format;
+    if (AmctCommon::GetFp8Format(trimedDstType, fp8Format)) {
+        ComputeFp8(context, static_cast<int64_t>(fp8Format));
+        return;
+    }
+    auto quantBitsItem = dstType2QuantBits_.find(trimedDstType);
+    if (quantBitsItem == dstType2QuantBits_.end()) {
+        LOG_ERROR("Cannot support AscendQuant with \"dst_type\": %s.\n", trimedDstType.c_str());
+        return;
+    }
+    int64_t quantBits = quantBitsItem->second;
+    bool packInt4 = quantBits == INT4_QUANT_BITS && outputType_ == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8;
+
     // Setup output
     OrtTensorDimensions dimensions(api_, inputX);
+    int64_t rowLength = dimensions.empty() ? 1 : dimensions.back();
+    if (packInt4 && !dimensions.empty()) {
+        dimensions.back() = (rowLength + 1) / NUM_TWO;
+    }
     OrtValue* output = AmctUtils::GetKernelOutput(api_, context, 0, dimensions.data(), dimensions.size());
     OrtTensorTypeAndShapeInfo* outputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, output);
     ONNXTensorElementDataType outputTensorType = AmctUtils::GetTensorEleType(api_, outputInfo);
@@ -69,15 +104,16 @@ void AscendQuantKernel::Compute(OrtKernelContext* context)
     }
     InputDataParam params = {
         x, y, static_cast<int64_t>(inputTensorType), static_cast<int64_t>(outputTensorType), inputSize, fakePrecisionMode};
-
-    int64_t offsetData = static_cast<int64_t>(offsetData_);
-    auto trimedDstType = AmctUtils::TrimTailSpace(dstType_);
-    auto quantBitsItem = dstType2QuantBits_.find(trimedDstType);
-    if (quantBitsItem == dstType2QuantBits_.end()) {
-        LOG_ERROR("Cannot support AscendQuant with \"dst_type\": %s.\n", trimedDstType.c_str());
+#ifndef USE_CUDA
+    // rejected at construction in cuda builds
+    if (packInt4) {
+        int ret = QuantPackInt4(params, rowLength, scaleData_, offsetData);
+        if (ret != 0) {
+            LOG_ERROR("Do AscendQuant int4 compute failed, error code: %d.\n", ret);
+        }
         return;
     }
-    int64_t quantBits = quantBitsItem->second;
+#endif
 
 #ifdef USE_CUDA
     // Launch on stream 0 or user provided stream
@@ -93,4 +129,46 @@ void AscendQuantKernel::Compute(OrtKernelContext* context)
         return;
     }
 #endif
-}
\ No newline at end of file
+}
+
+void AscendQuantKernel::ComputeFp8(OrtKernelContext* context, int64_t fp8Format)
+{
+    const OrtValue* inputX = AmctUtils::GetKernelInput(api_, context, 0);
+    OrtTensorTypeAndShapeInfo* inputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, inputX);
+    size_t inputSize = AmctUtils::GetElementCount(api_, inputInfo);
+    ONNXTensorElementDataType inputTensorType = AmctUtils::GetTensorEleType(api_, inputInfo);
+    api_.ReleaseTensorTypeAndShapeInfo(inputInfo);
+    const void* x = AmctUtils::GetTensorData<void>(api_, inputX);
+
+    OrtTensorDimensions dimensions(api_, inputX);
+    const float* scale = &scaleData_;
+    int64_t channelNum = 1;
+    int64_t innerSize = static_cast<int64_t>(inputSize);
+    if (!channelScales_.empty()) {
+        int64_t rank = static_cast<int64_t>(dimensions.size());
+        int64_t axis = axis_ < 0 ? axis_ + rank : axis_;
+        if (axis < 0 || axis >= rank || dimensions[axis] != static_cast<int64_t>(channelScales_.size())) {
+            LOG_ERROR("AscendQuant needs one of \"scales\" per channel of axis %lld.\n", static_cast<long long>(axis_));
+            return;
+        }
+        scale = channelScales_.data();
+        channelNum = dimensions[axis];
+        innerSize = 1;
+        for (int64_t i = axis + 1; i < rank; ++i) {
+            innerSize *= dimensions[i];
+        }
+    }
+    OrtValue* output = AmctUtils::GetKernelOutput(api_, context, 0, dimensions.data(), dimensions.size());
+    OrtTensorTypeAndShapeInfo* outputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, output);
+    ONNXTensorElementDataType outputTensorType = AmctUtils::GetTensorEleType(api_, outputInfo);
+    api_.ReleaseTensorTypeAndShapeInfo(outputInfo);
+    void* y = AmctUtils::GetTensorMutableData<void>(api_, output);
+
+    InputDataParam params = {x, y, static_cast<int64_t>(inputTensorType), static_cast<int64_t>(outputTensorType),
+        inputSize, 0};
+    // rejected at construction in cuda builds, so the data is on the host
+    int ret = FakeQuantFp8(params, fp8Format, scale, channelNum, innerSize);
+    if (ret != 0) {
+        LOG_ERROR("Do AscendQuant fp8 compute failed, error code: %d.\n", ret);
+    }
+}
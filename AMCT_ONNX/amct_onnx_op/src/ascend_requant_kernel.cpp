@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief AMCT custom ops
+ *
+ * @file ascend_requant_kernel.cpp
+ *
+ * @version 1.0
+ */
+
+#include "amct_utils.h"
+#include "dequant_quant.h"
+#include "ascend_dequant_kernel.h"
+#include "ascend_requant_kernel.h"
+#include "util.h"
+
+AscendRequantKernel::AscendRequantKernel(const OrtApi &api, const OrtKernelInfo *info) : api_(api)
+{
+    AmctUtils::CheckStatus(api_, api_.KernelInfoGetAttribute_float(info, "scale", &scaleData_));
+    AmctUtils::CheckStatus(api_, api_.KernelInfoGetAttribute_float(info, "offset", &offsetData_));
+}
+
+#if ORT_API_VERSION >= 16
+OrtStatusPtr AscendRequantKernel::ComputeV2(OrtKernelContext* context)
+{
+    Compute(context);
+    return api_.CreateStatus(ORT_OK, "Success");
+}
+#endif
+
+void AscendRequantKernel::Compute(OrtKernelContext* context)
+{
+    AmctCommon::ProfileOpScope profile("AscendRequant");
+    // Setup inputs input 0: int32 data
+    const OrtValue* inputX = AmctUtils::GetKernelInput(api_, context, 0);
+    const void* x = AmctUtils::GetTensorData<void>(api_, inputX);
+    OrtTensorTypeAndShapeInfo* inputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, inputX);
+    ONNXTensorElementDataType inputTensorType = AmctUtils::GetTensorEleType(api_, inputInfo);
+    size_t inputSize = AmctUtils::GetElementCount(api_, inputInfo);
+    AmctUtils::CheckTensorNotEmpty(inputSize);
+    std::vector<int64_t> shapeInfo = AmctUtils::GetShape(api_, inputInfo);
+    api_.ReleaseTensorTypeAndShapeInfo(inputInfo);
+
+    // input 1: AscendDequant params, deq_scale and shift_n packed in uint64
+    const OrtValue* param = AmctUtils::GetKernelInput(api_, context, 1);
+    OrtTensorTypeAndShapeInfo* paramInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, param);
+    size_t paramSize = AmctUtils::GetElementCount(api_, paramInfo);
+    api_.ReleaseTensorTypeAndShapeInfo(paramInfo);
+    AmctUtils::CheckTensorNotEmpty(paramSize);
+    bool channelWise = paramSize != 1;
+    int64_t chwSize = 1;
+    int64_t hwSize = 1;
+    GetShapeInfo(channelWise, shapeInfo, hwSize, chwSize);
+    int64_t innerSize = channelWise ? hwSize : static_cast<int64_t>(inputSize);
+    RequantParam requantParam = {static_cast<int64_t>(paramSize), innerSize,
+        AmctUtils::GetTensorData<uint64_t>(api_, param), scaleData_, static_cast<int64_t>(offsetData_)};
+    if (channelWise && chwSize != requantParam.channelNum * hwSize) {
+        ORT_CXX_API_THROW("AscendRequant needs one param per channel of axis 1.", ORT_INVALID_ARGUMENT);
+    }
+
+    // Setup output
+    OrtTensorDimensions dimensions(api_, inputX);
+    OrtValue* output = AmctUtils::GetKernelOutput(api_, context, 0, dimensions.data(), dimensions.size());
+    void* y = AmctUtils::GetTensorMutableData<void>(api_, output);
+
+    InputDataParam params = {x, y, static_cast<int64_t>(inputTensorType),
+        static_cast<int64_t>(ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8), inputSize, 0};
+    // registered on the CPU execution provider only, so the data is on the host in cuda builds as well
+    int ret = Requant(params, requantParam);
+    if (ret != 0) {
+        LOG_ERROR("Do AscendRequant compute failed, error code: %d.\n", ret);
+    }
+}
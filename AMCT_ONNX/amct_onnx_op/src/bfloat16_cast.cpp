@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief bfloat16 and float32 conversions
+ *
+ * @file bfloat16_cast.cpp
+ *
+ * @version 1.0
+ */
+
+#include <cstring>
+
+#include "cast_util.h"
+#include "util.h"
+
+namespace util {
+namespace {
+constexpr uint32_t FP32_ABS_MASK = 0x7fffffff;
+constexpr uint32_t FP32_INF_BITS = 0x7f800000;
+constexpr uint32_t BF16_ROUND_BIAS = 0x7fff;
+constexpr uint32_t BF16_QUIET_NAN_BIT = 0x40;
+
+// round to nearest even on the dropped half, a nan stays a (quiet) nan instead of rounding into inf
+inline uint16_t RoundToBf16(uint32_t bits)
+{
+    uint32_t rounded = (bits + BF16_ROUND_BIAS + ((bits >> BF16_SHIFT) & 1)) >> BF16_SHIFT;
+    uint32_t nan = (bits >> BF16_SHIFT) | BF16_QUIET_NAN_BIT;
+    return static_cast<uint16_t>((bits & FP32_ABS_MASK) > FP32_INF_BITS ? nan : rounded);
+}
+}
+
+float Bf16ToFp32(uint16_t inputData)
+{
+    CastTransData data;
+    data.y = static_cast<uint32_t>(inputData) << BF16_SHIFT;
+    return data.x;
+}
+
+uint16_t Fp32ToBf16(float inputData)
+{
+    CastTransData data;
+    data.x = inputData;
+    return RoundToBf16(data.y);
+}
+
+template <>
+void DataCastToBFloat16Functor<CPUDevice, float>::operator()(const float* in, uint16_t* out, int length) const
+{
+#pragma omp simd
+    for (int i = 0; i < length; ++i) {
+        uint32_t bits;
+        memcpy(&bits, in + i, sizeof(bits));
+        out[i] = RoundToBf16(bits);
+    }
+}
+
+template <>
+void DataCastFromBFloat16Functor<CPUDevice, float>::operator()(const uint16_t* in, float* out, int length) const
+{
+#pragma omp simd
+    for (int i = 0; i < length; ++i) {
+        uint32_t bits = static_cast<uint32_t>(in[i]) << BF16_SHIFT;
+        memcpy(out + i, &bits, sizeof(bits));
+    }
+}
+} // namespace util
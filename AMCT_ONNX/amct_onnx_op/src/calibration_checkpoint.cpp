@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief calibration_checkpoint C++ implementation
+ *
+ * @file calibration_checkpoint.cpp
+ *
+ * @version 1.0
+ */
+
+#include "calibration_checkpoint.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace AmctCommon {
+namespace {
+/**
+ * single background thread writing the queued snapshots, when a file is queued again before it is written
+ * only the latest snapshot is kept
+ */
+class CheckpointWriter {
+public:
+    static CheckpointWriter& Instance()
+    {
+        static CheckpointWriter writer;
+        return writer;
+    }
+
+    // state nullptr removes the file
+    void Push(const std::string& fileName, std::unique_ptr<CalibrationState> state)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!worker_.joinable()) {
+            worker_ = std::thread(&CheckpointWriter::Run, this);
+        }
+        if (pending_.find(fileName) == pending_.end()) {
+            order_.push_back(fileName);
+        }
+        pending_[fileName] = std::move(state);
+        cond_.notify_all();
+    }
+
+    void Flush()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idleCond_.wait(lock, [this] { return order_.empty() && !writing_; });
+    }
+
+    ~CheckpointWriter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+            cond_.notify_all();
+        }
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
+
+private:
+    CheckpointWriter() = default;
+
+    void Run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cond_.wait(lock, [this] { return stop_ || !order_.empty(); });
+            if (order_.empty()) {
+                // stop_ is only honoured once the queue is drained
+                return;
+            }
+            std::string fileName = order_.front();
+            order_.pop_front();
+            std::unique_ptr<CalibrationState> state = std::move(pending_[fileName]);
+            pending_.erase(fileName);
+            writing_ = true;
+            lock.unlock();
+            if (state == nullptr) {
+                (void)unlink(fileName.c_str());
+            } else if (SaveCalibrationState(fileName, *state) != SUCCESS) {
+                LOG_ERROR("Write calibration checkpoint %s failed.\n", fileName.c_str());
+            }
+            lock.lock();
+            writing_ = false;
+            idleCond_.notify_all();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::condition_variable idleCond_;
+    std::deque<std::string> order_;
+    std::map<std::string, std::unique_ptr<CalibrationState>> pending_;
+    std::thread worker_;
+    bool writing_{false};
+    bool stop_{false};
+};
+
+std::mutex g_resumedMutex;
+// keyed by layer and calibrator like the checkpoint file, ops of one layer resume independently
+std::map<std::pair<std::string, std::string>, int64_t> g_resumedBatches;
+
+void SetResumedBatches(const std::string& layerName, const std::string& calibrator, int64_t batchCount)
+{
+    std::lock_guard<std::mutex> lock(g_resumedMutex);
+    g_resumedBatches[std::make_pair(layerName, calibrator)] = batchCount;
+}
+
+bool ResumeRequested()
+{
+    const char* value = getenv(CHECKPOINT_RESUME_ENV);
+    return value != nullptr && value[0] != '\0' && std::string(value) != "0";
+}
+}
+
+void CalibrationCheckpoint::Init(CalibratorType type, const std::string& layerName)
+{
+    const char* dir = getenv(CHECKPOINT_DIR_ENV);
+    if (dir == nullptr || dir[0] == '\0') {
+        fileName_.clear();
+        return;
+    }
+    const char* interval = getenv(CHECKPOINT_INTERVAL_ENV);
+    interval_ = interval == nullptr ? DEFAULT_CHECKPOINT_INTERVAL : atoll(interval);
+    layerName_ = layerName;
+    calibrator_ = CalibratorTypeName(type);
+    std::string fileLayerName = layerName;
+    std::replace(fileLayerName.begin(), fileLayerName.end(), '/', '_');
+    fileName_ = std::string(dir) + "/" + fileLayerName + "." + calibrator_ + ".ckpt";
+}
+
+bool CalibrationCheckpoint::Resume(CalibrationState& state, int64_t batchNum) const
+{
+    if (!Enabled()) {
+        return false;
+    }
+    bool resumed = ResumeRequested() && ResumeFromFile(state, batchNum);
+    SetResumedBatches(layerName_, calibrator_, resumed ? static_cast<int64_t>(state.batchCount) : 0);
+    return resumed;
+}
+
+bool CalibrationCheckpoint::ResumeFromFile(CalibrationState& state, int64_t batchNum) const
+{
+    struct stat fileStat;
+    if (stat(fileName_.c_str(), &fileStat) != 0) {
+        return false;
+    }
+    CalibrationState checkpoint;
+    if (LoadCalibrationState(fileName_, checkpoint) != SUCCESS) {
+        return false;
+    }
+    // SearchNV2 broadcast follows the input shape, it is not known before the first batch
+    state.isBroadcast = checkpoint.isBroadcast;
+    if (!CalibrationStateMatches(checkpoint, state)) {
+        LOG_ERROR("Calibration checkpoint %s does not match the op, calibrate from the beginning.\n",
+            fileName_.c_str());
+        return false;
+    }
+    if (checkpoint.batchCount == 0 || static_cast<int64_t>(checkpoint.batchCount) >= batchNum) {
+        return false;
+    }
+    state = std::move(checkpoint);
+    return true;
+}
+
+void CalibrationCheckpoint::Save(CalibrationState&& state) const
+{
+    if (!Enabled()) {
+        return;
+    }
+    std::unique_ptr<CalibrationState> snapshot(new CalibrationState(std::move(state)));
+    CheckpointWriter::Instance().Push(fileName_, std::move(snapshot));
+}
+
+void CalibrationCheckpoint::Remove() const
+{
+    if (!Enabled()) {
+        return;
+    }
+    CheckpointWriter::Instance().Push(fileName_, nullptr);
+}
+
+void FlushCalibrationCheckpoints()
+{
+    CheckpointWriter::Instance().Flush();
+}
+} // namespace AmctCommon
+
+int AmctGetCheckpointResumedBatches(const char* layerName, const char* calibrator, int64_t* batchCount)
+{
+    NULLPTR_CHECK(layerName);
+    NULLPTR_CHECK(calibrator);
+    NULLPTR_CHECK(batchCount);
+    std::lock_guard<std::mutex> lock(AmctCommon::g_resumedMutex);
+    auto item = AmctCommon::g_resumedBatches.find(std::make_pair(std::string(layerName), std::string(calibrator)));
+    if (item == AmctCommon::g_resumedBatches.end()) {
+        return AmctCommon::RECORD_NOT_EXIT_ERROR;
+    }
+    *batchCount = item->second;
+    return AmctCommon::SUCCESS;
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief calibration_partials C++ implementation
+ *
+ * @file calibration_partials.cpp
+ *
+ * @version 1.0
+ */
+
+#include "calibration_partials.h"
+
+#include <algorithm>
+
+namespace AmctCommon {
+void CalibrationPartials::Init(const CalibrationState& prototype, PartialsOrder order)
+{
+    prototype_ = prototype;
+    order_ = order;
+    folded_ = prototype;
+}
+
+void CalibrationPartials::Reset(int64_t batch, CalibrationState&& initial)
+{
+    std::unique_lock<std::shared_timed_mutex> gate(gate_);
+    std::lock_guard<std::mutex> foldLock(foldMutex_);
+    std::lock_guard<std::mutex> lock(finishedMutex_);
+    if (order_ == PartialsOrder::BATCH) {
+        folded_ = std::move(initial);
+        foldedBatches_ = batch;
+        slots_.clear();
+    } else {
+        initial_.reset(new Partial{0, std::move(initial)});
+    }
+    claimed_ = batch;
+    finished_ = batch;
+    finishedPrefix_ = batch;
+    finishedAhead_.clear();
+}
+
+CalibrationPartials::Partial& CalibrationPartials::ThreadPartial(int64_t batch)
+{
+    std::lock_guard<std::mutex> lock(partialsMutex_);
+    auto& partial = partials_[std::this_thread::get_id()];
+    if (partial == nullptr) {
+        partial.reset(new Partial{batch, prototype_});
+    }
+    return *partial;
+}
+
+int64_t CalibrationPartials::MarkFinished(int64_t batch)
+{
+    std::lock_guard<std::mutex> lock(finishedMutex_);
+    if (batch == finishedPrefix_ + 1) {
+        finishedPrefix_++;
+        while (!finishedAhead_.empty() && *finishedAhead_.begin() == finishedPrefix_ + 1) {
+            finishedAhead_.erase(finishedAhead_.begin());
+            finishedPrefix_++;
+        }
+    } else {
+        finishedAhead_.insert(batch);
+    }
+    return ++finished_;
+}
+
+int64_t CalibrationPartials::Skip(int64_t batch)
+{
+    if (order_ == PartialsOrder::BATCH) {
+        // an empty slot lets the later batches be folded
+        return Fold(batch, nullptr);
+    }
+    std::shared_lock<std::shared_timed_mutex> gate(gate_);
+    return MarkFinished(batch);
+}
+
+int64_t CalibrationPartials::Fold(int64_t batch, std::function<void(CalibrationState&)> update)
+{
+    // the batch is counted finished under the same lock as the fold, so the call that finishes the last batch
+    // has folded every slot
+    std::lock_guard<std::mutex> lock(foldMutex_);
+    slots_[batch] = std::move(update);
+    while (!slots_.empty() && slots_.begin()->first == foldedBatches_ + 1) {
+        std::function<void(CalibrationState&)> next = std::move(slots_.begin()->second);
+        slots_.erase(slots_.begin());
+        if (next) {
+            next(folded_);
+        }
+        foldedBatches_++;
+    }
+    return MarkFinished(batch);
+}
+
+std::vector<CalibrationPartials::Partial*> CalibrationPartials::OrderedPartials()
+{
+    std::vector<Partial*> ordered;
+    if (initial_ != nullptr) {
+        ordered.push_back(initial_.get());
+    }
+    std::lock_guard<std::mutex> lock(partialsMutex_);
+    for (auto& item : partials_) {
+        ordered.push_back(item.second.get());
+    }
+    std::stable_sort(ordered.begin(), ordered.end(),
+        [](const Partial* a, const Partial* b) { return a->firstBatch < b->firstBatch; });
+    return ordered;
+}
+
+bool CalibrationPartials::Snapshot(CalibrationState& state)
+{
+    if (order_ == PartialsOrder::BATCH) {
+        std::lock_guard<std::mutex> lock(foldMutex_);
+        if (foldedBatches_ == 0) {
+            return false;
+        }
+        state = folded_;
+        state.batchCount = static_cast<uint64_t>(foldedBatches_);
+        return true;
+    }
+    std::unique_lock<std::shared_timed_mutex> gate(gate_);
+    int64_t batchCount = 0;
+    {
+        std::lock_guard<std::mutex> lock(finishedMutex_);
+        if (!finishedAhead_.empty() || finishedPrefix_ == 0) {
+            return false;
+        }
+        batchCount = finishedPrefix_;
+    }
+    std::vector<Partial*> partials = OrderedPartials();
+    for (size_t i = 0; i < partials.size(); i++) {
+        if (i == 0) {
+            state = partials[i]->state;
+        } else if (MergeCalibrationState(partials[i]->state, state) != SUCCESS) {
+            return false;
+        }
+    }
+    state.batchCount = static_cast<uint64_t>(batchCount);
+    return true;
+}
+
+Status CalibrationPartials::Merge(CalibrationState& state)
+{
+    if (order_ == PartialsOrder::BATCH) {
+        std::lock_guard<std::mutex> lock(foldMutex_);
+        if (!slots_.empty()) {
+            return GENERIC_ERROR;
+        }
+        state = std::move(folded_);
+        folded_ = prototype_;
+        foldedBatches_ = 0;
+        return SUCCESS;
+    }
+    std::unique_lock<std::shared_timed_mutex> gate(gate_);
+    std::vector<Partial*> partials = OrderedPartials();
+    Status ret = SUCCESS;
+    for (size_t i = 0; i < partials.size() && ret == SUCCESS; i++) {
+        if (i == 0) {
+            state = std::move(partials[i]->state);
+        } else {
+            ret = MergeCalibrationState(partials[i]->state, state);
+        }
+    }
+    initial_.reset();
+    std::lock_guard<std::mutex> lock(partialsMutex_);
+    partials_.clear();
+    return ret;
+}
+} // namespace AmctCommon
@@ -0,0 +1,708 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief calibration_state C++ implementation
+ *
+ * @file calibration_state.cpp
+ *
+ * @version 1.0
+ */
+
+#include "calibration_state.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+#include "search_n.h"
+#include "search_n_v2.h"
+#include "dmq_balance.h"
+#include "record_store.h"
+#include "fp8_quant.h"
+
+namespace AmctCommon {
+namespace {
+constexpr const char* SHARD_ID_ENV = "AMCT_SHARD_ID";
+
+class StateWriter {
+public:
+    template <typename T>
+    void Put(const T& value)
+    {
+        buffer_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void PutString(const std::string& str)
+    {
+        Put(static_cast<uint64_t>(str.size()));
+        buffer_.append(str);
+    }
+
+    template <typename T>
+    void PutVector(const std::vector<T>& data)
+    {
+        Put(static_cast<uint64_t>(data.size()));
+        buffer_.append(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(T));
+    }
+
+    // data and chunks stored as one vector
+    template <typename T>
+    void PutChunkedVector(const std::vector<T>& data, const std::vector<std::shared_ptr<const std::vector<T>>>& chunks)
+    {
+        uint64_t count = data.size();
+        for (auto& chunk : chunks) {
+            count += chunk->size();
+        }
+        Put(count);
+        buffer_.append(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(T));
+        for (auto& chunk : chunks) {
+            buffer_.append(reinterpret_cast<const char*>(chunk->data()), chunk->size() * sizeof(T));
+        }
+    }
+
+    const std::string& Buffer() const
+    {
+        return buffer_;
+    }
+
+private:
+    std::string buffer_;
+};
+
+class StateReader {
+public:
+    StateReader(const char* data, size_t size) : cur_(data), end_(data + size) {}
+
+    template <typename T>
+    bool Get(T& value)
+    {
+        if (static_cast<size_t>(end_ - cur_) < sizeof(T)) {
+            return false;
+        }
+        (void)memcpy(&value, cur_, sizeof(T));
+        cur_ += sizeof(T);
+        return true;
+    }
+
+    bool GetString(std::string& str)
+    {
+        uint64_t length = 0;
+        if (!Get(length) || static_cast<uint64_t>(end_ - cur_) < length) {
+            return false;
+        }
+        str.assign(cur_, length);
+        cur_ += length;
+        return true;
+    }
+
+    template <typename T>
+    bool GetVector(std::vector<T>& data)
+    {
+        uint64_t count = 0;
+        if (!Get(count) || static_cast<uint64_t>(end_ - cur_) / sizeof(T) < count) {
+            return false;
+        }
+        data.resize(count);
+        (void)memcpy(data.data(), cur_, count * sizeof(T));
+        cur_ += count * sizeof(T);
+        return true;
+    }
+
+    bool Finished() const
+    {
+        return cur_ == end_;
+    }
+
+private:
+    const char* cur_;
+    const char* end_;
+};
+
+void PutChannelData(StateWriter& writer, const std::vector<std::vector<float>>& channelData)
+{
+    writer.Put(static_cast<uint64_t>(channelData.size()));
+    for (auto& data : channelData) {
+        writer.PutVector(data);
+    }
+}
+
+bool GetChannelData(StateReader& reader, std::vector<std::vector<float>>& channelData)
+{
+    uint64_t channelNum = 0;
+    if (!reader.Get(channelNum)) {
+        return false;
+    }
+    channelData.clear();
+    for (uint64_t i = 0; i < channelNum; i++) {
+        std::vector<float> data;
+        if (!reader.GetVector(data)) {
+            return false;
+        }
+        channelData.push_back(std::move(data));
+    }
+    return true;
+}
+
+void PutPayload(StateWriter& writer, const CalibrationState& state)
+{
+    writer.Put(static_cast<uint64_t>(state.recordInfo.objectLayerNames.size()));
+    for (auto& layerName : state.recordInfo.objectLayerNames) {
+        writer.PutString(layerName);
+    }
+    writer.PutString(state.recordInfo.inputStamp);
+    writer.Put(static_cast<int32_t>(state.recordInfo.opDtype));
+    writer.PutString(state.recordInfo.fakeQuantPrecisionMode);
+    writer.PutString(state.recordInfo.dstType);
+    switch (state.type) {
+        case CalibratorType::IFMR:
+            writer.Put(state.ifmrParam.numBits);
+            writer.Put(static_cast<uint8_t>(state.ifmrParam.withOffset));
+            writer.Put(state.ifmrParam.startRatio);
+            writer.Put(state.ifmrParam.endRatio);
+            writer.Put(state.ifmrParam.step);
+            writer.Put(state.ifmrParam.maxPercentile);
+            writer.Put(state.ifmrParam.minPercentile);
+            writer.PutChunkedVector(state.data, state.dataChunks);
+            break;
+        case CalibratorType::HFMG:
+            writer.Put(state.hfmgParam.quantBitNum);
+            writer.Put(static_cast<uint8_t>(state.hfmgParam.withOffset));
+            writer.Put(state.hfmgParam.nbins);
+            writer.Put(static_cast<uint64_t>(state.bins.size()));
+            for (auto& bin : state.bins) {
+                writer.Put(bin.count);
+                writer.Put(bin.lowerBound);
+                writer.Put(bin.higherBound);
+            }
+            break;
+        case CalibratorType::SEARCH_N:
+            writer.PutVector(state.deqScale);
+            PutChannelData(writer, state.channelData);
+            break;
+        case CalibratorType::SEARCH_N_V2:
+            writer.Put(static_cast<uint8_t>(state.isBroadcast));
+            PutChannelData(writer, state.channelData);
+            break;
+        case CalibratorType::DMQ_BALANCE:
+            writer.Put(state.migrationStrength);
+            writer.Put(state.channelNum);
+            writer.PutVector(state.actMax);
+            writer.PutVector(state.wtsMax);
+            break;
+    }
+}
+
+bool GetHfmgPayload(StateReader& reader, CalibrationState& state)
+{
+    uint8_t withOffset = 0;
+    uint64_t binNum = 0;
+    if (!reader.Get(state.hfmgParam.quantBitNum) || !reader.Get(withOffset) ||
+        !reader.Get(state.hfmgParam.nbins) || !reader.Get(binNum)) {
+        return false;
+    }
+    state.hfmgParam.withOffset = withOffset != 0;
+    state.bins.clear();
+    for (uint64_t i = 0; i < binNum; i++) {
+        DataBin<float> bin(0, 0, 0);
+        if (!reader.Get(bin.count) || !reader.Get(bin.lowerBound) || !reader.Get(bin.higherBound)) {
+            return false;
+        }
+        state.bins.push_back(bin);
+    }
+    return true;
+}
+
+bool GetPayload(StateReader& reader, CalibrationState& state)
+{
+    uint64_t layerNum = 0;
+    if (!reader.Get(layerNum)) {
+        return false;
+    }
+    state.recordInfo.objectLayerNames.resize(0);
+    for (uint64_t i = 0; i < layerNum; i++) {
+        std::string layerName;
+        if (!reader.GetString(layerName)) {
+            return false;
+        }
+        state.recordInfo.objectLayerNames.push_back(layerName);
+    }
+    int32_t opDtype = 0;
+    if (!reader.GetString(state.recordInfo.inputStamp) || !reader.Get(opDtype) ||
+        !reader.GetString(state.recordInfo.fakeQuantPrecisionMode) || !reader.GetString(state.recordInfo.dstType)) {
+        return false;
+    }
+    state.recordInfo.opDtype = opDtype;
+    uint8_t flag = 0;
+    switch (state.type) {
+        case CalibratorType::IFMR:
+            if (!reader.Get(state.ifmrParam.numBits) || !reader.Get(flag) || !reader.Get(state.ifmrParam.startRatio) ||
+                !reader.Get(state.ifmrParam.endRatio) || !reader.Get(state.ifmrParam.step) ||
+                !reader.Get(state.ifmrParam.maxPercentile) || !reader.Get(state.ifmrParam.minPercentile)) {
+                return false;
+            }
+            state.ifmrParam.withOffset = flag != 0;
+            state.ifmrParam.calibration = 0;
+            state.ifmrParam.needDump = false;
+            return reader.GetVector(state.data);
+        case CalibratorType::HFMG:
+            return GetHfmgPayload(reader, state);
+        case CalibratorType::SEARCH_N:
+            return reader.GetVector(state.deqScale) && GetChannelData(reader, state.channelData);
+        case CalibratorType::SEARCH_N_V2:
+            if (!reader.Get(flag)) {
+                return false;
+            }
+            state.isBroadcast = flag != 0;
+            return GetChannelData(reader, state.channelData);
+        case CalibratorType::DMQ_BALANCE:
+            return reader.Get(state.migrationStrength) && reader.Get(state.channelNum) &&
+                reader.GetVector(state.actMax) && reader.GetVector(state.wtsMax);
+        default:
+            return false;
+    }
+}
+
+bool SameParams(const CalibrationState& src, const CalibrationState& dst)
+{
+    if (src.type != dst.type || src.recordInfo.objectLayerNames != dst.recordInfo.objectLayerNames ||
+        src.recordInfo.dstType != dst.recordInfo.dstType) {
+        return false;
+    }
+    switch (src.type) {
+        case CalibratorType::IFMR:
+            return src.ifmrParam.numBits == dst.ifmrParam.numBits &&
+                src.ifmrParam.withOffset == dst.ifmrParam.withOffset &&
+                src.ifmrParam.startRatio == dst.ifmrParam.startRatio &&
+                src.ifmrParam.endRatio == dst.ifmrParam.endRatio && src.ifmrParam.step == dst.ifmrParam.step &&
+                src.ifmrParam.maxPercentile == dst.ifmrParam.maxPercentile &&
+                src.ifmrParam.minPercentile == dst.ifmrParam.minPercentile;
+        case CalibratorType::HFMG:
+            return src.hfmgParam.quantBitNum == dst.hfmgParam.quantBitNum &&
+                src.hfmgParam.withOffset == dst.hfmgParam.withOffset && src.hfmgParam.nbins == dst.hfmgParam.nbins;
+        case CalibratorType::SEARCH_N:
+            return src.deqScale == dst.deqScale;
+        case CalibratorType::SEARCH_N_V2:
+            return src.isBroadcast == dst.isBroadcast;
+        case CalibratorType::DMQ_BALANCE:
+            return src.migrationStrength == dst.migrationStrength && src.channelNum == dst.channelNum;
+        default:
+            return false;
+    }
+}
+
+// spread every source bin uniformly over the equal width bins of [lower, higher], as HFMG assumes inside a bin
+void SpreadBins(const std::vector<DataBin<float>>& bins, double lower, double width, std::vector<double>& counts)
+{
+    int64_t lastBin = static_cast<int64_t>(counts.size()) - 1;
+    for (auto& bin : bins) {
+        if (bin.count == 0) {
+            continue;
+        }
+        double binWidth = static_cast<double>(bin.higherBound) - bin.lowerBound;
+        if (binWidth <= 0 || width <= 0) {
+            int64_t pos = width > 0 ? static_cast<int64_t>((bin.lowerBound - lower) / width) : 0;
+            counts[std::max<int64_t>(0, std::min(pos, lastBin))] += bin.count;
+            continue;
+        }
+        int64_t first = std::max<int64_t>(0, static_cast<int64_t>((bin.lowerBound - lower) / width));
+        int64_t last = std::min(lastBin, static_cast<int64_t>((bin.higherBound - lower) / width));
+        for (int64_t j = first; j <= last; j++) {
+            double overlap = std::min(lower + (j + 1) * width, static_cast<double>(bin.higherBound)) -
+                std::max(lower + j * width, static_cast<double>(bin.lowerBound));
+            if (overlap > 0) {
+                counts[j] += bin.count * overlap / binWidth;
+            }
+        }
+    }
+}
+
+void MergeHistogram(const std::vector<DataBin<float>>& src, unsigned int nbins, std::vector<DataBin<float>>& dst)
+{
+    if (src.empty()) {
+        return;
+    }
+    if (dst.empty()) {
+        dst = src;
+        return;
+    }
+    uint64_t total = 0;
+    for (auto& bin : src) {
+        total += bin.count;
+    }
+    for (auto& bin : dst) {
+        total += bin.count;
+    }
+    float lower = std::min(src.front().lowerBound, dst.front().lowerBound);
+    float higher = std::max(src.back().higherBound, dst.back().higherBound);
+    nbins = nbins == 0 ? static_cast<unsigned int>(dst.size()) : nbins;
+    double width = (static_cast<double>(higher) - lower) / nbins;
+    std::vector<double> counts(nbins, 0);
+    SpreadBins(src, lower, width, counts);
+    SpreadBins(dst, lower, width, counts);
+
+    // largest remainder rounding keeps the total element count
+    std::vector<DataBin<float>> merged;
+    std::vector<std::pair<double, size_t>> remainders;
+    uint64_t assigned = 0;
+    for (unsigned int j = 0; j < nbins; j++) {
+        double floorCount = std::floor(counts[j]);
+        assigned += static_cast<uint64_t>(floorCount);
+        remainders.push_back({counts[j] - floorCount, j});
+        merged.push_back(DataBin<float>(static_cast<unsigned int>(floorCount), static_cast<float>(lower + j * width),
+            static_cast<float>(lower + (j + 1) * width)));
+    }
+    std::stable_sort(remainders.begin(), remainders.end(),
+        [](const std::pair<double, size_t>& a, const std::pair<double, size_t>& b) { return a.first > b.first; });
+    for (size_t i = 0; assigned < total && i < remainders.size(); i++, assigned++) {
+        merged[remainders[i].second].count++;
+    }
+    merged.back().higherBound = higher;
+    dst.swap(merged);
+}
+
+Status RecordScaleOffsetResult(const CalibrationState& state, float scale, int offset, unsigned int numBits,
+    const std::string& recordFileName)
+{
+    std::string inputStamp = state.recordInfo.inputStamp;
+    int opDtype = (inputStamp == "weight" || inputStamp == "initial_h") ? 0 : state.recordInfo.opDtype;
+    std::string quantType;
+    Fp8Format fp8Format;
+    if (GetFp8Format(state.recordInfo.dstType, fp8Format)) {
+        IntScaleToFp8Scale(numBits, fp8Format, scale, offset);
+        quantType = state.recordInfo.dstType;
+    }
+    util::RecordData<int> recordData = {
+        scale, offset, {}, inputStamp, opDtype, numBits, state.recordInfo.fakeQuantPrecisionMode, quantType};
+    for (auto& layerName : state.recordInfo.objectLayerNames) {
+        Status ret = RecordStore::Instance().RecordScaleOffset(recordFileName, layerName, recordData);
+        CHECK_OK(ret);
+    }
+    return SUCCESS;
+}
+
+template <typename T>
+Status RecordRepeatResult(const CalibrationState& state, const std::vector<T>& data, const std::string& dataType,
+    const std::string& recordFileName)
+{
+    for (auto& layerName : state.recordInfo.objectLayerNames) {
+        Status ret = RecordStore::Instance().RecordRepeatData(recordFileName, layerName, data, dataType);
+        CHECK_OK(ret);
+    }
+    return SUCCESS;
+}
+
+Status FinalizeSearchN(const CalibrationState& state, const std::string& recordFileName)
+{
+    if (state.channelData.empty() || state.deqScale.size() != state.channelData.size()) {
+        return BAD_PARAMETERS_ERROR;
+    }
+    std::vector<std::vector<int>> int32Data(state.channelData.size());
+    for (size_t i = 0; i < state.channelData.size(); ++i) {
+        if (state.deqScale[i] == 0.0) {
+            return ZERO_DIVISION_ERROR;
+        }
+        int32Data[i].resize(state.channelData[i].size());
+        for (size_t j = 0; j < state.channelData[i].size(); ++j) {
+            int32Data[i][j] = round(state.channelData[i][j] / state.deqScale[i]);
+        }
+    }
+    std::vector<int> bestN;
+    SearchShiftBits(int32Data, bestN);
+    return RecordRepeatResult(state, bestN, "shift_bit", recordFileName);
+}
+
+Status FinalizeDmqBalance(const CalibrationState& state, const std::string& recordFileName)
+{
+    if (state.actMax.size() != state.channelNum || state.wtsMax.size() != state.channelNum) {
+        return BAD_PARAMETERS_ERROR;
+    }
+    // the per-channel maxima are all DMQBalance reduces the tensors to
+    std::vector<float> actMax = state.actMax;
+    std::vector<float> wtsMax = state.wtsMax;
+    util::FloatData act = {state.channelNum, actMax.data()};
+    util::FloatData wts = {state.channelNum, wtsMax.data()};
+    std::vector<float> dmqbFactor(state.channelNum, 0);
+    Status ret = DMQBalance(act, wts, state.migrationStrength, state.channelNum, dmqbFactor.data());
+    CHECK_OK(ret);
+    ret = util::CheckBalanceFactor(dmqbFactor.data(), state.channelNum);
+    CHECK_OK(ret);
+    return RecordRepeatResult(state, dmqbFactor, "tensor_balance_factor", recordFileName);
+}
+}
+
+Status SaveCalibrationState(const std::string& fileName, const CalibrationState& state)
+{
+    StateWriter writer;
+    writer.Put(CALIBRATION_STATE_MAGIC);
+    writer.Put(CALIBRATION_STATE_VERSION);
+    writer.Put(static_cast<uint32_t>(state.type));
+    writer.Put(state.batchCount);
+    PutPayload(writer, state);
+
+    std::string tmpFileName = fileName + ".tmp." + std::to_string(getpid());
+    std::ofstream out(tmpFileName, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        LOG_ERROR("Open calibration state file %s failed.\n", tmpFileName.c_str());
+        return RECORD_FILE_OPEN_ERROR;
+    }
+    out.write(writer.Buffer().data(), static_cast<std::streamsize>(writer.Buffer().size()));
+    out.close();
+    if (out.fail() || rename(tmpFileName.c_str(), fileName.c_str()) != 0) {
+        LOG_ERROR("Write calibration state file %s failed.\n", fileName.c_str());
+        (void)unlink(tmpFileName.c_str());
+        return RECORD_FILE_ERROR;
+    }
+    return SUCCESS;
+}
+
+Status LoadCalibrationState(const std::string& fileName, CalibrationState& state)
+{
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in.is_open()) {
+        LOG_ERROR("Open calibration state file %s failed.\n", fileName.c_str());
+        return RECORD_FILE_OPEN_ERROR;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string content = buffer.str();
+    StateReader reader(content.data(), content.size());
+    char magic[sizeof(CALIBRATION_STATE_MAGIC)];
+    uint32_t version = 0;
+    uint32_t type = 0;
+    bool valid = reader.Get(magic) && memcmp(magic, CALIBRATION_STATE_MAGIC, sizeof(magic)) == 0 &&
+        reader.Get(version) && version == CALIBRATION_STATE_VERSION && reader.Get(type) &&
+        reader.Get(state.batchCount);
+    state.type = static_cast<CalibratorType>(type);
+    if (!valid || !GetPayload(reader, state) || !reader.Finished()) {
+        LOG_ERROR("Calibration state file %s is invalid.\n", fileName.c_str());
+        return RECORD_FILE_PARSE_ERROR;
+    }
+    return SUCCESS;
+}
+
+bool CalibrationStateMatches(const CalibrationState& lhs, const CalibrationState& rhs)
+{
+    return SameParams(lhs, rhs);
+}
+
+Status MergeCalibrationState(const CalibrationState& src, CalibrationState& dst)
+{
+    if (!SameParams(src, dst)) {
+        LOG_ERROR("Can not merge calibration states of different ops or attributes.\n");
+        return BAD_PARAMETERS_ERROR;
+    }
+    switch (src.type) {
+        case CalibratorType::IFMR:
+            if (dst.dataChunks.empty()) {
+                dst.data.insert(dst.data.end(), src.data.begin(), src.data.end());
+            } else if (!src.data.empty()) {
+                dst.dataChunks.push_back(std::make_shared<const std::vector<float>>(src.data));
+            }
+            dst.dataChunks.insert(dst.dataChunks.end(), src.dataChunks.begin(), src.dataChunks.end());
+            break;
+        case CalibratorType::HFMG:
+            MergeHistogram(src.bins, dst.hfmgParam.nbins, dst.bins);
+            break;
+        case CalibratorType::SEARCH_N:
+            if (dst.channelData.empty()) {
+                dst.channelData.resize(src.channelData.size());
+            }
+            if (!src.channelData.empty() && src.channelData.size() != dst.channelData.size()) {
+                return BAD_PARAMETERS_ERROR;
+            }
+            for (size_t i = 0; i < src.channelData.size(); i++) {
+                dst.channelData[i].insert(dst.channelData[i].end(), src.channelData[i].begin(),
+                    src.channelData[i].end());
+            }
+            break;
+        case CalibratorType::SEARCH_N_V2:
+            if (dst.channelData.empty()) {
+                dst.channelData = src.channelData;
+                break;
+            }
+            if (!src.channelData.empty() && src.channelData.size() != dst.channelData.size()) {
+                return BAD_PARAMETERS_ERROR;
+            }
+            for (size_t i = 0; i < src.channelData.size(); i++) {
+                if (src.channelData[i].size() != dst.channelData[i].size()) {
+                    return BAD_PARAMETERS_ERROR;
+                }
+                for (size_t j = 0; j < src.channelData[i].size(); j++) {
+                    dst.channelData[i][j] += src.channelData[i][j];
+                }
+            }
+            break;
+        case CalibratorType::DMQ_BALANCE:
+            if (src.actMax.size() != dst.actMax.size() || src.wtsMax.size() != dst.wtsMax.size()) {
+                return BAD_PARAMETERS_ERROR;
+            }
+            for (size_t i = 0; i < src.actMax.size(); i++) {
+                dst.actMax[i] = std::max(dst.actMax[i], src.actMax[i]);
+            }
+            for (size_t i = 0; i < src.wtsMax.size(); i++) {
+                dst.wtsMax[i] = std::max(dst.wtsMax[i], src.wtsMax[i]);
+            }
+            break;
+        default:
+            return BAD_PARAMETERS_ERROR;
+    }
+    dst.batchCount += src.batchCount;
+    return SUCCESS;
+}
+
+Status FinalizeCalibrationState(const CalibrationState& state, const std::string& recordFileName)
+{
+    Status ret = SUCCESS;
+    float scale = 0;
+    int offset = 0;
+    util::FloatData scaleData = {1, &scale};
+    util::IntData offsetData = {1, &offset};
+    switch (state.type) {
+        case CalibratorType::IFMR: {
+            CalibrationState flatState = state;
+            FlattenDataChunks(flatState);
+            std::vector<float>& data = flatState.data;
+            if (data.empty()) {
+                return CONTAINER_EMPTY_ERROR;
+            }
+            ret = IfmrQuant(data.data(), data.size(), state.ifmrParam, scaleData, offsetData);
+            CHECK_OK(ret);
+            ret = RecordScaleOffsetResult(state, scale, offset, state.ifmrParam.numBits, recordFileName);
+            break;
+        }
+        case CalibratorType::HFMG: {
+            std::vector<DataBin<float>> bins = state.bins;
+            ret = HfmgCompute(bins, scale, offset, state.hfmgParam);
+            CHECK_OK(ret);
+            ret = RecordScaleOffsetResult(state, scale, offset, state.hfmgParam.quantBitNum, recordFileName);
+            break;
+        }
+        case CalibratorType::SEARCH_N:
+            ret = FinalizeSearchN(state, recordFileName);
+            break;
+        case CalibratorType::SEARCH_N_V2: {
+            std::vector<std::vector<float>> errors = state.channelData;
+            std::vector<int> bestN(errors.size());
+            util::IntData bestNData = {static_cast<unsigned int>(bestN.size()), bestN.data()};
+            ret = SearchNV2FindBestNCpu(errors, bestNData, state.isBroadcast);
+            CHECK_OK(ret);
+            ret = RecordRepeatResult(state, bestN, "shift_bit", recordFileName);
+            break;
+        }
+        case CalibratorType::DMQ_BALANCE:
+            ret = FinalizeDmqBalance(state, recordFileName);
+            break;
+        default:
+            return BAD_PARAMETERS_ERROR;
+    }
+    CHECK_OK(ret);
+    return RecordStore::Instance().Flush(recordFileName);
+}
+
+void FlattenDataChunks(CalibrationState& state)
+{
+    size_t count = state.data.size();
+    for (auto& chunk : state.dataChunks) {
+        count += chunk->size();
+    }
+    state.data.reserve(count);
+    for (auto& chunk : state.dataChunks) {
+        state.data.insert(state.data.end(), chunk->begin(), chunk->end());
+    }
+    state.dataChunks.clear();
+}
+
+void ChannelAbsMax(const float* data, size_t length, uint32_t channelNum, std::vector<float>& absMax)
+{
+    absMax.assign(channelNum, 0);
+    if (channelNum == 0) {
+        return;
+    }
+    size_t channelSize = length / channelNum;
+    for (uint32_t c = 0; c < channelNum; c++) {
+        const float* channelData = data + c * channelSize;
+        float channelMax = 0;
+#pragma omp simd reduction(max:channelMax)
+        for (size_t i = 0; i < channelSize; i++) {
+            float absValue = std::fabs(channelData[i]);
+            channelMax = absValue > channelMax ? absValue : channelMax;
+        }
+        absMax[c] = channelMax;
+    }
+}
+
+std::string GetPartialStateDir()
+{
+    const char* dir = getenv(PARTIAL_STATE_DIR_ENV);
+    return dir == nullptr ? "" : dir;
+}
+
+const char* CalibratorTypeName(CalibratorType type)
+{
+    static const char* typeNames[] = {"unknown", "ifmr", "hfmg", "search_n", "search_n_v2", "dmq_balance"};
+    uint32_t index = static_cast<uint32_t>(type);
+    return index < sizeof(typeNames) / sizeof(typeNames[0]) ? typeNames[index] : typeNames[0];
+}
+
+std::string GetCalibrationStateFileName(const std::string& dir, const std::string& layerName, CalibratorType type)
+{
+    std::string fileLayerName = layerName;
+    std::replace(fileLayerName.begin(), fileLayerName.end(), '/', '_');
+    const char* shardId = getenv(SHARD_ID_ENV);
+    std::string shard = shardId == nullptr ? std::to_string(getpid()) : shardId;
+    return dir + "/" + fileLayerName + "." + CalibratorTypeName(type) + "." + shard + ".state";
+}
+
+Status SavePartialCalibrationState(const std::string& stateDir, const CalibrationState& state)
+{
+    if (state.recordInfo.objectLayerNames.empty()) {
+        return BAD_PARAMETERS_ERROR;
+    }
+    std::string fileName = GetCalibrationStateFileName(stateDir, state.recordInfo.objectLayerNames[0], state.type);
+    Status ret = SaveCalibrationState(fileName, state);
+    if (ret != SUCCESS) {
+        LOG_ERROR("Save partial calibration state of \"%s\" failed, error code: %d.\n",
+            state.recordInfo.objectLayerNames[0].c_str(), ret);
+    }
+    return ret;
+}
+} // namespace AmctCommon
+
+int AmctMergeCalibrationStates(const char* const* stateFiles, int stateNum, const char* recordFileName,
+    const char* mergedStateFile)
+{
+    NULLPTR_CHECK(stateFiles);
+    NULLPTR_CHECK(recordFileName);
+    if (stateNum <= 0) {
+        return AmctCommon::BAD_PARAMETERS_ERROR;
+    }
+    AmctCommon::CalibrationState merged;
+    for (int i = 0; i < stateNum; i++) {
+        NULLPTR_CHECK(stateFiles[i]);
+        AmctCommon::CalibrationState state;
+        int ret = AmctCommon::LoadCalibrationState(stateFiles[i], i == 0 ? merged : state);
+        CHECK_OK(ret);
+        if (i > 0) {
+            ret = AmctCommon::MergeCalibrationState(state, merged);
+            CHECK_OK(ret);
+        }
+    }
+    if (mergedStateFile != nullptr) {
+        int ret = AmctCommon::SaveCalibrationState(mergedStateFile, merged);
+        CHECK_OK(ret);
+    }
+    return AmctCommon::FinalizeCalibrationState(merged, recordFileName);
+}
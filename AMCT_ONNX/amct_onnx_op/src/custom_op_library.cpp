@@ -30,11 +30,19 @@
 #include "ascend_quant_kernel.h"
 #include "ascend_dequant_kernel.h"
 #include "ascend_antiquant_kernel.h"
+#include "ascend_group_quant_kernel.h"
+#include "ascend_group_antiquant_kernel.h"
+#include "dynamic_ascend_quant_kernel.h"
+#include "ascend_nuq_antiquant_kernel.h"
+#include "ascend_requant_kernel.h"
 #include "dmq_balance_kernel.h"
 #include "hfmg_kernel.h"
 #include "search_n.h"
 #include "util.h"
 #include "dump_kernel.h"
+#include "yolo_nms_kernel.h"
+#include "image_preprocess_kernel.h"
+#include "softmax_topk_kernel.h"
 
 
 struct OrtCustomOpDomainDeleter {
@@ -254,7 +262,7 @@ public:
 #endif
     void* CreateKernel(const OrtApi& api, const OrtKernelInfo* info) const
     {
-        return new AscendQuantKernel(api, info);
+        return new AscendQuantKernel(api, info, GetOutputType(0));
     }
     const char* GetExecutionProviderType() const
     {
@@ -399,6 +407,338 @@ private:
 #endif
 
 
+// weight only quantized models, int8 input holding two int4 values per byte
+struct AscendAntiQuantInt4Op : Ort::CustomOpBase<AscendAntiQuantInt4Op, AntiQuantKernel> {
+public:
+    explicit AscendAntiQuantInt4Op(const char* provider, void* compute_stream) : provider_(provider),
+        compute_stream_(compute_stream) {}
+#if ORT_API_VERSION >= 16
+    OrtStatusPtr CreateKernelV2(const OrtApi& api, const OrtKernelInfo* info, void* kernel) const
+    {
+        kernel = CreateKernel(api, info);
+        return api.CreateStatus(ORT_OK, "Success");
+    }
+#endif
+    void* CreateKernel(const OrtApi& api, const OrtKernelInfo* info) const
+    {
+        return new AntiQuantKernel(api, info, AntiQuantSource::INT4);
+    }
+    virtual const char* GetName() const
+    {
+        return "AscendAntiQuantInt4";
+    }
+    const char* GetExecutionProviderType() const
+    {
+        return provider_;
+    }
+    size_t GetOutputTypeCount() const
+    {
+        return 1;
+    }
+    virtual ONNXTensorElementDataType GetOutputType(size_t) const
+    {
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+    }
+    size_t GetInputTypeCount() const
+    {
+        return 1;
+    }
+    ONNXTensorElementDataType GetInputType(size_t) const
+    {
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8;
+    }
+
+private:
+    const char* provider_;
+    void* compute_stream_;
+};
+
+AscendAntiQuantInt4Op g_cAscendAntiQuantInt4Op{"CPUExecutionProvider", nullptr};
+
+// int8 input holding fp8 bits, FP8_E4M3 unless src_type is FP8_E5M2
+struct AscendAntiQuantFp8Op : Ort::CustomOpBase<AscendAntiQuantFp8Op, AntiQuantKernel> {
+public:
+    explicit AscendAntiQuantFp8Op(const char* provider, void* compute_stream) : provider_(provider),
+        compute_stream_(compute_stream) {}
+#if ORT_API_VERSION >= 16
+    OrtStatusPtr CreateKernelV2(const OrtApi& api, const OrtKernelInfo* info, void* kernel) const
+    {
+        kernel = CreateKernel(api, info);
+        return api.CreateStatus(ORT_OK, "Success");
+    }
+#endif
+    void* CreateKernel(const OrtApi& api, const OrtKernelInfo* info) const
+    {
+        return new AntiQuantKernel(api, info, AntiQuantSource::FP8);
+    }
+    const char* GetName() const
+    {
+        return "AscendAntiQuantFp8";
+    }
+    const char* GetExecutionProviderType() const
+    {
+        return provider_;
+    }
+    size_t GetOutputTypeCount() const
+    {
+        return 1;
+    }
+    ONNXTensorElementDataType GetOutputType(size_t) const
+    {
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+    }
+    size_t GetInputTypeCount() const
+    {
+        return 1;
+    }
+    ONNXTensorElementDataType GetInputType(size_t) const
+    {
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8;
+    }
+
+private:
+    const char* provider_;
+    void* compute_stream_;
+};
+
+AscendAntiQuantFp8Op g_cAscendAntiQuantFp8Op{"CPUExecutionProvider", nullptr};
+
+
+// weight quantization with a scale and offset per group of group_size elements along axis
+struct AscendGroupQuantOp : Ort::CustomOpBase<AscendGroupQuantOp, AscendGroupQuantKernel> {
+public:
+    explicit AscendGroupQuantOp(const char* provider, void* compute_stream) : provider_(provider),
+        compute_stream_(compute_stream) {}
+#if ORT_API_VERSION >= 16
+    OrtStatusPtr CreateKernelV2(const OrtApi& api, const OrtKernelInfo* info, void* kernel) const
+    {
+        kernel = CreateKernel(api, info);
+        return api.CreateStatus(ORT_OK, "Success");
+    }
+#endif
+    void* CreateKernel(const OrtApi& api, const OrtKernelInfo* info) const
+    {
+        return new AscendGroupQuantKernel(api, info);
+    }
+    const char* GetName() const
+    {
+        return "AscendGroupQuant";
+    }
+    const char* GetExecutionProviderType() const
+    {
+        return provider_;
+    }
+    size_t GetInputTypeCount() const
+    {
+        return NUM_THREE;
+    }
+    ONNXTensorElementDataType GetInputType(size_t index) const
+    {
+        if (index == 0) {
+            return AmctUtils::AmctOpDynamicTypeCheck();
+        }
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+    }
+    size_t GetOutputTypeCount() const
+    {
+        return 1;
+    }
+    virtual ONNXTensorElementDataType GetOutputType(size_t) const
+    {
+        return AmctUtils::AmctOpDynamicTypeCheck();
+    }
+
+private:
+    const char* provider_;
+    void* compute_stream_;
+};
+
+AscendGroupQuantOp g_cAscendGroupQuantOp{"CPUExecutionProvider", nullptr};
+
+
+struct AscendGroupAntiQuantOp : Ort::CustomOpBase<AscendGroupAntiQuantOp, AscendGroupAntiQuantKernel> {
+public:
+    explicit AscendGroupAntiQuantOp(const char* provider, void* compute_stream) : provider_(provider),
+        compute_stream_(compute_stream) {}
+#if ORT_API_VERSION >= 16
+    OrtStatusPtr CreateKernelV2(const OrtApi& api, const OrtKernelInfo* info, void* kernel) const
+    {
+        kernel = CreateKernel(api, info);
+        return api.CreateStatus(ORT_OK, "Success");
+    }
+#endif
+    void* CreateKernel(const OrtApi& api, const OrtKernelInfo* info) const
+    {
+        return new AscendGroupAntiQuantKernel(api, info);
+    }
+    const char* GetName() const
+    {
+        return "AscendGroupAntiQuant";
+    }
+    const char* GetExecutionProviderType() const
+    {
+        return provider_;
+    }
+    size_t GetInputTypeCount() const
+    {
+        return NUM_THREE;
+    }
+    ONNXTensorElementDataType GetInputType(size_t index) const
+    {
+        if (index == 0) {
+            return AmctUtils::AmctOpDynamicTypeCheck();
+        }
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+    }
+    size_t GetOutputTypeCount() const
+    {
+        return 1;
+    }
+    virtual ONNXTensorElementDataType GetOutputType(size_t) const
+    {
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+    }
+
+private:
+    const char* provider_;
+    void* compute_stream_;
+};
+
+AscendGroupAntiQuantOp g_cAscendGroupAntiQuantOp{"CPUExecutionProvider", nullptr};
+
+
+// activation quantization with the scale and offset taken from the min/max of each run
+struct DynamicAscendQuantOp : Ort::CustomOpBase<DynamicAscendQuantOp, DynamicAscendQuantKernel> {
+public:
+#if ORT_API_VERSION >= 16
+    OrtStatusPtr CreateKernelV2(const OrtApi& api, const OrtKernelInfo* info, void* kernel) const
+    {
+        kernel = CreateKernel(api, info);
+        return api.CreateStatus(ORT_OK, "Success");
+    }
+#endif
+    void* CreateKernel(const OrtApi& api, const OrtKernelInfo* info) const
+    {
+        return new DynamicAscendQuantKernel(api, info);
+    }
+    const char* GetName() const
+    {
+        return "DynamicAscendQuant";
+    }
+    size_t GetInputTypeCount() const
+    {
+        return 1;
+    }
+    ONNXTensorElementDataType GetInputType(size_t) const
+    {
+        return AmctUtils::AmctOpDynamicTypeCheck();
+    }
+    size_t GetOutputTypeCount() const
+    {
+        return NUM_THREE;
+    }
+    ONNXTensorElementDataType GetOutputType(size_t index) const
+    {
+        if (index == 0) {
+            return ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8;
+        }
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+    }
+} g_cDynamicAscendQuantOp;
+
+
+// nuq weights kept as uint8 codes plus their centroid table
+struct AscendNuqAntiQuantOp : Ort::CustomOpBase<AscendNuqAntiQuantOp, AscendNuqAntiQuantKernel> {
+public:
+    explicit AscendNuqAntiQuantOp(const char* provider, void* compute_stream) : provider_(provider),
+        compute_stream_(compute_stream) {}
+#if ORT_API_VERSION >= 16
+    OrtStatusPtr CreateKernelV2(const OrtApi& api, const OrtKernelInfo* info, void* kernel) const
+    {
+        kernel = CreateKernel(api, info);
+        return api.CreateStatus(ORT_OK, "Success");
+    }
+#endif
+    void* CreateKernel(const OrtApi& api, const OrtKernelInfo* info) const
+    {
+        return new AscendNuqAntiQuantKernel(api, info);
+    }
+    const char* GetName() const
+    {
+        return "AscendNuqAntiQuant";
+    }
+    const char* GetExecutionProviderType() const
+    {
+        return provider_;
+    }
+    size_t GetInputTypeCount() const
+    {
+        return NUM_TWO;
+    }
+    ONNXTensorElementDataType GetInputType(size_t index) const
+    {
+        if (index == 0) {
+            return ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8;
+        }
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+    }
+    size_t GetOutputTypeCount() const
+    {
+        return 1;
+    }
+    virtual ONNXTensorElementDataType GetOutputType(size_t) const
+    {
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+    }
+
+private:
+    const char* provider_;
+    void* compute_stream_;
+};
+
+AscendNuqAntiQuantOp g_cAscendNuqAntiQuantOp{"CPUExecutionProvider", nullptr};
+
+
+// int32 accumulators with the AscendDequant params straight to the int8 input of the next layer
+struct AscendRequantOp : Ort::CustomOpBase<AscendRequantOp, AscendRequantKernel> {
+public:
+#if ORT_API_VERSION >= 16
+    OrtStatusPtr CreateKernelV2(const OrtApi& api, const OrtKernelInfo* info, void* kernel) const
+    {
+        kernel = CreateKernel(api, info);
+        return api.CreateStatus(ORT_OK, "Success");
+    }
+#endif
+    void* CreateKernel(const OrtApi& api, const OrtKernelInfo* info) const
+    {
+        return new AscendRequantKernel(api, info);
+    }
+    const char* GetName() const
+    {
+        return "AscendRequant";
+    }
+    size_t GetInputTypeCount() const
+    {
+        return NUM_TWO;
+    }
+    ONNXTensorElementDataType GetInputType(size_t index) const
+    {
+        if (index == 0) {
+            return ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32;
+        }
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT64;
+    }
+    size_t GetOutputTypeCount() const
+    {
+        return 1;
+    }
+    ONNXTensorElementDataType GetOutputType(size_t) const
+    {
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8;
+    }
+} g_cAscendRequantOp;
+
+
 struct SearchNOp : Ort::CustomOpBase<SearchNOp, SearchNKernel> {
 #if ORT_API_VERSION >= 16
     OrtStatusPtr CreateKernelV2(const OrtApi& api, const OrtKernelInfo* info, void* kernel) const
@@ -527,6 +867,120 @@ private:
 #endif
 
 
+struct YoloNmsOp : Ort::CustomOpBase<YoloNmsOp, YoloNmsKernel> {
+public:
+#if ORT_API_VERSION >= 16
+    OrtStatusPtr CreateKernelV2(const OrtApi& api, const OrtKernelInfo* info, void* kernel) const
+    {
+        kernel = CreateKernel(api, info);
+        return api.CreateStatus(ORT_OK, "Success");
+    }
+#endif
+    void* CreateKernel(const OrtApi& api, const OrtKernelInfo* info) const
+    {
+        return new YoloNmsKernel(api, info);
+    }
+    const char* GetName() const
+    {
+        return "YoloNms";
+    }
+    size_t GetInputTypeCount() const
+    {
+        return 1;
+    }
+    ONNXTensorElementDataType GetInputType(size_t) const
+    {
+        return AmctUtils::AmctOpDynamicTypeCheck();
+    }
+    size_t GetOutputTypeCount() const
+    {
+        return YOLO_NMS_OUTPUT_TYPE_COUNT;
+    }
+    ONNXTensorElementDataType GetOutputType(size_t index) const
+    {
+        if (index == 0) {
+            return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+        }
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64;
+    }
+} g_cYoloNmsOp;
+
+
+struct ImagePreprocessOp : Ort::CustomOpBase<ImagePreprocessOp, ImagePreprocessKernel> {
+public:
+#if ORT_API_VERSION >= 16
+    OrtStatusPtr CreateKernelV2(const OrtApi& api, const OrtKernelInfo* info, void* kernel) const
+    {
+        kernel = CreateKernel(api, info);
+        return api.CreateStatus(ORT_OK, "Success");
+    }
+#endif
+    void* CreateKernel(const OrtApi& api, const OrtKernelInfo* info) const
+    {
+        return new ImagePreprocessKernel(api, info);
+    }
+    const char* GetName() const
+    {
+        return "ImagePreprocess";
+    }
+    size_t GetInputTypeCount() const
+    {
+        return 1;
+    }
+    ONNXTensorElementDataType GetInputType(size_t) const
+    {
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8;
+    }
+    size_t GetOutputTypeCount() const
+    {
+        return 1;
+    }
+    virtual ONNXTensorElementDataType GetOutputType(size_t) const
+    {
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+    }
+} g_cImagePreprocessOp;
+
+
+struct SoftmaxTopKOp : Ort::CustomOpBase<SoftmaxTopKOp, SoftmaxTopKKernel> {
+public:
+#if ORT_API_VERSION >= 16
+    OrtStatusPtr CreateKernelV2(const OrtApi& api, const OrtKernelInfo* info, void* kernel) const
+    {
+        kernel = CreateKernel(api, info);
+        return api.CreateStatus(ORT_OK, "Success");
+    }
+#endif
+    void* CreateKernel(const OrtApi& api, const OrtKernelInfo* info) const
+    {
+        return new SoftmaxTopKKernel(api, info);
+    }
+    const char* GetName() const
+    {
+        return "SoftmaxTopK";
+    }
+    size_t GetInputTypeCount() const
+    {
+        return 1;
+    }
+    ONNXTensorElementDataType GetInputType(size_t) const
+    {
+        return AmctUtils::AmctOpDynamicTypeCheck();
+    }
+    size_t GetOutputTypeCount() const
+    {
+        return SOFTMAX_TOPK_OUTPUT_TYPE_COUNT;
+    }
+    ONNXTensorElementDataType GetOutputType(size_t index) const
+    {
+        if (index == 0) {
+            return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+        }
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64;
+    }
+} g_cSoftmaxTopKOp;
+
+
 struct AscendQuantOpFp16 : AscendQuantOp {
 public:
     explicit AscendQuantOpFp16(const char* provider, void* compute_stream)
@@ -608,6 +1062,177 @@ private:
     AscendAntiQuantOpFp16 g_cAscendAntiQuantOpFp16{"CPUExecutionProvider", nullptr};
 #endif
 
+
+struct AscendAntiQuantInt4OpFp16 : AscendAntiQuantInt4Op {
+public:
+    explicit AscendAntiQuantInt4OpFp16(const char* provider, void* compute_stream)
+        : AscendAntiQuantInt4Op(provider, compute_stream) {}
+    ONNXTensorElementDataType GetOutputType(size_t) const
+    {
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16;
+    }
+};
+
+AscendAntiQuantInt4OpFp16 g_cAscendAntiQuantInt4OpFp16{"CPUExecutionProvider", nullptr};
+
+
+struct AscendGroupQuantOpInt8 : AscendGroupQuantOp {
+public:
+    explicit AscendGroupQuantOpInt8(const char* provider, void* compute_stream)
+        : AscendGroupQuantOp(provider, compute_stream) {}
+    ONNXTensorElementDataType GetOutputType(size_t) const
+    {
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8;
+    }
+};
+
+AscendGroupQuantOpInt8 g_cAscendGroupQuantOpInt8{"CPUExecutionProvider", nullptr};
+
+
+struct AscendGroupAntiQuantOpFp16 : AscendGroupAntiQuantOp {
+public:
+    explicit AscendGroupAntiQuantOpFp16(const char* provider, void* compute_stream)
+        : AscendGroupAntiQuantOp(provider, compute_stream) {}
+    ONNXTensorElementDataType GetOutputType(size_t) const
+    {
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16;
+    }
+};
+
+AscendGroupAntiQuantOpFp16 g_cAscendGroupAntiQuantOpFp16{"CPUExecutionProvider", nullptr};
+
+
+struct AscendNuqAntiQuantOpFp16 : AscendNuqAntiQuantOp {
+public:
+    explicit AscendNuqAntiQuantOpFp16(const char* provider, void* compute_stream)
+        : AscendNuqAntiQuantOp(provider, compute_stream) {}
+    ONNXTensorElementDataType GetOutputType(size_t) const
+    {
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16;
+    }
+};
+
+AscendNuqAntiQuantOpFp16 g_cAscendNuqAntiQuantOpFp16{"CPUExecutionProvider", nullptr};
+
+
+#if !USE_CUDA
+// bf16 outputs of the dequantization ops, the cuda kernels only compute fp32 and fp16
+struct AscendDequantOpBf16 : AscendDequantOp {
+public:
+    explicit AscendDequantOpBf16(const char* provider, void* compute_stream)
+        : AscendDequantOp(provider, compute_stream) {}
+    ONNXTensorElementDataType GetOutputType(size_t) const
+    {
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_BFLOAT16;
+    }
+};
+
+AscendDequantOpBf16 g_cAscendDequantOpBf16{"CPUExecutionProvider", nullptr};
+
+
+struct AscendAntiQuantOpBf16 : AscendAntiQuantOp {
+public:
+    explicit AscendAntiQuantOpBf16(const char* provider, void* compute_stream)
+        : AscendAntiQuantOp(provider, compute_stream) {}
+    ONNXTensorElementDataType GetOutputType(size_t) const
+    {
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_BFLOAT16;
+    }
+};
+
+AscendAntiQuantOpBf16 g_cAscendAntiQuantOpBf16{"CPUExecutionProvider", nullptr};
+
+
+struct AscendAntiQuantInt4OpBf16 : AscendAntiQuantInt4Op {
+public:
+    explicit AscendAntiQuantInt4OpBf16(const char* provider, void* compute_stream)
+        : AscendAntiQuantInt4Op(provider, compute_stream) {}
+    ONNXTensorElementDataType GetOutputType(size_t) const
+    {
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_BFLOAT16;
+    }
+};
+
+AscendAntiQuantInt4OpBf16 g_cAscendAntiQuantInt4OpBf16{"CPUExecutionProvider", nullptr};
+
+
+struct AscendGroupAntiQuantOpBf16 : AscendGroupAntiQuantOp {
+public:
+    explicit AscendGroupAntiQuantOpBf16(const char* provider, void* compute_stream)
+        : AscendGroupAntiQuantOp(provider, compute_stream) {}
+    ONNXTensorElementDataType GetOutputType(size_t) const
+    {
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_BFLOAT16;
+    }
+};
+
+AscendGroupAntiQuantOpBf16 g_cAscendGroupAntiQuantOpBf16{"CPUExecutionProvider", nullptr};
+
+
+struct AscendNuqAntiQuantOpBf16 : AscendNuqAntiQuantOp {
+public:
+    explicit AscendNuqAntiQuantOpBf16(const char* provider, void* compute_stream)
+        : AscendNuqAntiQuantOp(provider, compute_stream) {}
+    ONNXTensorElementDataType GetOutputType(size_t) const
+    {
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_BFLOAT16;
+    }
+};
+
+AscendNuqAntiQuantOpBf16 g_cAscendNuqAntiQuantOpBf16{"CPUExecutionProvider", nullptr};
+
+static OrtStatus* RegisterCustomBf16Domain(OrtSessionOptions* options, const OrtApi* ortApi)
+{
+    // register customop bf16 domain
+    const char* cOpDomainBf16 = "amct.customop.extbf16";
+    OrtCustomOpDomain* domainExBf16 = nullptr;
+    if (auto status = ortApi->CreateCustomOpDomain(cOpDomainBf16, &domainExBf16)) {
+        return status;
+    }
+    AddOrtCustomOpDomainToContainer(domainExBf16, ortApi);
+    // add ascenddequant bf16 custom op
+    if (auto status = ortApi->CustomOpDomain_Add(domainExBf16, &g_cAscendDequantOpBf16)) {
+        return status;
+    }
+    // add ascendantiquant bf16 custom op
+    if (auto status = ortApi->CustomOpDomain_Add(domainExBf16, &g_cAscendAntiQuantOpBf16)) {
+        return status;
+    }
+    // add int4 antiquant bf16 custom op
+    if (auto status = ortApi->CustomOpDomain_Add(domainExBf16, &g_cAscendAntiQuantInt4OpBf16)) {
+        return status;
+    }
+    // add group-wise antiquant bf16 custom op
+    if (auto status = ortApi->CustomOpDomain_Add(domainExBf16, &g_cAscendGroupAntiQuantOpBf16)) {
+        return status;
+    }
+    // add nuq antiquant bf16 custom op
+    if (auto status = ortApi->CustomOpDomain_Add(domainExBf16, &g_cAscendNuqAntiQuantOpBf16)) {
+        return status;
+    }
+    return ortApi->AddCustomOpDomain(options, domainExBf16);
+}
+#endif
+
+
+struct ImagePreprocessOpFp16 : ImagePreprocessOp {
+public:
+    ONNXTensorElementDataType GetOutputType(size_t) const
+    {
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16;
+    }
+} g_cImagePreprocessOpFp16;
+
+
+// preprocessing fused with the AscendQuant of the first layer
+struct ImagePreprocessOpInt8 : ImagePreprocessOp {
+public:
+    ONNXTensorElementDataType GetOutputType(size_t) const
+    {
+        return ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8;
+    }
+} g_cImagePreprocessOpInt8;
+
 static OrtStatus* RegisterCustomInt8Domain(OrtSessionOptions* options, const OrtApi* ortApi)
 {
     // register customop int8 domain
@@ -621,6 +1246,14 @@ static OrtStatus* RegisterCustomInt8Domain(OrtSessionOptions* options, const Ort
     if (auto status = ortApi->CustomOpDomain_Add(domainExInt8, &g_cAscendQuantOpInt8)) {
         return status;
     }
+    // add preprocessing with int8 output custom op
+    if (auto status = ortApi->CustomOpDomain_Add(domainExInt8, &g_cImagePreprocessOpInt8)) {
+        return status;
+    }
+    // add group-wise quant int8 custom op
+    if (auto status = ortApi->CustomOpDomain_Add(domainExInt8, &g_cAscendGroupQuantOpInt8)) {
+        return status;
+    }
     return ortApi->AddCustomOpDomain(options, domainExInt8);
 }
 
@@ -664,6 +1297,33 @@ OrtStatus* ORT_API_CALL RegisterCustomOps(OrtSessionOptions* options, const OrtA
     if (auto status = ortApi->CustomOpDomain_Add(domain, &g_cAscendAntiQuantOp)) {
         return status;
     }
+    // add int4 antiquant custom op
+    if (auto status = ortApi->CustomOpDomain_Add(domain, &g_cAscendAntiQuantInt4Op)) {
+        return status;
+    }
+    // add fp8 antiquant custom op
+    if (auto status = ortApi->CustomOpDomain_Add(domain, &g_cAscendAntiQuantFp8Op)) {
+        return status;
+    }
+    // add group-wise quant and antiquant custom ops
+    if (auto status = ortApi->CustomOpDomain_Add(domain, &g_cAscendGroupQuantOp)) {
+        return status;
+    }
+    if (auto status = ortApi->CustomOpDomain_Add(domain, &g_cAscendGroupAntiQuantOp)) {
+        return status;
+    }
+    // add dynamic quant custom op
+    if (auto status = ortApi->CustomOpDomain_Add(domain, &g_cDynamicAscendQuantOp)) {
+        return status;
+    }
+    // add nuq antiquant custom op
+    if (auto status = ortApi->CustomOpDomain_Add(domain, &g_cAscendNuqAntiQuantOp)) {
+        return status;
+    }
+    // add requant custom op
+    if (auto status = ortApi->CustomOpDomain_Add(domain, &g_cAscendRequantOp)) {
+        return status;
+    }
     // add search_n custom op
     if (auto status = ortApi->CustomOpDomain_Add(domain, &c_SearchNOp)) {
         return status;
@@ -676,6 +1336,18 @@ OrtStatus* ORT_API_CALL RegisterCustomOps(OrtSessionOptions* options, const OrtA
     if (auto status = ortApi->CustomOpDomain_Add(domain, &g_cDMQBalanceOp)) {
         return status;
     }
+    // add yolo nms post-processing custom op
+    if (auto status = ortApi->CustomOpDomain_Add(domain, &g_cYoloNmsOp)) {
+        return status;
+    }
+    // add image preprocessing custom op
+    if (auto status = ortApi->CustomOpDomain_Add(domain, &g_cImagePreprocessOp)) {
+        return status;
+    }
+    // add softmax top k post-processing custom op
+    if (auto status = ortApi->CustomOpDomain_Add(domain, &g_cSoftmaxTopKOp)) {
+        return status;
+    }
     if (auto status = ortApi->AddCustomOpDomain(options, domain)) {
         return status;
     }
@@ -699,9 +1371,30 @@ OrtStatus* ORT_API_CALL RegisterCustomOps(OrtSessionOptions* options, const OrtA
     if (auto status = ortApi->CustomOpDomain_Add(domainEx, &g_cAscendAntiQuantOpFp16)) {
         return status;
     }
+    // add int4 antiquant fp16 custom op
+    if (auto status = ortApi->CustomOpDomain_Add(domainEx, &g_cAscendAntiQuantInt4OpFp16)) {
+        return status;
+    }
+    // add group-wise antiquant fp16 custom op
+    if (auto status = ortApi->CustomOpDomain_Add(domainEx, &g_cAscendGroupAntiQuantOpFp16)) {
+        return status;
+    }
+    // add nuq antiquant fp16 custom op
+    if (auto status = ortApi->CustomOpDomain_Add(domainEx, &g_cAscendNuqAntiQuantOpFp16)) {
+        return status;
+    }
+    // add image preprocessing fp16 custom op
+    if (auto status = ortApi->CustomOpDomain_Add(domainEx, &g_cImagePreprocessOpFp16)) {
+        return status;
+    }
     if (auto status = ortApi->AddCustomOpDomain(options, domainEx)) {
         return status;
     }
 
+#if !USE_CUDA
+    if (auto status = RegisterCustomBf16Domain(options, ortApi)) {
+        return status;
+    }
+#endif
     return RegisterCustomInt8Domain(options, ortApi);
 }
@@ -22,6 +22,7 @@
 #include "dequant_quant.h"
 #include "dequant_kernel.h"
 #include "util.h"
+#include "scratch_arena.h"
 
 DequantKernel::DequantKernel(const OrtApi &api, const OrtKernelInfo *info) : api_(api)
 {
@@ -38,6 +39,7 @@ OrtStatusPtr DequantKernel::ComputeV2(OrtKernelContext* context)
 
 void DequantKernel::Compute(OrtKernelContext* context)
 {
+    AmctCommon::ProfileOpScope profile("Dequant");
     // Setup inputs input 0: data
     const OrtValue* inputX = AmctUtils::GetKernelInput(api_, context, 0);
 
@@ -70,8 +72,9 @@ void DequantKernel::Compute(OrtKernelContext* context)
         }
     }
 
-    std::vector<float> shiftDataWithPow(deqScaleSize);
-    std::vector<float> deqScaleDataTmp(deqScaleSize);
+    AmctCommon::ScratchScope scratch;
+    float* shiftDataWithPow = scratch.Allocate<float>(deqScaleSize);
+    float* deqScaleDataTmp = scratch.Allocate<float>(deqScaleSize);
     for (size_t idx = 0; idx < deqScaleSize; idx++) {
         shiftDataWithPow[idx] = pow(NUM_TWO, shiftData[idx]);
         deqScaleDataTmp[idx] = deqScaleData[idx];
@@ -83,18 +86,19 @@ void DequantKernel::Compute(OrtKernelContext* context)
     OrtTensorTypeAndShapeInfo* outputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, output);
     ONNXTensorElementDataType outputTensorType = AmctUtils::GetTensorEleType(api_, outputInfo);
     api_.ReleaseTensorTypeAndShapeInfo(outputInfo);
-    //  fake dequant compute
-    dequantParam_.chwSize = chwSize;
-    dequantParam_.hwSize = hwSize;
-    dequantParam_.shiftValue = shiftDataWithPow.data();
-    dequantParam_.deqScale = deqScaleDataTmp.data();
-    dequantParam_.channelWise = channelWise;
+    //  fake dequant compute, the kernel attributes are shared by concurrent calls so the params are a local copy
+    DequantParam dequantParam = dequantParam_;
+    dequantParam.chwSize = chwSize;
+    dequantParam.hwSize = hwSize;
+    dequantParam.shiftValue = shiftDataWithPow;
+    dequantParam.deqScale = deqScaleDataTmp;
+    dequantParam.channelWise = channelWise;
     InputDataParam params = {inputData,
         outputData,
         static_cast<int64_t>(inputTensorType),
         static_cast<int64_t>(outputTensorType),
         inputSize};
-    int ret = FakeDequant(params, dequantParam_);
+    int ret = FakeDequant(params, dequantParam);
     if (ret != 0) {
         LOG_ERROR("Do dequant compute failed, error code: %d.\n", ret);
         return;
@@ -23,8 +23,16 @@
 #include <numeric>
 #include <iostream>
 #include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
 
 #include "dequant_quant.h"
+#include "fp8_quant.h"
+#include "amct_profiler.h"
+#include "amct_thread_pool.h"
+#include "scratch_arena.h"
 #include "cast_util.h"
 #include "util.h"
 
@@ -38,6 +46,70 @@ constexpr int FLOAT16_TYPE_ID = 10;
 constexpr int QUANT_BIT_NUM = 8;
 
 
+namespace {
+constexpr int BFLOAT16_TYPE_ID = 16;
+
+// the 16 bit float types, stored as uint16_t
+bool IsHalfType(int64_t dataType)
+{
+    return dataType == FLOAT16_TYPE_ID || dataType == BFLOAT16_TYPE_ID;
+}
+
+
+// element type casts split over the AMCT execution layer
+void CastToFloat32(const void* in, int64_t inType, float* out, int64_t length)
+{
+    const uint16_t* data = reinterpret_cast<const uint16_t*>(in);
+    if (inType == BFLOAT16_TYPE_ID) {
+        AmctCommon::ProfileScope profile("bf16_to_fp32", length, length * (sizeof(uint16_t) + sizeof(float)));
+        AmctCommon::ParallelFor(length, [data, out](int64_t begin, int64_t end) {
+            DataCastFromBFloat16Functor<util::CPUDevice, float>()(data + begin, out + begin,
+                static_cast<int>(end - begin));
+        });
+        return;
+    }
+    AmctCommon::ProfileScope profile("fp16_to_fp32", length, length * (sizeof(uint16_t) + sizeof(float)));
+    AmctCommon::ParallelFor(length, [data, out](int64_t begin, int64_t end) {
+        DataCastToFloat32Functor<util::CPUDevice, uint16_t>()(data + begin, out + begin, static_cast<int>(end - begin));
+    });
+}
+
+
+void CastFromFloat32(const float* in, void* out, int64_t outType, int64_t length)
+{
+    uint16_t* data = reinterpret_cast<uint16_t*>(out);
+    if (outType == BFLOAT16_TYPE_ID) {
+        AmctCommon::ProfileScope profile("fp32_to_bf16", length, length * (sizeof(float) + sizeof(uint16_t)));
+        AmctCommon::ParallelFor(length, [in, data](int64_t begin, int64_t end) {
+            DataCastToBFloat16Functor<util::CPUDevice, float>()(in + begin, data + begin,
+                static_cast<int>(end - begin));
+        });
+        return;
+    }
+    AmctCommon::ProfileScope profile("fp32_to_fp16", length, length * (sizeof(float) + sizeof(uint16_t)));
+    AmctCommon::ParallelFor(length, [in, data](int64_t begin, int64_t end) {
+        DataCastToFloat16Functor<util::CPUDevice, float>()(in + begin, data + begin, static_cast<int>(end - begin));
+    });
+}
+
+
+// splits rows of rowLength elements over the AMCT execution layer, a row never spans two tasks
+void ParallelForRows(int64_t rowNum, int64_t rowLength, const AmctCommon::ParallelRange& fn)
+{
+    const AmctCommon::ParallelConfig& config = AmctCommon::GetParallelConfig();
+    if (rowNum * rowLength <= config.serialThreshold) {
+        fn(0, rowNum);
+        return;
+    }
+    int64_t rowsPerTask = std::max<int64_t>(config.grainSize / std::max<int64_t>(rowLength, 1), 1);
+    int64_t taskNum = (rowNum + rowsPerTask - 1) / rowsPerTask;
+    AmctCommon::ParallelForTasks(taskNum, [&](int64_t begin, int64_t end) {
+        fn(begin * rowsPerTask, std::min(end * rowsPerTask, rowNum));
+    });
+}
+}
+
+
 template<class T>
 Status FakeDequantKernel(const T* data,
                          T* outputData,
@@ -50,27 +122,29 @@ Status FakeDequantKernel(const T* data,
     if (dequantParam.chwSize == 0 || dequantParam.hwSize == 0) {
         return AmctCommon::GENERIC_ERROR;
     }
-#pragma omp parallel for
-    for (int64_t index = 0; index < length; index++) {
-        int channelIndex = !dequantParam.channelWise ? 0 : (index % (dequantParam.chwSize)) / dequantParam.hwSize;
-        float shiftValuePow = dequantParam.shiftValue[channelIndex];
-        T tmpData = 0;
-        if (std::fabs(shiftValuePow - 1) <= std::numeric_limits<float>::epsilon()) {
-            tmpData = data[index];
-        } else {
-            tmpData = floor(data[index] / shiftValuePow);
+    AmctCommon::ProfileScope profile("fake_dequant", length, length * sizeof(T) * 2);
+    AmctCommon::ParallelFor(length, [&](int64_t begin, int64_t end) {
+        for (int64_t index = begin; index < end; index++) {
+            int channelIndex = !dequantParam.channelWise ? 0 : (index % (dequantParam.chwSize)) / dequantParam.hwSize;
+            float shiftValuePow = dequantParam.shiftValue[channelIndex];
+            T tmpData = 0;
+            if (std::fabs(shiftValuePow - 1) <= std::numeric_limits<float>::epsilon()) {
+                tmpData = data[index];
+            } else {
+                tmpData = floor(data[index] / shiftValuePow);
+            }
+            if (tmpData < clipMin) {
+                tmpData = clipMin;
+            } else if (tmpData > clipMax) {
+                tmpData = clipMax;
+            }
+            if (fakePrecisionMode == util::FORCE_FP16_QUANT) {
+                outputData[index] = util::CastToFP16PrecisionCPU(tmpData * util::CastToS19CPU(dequantParam.deqScale[channelIndex]) * shiftValuePow);
+            } else {
+                outputData[index] = tmpData * dequantParam.deqScale[channelIndex] * shiftValuePow;
+            }
         }
-        if (tmpData < clipMin) {
-            tmpData = clipMin;
-        } else if (tmpData > clipMax) {
-            tmpData = clipMax;
-        }
-        if (fakePrecisionMode == util::FORCE_FP16_QUANT) {
-            outputData[index] = util::CastToFP16PrecisionCPU(tmpData * util::CastToS19CPU(dequantParam.deqScale[channelIndex]) * shiftValuePow);
-        } else {
-            outputData[index] = tmpData * dequantParam.deqScale[channelIndex] * shiftValuePow;
-        }
-    }
+    });
     return AmctCommon::SUCCESS;
 }
 
@@ -94,13 +168,15 @@ Status FakeQuantKernel(const T* inputData,
         }
     };
 
-#pragma omp parallel for
-    for (int64_t i = 0; i < length; i++) {
-        int64_t temp = quantFunc(inputData[i]);
-        temp = temp < clipMin ? clipMin : temp;
-        temp = temp > clipMax ? clipMax : temp;
-        outputData[i] = static_cast<float>(temp - calParams.offset);
-    }
+    AmctCommon::ProfileScope profile("fake_quant", length, length * sizeof(T) * 2);
+    AmctCommon::ParallelFor(length, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; i++) {
+            int64_t temp = quantFunc(inputData[i]);
+            temp = temp < clipMin ? clipMin : temp;
+            temp = temp > clipMax ? clipMax : temp;
+            outputData[i] = static_cast<float>(temp - calParams.offset);
+        }
+    });
     return AmctCommon::SUCCESS;
 }
 
@@ -123,13 +199,15 @@ Status FakeQuantKernelOutputInt8(const T* inputData,
         }
     };
     // Do quant computation
-#pragma omp parallel for
-    for (int64_t i = 0; i < length; i++) {
-        int64_t temp = quantFunc(inputData[i]);
-        temp = temp < clipMin ? clipMin : temp;
-        temp = temp > clipMax ? clipMax : temp;
-        outputData[i] = static_cast<int8_t>(temp);
-    }
+    AmctCommon::ProfileScope profile("fake_quant_int8", length, length * (sizeof(T) + sizeof(int8_t)));
+    AmctCommon::ParallelFor(length, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; i++) {
+            int64_t temp = quantFunc(inputData[i]);
+            temp = temp < clipMin ? clipMin : temp;
+            temp = temp > clipMax ? clipMax : temp;
+            outputData[i] = static_cast<int8_t>(temp);
+        }
+    });
     return AmctCommon::SUCCESS;
 }
 
@@ -137,10 +215,12 @@ Status FakeQuantKernelOutputInt8(const T* inputData,
 template<class T>
 Status FakeAntiQuantKernel(const T* inputData, T* outputData, int64_t length, float scale)
 {
-#pragma omp parallel for
-    for (int64_t idx = 0; idx < length; idx++) {
-        outputData[idx] = inputData[idx] * scale;
-    }
+    AmctCommon::ProfileScope profile("fake_antiquant", length, length * sizeof(T) * 2);
+    AmctCommon::ParallelFor(length, [&](int64_t begin, int64_t end) {
+        for (int64_t idx = begin; idx < end; idx++) {
+            outputData[idx] = inputData[idx] * scale;
+        }
+    });
     return AmctCommon::SUCCESS;
 }
 
@@ -150,7 +230,7 @@ int ParseParamData(
 {
     const uint64_t shiftnMask = 0x000000ff00000000;
     const uint64_t deqscaleMask = 0x00000000ffffffff;
-#pragma omp parallel for
+    // one entry per channel, too small to be worth any thread
     for (int64_t idx = 0; idx < dequantParam.paramSize; idx++) {
         unsigned int shiftValue = (dequantParam.paramData[idx] & shiftnMask) >> SHIFT_VAL_LEN;
         dequantParam.shiftValue[idx] = pow(BINARY_BASE, shiftValue);
@@ -168,22 +248,22 @@ int ParseParamData(
 int FakeDequant(InputDataParam param,
                 DequantParam dequantParam)
 {
+    // fp16 and bf16 data are computed in float32 buffers of the thread scratch arena
+    AmctCommon::ScratchScope scratch;
     int res = AmctCommon::SUCCESS;
     if (param.outType != FLOAT_TYPE_ID) {
-        std::vector<float> outCast(param.length, 0);
+        float* outCast = scratch.Allocate<float>(param.length);
         // in_16, out_16
         if (param.inType != FLOAT_TYPE_ID) {
-            std::vector<float> inCast(param.length, 0);
-            DataCastToFloat32Functor<util::CPUDevice, uint16_t>()(
-                reinterpret_cast<const uint16_t*>(param.in), inCast.data(), param.length);
-            res = FakeDequantKernel(inCast.data(), outCast.data(), param.length, dequantParam, param.fakePrecisionMode);
+            float* inCast = scratch.Allocate<float>(param.length);
+            CastToFloat32(param.in, param.inType, inCast, param.length);
+            res = FakeDequantKernel(inCast, outCast, param.length, dequantParam, param.fakePrecisionMode);
         } else {
             // in_32, out_16
-            res = FakeDequantKernel(reinterpret_cast<const float*>(param.in), outCast.data(),
+            res = FakeDequantKernel(reinterpret_cast<const float*>(param.in), outCast,
                 param.length, dequantParam, param.fakePrecisionMode);
         }
-        DataCastToFloat16Functor<util::CPUDevice, float>()(
-            outCast.data(), reinterpret_cast<uint16_t*>(param.out), param.length);
+        CastFromFloat32(outCast, param.out, param.outType, param.length);
         return res;
     }
     // in_32, out_32
@@ -195,29 +275,28 @@ int FakeDequant(InputDataParam param,
 
 int FakeQuant(InputDataParam param, int64_t quantBits, float scale, int64_t offset)
 {
+    AmctCommon::ScratchScope scratch;
     FakeCalParams calParams = {param.fakePrecisionMode, scale, offset};
-    if (param.inType == FLOAT16_TYPE_ID) {
-        std::vector<float> inCast(param.length, 0);
-        DataCastToFloat32Functor<util::CPUDevice, uint16_t>()(
-            reinterpret_cast<const uint16_t*>(param.in), inCast.data(), param.length);
+    if (IsHalfType(param.inType)) {
+        float* inCast = scratch.Allocate<float>(param.length);
+        CastToFloat32(param.in, param.inType, inCast, param.length);
         // in_16, out_16
-        if (param.outType == FLOAT16_TYPE_ID) {
-            std::vector<float> outCast(param.length, 0);
-            int res = FakeQuantKernel(inCast.data(), outCast.data(), param.length, quantBits, calParams);
-            DataCastToFloat16Functor<util::CPUDevice, float>()(
-                outCast.data(), reinterpret_cast<uint16_t*>(param.out), param.length);
+        if (IsHalfType(param.outType)) {
+            float* outCast = scratch.Allocate<float>(param.length);
+            int res = FakeQuantKernel(inCast, outCast, param.length, quantBits, calParams);
+            CastFromFloat32(outCast, param.out, param.outType, param.length);
             return res;
         }
 
         // in_16, out_32
         if (param.outType == FLOAT_TYPE_ID) {
-            return FakeQuantKernel(inCast.data(), reinterpret_cast<float*>(param.out), param.length,
+            return FakeQuantKernel(inCast, reinterpret_cast<float*>(param.out), param.length,
                 quantBits, calParams);
         }
 
         // in_16, out_8
         if (param.outType == INT8_TYPE_ID) {
-            return FakeQuantKernelOutputInt8(inCast.data(), reinterpret_cast<int8_t*>(param.out), param.length,
+            return FakeQuantKernelOutputInt8(inCast, reinterpret_cast<int8_t*>(param.out), param.length,
                 calParams);
         }
     }
@@ -236,24 +315,762 @@ int FakeQuant(InputDataParam param, int64_t quantBits, float scale, int64_t offs
 
 int FakeAntiQuant(InputDataParam param, float scaleData)
 {
+    AmctCommon::ScratchScope scratch;
     if (param.outType != FLOAT_TYPE_ID) {
-        std::vector<float> outCast(param.length, 0);
+        float* outCast = scratch.Allocate<float>(param.length);
         // in_16, out_16
         if (param.inType != FLOAT_TYPE_ID) {
-            std::vector<float> inCast(param.length, 0);
-            DataCastToFloat32Functor<util::CPUDevice, uint16_t>()(
-                reinterpret_cast<const uint16_t*>(param.in), inCast.data(), param.length);
-            FakeAntiQuantKernel(inCast.data(), outCast.data(), param.length, scaleData);
+            float* inCast = scratch.Allocate<float>(param.length);
+            CastToFloat32(param.in, param.inType, inCast, param.length);
+            FakeAntiQuantKernel(inCast, outCast, param.length, scaleData);
         } else {
             // in_32, out_16
-            FakeAntiQuantKernel(reinterpret_cast<const float*>(param.in), outCast.data(), param.length, scaleData);
+            FakeAntiQuantKernel(reinterpret_cast<const float*>(param.in), outCast, param.length, scaleData);
         }
-        DataCastToFloat16Functor<util::CPUDevice, float>()(outCast.data(), reinterpret_cast<uint16_t*>(param.out),
-                                                           param.length);
+        CastFromFloat32(outCast, param.out, param.outType, param.length);
         return AmctCommon::SUCCESS;
     }
     // in_32, out_32
     FakeAntiQuantKernel(reinterpret_cast<const float*>(param.in), reinterpret_cast<float*>(param.out),
                         param.length, scaleData);
     return AmctCommon::SUCCESS;
-}
\ No newline at end of file
+}
+
+namespace {
+constexpr int INT4_MIN = -8;
+constexpr int INT4_MAX = 7;
+constexpr int INT4_NIBBLE_BITS = 4;
+constexpr int INT4_NIBBLE_MASK = 0xf;
+constexpr int BYTE_VALUE_NUM = 256;
+constexpr int64_t INT4_PER_BYTE = 2;
+
+inline int QuantInt4Value(float x, const FakeCalParams& calParams)
+{
+    float quantValue = 0;
+    if (calParams.fakePrecisonMode == util::FORCE_FP16_QUANT) {
+        quantValue = rint(util::CastToFP16PrecisionCPU(util::CastToFP16PrecisionCPU(
+            (util::CastToFP16PrecisionCPU(x) * util::FakeFp16PrecisionDataCPU(calParams.scale))) + calParams.offset));
+    } else {
+        quantValue = rint(x * calParams.scale) + calParams.offset;
+    }
+    quantValue = quantValue < INT4_MIN ? INT4_MIN : quantValue;
+    quantValue = quantValue > INT4_MAX ? INT4_MAX : quantValue;
+    return static_cast<int>(quantValue);
+}
+
+Status QuantPackInt4Kernel(const float* inputData, uint8_t* outputData, int64_t length, int64_t rowLength,
+    FakeCalParams calParams)
+{
+    int64_t rowNum = length / rowLength;
+    int64_t packedRow = (rowLength + 1) / INT4_PER_BYTE;
+    int64_t pairNum = rowLength / INT4_PER_BYTE;
+    AmctCommon::ProfileScope profile("quant_pack_int4", length, length * sizeof(float) + rowNum * packedRow);
+    ParallelForRows(rowNum, rowLength, [&](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row < end; ++row) {
+            const float* in = inputData + row * rowLength;
+            uint8_t* out = outputData + row * packedRow;
+#pragma omp simd
+            for (int64_t i = 0; i < pairNum; ++i) {
+                int low = QuantInt4Value(in[INT4_PER_BYTE * i], calParams) & INT4_NIBBLE_MASK;
+                int high = QuantInt4Value(in[INT4_PER_BYTE * i + 1], calParams) & INT4_NIBBLE_MASK;
+                out[i] = static_cast<uint8_t>(low | (high << INT4_NIBBLE_BITS));
+            }
+            if (packedRow != pairNum) {
+                out[pairNum] = static_cast<uint8_t>(QuantInt4Value(in[rowLength - 1], calParams) & INT4_NIBBLE_MASK);
+            }
+        }
+    });
+    return AmctCommon::SUCCESS;
+}
+
+Status UnpackInt4Kernel(const int8_t* inputData, float* outputData, int64_t length, int64_t rowLength, float scale)
+{
+    int64_t rowNum = length / rowLength;
+    int64_t packedRow = (rowLength + 1) / INT4_PER_BYTE;
+    int64_t pairNum = rowLength / INT4_PER_BYTE;
+    AmctCommon::ProfileScope profile("antiquant_unpack_int4", length, rowNum * packedRow + length * sizeof(float));
+    ParallelForRows(rowNum, rowLength, [&](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row < end; ++row) {
+            const int8_t* in = inputData + row * packedRow;
+            float* out = outputData + row * rowLength;
+            // arithmetic shifts sign extend both nibbles
+#pragma omp simd
+            for (int64_t i = 0; i < pairNum; ++i) {
+                int packed = in[i];
+                out[INT4_PER_BYTE * i] = static_cast<float>(static_cast<int8_t>(packed << INT4_NIBBLE_BITS) >>
+                    INT4_NIBBLE_BITS) * scale;
+                out[INT4_PER_BYTE * i + 1] = static_cast<float>(packed >> INT4_NIBBLE_BITS) * scale;
+            }
+            if (packedRow != pairNum) {
+                int packed = in[pairNum];
+                out[rowLength - 1] = static_cast<float>(static_cast<int8_t>(packed << INT4_NIBBLE_BITS) >>
+                    INT4_NIBBLE_BITS) * scale;
+            }
+        }
+    });
+    return AmctCommon::SUCCESS;
+}
+
+// a byte holds one of 256 value pairs, so the fp16 or bf16 pairs are looked up instead of converted one by one
+Status UnpackInt4KernelHalf(const int8_t* inputData, uint16_t* outputData, int64_t length, int64_t rowLength,
+    float scale, uint16_t (*castHalf)(float))
+{
+    uint16_t values[INT4_NIBBLE_MASK + 1];
+    for (int nibble = 0; nibble <= INT4_NIBBLE_MASK; ++nibble) {
+        int value = nibble > INT4_MAX ? nibble - (INT4_NIBBLE_MASK + 1) : nibble;
+        values[nibble] = castHalf(static_cast<float>(value) * scale);
+    }
+    uint16_t pairs[BYTE_VALUE_NUM][INT4_PER_BYTE];
+    for (int packed = 0; packed < BYTE_VALUE_NUM; ++packed) {
+        pairs[packed][0] = values[packed & INT4_NIBBLE_MASK];
+        pairs[packed][1] = values[packed >> INT4_NIBBLE_BITS];
+    }
+    int64_t rowNum = length / rowLength;
+    int64_t packedRow = (rowLength + 1) / INT4_PER_BYTE;
+    int64_t pairNum = rowLength / INT4_PER_BYTE;
+    AmctCommon::ProfileScope profile("antiquant_unpack_int4", length, rowNum * packedRow + length * sizeof(uint16_t));
+    ParallelForRows(rowNum, rowLength, [&](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row < end; ++row) {
+            const uint8_t* in = reinterpret_cast<const uint8_t*>(inputData) + row * packedRow;
+            uint16_t* out = outputData + row * rowLength;
+            for (int64_t i = 0; i < pairNum; ++i) {
+                memcpy(out + INT4_PER_BYTE * i, pairs[in[i]], sizeof(pairs[0]));
+            }
+            if (packedRow != pairNum) {
+                out[rowLength - 1] = pairs[in[pairNum]][0];
+            }
+        }
+    });
+    return AmctCommon::SUCCESS;
+}
+}
+
+
+int QuantPackInt4(InputDataParam param, int64_t rowLength, float scale, int64_t offset)
+{
+    if (rowLength <= 0 || param.length % rowLength != 0) {
+        return AmctCommon::BAD_PARAMETERS_ERROR;
+    }
+    AmctCommon::ScratchScope scratch;
+    FakeCalParams calParams = {param.fakePrecisionMode, scale, offset};
+    const float* in = reinterpret_cast<const float*>(param.in);
+    if (IsHalfType(param.inType)) {
+        float* inCast = scratch.Allocate<float>(param.length);
+        CastToFloat32(param.in, param.inType, inCast, param.length);
+        in = inCast;
+    }
+    return QuantPackInt4Kernel(in, reinterpret_cast<uint8_t*>(param.out), param.length, rowLength, calParams);
+}
+
+
+int AntiQuantUnpackInt4(InputDataParam param, int64_t rowLength, float scaleData)
+{
+    if (rowLength <= 0 || param.length % rowLength != 0) {
+        return AmctCommon::BAD_PARAMETERS_ERROR;
+    }
+    const int8_t* in = reinterpret_cast<const int8_t*>(param.in);
+    if (IsHalfType(param.outType)) {
+        return UnpackInt4KernelHalf(in, reinterpret_cast<uint16_t*>(param.out), param.length, rowLength, scaleData,
+            param.outType == BFLOAT16_TYPE_ID ? util::Fp32ToBf16 : util::Fp32ToFp16);
+    }
+    return UnpackInt4Kernel(in, reinterpret_cast<float*>(param.out), param.length, rowLength, scaleData);
+}
+
+namespace {
+// calls func(x, scale, offset) for every element with the scale and offset of its group
+template<class T, class U, class Func>
+void ApplyGroupWise(const T* inputData, U* outputData, const GroupQuantParam& groupParam, const Func& func)
+{
+    int64_t groupSize = groupParam.groupSize;
+    int64_t innerSize = groupParam.innerSize;
+    int64_t groupNum = groupParam.axisSize / groupSize;
+    const float* scales = groupParam.scale;
+    const float* offsets = groupParam.offset;
+    if (innerSize == 1) {
+        // groups along the last axis are contiguous blocks of one scale
+        ParallelForRows(groupParam.outerSize * groupNum, groupSize, [&](int64_t begin, int64_t end) {
+            for (int64_t block = begin; block < end; ++block) {
+                const T* in = inputData + block * groupSize;
+                U* out = outputData + block * groupSize;
+                float scale = scales[block];
+                float offset = offsets[block];
+#pragma omp simd
+                for (int64_t i = 0; i < groupSize; ++i) {
+                    out[i] = func(in[i], scale, offset);
+                }
+            }
+        });
+        return;
+    }
+    // otherwise each row of innerSize elements pairs with the scale row of its group
+    ParallelForRows(groupParam.outerSize * groupParam.axisSize, innerSize, [&](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row < end; ++row) {
+            int64_t group = row / groupParam.axisSize * groupNum + row % groupParam.axisSize / groupSize;
+            const T* in = inputData + row * innerSize;
+            U* out = outputData + row * innerSize;
+            const float* scale = scales + group * innerSize;
+            const float* offset = offsets + group * innerSize;
+#pragma omp simd
+            for (int64_t i = 0; i < innerSize; ++i) {
+                out[i] = func(in[i], scale[i], offset[i]);
+            }
+        }
+    });
+}
+
+template<class U>
+Status GroupQuantKernel(const float* inputData, U* outputData, int64_t length, int64_t quantBits,
+    int64_t fakePrecisionMode, const GroupQuantParam& groupParam)
+{
+    float clipMin = -static_cast<float>(pow(BINARY_BASE, quantBits - 1));
+    float clipMax = static_cast<float>(pow(BINARY_BASE, quantBits - 1) - 1);
+    // int8 output keeps the offset, the fake quantized float output removes it again
+    bool keepOffset = std::is_same<U, int8_t>::value;
+    AmctCommon::ProfileScope profile("fake_group_quant", length, length * (sizeof(float) + sizeof(U)));
+    if (fakePrecisionMode == util::FORCE_FP16_QUANT) {
+        ApplyGroupWise(inputData, outputData, groupParam, [=](float x, float scale, float offset) {
+            float quantValue = rint(util::CastToFP16PrecisionCPU(util::CastToFP16PrecisionCPU(
+                (util::CastToFP16PrecisionCPU(x) * util::FakeFp16PrecisionDataCPU(scale))) + offset));
+            quantValue = std::min(std::max(quantValue, clipMin), clipMax);
+            return static_cast<U>(keepOffset ? quantValue : quantValue - offset);
+        });
+        return AmctCommon::SUCCESS;
+    }
+    ApplyGroupWise(inputData, outputData, groupParam, [=](float x, float scale, float offset) {
+        float quantValue = std::min(std::max(rint(x * scale) + offset, clipMin), clipMax);
+        return static_cast<U>(keepOffset ? quantValue : quantValue - offset);
+    });
+    return AmctCommon::SUCCESS;
+}
+
+template<class T>
+Status GroupAntiQuantKernel(const T* inputData, float* outputData, int64_t length, const GroupQuantParam& groupParam)
+{
+    AmctCommon::ProfileScope profile("fake_group_antiquant", length, length * (sizeof(T) + sizeof(float)));
+    ApplyGroupWise(inputData, outputData, groupParam, [](T x, float scale, float offset) {
+        return (static_cast<float>(x) - offset) * scale;
+    });
+    return AmctCommon::SUCCESS;
+}
+
+int CheckGroupParam(const InputDataParam& param, const GroupQuantParam& groupParam)
+{
+    if (groupParam.groupSize <= 0 || groupParam.axisSize % groupParam.groupSize != 0) {
+        LOG_ERROR("Group size %lld does not divide the quantized axis of size %lld.\n",
+            static_cast<long long>(groupParam.groupSize), static_cast<long long>(groupParam.axisSize));
+        return AmctCommon::BAD_PARAMETERS_ERROR;
+    }
+    if (groupParam.outerSize * groupParam.axisSize * groupParam.innerSize != static_cast<int64_t>(param.length) ||
+        groupParam.scale == nullptr || groupParam.offset == nullptr) {
+        return AmctCommon::BAD_PARAMETERS_ERROR;
+    }
+    return AmctCommon::SUCCESS;
+}
+}
+
+
+int FakeGroupQuant(InputDataParam param, int64_t quantBits, GroupQuantParam groupParam)
+{
+    int ret = CheckGroupParam(param, groupParam);
+    if (ret != AmctCommon::SUCCESS) {
+        return ret;
+    }
+    AmctCommon::ScratchScope scratch;
+    const float* in = reinterpret_cast<const float*>(param.in);
+    if (IsHalfType(param.inType)) {
+        float* inCast = scratch.Allocate<float>(param.length);
+        CastToFloat32(param.in, param.inType, inCast, param.length);
+        in = inCast;
+    }
+    if (param.outType == INT8_TYPE_ID) {
+        return GroupQuantKernel(in, reinterpret_cast<int8_t*>(param.out), param.length, quantBits,
+            param.fakePrecisionMode, groupParam);
+    }
+    if (IsHalfType(param.outType)) {
+        float* outCast = scratch.Allocate<float>(param.length);
+        ret = GroupQuantKernel(in, outCast, param.length, quantBits, param.fakePrecisionMode, groupParam);
+        CastFromFloat32(outCast, param.out, param.outType, param.length);
+        return ret;
+    }
+    return GroupQuantKernel(in, reinterpret_cast<float*>(param.out), param.length, quantBits,
+        param.fakePrecisionMode, groupParam);
+}
+
+
+int FakeGroupAntiQuant(InputDataParam param, GroupQuantParam groupParam)
+{
+    int ret = CheckGroupParam(param, groupParam);
+    if (ret != AmctCommon::SUCCESS) {
+        return ret;
+    }
+    AmctCommon::ScratchScope scratch;
+    float* out = reinterpret_cast<float*>(param.out);
+    if (IsHalfType(param.outType)) {
+        out = scratch.Allocate<float>(param.length);
+    }
+    if (param.inType == INT8_TYPE_ID) {
+        ret = GroupAntiQuantKernel(reinterpret_cast<const int8_t*>(param.in), out, param.length, groupParam);
+    } else if (IsHalfType(param.inType)) {
+        float* inCast = scratch.Allocate<float>(param.length);
+        CastToFloat32(param.in, param.inType, inCast, param.length);
+        ret = GroupAntiQuantKernel(static_cast<const float*>(inCast), out, param.length, groupParam);
+    } else {
+        ret = GroupAntiQuantKernel(reinterpret_cast<const float*>(param.in), out, param.length, groupParam);
+    }
+    if (IsHalfType(param.outType)) {
+        CastFromFloat32(out, param.out, param.outType, param.length);
+    }
+    return ret;
+}
+
+namespace {
+constexpr float INT8_MIN_VALUE = -128.0f;
+constexpr float INT8_MAX_VALUE = 127.0f;
+
+void GetMinMax(const float* data, int64_t length, float& minValue, float& maxValue)
+{
+    float minData = minValue;
+    float maxData = maxValue;
+#pragma omp simd reduction(min:minData) reduction(max:maxData)
+    for (int64_t i = 0; i < length; ++i) {
+        minData = std::min(minData, data[i]);
+        maxData = std::max(maxData, data[i]);
+    }
+    minValue = minData;
+    maxValue = maxData;
+}
+
+// the range always holds zero so that zero padding quantizes exactly, a zero range gets scale 1
+void GetDynamicScale(float minValue, float maxValue, bool symmetric, float& scale, float& offset)
+{
+    minValue = std::min(minValue, 0.0f);
+    maxValue = std::max(maxValue, 0.0f);
+    if (symmetric) {
+        scale = std::max(-minValue, maxValue) / INT8_MAX_VALUE;
+        offset = 0;
+    } else {
+        scale = (maxValue - minValue) / (INT8_MAX_VALUE - INT8_MIN_VALUE);
+        offset = scale > 0 ? INT8_MIN_VALUE - rint(minValue / scale) : 0;
+    }
+    scale = scale > 0 ? scale : 1.0f;
+}
+
+void QuantizeInt8(const float* in, int8_t* out, int64_t length, float scale, float offset)
+{
+    float quantScale = 1.0f / scale;
+#pragma omp simd
+    for (int64_t i = 0; i < length; ++i) {
+        float quantValue = rint(in[i] * quantScale) + offset;
+        out[i] = static_cast<int8_t>(std::min(std::max(quantValue, INT8_MIN_VALUE), INT8_MAX_VALUE));
+    }
+}
+
+// per token: the min/max reduction and the quantization of a row run back to back while the row is in cache
+void DynamicQuantRows(const InputDataParam& param, int64_t rowLength, bool symmetric, float* scale, float* offset)
+{
+    int64_t rowNum = static_cast<int64_t>(param.length) / rowLength;
+    bool castInput = IsHalfType(param.inType);
+    ParallelForRows(rowNum, rowLength, [&](int64_t begin, int64_t end) {
+        // the arena of the worker running this task, reused by every row of the range
+        AmctCommon::ScratchScope scratch;
+        float* rowBuffer = castInput ? scratch.Allocate<float>(static_cast<size_t>(rowLength)) : nullptr;
+        for (int64_t row = begin; row < end; ++row) {
+            const float* in = reinterpret_cast<const float*>(param.in) + row * rowLength;
+            const uint16_t* halfIn = reinterpret_cast<const uint16_t*>(param.in) + row * rowLength;
+            if (param.inType == BFLOAT16_TYPE_ID) {
+                DataCastFromBFloat16Functor<util::CPUDevice, float>()(halfIn, rowBuffer, static_cast<int>(rowLength));
+                in = rowBuffer;
+            } else if (castInput) {
+                DataCastToFloat32Functor<util::CPUDevice, uint16_t>()(halfIn, rowBuffer, static_cast<int>(rowLength));
+                in = rowBuffer;
+            }
+            float minValue = in[0];
+            float maxValue = in[0];
+            GetMinMax(in, rowLength, minValue, maxValue);
+            GetDynamicScale(minValue, maxValue, symmetric, scale[row], offset[row]);
+            QuantizeInt8(in, reinterpret_cast<int8_t*>(param.out) + row * rowLength, rowLength, scale[row],
+                offset[row]);
+        }
+    });
+}
+
+// per tensor: the scale needs the whole tensor, so a blocked parallel reduction is followed by the quantization
+void DynamicQuantTensor(const InputDataParam& param, bool symmetric, float* scale, float* offset)
+{
+    AmctCommon::ScratchScope scratch;
+    int64_t length = static_cast<int64_t>(param.length);
+    const float* in = reinterpret_cast<const float*>(param.in);
+    if (IsHalfType(param.inType)) {
+        float* inCast = scratch.Allocate<float>(param.length);
+        CastToFloat32(param.in, param.inType, inCast, length);
+        in = inCast;
+    }
+    const AmctCommon::ParallelConfig& config = AmctCommon::GetParallelConfig();
+    int64_t blockSize = std::max<int64_t>(config.grainSize, 1);
+    int64_t blockNum = (length + blockSize - 1) / blockSize;
+    float* blockMin = scratch.Allocate<float>(static_cast<size_t>(blockNum));
+    float* blockMax = scratch.Allocate<float>(static_cast<size_t>(blockNum));
+    AmctCommon::ParallelForTasks(blockNum, [&](int64_t begin, int64_t end) {
+        for (int64_t block = begin; block < end; ++block) {
+            int64_t start = block * blockSize;
+            blockMin[block] = in[start];
+            blockMax[block] = in[start];
+            GetMinMax(in + start, std::min(blockSize, length - start), blockMin[block], blockMax[block]);
+        }
+    });
+    float minValue = *std::min_element(blockMin, blockMin + blockNum);
+    float maxValue = *std::max_element(blockMax, blockMax + blockNum);
+    GetDynamicScale(minValue, maxValue, symmetric, scale[0], offset[0]);
+    int8_t* out = reinterpret_cast<int8_t*>(param.out);
+    AmctCommon::ParallelFor(length, [&](int64_t begin, int64_t end) {
+        QuantizeInt8(in + begin, out + begin, end - begin, scale[0], offset[0]);
+    });
+}
+}
+
+
+int DynamicQuant(InputDataParam param, int64_t rowLength, bool symmetric, float* scale, float* offset)
+{
+    if (param.length == 0 || rowLength <= 0 || param.length % rowLength != 0 || param.outType != INT8_TYPE_ID) {
+        return AmctCommon::BAD_PARAMETERS_ERROR;
+    }
+    int64_t length = static_cast<int64_t>(param.length);
+    AmctCommon::ProfileScope profile("dynamic_quant", length,
+        length * ((IsHalfType(param.inType) ? sizeof(uint16_t) : sizeof(float)) + sizeof(int8_t)));
+    if (rowLength == length) {
+        DynamicQuantTensor(param, symmetric, scale, offset);
+    } else {
+        DynamicQuantRows(param, rowLength, symmetric, scale, offset);
+    }
+    return AmctCommon::SUCCESS;
+}
+
+
+int FakeQuantFp8(InputDataParam param, int64_t fp8Format, const float* scale, int64_t channelNum, int64_t innerSize)
+{
+    int64_t length = static_cast<int64_t>(param.length);
+    if (channelNum <= 0 || innerSize <= 0 || length % (channelNum * innerSize) != 0) {
+        return AmctCommon::BAD_PARAMETERS_ERROR;
+    }
+    AmctCommon::Fp8Format format = static_cast<AmctCommon::Fp8Format>(fp8Format);
+    AmctCommon::ScratchScope scratch;
+    const float* in = reinterpret_cast<const float*>(param.in);
+    if (IsHalfType(param.inType)) {
+        float* inCast = scratch.Allocate<float>(param.length);
+        CastToFloat32(param.in, param.inType, inCast, length);
+        in = inCast;
+    }
+    bool encode = param.outType == INT8_TYPE_ID;
+    float* out = reinterpret_cast<float*>(param.out);
+    if (IsHalfType(param.outType)) {
+        out = scratch.Allocate<float>(param.length);
+    }
+    // elements [begin, end) of one channel
+    auto quantRange = [&](int64_t begin, int64_t end, float channelScale) {
+        if (encode) {
+            AmctCommon::Fp8EncodeKernel(in + begin, reinterpret_cast<uint8_t*>(param.out) + begin, end - begin,
+                channelScale, format);
+        } else {
+            AmctCommon::Fp8RoundKernel(in + begin, out + begin, end - begin, channelScale, format);
+        }
+    };
+    {
+        AmctCommon::ProfileScope profile("fake_quant_fp8", length,
+            length * (sizeof(float) + (encode ? sizeof(uint8_t) : sizeof(float))));
+        if (channelNum == 1) {
+            AmctCommon::ParallelFor(length, [&](int64_t begin, int64_t end) {
+                quantRange(begin, end, scale[0]);
+            });
+        } else {
+            ParallelForRows(length / innerSize, innerSize, [&](int64_t begin, int64_t end) {
+                for (int64_t row = begin; row < end; ++row) {
+                    quantRange(row * innerSize, (row + 1) * innerSize, scale[row % channelNum]);
+                }
+            });
+        }
+    }
+    if (IsHalfType(param.outType)) {
+        CastFromFloat32(out, param.out, param.outType, length);
+    }
+    return AmctCommon::SUCCESS;
+}
+
+
+int FakeAntiQuantFp8(InputDataParam param, int64_t fp8Format, float scaleData)
+{
+    int64_t length = static_cast<int64_t>(param.length);
+    if (param.inType != INT8_TYPE_ID) {
+        return AmctCommon::BAD_PARAMETERS_ERROR;
+    }
+    AmctCommon::Fp8Format format = static_cast<AmctCommon::Fp8Format>(fp8Format);
+    AmctCommon::ScratchScope scratch;
+    float* out = reinterpret_cast<float*>(param.out);
+    if (IsHalfType(param.outType)) {
+        out = scratch.Allocate<float>(param.length);
+    }
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(param.in);
+    {
+        AmctCommon::ProfileScope profile("fake_antiquant_fp8", length, length * (sizeof(uint8_t) + sizeof(float)));
+        AmctCommon::ParallelFor(length, [&](int64_t begin, int64_t end) {
+            AmctCommon::Fp8DecodeKernel(in + begin, out + begin, end - begin, scaleData, format);
+        });
+    }
+    if (IsHalfType(param.outType)) {
+        CastFromFloat32(out, param.out, param.outType, length);
+    }
+    return AmctCommon::SUCCESS;
+}
+
+namespace {
+constexpr int64_t NUQ_PACKED_CODE_BITS = 4;
+constexpr int64_t NUQ_BYTE_CODE_BITS = 8;
+
+template<class T>
+inline void NuqLutRow(const uint8_t* in, T* out, const T* table, int64_t rowLength, int32_t tableStride,
+    uint32_t maxCode)
+{
+#pragma omp simd
+    for (int64_t j = 0; j < rowLength; ++j) {
+        int32_t code = static_cast<int32_t>(std::min(static_cast<uint32_t>(in[j]), maxCode));
+        out[j] = table[static_cast<int32_t>(j) * tableStride + code];
+    }
+}
+
+// two codes per byte, the even element of a pair in the low nibble
+template<class T>
+inline void NuqLutPackedRow(const uint8_t* in, T* out, const T* table, int64_t rowLength, int32_t tableStride,
+    uint32_t maxCode)
+{
+    int64_t pairNum = rowLength / INT4_PER_BYTE;
+#pragma omp simd
+    for (int64_t i = 0; i < pairNum; ++i) {
+        uint32_t packed = in[i];
+        int32_t index = static_cast<int32_t>(i) * static_cast<int32_t>(INT4_PER_BYTE) * tableStride;
+        int32_t low = static_cast<int32_t>(std::min(packed & static_cast<uint32_t>(INT4_NIBBLE_MASK), maxCode));
+        int32_t high = static_cast<int32_t>(std::min(packed >> INT4_NIBBLE_BITS, maxCode));
+        out[INT4_PER_BYTE * i] = table[index + low];
+        out[INT4_PER_BYTE * i + 1] = table[index + tableStride + high];
+    }
+    if (rowLength != pairNum * INT4_PER_BYTE) {
+        uint32_t low = std::min(static_cast<uint32_t>(in[pairNum]) & static_cast<uint32_t>(INT4_NIBBLE_MASK), maxCode);
+        out[rowLength - 1] = table[(rowLength - 1) * tableStride + low];
+    }
+}
+
+template<class T>
+Status NuqLutKernel(const uint8_t* codes, T* outputData, int64_t length, const T* table, const NuqLutParam& nuqParam)
+{
+    int64_t rowLength = nuqParam.rowLength;
+    int64_t rowNum = length / rowLength;
+    bool packed = nuqParam.codeBits == NUQ_PACKED_CODE_BITS;
+    int64_t codeRow = packed ? (rowLength + 1) / INT4_PER_BYTE : rowLength;
+    uint32_t maxCode = static_cast<uint32_t>(nuqParam.numSteps - 1);
+    // channels along the last axis give every element of a row its own table, otherwise a row shares one table
+    bool lastAxis = nuqParam.innerSize == 1 && nuqParam.rowLength > 1;
+    int32_t tableStride = lastAxis ? static_cast<int32_t>(nuqParam.numSteps) : 0;
+    int64_t rowsPerChannel = lastAxis ? 1 : nuqParam.innerSize / rowLength;
+    AmctCommon::ProfileScope profile("nuq_lut_antiquant", length, rowNum * codeRow + length * sizeof(T));
+    ParallelForRows(rowNum, rowLength, [&](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row < end; ++row) {
+            const T* rowTable = lastAxis ? table :
+                table + (row / rowsPerChannel % nuqParam.channelNum) * nuqParam.numSteps;
+            if (packed) {
+                NuqLutPackedRow(codes + row * codeRow, outputData + row * rowLength, rowTable, rowLength,
+                    tableStride, maxCode);
+            } else {
+                NuqLutRow(codes + row * codeRow, outputData + row * rowLength, rowTable, rowLength, tableStride,
+                    maxCode);
+            }
+        }
+    });
+    return AmctCommon::SUCCESS;
+}
+
+int CheckNuqLutParam(const InputDataParam& param, const NuqLutParam& nuqParam)
+{
+    int64_t length = static_cast<int64_t>(param.length);
+    if (nuqParam.codeBits != NUQ_PACKED_CODE_BITS && nuqParam.codeBits != NUQ_BYTE_CODE_BITS) {
+        return AmctCommon::BAD_PARAMETERS_ERROR;
+    }
+    if (nuqParam.numSteps <= 0 || nuqParam.numSteps > (1LL << nuqParam.codeBits) || nuqParam.rowLength <= 0 ||
+        length % nuqParam.rowLength != 0 || nuqParam.channelNum <= 0 || nuqParam.innerSize <= 0 ||
+        length % (nuqParam.channelNum * nuqParam.innerSize) != 0) {
+        return AmctCommon::BAD_PARAMETERS_ERROR;
+    }
+    // table indexes are 32 bit, a table covers whole rows unless the channels are the last axis
+    bool lastAxis = nuqParam.innerSize == 1 && nuqParam.rowLength > 1;
+    if (nuqParam.channelNum * nuqParam.numSteps > INT32_MAX ||
+        (lastAxis && nuqParam.channelNum != nuqParam.rowLength) ||
+        (!lastAxis && nuqParam.innerSize % nuqParam.rowLength != 0)) {
+        return AmctCommon::BAD_PARAMETERS_ERROR;
+    }
+    return AmctCommon::SUCCESS;
+}
+}
+
+
+int NuqLutAntiQuant(InputDataParam param, NuqLutParam nuqParam)
+{
+    int ret = CheckNuqLutParam(param, nuqParam);
+    if (ret != AmctCommon::SUCCESS) {
+        return ret;
+    }
+    int64_t length = static_cast<int64_t>(param.length);
+    const uint8_t* codes = reinterpret_cast<const uint8_t*>(param.in);
+    if (IsHalfType(param.outType)) {
+        // the table is cast once, the lookup then writes the 16 bit values directly
+        AmctCommon::ScratchScope scratch;
+        int64_t tableSize = nuqParam.channelNum * nuqParam.numSteps;
+        uint16_t* table = scratch.Allocate<uint16_t>(static_cast<size_t>(tableSize));
+        CastFromFloat32(nuqParam.centroids, table, param.outType, tableSize);
+        return NuqLutKernel(codes, reinterpret_cast<uint16_t*>(param.out), length, table, nuqParam);
+    }
+    return NuqLutKernel(codes, reinterpret_cast<float*>(param.out), length, nuqParam.centroids, nuqParam);
+}
+
+namespace {
+constexpr int INT32_TYPE_ID = 6;
+constexpr int REQUANT_MULTIPLIER_BITS = 31;
+constexpr int64_t REQUANT_MAX_SHIFT = 62;
+constexpr uint32_t REQUANT_MAX_PRE_SHIFT = 31;
+constexpr int64_t REQUANT_INT8_MIN = -128;
+constexpr int64_t REQUANT_INT8_MAX = 127;
+constexpr int INT64_SIGN_SHIFT = 63;
+
+// per channel: x >> preShift, clipped, times multiplier * 2^-shift, half is 2^(shift - 1)
+struct RequantTable {
+    const uint32_t* multiplier;
+    const uint64_t* shift;
+    const int64_t* half;
+    const uint32_t* preShift;
+    int64_t clipMin;
+    int64_t clipMax;
+    int64_t offset;
+};
+
+// m = multiplier * 2^-shift with a 31 bit multiplier, factors out of that range saturate or flush to zero
+void GetRequantMultiplier(double m, uint32_t& multiplier, uint64_t& shift)
+{
+    int exponent = 0;
+    double fraction = frexp(m, &exponent);
+    int64_t rounded = llround(ldexp(fraction, REQUANT_MULTIPLIER_BITS));
+    if (rounded == (1LL << REQUANT_MULTIPLIER_BITS)) {
+        rounded /= BINARY_BASE;
+        ++exponent;
+    }
+    int64_t totalShift = REQUANT_MULTIPLIER_BITS - exponent;
+    multiplier = static_cast<uint32_t>(rounded);
+    shift = static_cast<uint64_t>(totalShift);
+    if (totalShift > REQUANT_MAX_SHIFT) {
+        multiplier = 0;
+        shift = 1;
+    } else if (totalShift < 1) {
+        multiplier = INT32_MAX;
+        shift = 1;
+    }
+}
+
+// the magnitude is rounded with an unsigned 32x32 bit product and logical shifts, half to even is symmetric like rint
+inline int8_t RequantValue(int32_t x, uint32_t multiplier, uint64_t shift, int64_t half, uint32_t preShift,
+    const RequantTable& table)
+{
+    int64_t value = static_cast<int64_t>(x >> preShift);
+    value = std::min(std::max(value, table.clipMin), table.clipMax);
+    int64_t sign = value >> INT64_SIGN_SHIFT;
+    uint64_t magnitude = static_cast<uint64_t>((value ^ sign) - sign);
+    uint64_t product = static_cast<uint64_t>(static_cast<uint32_t>(magnitude)) * multiplier;
+    uint64_t quotient = product >> shift;
+    int64_t remainder = static_cast<int64_t>(product - (quotient << shift));
+    int64_t rounded = static_cast<int64_t>(quotient);
+    rounded += static_cast<int64_t>(remainder > half) | (static_cast<int64_t>(remainder == half) & rounded);
+    rounded = (rounded ^ sign) - sign;
+    return static_cast<int8_t>(std::min(std::max(rounded + table.offset, REQUANT_INT8_MIN), REQUANT_INT8_MAX));
+}
+
+// a row of one channel
+void RequantRow(const int32_t* in, int8_t* out, int64_t length, int64_t channel, const RequantTable& table)
+{
+    uint32_t multiplier = table.multiplier[channel];
+    uint64_t shift = table.shift[channel];
+    int64_t half = table.half[channel];
+    uint32_t preShift = table.preShift[channel];
+    RequantTable rowTable = table;
+#pragma omp simd
+    for (int64_t j = 0; j < length; ++j) {
+        out[j] = RequantValue(in[j], multiplier, shift, half, preShift, rowTable);
+    }
+}
+
+// channels along the last axis, element j of a row is channel j
+void RequantChannelRow(const int32_t* in, int8_t* out, int64_t length, const RequantTable& table)
+{
+    const uint32_t* multiplier = table.multiplier;
+    const uint64_t* shift = table.shift;
+    const int64_t* half = table.half;
+    const uint32_t* preShift = table.preShift;
+    RequantTable rowTable = table;
+#pragma omp simd
+    for (int64_t j = 0; j < length; ++j) {
+        out[j] = RequantValue(in[j], multiplier[j], shift[j], half[j], preShift[j], rowTable);
+    }
+}
+}
+
+
+int Requant(InputDataParam param, RequantParam requantParam)
+{
+    int64_t length = static_cast<int64_t>(param.length);
+    int64_t channelNum = requantParam.channelNum;
+    int64_t innerSize = requantParam.innerSize;
+    if (param.inType != INT32_TYPE_ID || param.outType != INT8_TYPE_ID || channelNum <= 0 || innerSize <= 0 ||
+        length % (channelNum * innerSize) != 0) {
+        return AmctCommon::BAD_PARAMETERS_ERROR;
+    }
+    // the AscendDequant params, deq_scale in the low 32 bits and shift_n in the next 8
+    const uint64_t shiftnMask = 0x000000ff00000000;
+    const uint64_t deqscaleMask = 0x00000000ffffffff;
+    AmctCommon::ScratchScope scratch;
+    size_t tableSize = static_cast<size_t>(channelNum);
+    uint32_t* multiplier = scratch.Allocate<uint32_t>(tableSize);
+    uint64_t* shift = scratch.Allocate<uint64_t>(tableSize);
+    int64_t* half = scratch.Allocate<int64_t>(tableSize);
+    uint32_t* preShift = scratch.Allocate<uint32_t>(tableSize);
+    int64_t clipMode = CLIP_32;
+    for (int64_t c = 0; c < channelNum; ++c) {
+        uint32_t shiftValue = static_cast<uint32_t>((requantParam.paramData[c] & shiftnMask) >> SHIFT_VAL_LEN);
+        uint32_t deqscaleUint = static_cast<uint32_t>(requantParam.paramData[c] & deqscaleMask);
+        float deqScale = 0;
+        memcpy(&deqScale, &deqscaleUint, sizeof(deqScale));
+        if (shiftValue != 0) {
+            clipMode = CLIP_16;
+        }
+        double factor = static_cast<double>(deqScale) * ldexp(1.0, static_cast<int>(shiftValue)) *
+            static_cast<double>(requantParam.scale);
+        if (!std::isfinite(factor) || factor < 0) {
+            return AmctCommon::BAD_PARAMETERS_ERROR;
+        }
+        GetRequantMultiplier(factor, multiplier[c], shift[c]);
+        half[c] = 1LL << (shift[c] - 1);
+        preShift[c] = std::min(shiftValue, REQUANT_MAX_PRE_SHIFT);
+    }
+    RequantTable table = {multiplier, shift, half, preShift, -(1LL << (clipMode - 1)), (1LL << (clipMode - 1)) - 1,
+        requantParam.offset};
+
+    const int32_t* in = reinterpret_cast<const int32_t*>(param.in);
+    int8_t* out = reinterpret_cast<int8_t*>(param.out);
+    AmctCommon::ProfileScope profile("requant", length, length * (sizeof(int32_t) + sizeof(int8_t)));
+    if (channelNum > 1 && innerSize == 1) {
+        ParallelForRows(length / channelNum, channelNum, [&](int64_t begin, int64_t end) {
+            for (int64_t row = begin; row < end; ++row) {
+                RequantChannelRow(in + row * channelNum, out + row * channelNum, channelNum, table);
+            }
+        });
+        return AmctCommon::SUCCESS;
+    }
+    ParallelForRows(length / innerSize, innerSize, [&](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row < end; ++row) {
+            RequantRow(in + row * innerSize, out + row * innerSize, innerSize, row % channelNum, table);
+        }
+    });
+    return AmctCommon::SUCCESS;
+}
@@ -17,11 +17,14 @@
  * @version 1.0
  */
 
+#include <algorithm>
 
 #include "dmq_balance_kernel.h"
 #include "amct_utils.h"
 #include "cast_util.h"
 #include "dmq_balance.h"
+#include "record_store.h"
+#include "calibration_state.h"
 
 DMQBalanceKernel::DMQBalanceKernel(const OrtApi &api, const OrtKernelInfo *info) : api_(api)
 {
@@ -32,11 +35,27 @@ DMQBalanceKernel::DMQBalanceKernel(const OrtApi &api, const OrtKernelInfo *info)
     channelNum_ = channelNum;
     objectLayerName_ = AmctUtils::GetStringAttr(api_, info, "object_layer");
     recordFileName_ = AmctUtils::GetStringAttr(api_, info, "record_file_path");
+    batchNum_ = AmctUtils::GetInt64AttrOrDefault(api_, info, "batch_num", 0);
+    stateDir_ = AmctCommon::GetPartialStateDir();
+#ifdef USE_CUDA
+    if (!stateDir_.empty()) {
+        LOG_ERROR("Partial calibration state of \"%s\" is only saved by the CPU DMQBalancer.\n",
+            objectLayerName_.c_str());
+    }
+#endif
+}
+
+DMQBalanceKernel::~DMQBalanceKernel()
+{
+    // without batch_num the last batch is only known once the session is released
+    if (batchNum_ <= 0) {
+        SavePartialState();
+    }
 }
 
 void DMQBalanceKernel::GetInput(OrtKernelContext* context, uint32_t index, std::vector<float> &inputData)
 {
-    const OrtValue* input = AmctUtils::GetKernelInput(api_, context, 0);
+    const OrtValue* input = AmctUtils::GetKernelInput(api_, context, index);
     OrtTensorTypeAndShapeInfo* inputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, input);
     size_t inputSize = AmctUtils::GetElementCount(api_, inputInfo);
     AmctUtils::CheckTensorNotEmpty(inputSize);
@@ -48,6 +67,36 @@ void DMQBalanceKernel::GetInput(OrtKernelContext* context, uint32_t index, std::
     return;
 }
 
+void DMQBalanceKernel::UpdatePartialState(const std::vector<float>& actData, const std::vector<float>& wtsData)
+{
+    if (stateDir_.empty()) {
+        return;
+    }
+    // the serial op balances on the current batch only, so the state keeps the last batch as well
+    AmctCommon::ChannelAbsMax(actData.data(), actData.size(), channelNum_, actMax_);
+    AmctCommon::ChannelAbsMax(wtsData.data(), wtsData.size(), channelNum_, wtsMax_);
+    batchCount_++;
+    if (batchNum_ > 0 && batchCount_ == static_cast<uint64_t>(batchNum_)) {
+        SavePartialState();
+    }
+}
+
+void DMQBalanceKernel::SavePartialState()
+{
+    if (stateDir_.empty() || batchCount_ == 0) {
+        return;
+    }
+    AmctCommon::CalibrationState state;
+    state.type = AmctCommon::CalibratorType::DMQ_BALANCE;
+    state.batchCount = batchCount_;
+    state.recordInfo.objectLayerNames = {AmctUtils::TrimTailSpace(objectLayerName_)};
+    state.migrationStrength = migrationStrength_;
+    state.channelNum = channelNum_;
+    state.actMax = actMax_;
+    state.wtsMax = wtsMax_;
+    (void)AmctCommon::SavePartialCalibrationState(stateDir_, state);
+}
+
 #if ORT_API_VERSION >= 16
 OrtStatusPtr DMQBalanceKernel::ComputeV2(OrtKernelContext* context)
 {
@@ -58,6 +107,7 @@ OrtStatusPtr DMQBalanceKernel::ComputeV2(OrtKernelContext* context)
 
 void DMQBalanceKernel::Compute(OrtKernelContext* context)
 {
+    AmctCommon::ProfileOpScope profile("DMQBalancer");
     std::vector<float> dmqbFactor(channelNum_, 0);
 
 #ifdef USE_CUDA
@@ -93,6 +143,7 @@ void DMQBalanceKernel::Compute(OrtKernelContext* context)
     std::vector<float> wtsData;
     GetInput(context, 1, wtsData);
     util::FloatData wts = {static_cast<unsigned int>(wtsData.size()), wtsData.data()};
+    UpdatePartialState(actData, wtsData);
     int ret = AmctCommon::DMQBalance(act, wts, migrationStrength_, channelNum_, dmqbFactor.data());
     if (ret != 0) {
         LOG_ERROR("Do \"%s\" DMQBalance failed, error code: %d.\n", objectLayerName_.c_str(), ret);
@@ -107,7 +158,8 @@ void DMQBalanceKernel::Compute(OrtKernelContext* context)
 
     std::string trimedRecordFileName = AmctUtils::TrimTailSpace(recordFileName_);
     std::string trimedLayerName = AmctUtils::TrimTailSpace(objectLayerName_);
-    ret = util::RecordRepeatData(trimedRecordFileName, trimedLayerName, dmqbFactor, "tensor_balance_factor");
+    ret = AmctCommon::RecordStore::Instance().RecordRepeatData(trimedRecordFileName, trimedLayerName, dmqbFactor,
+        "tensor_balance_factor");
     if (ret != AmctCommon::SUCCESS) {
         return;
     }
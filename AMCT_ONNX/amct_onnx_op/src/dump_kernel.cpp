@@ -18,10 +18,23 @@
  */
 
 #include "dump_kernel.h"
+#include <map>
 #include <sstream>
 #include "amct_utils.h"
+#include "cast_util.h"
+#include "dump_stats.h"
 #include "util.h"
 
+namespace {
+const std::map<std::string, DumpMode> DUMP_MODES = {
+    {"RAW", DumpMode::RAW},
+    {"STATS", DumpMode::STATS},
+    {"SAMPLED", DumpMode::SAMPLED}
+};
+const std::string SAMPLE_DTYPE_FLOAT16 = "FLOAT16";
+const std::string SAMPLE_DTYPE_INT8 = "INT8";
+}
+
 
 DUMPKernel::DUMPKernel(const OrtApi& api, const OrtKernelInfo* info)
     : api_(api)
@@ -39,10 +52,28 @@ DUMPKernel::DUMPKernel(const OrtApi& api, const OrtKernelInfo* info)
     }
     dumpDir_ = AmctUtils::GetStringAttr(api_, info, "dump_dir");
     dumpStamp_ = AmctUtils::GetStringAttr(api_, info, "dump_stamp");
+
+    std::string dumpMode = AmctUtils::GetStringAttrOrDefault(api_, info, "dump_mode", "RAW");
+    auto dumpModeItem = DUMP_MODES.find(dumpMode);
+    if (dumpModeItem == DUMP_MODES.end()) {
+        std::string errMsg = "Cannot support DUMP with \"dump_mode\": " + dumpMode;
+        ORT_CXX_API_THROW(errMsg.c_str(), ORT_FAIL);
+    }
+    dumpMode_ = dumpModeItem->second;
+    dumpInterval_ = std::max<int64_t>(AmctUtils::GetInt64AttrOrDefault(api_, info, "dump_interval", 1), 1);
+    sampleStride_ = std::max<int64_t>(AmctUtils::GetInt64AttrOrDefault(api_, info, "sample_stride", 1), 1);
+    sampleDtype_ = AmctUtils::GetStringAttrOrDefault(api_, info, "sample_dtype", "");
+    if (!sampleDtype_.empty() && sampleDtype_ != SAMPLE_DTYPE_FLOAT16 && sampleDtype_ != SAMPLE_DTYPE_INT8) {
+        std::string errMsg = "Cannot support DUMP with \"sample_dtype\": " + sampleDtype_;
+        ORT_CXX_API_THROW(errMsg.c_str(), ORT_FAIL);
+    }
+    histBins_ = AmctUtils::GetInt64AttrOrDefault(api_, info, "hist_bins", AmctCommon::DEFAULT_HIST_BINS);
+    if (histBins_ <= 0) {
+        ORT_CXX_API_THROW("DUMP attribute \"hist_bins\" must be positive", ORT_FAIL);
+    }
 }
 
-void DUMPKernel::DumpData(const void* x, const int inputSize, const std::vector<int32_t>& inputShapeFlt,
-    std::string objectLayerName)
+std::string DUMPKernel::GetDumpFileName(std::string objectLayerName, int64_t batch, const std::string& suffix)
 {
     std::string trimedLayerName = AmctUtils::TrimTailSpace(objectLayerName);
     std::string trimedDumpDir = AmctUtils::TrimTailSpace(dumpDir_);
@@ -50,11 +81,90 @@ void DUMPKernel::DumpData(const void* x, const int inputSize, const std::vector<
     AmctUtils::ConvertLayerName(trimedLayerName, "/", "_");
     std::stringstream ss;
     ss << trimedDumpDir << '/' << trimedLayerName << \
-        "_act_calibration_layer_" << trimedDumpStamp << "_" << std::to_string(currentBatch_) << ".bin";
-    std::string fileName = ss.str();
+        "_act_calibration_layer_" << trimedDumpStamp << "_" << std::to_string(batch) << suffix;
+    return ss.str();
+}
+
+void DUMPKernel::DumpData(const void* x, const int inputSize, const std::vector<int32_t>& inputShapeFlt,
+    std::string objectLayerName, int64_t batch)
+{
+    AmctCommon::ProfileScope profile("dump_write", 0, static_cast<uint64_t>(inputSize));
+    std::string fileName = GetDumpFileName(objectLayerName, batch, ".bin");
     AmctUtils::AmctDumpData(fileName.c_str(), inputShapeFlt.data(), inputShapeFlt.size(), x, inputSize);
 }
 
+void DUMPKernel::DumpStats(const void* x, size_t inputSize, int opDtype, const std::vector<int64_t>& inputShape,
+    int64_t batch)
+{
+    AmctCommon::ProfileScope profile("dump_stats", inputSize);
+    std::vector<float> floatData(inputSize);
+    AmctUtils::SaveInputDataToFloat32(x, floatData.data(), inputSize, opDtype);
+    // channel axis is 1 for NCHW and NC inputs, lower ranks only have tensor statistics
+    AmctCommon::DumpStatsParam param = {1, 1, static_cast<int64_t>(inputSize), static_cast<unsigned int>(histBins_)};
+    if (inputShape.size() >= NUM_TWO && inputShape[0] > 0 && inputShape[1] > 0) {
+        param.outerNum = inputShape[0];
+        param.channelNum = inputShape[1];
+        param.innerNum = static_cast<int64_t>(inputSize) / (param.outerNum * param.channelNum);
+    }
+    AmctCommon::DumpStatsResult result;
+    int ret = AmctCommon::ComputeDumpStats(floatData.data(), param, result);
+    if (ret != AmctCommon::SUCCESS) {
+        LOG_ERROR("Do ComputeDumpStats failed, error code: %d.\n", ret);
+        return;
+    }
+    for (auto objectLayerName : objectLayerNames_) {
+        AmctCommon::WriteDumpStats(GetDumpFileName(objectLayerName, batch, ".stats.txt"), inputShape, result);
+    }
+}
+
+void DUMPKernel::DumpSampledData(const void* x, size_t inputSize, int opDtype, int64_t batch)
+{
+    AmctCommon::ProfileScope profile("dump_sample", inputSize);
+    size_t stride = static_cast<size_t>(sampleStride_);
+    // the sampled data loses the tensor layout, it is dumped as a 1-D tensor
+    size_t sampleSize = (inputSize + stride - 1) / stride;
+    std::vector<int32_t> sampleShape = {1, static_cast<int32_t>(sampleSize)};
+    std::vector<uint16_t> halfData;
+    std::vector<float> floatData;
+    if (opDtype == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16) {
+        AmctCommon::SampleData(reinterpret_cast<const uint16_t*>(x), inputSize, stride, halfData);
+        if (sampleDtype_ == SAMPLE_DTYPE_INT8) {
+            floatData.resize(sampleSize);
+            util::DataCastToFloat32Functor<util::CPUDevice, uint16_t>()(halfData.data(), floatData.data(),
+                sampleSize);
+        }
+    } else {
+        AmctCommon::SampleData(reinterpret_cast<const float*>(x), inputSize, stride, floatData);
+        if (sampleDtype_ == SAMPLE_DTYPE_FLOAT16) {
+            halfData.resize(sampleSize);
+            util::DataCastToFloat16Functor<util::CPUDevice, float>()(floatData.data(), halfData.data(), sampleSize);
+        }
+    }
+
+    for (auto objectLayerName : objectLayerNames_) {
+        if (sampleDtype_ == SAMPLE_DTYPE_INT8) {
+            // layout: shape header, float scale, int8 data; data ~= int8 * scale
+            std::vector<int8_t> int8Data(sampleSize);
+            float scale = AmctCommon::DowncastToInt8(floatData.data(), sampleSize, int8Data.data());
+            std::string fileName = GetDumpFileName(objectLayerName, batch, ".int8.bin");
+            std::ofstream out(fileName, std::ios::binary);
+            CHECK_TRUE_RETURN_WITH_LOG(!out.is_open(), "DUMP fail to open file %s.\n", fileName.c_str());
+            out.write(reinterpret_cast<const char*>(sampleShape.data()), sizeof(int32_t) * sampleShape.size());
+            out.write(reinterpret_cast<const char*>(&scale), sizeof(float));
+            out.write(reinterpret_cast<const char*>(int8Data.data()), sampleSize);
+            out.close();
+        } else if (!halfData.empty()) {
+            std::string fileName = GetDumpFileName(objectLayerName, batch, ".sampled.bin");
+            AmctUtils::AmctDumpData(fileName.c_str(), sampleShape.data(), sampleShape.size(), halfData.data(),
+                sizeof(uint16_t) * sampleSize);
+        } else {
+            std::string fileName = GetDumpFileName(objectLayerName, batch, ".sampled.bin");
+            AmctUtils::AmctDumpData(fileName.c_str(), sampleShape.data(), sampleShape.size(), floatData.data(),
+                sizeof(float) * sampleSize);
+        }
+    }
+}
+
 #if ORT_API_VERSION >= 16
 OrtStatusPtr DUMPKernel::ComputeV2(OrtKernelContext* context)
 {
@@ -65,9 +175,13 @@ OrtStatusPtr DUMPKernel::ComputeV2(OrtKernelContext* context)
 
 void DUMPKernel::Compute(OrtKernelContext* context)
 {
+    AmctCommon::ProfileOpScope profile("DUMP");
     // dump count control
-    currentBatch_++;
-    if (currentBatch_ > bathNum_) {
+    int64_t batch = ++currentBatch_;
+    if (batch > bathNum_) {
+        return;
+    }
+    if (dumpMode_ == DumpMode::SAMPLED && (batch - 1) % dumpInterval_ != 0) {
         return;
     }
     const OrtValue* inputX = AmctUtils::GetKernelInput(api_, context, 0);
@@ -96,8 +210,16 @@ void DUMPKernel::Compute(OrtKernelContext* context)
         LOG_ERROR("Wrong input data type. Only support float16 and float32 for dump.\n");
         return;
     }
+    if (dumpMode_ == DumpMode::STATS) {
+        DumpStats(x, inputSize, opDtype, inputShape, batch);
+        return;
+    }
+    if (dumpMode_ == DumpMode::SAMPLED) {
+        DumpSampledData(x, inputSize, opDtype, batch);
+        return;
+    }
     // dump data
     for (auto objectLayerName : objectLayerNames_) {
-        this->DumpData(x, dataByteCount, inputShapeFlt, objectLayerName);
+        this->DumpData(x, dataByteCount, inputShapeFlt, objectLayerName, batch);
     }
 }
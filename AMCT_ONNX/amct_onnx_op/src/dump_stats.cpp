@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief dump statistics C++ implementation
+ *
+ * @file dump_stats.cpp
+ *
+ * @version 1.0
+ */
+
+#include "dump_stats.h"
+
+#include <cfloat>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace AmctCommon {
+namespace {
+struct BlockAccumulator {
+    uint64_t count = 0;
+    float minValue = FLT_MAX;
+    float maxValue = -FLT_MAX;
+    double mean = 0;
+    // sum of squared deviations from mean
+    double m2 = 0;
+    uint64_t zeroCount = 0;
+};
+
+// Chan et al. pairwise update, so the variance never comes from E[x^2] - E[x]^2
+void MergeMoments(uint64_t srcCount, double srcMean, double srcM2, BlockAccumulator& dst)
+{
+    if (srcCount == 0) {
+        return;
+    }
+    double count = static_cast<double>(dst.count + srcCount);
+    double delta = srcMean - dst.mean;
+    double srcWeight = static_cast<double>(srcCount) / count;
+    dst.mean += delta * srcWeight;
+    dst.m2 += srcM2 + delta * delta * static_cast<double>(dst.count) * srcWeight;
+    dst.count += srcCount;
+}
+
+// min, max, moments and zero count of one contiguous block in a single pass. Values are
+// shifted by the first element and summed in double so a large mean does not cancel the spread.
+void AccumulateBlock(const float* data, int64_t length, BlockAccumulator& acc)
+{
+    if (length <= 0) {
+        return;
+    }
+    float blockMin = FLT_MAX;
+    float blockMax = -FLT_MAX;
+    double shift = data[0];
+    double blockSum = 0;
+    double blockSquareSum = 0;
+    int64_t blockZeros = 0;
+#pragma omp simd reduction(min:blockMin) reduction(max:blockMax) reduction(+:blockSum, blockSquareSum, blockZeros)
+    for (int64_t i = 0; i < length; i++) {
+        float value = data[i];
+        double shifted = static_cast<double>(value) - shift;
+        blockMin = value < blockMin ? value : blockMin;
+        blockMax = value > blockMax ? value : blockMax;
+        blockSum += shifted;
+        blockSquareSum += shifted * shifted;
+        blockZeros += (value == 0.0f) ? 1 : 0;
+    }
+    double blockLength = static_cast<double>(length);
+    double blockMean = blockSum / blockLength;
+    double blockM2 = std::max(blockSquareSum - blockSum * blockMean, 0.0);
+    acc.minValue = std::min(acc.minValue, blockMin);
+    acc.maxValue = std::max(acc.maxValue, blockMax);
+    acc.zeroCount += static_cast<uint64_t>(blockZeros);
+    MergeMoments(static_cast<uint64_t>(length), shift + blockMean, blockM2, acc);
+}
+
+void MergeAccumulator(const BlockAccumulator& src, BlockAccumulator& dst)
+{
+    dst.minValue = std::min(dst.minValue, src.minValue);
+    dst.maxValue = std::max(dst.maxValue, src.maxValue);
+    dst.zeroCount += src.zeroCount;
+    MergeMoments(src.count, src.mean, src.m2, dst);
+}
+
+TensorStats ToTensorStats(const BlockAccumulator& acc)
+{
+    TensorStats stats = {acc.count, acc.minValue, acc.maxValue, 0, 0, 0};
+    if (acc.count == 0) {
+        stats.minValue = 0;
+        stats.maxValue = 0;
+        return stats;
+    }
+    double count = static_cast<double>(acc.count);
+    stats.mean = acc.mean;
+    stats.variance = acc.m2 / count;
+    stats.zeroRatio = static_cast<double>(acc.zeroCount) / count;
+    return stats;
+}
+
+void WriteStatsLine(std::ofstream& out, const TensorStats& stats)
+{
+    out << stats.count << ' ' << stats.minValue << ' ' << stats.maxValue << ' ' << stats.mean << ' ' <<
+        stats.variance << ' ' << stats.zeroRatio << '\n';
+}
+}
+
+Status ComputeDumpStats(const float* data, const DumpStatsParam& param, DumpStatsResult& result)
+{
+    NULLPTR_CHECK(data);
+    if (param.outerNum <= 0 || param.channelNum <= 0 || param.innerNum <= 0 || param.histBins == 0) {
+        return BAD_PARAMETERS_ERROR;
+    }
+    std::vector<BlockAccumulator> channelAcc(param.channelNum);
+    const float* block = data;
+    for (int64_t n = 0; n < param.outerNum; n++) {
+        for (int64_t c = 0; c < param.channelNum; c++) {
+            AccumulateBlock(block, param.innerNum, channelAcc[c]);
+            block += param.innerNum;
+        }
+    }
+    BlockAccumulator tensorAcc;
+    result.channelStats.resize(param.channelNum);
+    for (int64_t c = 0; c < param.channelNum; c++) {
+        MergeAccumulator(channelAcc[c], tensorAcc);
+        result.channelStats[c] = ToTensorStats(channelAcc[c]);
+    }
+    result.tensorStats = ToTensorStats(tensorAcc);
+
+    // the histogram range is only known after the reduction, so it takes a second pass
+    result.hist.assign(param.histBins, 0);
+    float histMin = result.tensorStats.minValue;
+    float histRange = result.tensorStats.maxValue - histMin;
+    int64_t length = param.outerNum * param.channelNum * param.innerNum;
+    if (histRange <= 0) {
+        result.hist[0] = static_cast<uint64_t>(length);
+        return SUCCESS;
+    }
+    float binScale = static_cast<float>(param.histBins) / histRange;
+    int64_t lastBin = static_cast<int64_t>(param.histBins) - 1;
+    for (int64_t i = 0; i < length; i++) {
+        int64_t bin = static_cast<int64_t>((data[i] - histMin) * binScale);
+        bin = bin > lastBin ? lastBin : bin;
+        bin = bin < 0 ? 0 : bin;
+        result.hist[bin]++;
+    }
+    return SUCCESS;
+}
+
+Status WriteDumpStats(const std::string& fileName, const std::vector<int64_t>& shape, const DumpStatsResult& result)
+{
+    std::ofstream out(fileName, std::ios::trunc);
+    if (!out.is_open()) {
+        LOG_ERROR("WriteDumpStats fail to open file %s.\n", fileName.c_str());
+        return RECORD_FILE_OPEN_ERROR;
+    }
+    out.precision(FLT_DIG + 3);
+    out << "shape:";
+    for (auto dim : shape) {
+        out << ' ' << dim;
+    }
+    out << "\n# count min max mean variance zero_ratio\n";
+    out << "tensor: ";
+    WriteStatsLine(out, result.tensorStats);
+    out << "hist_range: " << result.tensorStats.minValue << ' ' << result.tensorStats.maxValue << '\n';
+    out << "hist:";
+    for (auto binCount : result.hist) {
+        out << ' ' << binCount;
+    }
+    out << '\n';
+    for (size_t c = 0; c < result.channelStats.size(); c++) {
+        out << "channel " << c << ": ";
+        WriteStatsLine(out, result.channelStats[c]);
+    }
+    out.close();
+    return SUCCESS;
+}
+
+template <typename T>
+void SampleData(const T* data, size_t length, size_t stride, std::vector<T>& sampleData)
+{
+    stride = stride == 0 ? 1 : stride;
+    sampleData.resize((length + stride - 1) / stride);
+    for (size_t i = 0, j = 0; i < length; i += stride, j++) {
+        sampleData[j] = data[i];
+    }
+}
+
+template void SampleData<float>(const float* data, size_t length, size_t stride, std::vector<float>& sampleData);
+template void SampleData<uint16_t>(const uint16_t* data, size_t length, size_t stride,
+    std::vector<uint16_t>& sampleData);
+
+float DowncastToInt8(const float* data, size_t length, int8_t* int8Data)
+{
+    float absMax = 0;
+#pragma omp simd reduction(max:absMax)
+    for (size_t i = 0; i < length; i++) {
+        float absValue = std::fabs(data[i]);
+        absMax = absValue > absMax ? absValue : absMax;
+    }
+    float scale = absMax > 0 ? absMax / INT8_SAMPLE_MAX : 1.0f;
+    float invScale = 1.0f / scale;
+#pragma omp simd
+    for (size_t i = 0; i < length; i++) {
+        int8Data[i] = static_cast<int8_t>(std::rint(data[i] * invScale));
+    }
+    return scale;
+}
+} // namespace AmctCommon
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief AMCT custom ops
+ *
+ * @file dynamic_ascend_quant_kernel.cpp
+ *
+ * @version 1.0
+ */
+
+#include "amct_utils.h"
+#include "dequant_quant.h"
+#include "dynamic_ascend_quant_kernel.h"
+#include "util.h"
+
+namespace {
+constexpr size_t SCALE_OUTPUT_INDEX = 1;
+constexpr size_t OFFSET_OUTPUT_INDEX = 2;
+}
+
+DynamicAscendQuantKernel::DynamicAscendQuantKernel(const OrtApi &api, const OrtKernelInfo *info) : api_(api)
+{
+    perToken_ = AmctUtils::GetInt64AttrOrDefault(api_, info, "per_token", 1) != 0;
+    symmetric_ = AmctUtils::GetInt64AttrOrDefault(api_, info, "symmetric", 1) != 0;
+}
+
+#if ORT_API_VERSION >= 16
+OrtStatusPtr DynamicAscendQuantKernel::ComputeV2(OrtKernelContext* context)
+{
+    Compute(context);
+    return api_.CreateStatus(ORT_OK, "Success");
+}
+#endif
+
+void DynamicAscendQuantKernel::Compute(OrtKernelContext* context)
+{
+    AmctCommon::ProfileOpScope profile("DynamicAscendQuant");
+    // Setup inputs
+    const OrtValue* inputX = AmctUtils::GetKernelInput(api_, context, 0);
+    OrtTensorTypeAndShapeInfo* inputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, inputX);
+    size_t inputSize = AmctUtils::GetElementCount(api_, inputInfo);
+    AmctUtils::CheckTensorNotEmpty(inputSize);
+    ONNXTensorElementDataType inputTensorType = AmctUtils::GetTensorEleType(api_, inputInfo);
+    api_.ReleaseTensorTypeAndShapeInfo(inputInfo);
+    const void* x = AmctUtils::GetTensorData<void>(api_, inputX);
+
+    // Setup outputs, per token scale and offset keep the input dims with a last axis of 1
+    OrtTensorDimensions dimensions(api_, inputX);
+    int64_t rowLength = static_cast<int64_t>(inputSize);
+    std::vector<int64_t> scaleDims = {1};
+    if (perToken_ && !dimensions.empty()) {
+        rowLength = dimensions.back();
+        scaleDims.assign(dimensions.begin(), dimensions.end());
+        scaleDims.back() = 1;
+    }
+    OrtValue* output = AmctUtils::GetKernelOutput(api_, context, 0, dimensions.data(), dimensions.size());
+    OrtValue* scaleOutput = AmctUtils::GetKernelOutput(api_, context, SCALE_OUTPUT_INDEX, scaleDims.data(),
+        scaleDims.size());
+    OrtValue* offsetOutput = AmctUtils::GetKernelOutput(api_, context, OFFSET_OUTPUT_INDEX, scaleDims.data(),
+        scaleDims.size());
+    void* y = AmctUtils::GetTensorMutableData<void>(api_, output);
+    float* scale = AmctUtils::GetTensorMutableData<float>(api_, scaleOutput);
+    float* offset = AmctUtils::GetTensorMutableData<float>(api_, offsetOutput);
+
+    InputDataParam params = {x, y, static_cast<int64_t>(inputTensorType),
+        static_cast<int64_t>(ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8), inputSize, 0};
+    int ret = DynamicQuant(params, rowLength, symmetric_, scale, offset);
+    if (ret != 0) {
+        LOG_ERROR("Do DynamicAscendQuant compute failed, error code: %d.\n", ret);
+    }
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief fp8 quantization C++ implement
+ *
+ * @file fp8_quant.cpp
+ *
+ * @version 1.0
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "fp8_quant.h"
+
+namespace AmctCommon {
+namespace {
+constexpr uint32_t FP32_SIGN_MASK = 0x80000000;
+constexpr uint32_t FP32_ABS_MASK = 0x7fffffff;
+constexpr uint32_t FP32_EXP_MASK = 0x7f800000;
+constexpr uint32_t FP32_INF_BITS = 0x7f800000;
+constexpr int32_t FP32_EXP_SHIFT = 23;
+constexpr int32_t FP32_BIAS = 127;
+// bits of 1 / x for a power of two x: the exponent field is mirrored around the bias
+constexpr int32_t FP32_RECIPROCAL_BITS = (2 * FP32_BIAS) << FP32_EXP_SHIFT;
+// adding and subtracting 1.5 * 2^23 rounds a float below 2^22 to an integer, to nearest even
+constexpr float ROUND_MAGIC = 12582912.0f;
+constexpr uint32_t FP8_SIGN_SHIFT = 24;
+constexpr uint32_t FP8_NAN = 0x7f;
+constexpr int FP8_VALUE_NUM = 256;
+constexpr uint32_t FP8_SIGN_BIT = 0x80;
+
+struct Fp8Spec {
+    int32_t mantBits;
+    int32_t bias;
+    float maxValue;
+    float minNormal;
+    float subnormalStep;
+};
+
+Fp8Spec GetFp8Spec(Fp8Format format)
+{
+    if (format == Fp8Format::E5M2) {
+        return {2, 15, 57344.0f, std::ldexp(1.0f, -14), std::ldexp(1.0f, -16)};
+    }
+    return {3, 7, 448.0f, std::ldexp(1.0f, -6), std::ldexp(1.0f, -9)};
+}
+
+inline uint32_t FloatBits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline float BitsFloat(uint32_t bits)
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// fp32 bit patterns of the format limits, the rounding works on bits so that the loops have no branches
+struct Fp8Bits {
+    int32_t mantBits;
+    int32_t bias;
+    uint32_t maxBits;
+    uint32_t minNormalBits;
+    int32_t minStepBits;
+    float subnormalInv;
+};
+
+Fp8Bits GetFp8Bits(Fp8Format format)
+{
+    Fp8Spec spec = GetFp8Spec(format);
+    return {spec.mantBits, spec.bias, FloatBits(spec.maxValue), FloatBits(spec.minNormal),
+        static_cast<int32_t>(FloatBits(spec.subnormalStep)), 1.0f / spec.subnormalStep};
+}
+
+// all ones for a nan, selected with masks because a branch around the float math blocks vectorization
+inline uint32_t NanMask(uint32_t absBits)
+{
+    return 0U - static_cast<uint32_t>(absBits > FP32_INF_BITS);
+}
+
+// magnitude of x rounded to the fp8 grid: saturated first so that rounding never passes the max, the grid step is
+// 2^(exponent - mantBits) down to the subnormal step
+inline uint32_t RoundFp8Abs(uint32_t absBits, const Fp8Bits& fp8)
+{
+    uint32_t clamped = absBits > fp8.maxBits ? fp8.maxBits : absBits;
+    int32_t stepBits = static_cast<int32_t>(clamped & FP32_EXP_MASK) - (fp8.mantBits << FP32_EXP_SHIFT);
+    stepBits = stepBits < fp8.minStepBits ? fp8.minStepBits : stepBits;
+    float steps = BitsFloat(clamped) * BitsFloat(static_cast<uint32_t>(FP32_RECIPROCAL_BITS - stepBits));
+    steps = (steps + ROUND_MAGIC) - ROUND_MAGIC;
+    return FloatBits(steps * BitsFloat(static_cast<uint32_t>(stepBits)));
+}
+} // namespace
+
+bool GetFp8Format(const std::string& dstType, Fp8Format& format)
+{
+    if (dstType == "FP8_E4M3") {
+        format = Fp8Format::E4M3;
+        return true;
+    }
+    if (dstType == "FP8_E5M2") {
+        format = Fp8Format::E5M2;
+        return true;
+    }
+    return false;
+}
+
+const char* GetFp8TypeName(Fp8Format format)
+{
+    return format == Fp8Format::E5M2 ? "FP8_E5M2" : "FP8_E4M3";
+}
+
+float GetFp8MaxValue(Fp8Format format)
+{
+    return GetFp8Spec(format).maxValue;
+}
+
+void Fp8RoundKernel(const float* in, float* out, int64_t length, float scale, Fp8Format format)
+{
+    const Fp8Bits fp8 = GetFp8Bits(format);
+#pragma omp simd
+    for (int64_t i = 0; i < length; ++i) {
+        uint32_t bits = FloatBits(in[i] * scale);
+        uint32_t absBits = bits & FP32_ABS_MASK;
+        uint32_t rounded = RoundFp8Abs(absBits, fp8) | (bits & FP32_SIGN_MASK);
+        uint32_t nanMask = NanMask(absBits);
+        out[i] = BitsFloat((bits & nanMask) | (rounded & ~nanMask));
+    }
+}
+
+void Fp8EncodeKernel(const float* in, uint8_t* out, int64_t length, float scale, Fp8Format format)
+{
+    const Fp8Bits fp8 = GetFp8Bits(format);
+    const uint32_t mantMask = (1U << static_cast<uint32_t>(fp8.mantBits)) - 1;
+    const uint32_t mantShift = static_cast<uint32_t>(FP32_EXP_SHIFT - fp8.mantBits);
+    const uint32_t expRebias = static_cast<uint32_t>(FP32_BIAS - fp8.bias);
+#pragma omp simd
+    for (int64_t i = 0; i < length; ++i) {
+        uint32_t bits = FloatBits(in[i] * scale);
+        uint32_t absBits = bits & FP32_ABS_MASK;
+        uint32_t rounded = RoundFp8Abs(absBits, fp8);
+        uint32_t normal = (((rounded >> FP32_EXP_SHIFT) - expRebias) << fp8.mantBits) |
+            ((rounded >> mantShift) & mantMask);
+        uint32_t subnormal = static_cast<uint32_t>(static_cast<int32_t>(BitsFloat(rounded) * fp8.subnormalInv));
+        uint32_t normalMask = 0U - static_cast<uint32_t>(rounded >= fp8.minNormalBits);
+        uint32_t code = (normal & normalMask) | (subnormal & ~normalMask);
+        uint32_t nanMask = NanMask(absBits);
+        code = (FP8_NAN & nanMask) | (code & ~nanMask);
+        out[i] = static_cast<uint8_t>(code | ((bits & FP32_SIGN_MASK) >> FP8_SIGN_SHIFT));
+    }
+}
+
+void Fp8DecodeKernel(const uint8_t* in, float* out, int64_t length, float scale, Fp8Format format)
+{
+    Fp8Spec spec = GetFp8Spec(format);
+    int32_t mantNum = 1 << spec.mantBits;
+    int32_t expMax = (FP8_SIGN_BIT >> spec.mantBits) - 1;
+    float values[FP8_VALUE_NUM];
+    for (int32_t code = 0; code < FP8_VALUE_NUM; ++code) {
+        int32_t exponent = (code & (FP8_SIGN_BIT - 1)) >> spec.mantBits;
+        int32_t mant = code & (mantNum - 1);
+        float value = exponent == 0 ? static_cast<float>(mant) * spec.subnormalStep :
+            std::ldexp(1.0f + static_cast<float>(mant) / static_cast<float>(mantNum), exponent - spec.bias);
+        if (exponent == expMax && format == Fp8Format::E5M2) {
+            value = mant == 0 ? std::numeric_limits<float>::infinity() : std::numeric_limits<float>::quiet_NaN();
+        } else if (exponent == expMax && mant == mantNum - 1) {
+            value = std::numeric_limits<float>::quiet_NaN();
+        }
+        values[code] = ((code & FP8_SIGN_BIT) != 0 ? -value : value) * scale;
+    }
+    for (int64_t i = 0; i < length; ++i) {
+        out[i] = values[in[i]];
+    }
+}
+
+void IntScaleToFp8Scale(unsigned int numBits, Fp8Format format, float& scale, int& offset)
+{
+    float quantMax = std::ldexp(1.0f, static_cast<int>(numBits) - 1) - 1;
+    float quantMin = -quantMax - 1;
+    // a symmetric search clips at quantMax * scale, an asymmetric one at either end of the shifted int range
+    float rangeMax = quantMax * scale;
+    if (offset != 0) {
+        rangeMax = std::max((quantMax - static_cast<float>(offset)) * scale,
+            (static_cast<float>(offset) - quantMin) * scale);
+    }
+    scale = rangeMax / GetFp8MaxValue(format);
+    offset = 0;
+}
+} // namespace AmctCommon
@@ -22,6 +22,8 @@
 #include "hfmg_kernel.h"
 #include "util.h"
 #include "cast_util.h"
+#include "record_store.h"
+#include "fp8_quant.h"
 
 using namespace util;
 
@@ -56,10 +58,80 @@ HFMGKernel::HFMGKernel(const OrtApi& api, const OrtKernelInfo* info)
 
     auto fakeQuantPrecisionMode = AmctUtils::GetStringAttr(api_, info, "fakequant_precision_mode");
     fakeQuantPrecisionMode_ = AmctUtils::TrimTailSpace(fakeQuantPrecisionMode);
+    auto dstType = AmctUtils::GetStringAttrOrDefault(api_, info, "dst_type", "");
+    dstType_ = AmctUtils::TrimTailSpace(dstType);
+    AmctCommon::Fp8Format fp8Format;
+    if (!dstType_.empty() && !AmctCommon::GetFp8Format(dstType_, fp8Format)) {
+        ORT_CXX_API_THROW("HFMG dst_type only supports FP8_E4M3 and FP8_E5M2.", ORT_INVALID_ARGUMENT);
+    }
 
     scale_.data = &scaleData_;
     offset_.length = 1;
     offset_.data = &offsetData_;
+    AmctCommon::RecordStore::Instance().AcquireWriter(AmctUtils::TrimTailSpace(recordFileName_));
+    AmctCommon::CalibrationState prototype;
+    GetCalibrationState(prototype);
+    // the histogram range grows with the data, so batches are merged in batch order like a serial run
+    partials_.Init(prototype, AmctCommon::PartialsOrder::BATCH);
+    checkpoint_.Init(AmctCommon::CalibratorType::HFMG, objectLayerNames_[0]);
+    ResumeFromCheckpoint();
+}
+
+HFMGKernel::~HFMGKernel()
+{
+    ReleaseRecordWriter();
+}
+
+void HFMGKernel::ReleaseRecordWriter()
+{
+    if (recordWriterReleased_) {
+        return;
+    }
+    recordWriterReleased_ = true;
+    int ret = AmctCommon::RecordStore::Instance().ReleaseWriter(AmctUtils::TrimTailSpace(recordFileName_));
+    if (ret != AmctCommon::SUCCESS) {
+        LOG_ERROR("Write record file %s failed, error code: %d.\n", recordFileName_.c_str(), ret);
+    }
+}
+
+void HFMGKernel::GetCalibrationState(AmctCommon::CalibrationState& state)
+{
+    state.type = AmctCommon::CalibratorType::HFMG;
+    state.recordInfo = {
+        objectLayerNames_, AmctUtils::TrimTailSpace(inputStamp_), inputTypeId_, fakeQuantPrecisionMode_, dstType_};
+    state.hfmgParam = hfmgAlgoParam_;
+}
+
+void HFMGKernel::SavePartialState(const AmctCommon::CalibrationState& state)
+{
+    std::string stateDir = AmctCommon::GetPartialStateDir();
+    if (stateDir.empty()) {
+        return;
+    }
+    (void)AmctCommon::SavePartialCalibrationState(stateDir, state);
+}
+
+void HFMGKernel::SaveCheckpoint()
+{
+    AmctCommon::CalibrationState state;
+    GetCalibrationState(state);
+    if (partials_.Snapshot(state)) {
+        checkpoint_.Save(std::move(state));
+    }
+}
+
+void HFMGKernel::ResumeFromCheckpoint()
+{
+    if (!checkpoint_.Enabled()) {
+        return;
+    }
+    AmctCommon::CalibrationState state;
+    GetCalibrationState(state);
+    if (!checkpoint_.Resume(state, bathNum_)) {
+        return;
+    }
+    inputTypeId_ = state.recordInfo.opDtype;
+    partials_.Reset(static_cast<int64_t>(state.batchCount), std::move(state));
 }
 
 void HFMGKernel::UpdateMinMax(const float* inputData, const int count, float& min, float& max)
@@ -71,16 +143,18 @@ void HFMGKernel::UpdateMinMax(const float* inputData, const int count, float& mi
 }
 
 
-void HFMGKernel::DumpData(const void* x, const int inputSize, const std::vector<int32_t>& inputShapeFlt)
+void HFMGKernel::DumpData(const void* x, const int inputSize, const std::vector<int32_t>& inputShapeFlt,
+    int64_t batch)
 {
     for (auto objectLayerName : objectLayerNames_) {
         if (needDump_) {
+            AmctCommon::ProfileScope profile("dump_write", 0, static_cast<uint64_t>(inputSize));
             std::string trimedLayerName_ = AmctUtils::TrimTailSpace(objectLayerName);
             std::string trimedDumpDir_ = AmctUtils::TrimTailSpace(dumpDir_);
             AmctUtils::ConvertLayerName(trimedLayerName_, "/", "_");
             std::stringstream ss;
             ss << trimedDumpDir_ << '/' << trimedLayerName_ << \
-                "_act_calibration_layer_" << std::to_string(currentBatch_) << ".bin";
+                "_act_calibration_layer_" << std::to_string(batch) << ".bin";
             std::string fileName = ss.str();
             AmctUtils::AmctDumpData(fileName.c_str(), inputShapeFlt.data(), inputShapeFlt.size(), x, inputSize);
         }
@@ -88,7 +162,7 @@ void HFMGKernel::DumpData(const void* x, const int inputSize, const std::vector<
 }
 
 
-int HFMGKernel::Accumlate(OrtKernelContext* context)
+std::unique_ptr<HfmgBatch> HFMGKernel::PrepareBatch(OrtKernelContext* context, int64_t batch, float* out)
 {
     const OrtValue* inputX = AmctUtils::GetKernelInput(api_, context, 0);
     OrtTensorTypeAndShapeInfo* inputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, inputX);
@@ -100,7 +174,6 @@ int HFMGKernel::Accumlate(OrtKernelContext* context)
         ORT_CXX_API_THROW(errMsg.c_str(), ORT_FAIL);
     }
     size_t inputSize = AmctUtils::GetElementCount(api_, inputInfo);
-    size_t dataByteCount = sizeof(float) * inputSize;
     AmctUtils::CheckTensorNotEmpty(inputSize);
     size_t shapeLen = inputShape.size() + 1;
     std::vector<int32_t> inputShapeFlt(shapeLen, 0);
@@ -110,31 +183,101 @@ int HFMGKernel::Accumlate(OrtKernelContext* context)
     }
     // dump the input data each batch
     const void* x = AmctUtils::GetTensorData<void>(api_, inputX);
-    const float* floatX = reinterpret_cast<const float*>(x);
-    this->DumpData(x, dataByteCount, inputShapeFlt);
     ONNXTensorElementDataType inputType = AmctUtils::GetTensorEleType(api_, inputInfo);
-    inputTypeId_ = static_cast<int64_t>(inputType);
-    if (inputType == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
-        this->DumpData(x, dataByteCount, inputShapeFlt);
-        AmctCommon::InputData<float> inputData{static_cast<unsigned int>(inputSize), floatX};
-        int ret = HfmgMerge(hfmgAlgoParam_.nbins, dataBins_, inputData);
-        if (ret != AmctCommon::SUCCESS) {
-            LOG_ERROR("Do HfmgMerge error, error code is %d", ret);
-        }
-        return ret;
+    size_t dataByteCount = inputType == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT ?
+        sizeof(float) * inputSize : sizeof(uint16_t) * inputSize;
+    this->DumpData(x, dataByteCount, inputShapeFlt, batch);
+
+    std::unique_ptr<HfmgBatch> batchData(new HfmgBatch());
+    batchData->inputTypeId = static_cast<int>(inputType);
+    batchData->data.resize(inputSize);
+    {
+        AmctCommon::ProfileScope profile("input_to_fp32", inputSize, dataByteCount + sizeof(float) * inputSize);
+        AmctUtils::SaveInputDataToFloat32(x, batchData->data.data(), inputSize, batchData->inputTypeId);
+    }
+    if (batch != bathNum_) {
+        // scale of the batch alone, the histogram scale is only known after the last batch
+        float currentMin = 0;
+        float currentMax = 0;
+        UpdateMinMax(batchData->data.data(), inputSize, currentMin, currentMax);
+        float batchScale = 0;
+        int batchOffset = 0;
+        FloatData scaleData = {1, &batchScale};
+        IntData offsetData = {1, &batchOffset};
+        AmctCommon::ActArqCalibration(currentMin, currentMax, scaleData, offsetData, hfmgAlgoParam_);
+        out[0] = batchScale;
     }
-    std::vector<float> accumulateData(inputSize);
-    AmctUtils::SaveInputDataToFloat32(x, accumulateData.data(), inputSize, inputType);
+    return batchData;
+}
 
-    dataByteCount = sizeof(uint16_t) * inputSize;
-    this->DumpData(x, dataByteCount, inputShapeFlt);
-    AmctCommon::InputData<float> inputData{static_cast<unsigned int>(inputSize), accumulateData.data()};
-    int ret = HfmgMerge(hfmgAlgoParam_.nbins, dataBins_, inputData);
+void HFMGKernel::AccumulateBatch(const HfmgBatch& batchData, AmctCommon::CalibrationState& state)
+{
+    state.recordInfo.opDtype = batchData.inputTypeId;
+    // accumulate data to the histogram of the batches before this one
+    AmctCommon::InputData<float> inputData{static_cast<unsigned int>(batchData.data.size()), batchData.data.data()};
+    int ret = AmctCommon::SUCCESS;
+    {
+        AmctCommon::ProfileScope profile("hfmg_merge", batchData.data.size(), sizeof(float) * batchData.data.size());
+        ret = HfmgMerge(hfmgAlgoParam_.nbins, state.bins, inputData);
+    }
     if (ret != AmctCommon::SUCCESS) {
         LOG_ERROR("Do HfmgMerge error, error code is %d", ret);
+        return;
     }
+    state.batchCount++;
+}
 
-    return ret;
+void HFMGKernel::FinishBatch(int64_t finishedBatches)
+{
+    if (finishedBatches == bathNum_) {
+        DoCalibration();
+    } else if (checkpoint_.Due(finishedBatches)) {
+        SaveCheckpoint();
+    }
+}
+
+void HFMGKernel::DoCalibration()
+{
+    // start to do hfmg calibration on the histogram of every batch
+    AmctCommon::CalibrationState state;
+    GetCalibrationState(state);
+    int ret = partials_.Merge(state);
+    if (ret != AmctCommon::SUCCESS) {
+        LOG_ERROR("Merge HFMG partial states error, error code is %d", ret);
+        return;
+    }
+    inputTypeId_ = state.recordInfo.opDtype;
+    SavePartialState(state);
+    {
+        AmctCommon::ProfileScope profile("hfmg_search");
+        ret = AmctCommon::HfmgCompute(state.bins, scaleData_, offsetData_, hfmgAlgoParam_);
+    }
+    if (ret != AmctCommon::SUCCESS) {
+        LOG_ERROR("Do HfmgCompute calculate scale and offset error, error code is %d", ret);
+        return;
+    }
+    std::string quantType;
+    AmctCommon::Fp8Format fp8Format;
+    if (AmctCommon::GetFp8Format(dstType_, fp8Format)) {
+        AmctCommon::IntScaleToFp8Scale(hfmgAlgoParam_.quantBitNum, fp8Format, scaleData_, offsetData_);
+        quantType = dstType_;
+    }
+    outputScale_.store(scaleData_);
+    std::string trimedRecordFilePath = AmctUtils::TrimTailSpace(recordFileName_);
+    for (auto objectLayerName : objectLayerNames_) {
+        std::string trimedObjectLayerName = AmctUtils::TrimTailSpace(objectLayerName);
+        std::string trimedInputSign_ = AmctUtils::TrimTailSpace(inputStamp_);
+        if (trimedInputSign_ == "weight" || trimedInputSign_ == "initial_h") {
+            inputTypeId_ = 0;
+        }
+        util::RecordData<int> recordData = {
+            scaleData_, offsetData_, {}, trimedInputSign_, inputTypeId_, hfmgAlgoParam_.quantBitNum,
+            fakeQuantPrecisionMode_, quantType};
+        AmctCommon::RecordStore::Instance().RecordScaleOffset(trimedRecordFilePath, trimedObjectLayerName,
+            recordData);
+    }
+    ReleaseRecordWriter();
+    checkpoint_.Remove();
 }
 
 #if ORT_API_VERSION >= 16
@@ -147,56 +290,31 @@ OrtStatusPtr HFMGKernel::ComputeV2(OrtKernelContext* context)
 
 void HFMGKernel::Compute(OrtKernelContext* context)
 {
+    AmctCommon::ProfileOpScope profile("HFMG");
     // set output
     std::vector<int64_t> outputDims = {1};
     OrtValue* output = AmctUtils::GetKernelOutput(api_, context, 0, outputDims.data(), outputDims.size());
     float* outFp32 = AmctUtils::GetTensorMutableData<float>(api_, output);
-    outFp32[0] = scaleData_;
-    // Setup inputs
-    currentBatch_++;
-    if (currentBatch_ > bathNum_) {
+    outFp32[0] = outputScale_.load();
+    // Compute may run concurrently, each call owns one batch number
+    int64_t batch = partials_.Claim();
+    if (batch > bathNum_) {
         return;
     }
-    // accumulate data to Histogram and dump the input data each batch
-    if (this->Accumlate(context) != AmctCommon::SUCCESS) {
-        LOG_ERROR("HFMGKernel::Accumlate fail");
-        return;
+    std::unique_ptr<HfmgBatch> batchData;
+    try {
+        batchData = PrepareBatch(context, batch, outFp32);
+    } catch (...) {
+        // a failed batch must not hold back the final search
+        FinishBatch(partials_.Skip(batch));
+        throw;
     }
-
-    if (currentBatch_ == bathNum_) {
-        // start to do hfmg calibration
-        int ret = AmctCommon::HfmgCompute(dataBins_, scaleData_, offsetData_, hfmgAlgoParam_);
-        if (ret != AmctCommon::SUCCESS) {
-            LOG_ERROR("Do HfmgCompute calculate scale and offset error, error code is %d", ret);
-            return;
-        }
-        std::string trimedRecordFilePath = AmctUtils::TrimTailSpace(recordFileName_);
-        for (auto objectLayerName : objectLayerNames_) {
-            std::string trimedObjectLayerName = AmctUtils::TrimTailSpace(objectLayerName);
-            std::string trimedInputSign_ = AmctUtils::TrimTailSpace(inputStamp_);
-            if (trimedInputSign_ == "weight" || trimedInputSign_ == "initial_h") {
-                inputTypeId_ = 0;
-            }
-            util::RecordData<int> recordData = {
-                scaleData_, offsetData_, {}, trimedInputSign_, inputTypeId_, hfmgAlgoParam_.quantBitNum,
-                fakeQuantPrecisionMode_};
-            util::RecordScaleOffset(trimedRecordFilePath, trimedObjectLayerName, recordData);
-        }
-    } else {
-        const OrtValue* inputX = AmctUtils::GetKernelInput(api_, context, 0);
-        OrtTensorTypeAndShapeInfo* inputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, inputX);
-        size_t inputSize = AmctUtils::GetElementCount(api_, inputInfo);
-
-        const void* x = AmctUtils::GetTensorData<void>(api_, inputX);
-        std::vector<float> currentData(inputSize);
-        AmctUtils::SaveInputDataToFloat32(x, currentData.data(), inputSize, inputTypeId_);
-
-        float currentMin = 0;
-        float currentMax = 0;
-        UpdateMinMax(currentData.data(), inputSize, currentMin, currentMax);
-        FloatData scaleData = {1, &scaleData_};
-        IntData offsetData = {1, &offsetData_};
-        AmctCommon::ActArqCalibration(currentMin, currentMax, scaleData, offsetData, hfmgAlgoParam_);
+    int64_t finishedBatches = partials_.Accumulate(batch,
+        [this, batchData = std::move(batchData)](AmctCommon::CalibrationState& state) {
+            AccumulateBatch(*batchData, state);
+        });
+    FinishBatch(finishedBatches);
+    if (finishedBatches == bathNum_) {
+        outFp32[0] = outputScale_.load();
     }
-    outFp32[0] = scaleData_;
 }
@@ -23,6 +23,8 @@
 #include "ifmr_kernel.h"
 #include "util.h"
 #include "cast_util.h"
+#include "record_store.h"
+#include "fp8_quant.h"
 
 IFMRKernel::IFMRKernel(const OrtApi &api, const OrtKernelInfo *info) : api_(api)
 {
@@ -48,6 +50,12 @@ IFMRKernel::IFMRKernel(const OrtApi &api, const OrtKernelInfo *info) : api_(api)
 
     auto fakeQuantPrecisionMode = AmctUtils::GetStringAttr(api_, info, "fakequant_precision_mode");
     fakeQuantPrecisionMode_ = AmctUtils::TrimTailSpace(fakeQuantPrecisionMode);
+    auto dstType = AmctUtils::GetStringAttrOrDefault(api_, info, "dst_type", "");
+    dstType_ = AmctUtils::TrimTailSpace(dstType);
+    AmctCommon::Fp8Format fp8Format;
+    if (!dstType_.empty() && !AmctCommon::GetFp8Format(dstType_, fp8Format)) {
+        ORT_CXX_API_THROW("IFMR dst_type only supports FP8_E4M3 and FP8_E5M2.", ORT_INVALID_ARGUMENT);
+    }
 
     int64_t layerNum;
     AmctUtils::CheckStatus(api_, api_.KernelInfoGetAttribute_int64(info, "layer_num", &layerNum));
@@ -62,17 +70,86 @@ IFMRKernel::IFMRKernel(const OrtApi &api, const OrtKernelInfo *info) : api_(api)
     scale_.data = &scaleData_;
     offset_.length = 1;
     offset_.data = &offsetData_;
+    AmctCommon::RecordStore::Instance().AcquireWriter(AmctUtils::TrimTailSpace(recordFileName_));
+    AmctCommon::CalibrationState prototype;
+    GetCalibrationState(prototype);
+    // the data of every batch is sorted before the search, so the thread partials merge in any order
+    partials_.Init(prototype, AmctCommon::PartialsOrder::ANY);
+    checkpoint_.Init(AmctCommon::CalibratorType::IFMR, objectLayerNames_[0]);
+    ResumeFromCheckpoint();
+}
+
+IFMRKernel::~IFMRKernel()
+{
+    ReleaseRecordWriter();
+}
+
+void IFMRKernel::ReleaseRecordWriter()
+{
+    if (recordWriterReleased_) {
+        return;
+    }
+    recordWriterReleased_ = true;
+    int ret = AmctCommon::RecordStore::Instance().ReleaseWriter(AmctUtils::TrimTailSpace(recordFileName_));
+    if (ret != 0) {
+        LOG_ERROR("Write record file %s failed, error code: %d.\n", recordFileName_.c_str(), ret);
+    }
+}
+
+void IFMRKernel::GetCalibrationState(AmctCommon::CalibrationState& state)
+{
+    state.type = AmctCommon::CalibratorType::IFMR;
+    state.recordInfo = {objectLayerNames_, AmctUtils::TrimTailSpace(inputStamp_), opDtype_, fakeQuantPrecisionMode_,
+        dstType_};
+    state.ifmrParam = ifmrParam_;
+}
+
+void IFMRKernel::SavePartialState(const AmctCommon::CalibrationState& state)
+{
+    std::string stateDir = AmctCommon::GetPartialStateDir();
+    if (stateDir.empty()) {
+        return;
+    }
+    (void)AmctCommon::SavePartialCalibrationState(stateDir, state);
+}
+
+void IFMRKernel::SaveCheckpoint()
+{
+    // the data chunks are never modified, the snapshot shares them and is serialized off the calibration path
+    AmctCommon::CalibrationState state;
+    GetCalibrationState(state);
+    if (partials_.Snapshot(state)) {
+        checkpoint_.Save(std::move(state));
+    }
+}
+
+void IFMRKernel::ResumeFromCheckpoint()
+{
+    if (!checkpoint_.Enabled()) {
+        return;
+    }
+    AmctCommon::CalibrationState state;
+    GetCalibrationState(state);
+    if (!checkpoint_.Resume(state, bathNum_)) {
+        return;
+    }
+    opDtype_ = state.recordInfo.opDtype;
+    AmctCommon::FlattenDataChunks(state);
+    state.dataChunks.push_back(std::make_shared<const std::vector<float>>(std::move(state.data)));
+    state.data.clear();
+    partials_.Reset(static_cast<int64_t>(state.batchCount), std::move(state));
 }
 
 void IFMRKernel::DumpData(const void* x, const int inputSize, const std::vector<int32_t>& inputShapeFlt,
-    std::string objectLayerName)
+    std::string objectLayerName, int64_t batch)
 {
+    AmctCommon::ProfileScope profile("dump_write", 0, static_cast<uint64_t>(inputSize));
     std::string trimedLayerName = AmctUtils::TrimTailSpace(objectLayerName);
     std::string trimedDumpDir = AmctUtils::TrimTailSpace(dumpDir_);
     AmctUtils::ConvertLayerName(trimedLayerName, "/", "_");
     std::stringstream ss;
     ss << trimedDumpDir << '/' << trimedLayerName << \
-        "_act_calibration_layer_" << std::to_string(currentBatch_) << ".bin";
+        "_act_calibration_layer_" << std::to_string(batch) << ".bin";
     std::string fileName = ss.str();
     AmctUtils::AmctDumpData(fileName.c_str(), inputShapeFlt.data(), inputShapeFlt.size(), x, inputSize);
 }
@@ -87,18 +164,37 @@ OrtStatusPtr IFMRKernel::ComputeV2(OrtKernelContext* context)
 
 void IFMRKernel::Compute(OrtKernelContext* context)
 {
+    AmctCommon::ProfileOpScope profile("IFMR");
     // set output
     std::vector<int64_t> outputShape = {1};
     OrtValue* output = AmctUtils::GetKernelOutput(api_, context, 0, outputShape.data(), outputShape.size());
     float* outFp32 = AmctUtils::GetTensorMutableData<float>(api_, output);
-    outFp32[0] = scaleData_;
+    outFp32[0] = outputScale_.load();
 
-    // Setup inputs
-    currentBatch_++;
-    if (currentBatch_ > bathNum_) {
+    // Compute may run concurrently, each call owns one batch number
+    int64_t batch = partials_.Claim();
+    if (batch > bathNum_) {
         return;
     }
-    // accumulate data
+    std::unique_ptr<IfmrBatch> batchData;
+    try {
+        batchData = PrepareBatch(context, batch);
+    } catch (...) {
+        // a failed batch must not hold back the final search
+        FinishBatch(partials_.Skip(batch));
+        throw;
+    }
+    int64_t finishedBatches = partials_.Accumulate(batch, [&batchData](AmctCommon::CalibrationState& partial) {
+        partial.batchCount++;
+        partial.recordInfo.opDtype = batchData->opDtype;
+        partial.dataChunks.push_back(std::make_shared<const std::vector<float>>(std::move(batchData->data)));
+    });
+    FinishBatch(finishedBatches);
+    outFp32[0] = outputScale_.load();
+}
+
+std::unique_ptr<IfmrBatch> IFMRKernel::PrepareBatch(OrtKernelContext* context, int64_t batch)
+{
     const OrtValue* inputX = AmctUtils::GetKernelInput(api_, context, 0);
 
     OrtTensorTypeAndShapeInfo* inputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, inputX);
@@ -123,36 +219,66 @@ void IFMRKernel::Compute(OrtKernelContext* context)
     const void* x = AmctUtils::GetTensorData<void>(api_, inputX);
     ONNXTensorElementDataType opDtype = AmctUtils::GetTensorEleType(api_, inputInfo);
     api_.ReleaseTensorTypeAndShapeInfo(inputInfo);
-    opDtype_ = static_cast<int64_t>(opDtype);
-    if (opDtype_ == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16) {
+    std::unique_ptr<IfmrBatch> batchData(new IfmrBatch());
+    batchData->opDtype = static_cast<int>(opDtype);
+    if (batchData->opDtype == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16 ||
+        batchData->opDtype == ONNX_TENSOR_ELEMENT_DATA_TYPE_BFLOAT16) {
         dataByteCount = sizeof(uint16_t) * inputSize;
     }
-    size_t dataOffset = accumulateData_.size();
-    accumulateData_.resize(dataOffset + inputSize);
-    AmctUtils::SaveInputDataToFloat32(x, accumulateData_.data() + dataOffset, inputSize, opDtype_);
+    batchData->data.resize(inputSize);
+    {
+        AmctCommon::ProfileScope profile("input_to_fp32", inputSize, dataByteCount + sizeof(float) * inputSize);
+        AmctUtils::SaveInputDataToFloat32(x, batchData->data.data(), inputSize, batchData->opDtype);
+    }
 
     for (auto objectLayerName : objectLayerNames_) {
         if (ifmrParam_.needDump) {
-            this->DumpData(x, dataByteCount, inputShapeFlt, objectLayerName);
+            this->DumpData(x, dataByteCount, inputShapeFlt, objectLayerName, batch);
         }
     }
-    if (currentBatch_ != bathNum_) {
-        return;
+    return batchData;
+}
+
+void IFMRKernel::FinishBatch(int64_t finishedBatches)
+{
+    if (finishedBatches == bathNum_) {
+        DoCalibration();
+    } else if (checkpoint_.Due(finishedBatches)) {
+        SaveCheckpoint();
     }
-    DoCalibration(outFp32);
 }
 
-void IFMRKernel::DoCalibration(float* out)
+void IFMRKernel::DoCalibration()
 {
     // start to do ifmr calibration
     ifmrParam_.calibration = 0;
     ifmrParam_.needDump = false;
-    int ret = AmctCommon::IfmrQuant(accumulateData_.data(), accumulateData_.size(), ifmrParam_, scale_, offset_);
+    AmctCommon::CalibrationState state;
+    GetCalibrationState(state);
+    int ret = partials_.Merge(state);
+    if (ret != 0) {
+        LOG_ERROR("Merge IFMR partial states failed, error code: %d.\n", ret);
+        ORT_CXX_API_THROW("Do IFMR calibration failed", ORT_FAIL);
+    }
+    opDtype_ = state.recordInfo.opDtype;
+    SavePartialState(state);
+    AmctCommon::FlattenDataChunks(state);
+    std::vector<float>& accumulateData = state.data;
+    {
+        AmctCommon::ProfileScope profile("ifmr_search", accumulateData.size(), sizeof(float) * accumulateData.size());
+        ret = AmctCommon::IfmrQuant(accumulateData.data(), accumulateData.size(), ifmrParam_, scale_, offset_);
+    }
     if (ret != 0) {
         LOG_ERROR("Do IFMR calibration failed, error code: %d.\n", ret);
         ORT_CXX_API_THROW("Do IFMR calibration failed", ORT_FAIL);
     }
-    out[0] = scaleData_;
+    std::string quantType;
+    AmctCommon::Fp8Format fp8Format;
+    if (AmctCommon::GetFp8Format(dstType_, fp8Format)) {
+        AmctCommon::IntScaleToFp8Scale(ifmrParam_.numBits, fp8Format, scaleData_, offsetData_);
+        quantType = dstType_;
+    }
+    outputScale_.store(scaleData_);
     std::string trimedRecordFilePath = AmctUtils::TrimTailSpace(recordFileName_);
     for (auto objectLayerName : objectLayerNames_) {
         std::string trimedObjectLayerName = AmctUtils::TrimTailSpace(objectLayerName);
@@ -161,7 +287,10 @@ void IFMRKernel::DoCalibration(float* out)
             opDtype_ = 0;
         }
         util::RecordData<int> recordData = {
-            scaleData_, offsetData_, {}, trimedInputSign_, opDtype_, ifmrParam_.numBits, fakeQuantPrecisionMode_};
-        util::RecordScaleOffset(trimedRecordFilePath, trimedObjectLayerName, recordData);
+            scaleData_, offsetData_, {}, trimedInputSign_, opDtype_, ifmrParam_.numBits, fakeQuantPrecisionMode_,
+            quantType};
+        AmctCommon::RecordStore::Instance().RecordScaleOffset(trimedRecordFilePath, trimedObjectLayerName, recordData);
     }
+    ReleaseRecordWriter();
+    checkpoint_.Remove();
 }
@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief fused image preprocessing C++ implement
+ *
+ * @file image_preprocess.cpp
+ *
+ * @version 1.0
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "image_preprocess.h"
+#include "amct_profiler.h"
+#include "amct_thread_pool.h"
+#include "cast_util.h"
+#include "error_codes.h"
+#include "scratch_arena.h"
+#include "util.h"
+
+namespace AmctCommon {
+namespace {
+// output rows of one task, a block reuses the horizontally resized source rows of its previous row
+constexpr int64_t PREPROCESS_ROW_BLOCK = 32;
+constexpr float INT8_MIN_VALUE = -128.0f;
+constexpr float INT8_MAX_VALUE = 127.0f;
+
+// source columns of the output columns [contentBegin, contentEnd) that fall inside the resized image
+struct ColumnTable {
+    int64_t contentBegin;
+    int64_t contentEnd;
+    const int64_t* offset0;
+    const int64_t* offset1;
+    const float* weight;
+};
+
+// half pixel centers as cv2 INTER_LINEAR, index0 <= position < index0 + 1
+void SourcePosition(int64_t resized, int64_t inSize, int64_t resizedSize, int64_t& index0, int64_t& index1,
+    float& weight)
+{
+    float position = (static_cast<float>(resized) + 0.5f) * static_cast<float>(inSize) /
+        static_cast<float>(resizedSize) - 0.5f;
+    position = std::max(position, 0.0f);
+    index0 = std::min(static_cast<int64_t>(position), inSize - 1);
+    index1 = std::min(index0 + 1, inSize - 1);
+    weight = index0 == inSize - 1 ? 0.0f : position - static_cast<float>(index0);
+}
+
+ColumnTable BuildColumnTable(const PreprocessParam& param, ScratchScope& scratch)
+{
+    int64_t* offset0 = scratch.Allocate<int64_t>(static_cast<size_t>(param.outWidth));
+    int64_t* offset1 = scratch.Allocate<int64_t>(static_cast<size_t>(param.outWidth));
+    float* weight = scratch.Allocate<float>(static_cast<size_t>(param.outWidth));
+    int64_t contentBegin = std::min(std::max(-param.cropLeft, int64_t(0)), param.outWidth);
+    int64_t contentEnd = std::max(std::min(param.resizedWidth - param.cropLeft, param.outWidth), contentBegin);
+    for (int64_t x = contentBegin; x < contentEnd; ++x) {
+        int64_t index0 = 0;
+        int64_t index1 = 0;
+        SourcePosition(x + param.cropLeft, param.inWidth, param.resizedWidth, index0, index1, weight[x]);
+        offset0[x] = index0 * param.channel;
+        offset1[x] = index1 * param.channel;
+    }
+    return {contentBegin, contentEnd, offset0, offset1, weight};
+}
+
+// one source row resized horizontally into channel planes of the content width
+void ResizeRow(const uint8_t* source, const PreprocessParam& param, const ColumnTable& columns, float* planes)
+{
+    int64_t width = columns.contentEnd - columns.contentBegin;
+    for (int64_t x = columns.contentBegin; x < columns.contentEnd; ++x) {
+        const uint8_t* left = source + columns.offset0[x];
+        const uint8_t* right = source + columns.offset1[x];
+        float weight = columns.weight[x];
+        int64_t column = x - columns.contentBegin;
+        for (int64_t c = 0; c < param.channel; ++c) {
+            int64_t sourceChannel = param.swapChannel ? param.channel - 1 - c : c;
+            float value = left[sourceChannel];
+            planes[c * width + column] = value + weight * (static_cast<float>(right[sourceChannel]) - value);
+        }
+    }
+}
+
+inline float* RowTarget(float* output, float*)
+{
+    return output;
+}
+
+template <typename T>
+inline float* RowTarget(T*, float* buffer)
+{
+    return buffer;
+}
+
+inline void StoreRow(const float*, float*, int64_t, const PreprocessParam&)
+{
+}
+
+inline void StoreRow(const float* row, uint16_t* output, int64_t length, const PreprocessParam&)
+{
+    util::DataCastToFloat16Functor<util::CPUDevice, float>()(row, output, static_cast<int>(length));
+}
+
+inline void StoreRow(const float* row, int8_t* output, int64_t length, const PreprocessParam& param)
+{
+    float scale = param.quantScale;
+    float offset = param.quantOffset;
+#pragma omp simd
+    for (int64_t i = 0; i < length; ++i) {
+        float value = std::rint(row[i] * scale) + offset;
+        value = value < INT8_MIN_VALUE ? INT8_MIN_VALUE : value;
+        value = value > INT8_MAX_VALUE ? INT8_MAX_VALUE : value;
+        output[i] = static_cast<int8_t>(value);
+    }
+}
+
+template <typename T>
+void PreprocessRows(const uint8_t* image, const PreprocessParam& param, const ColumnTable& columns,
+    int64_t rowBegin, int64_t rowEnd, T* output)
+{
+    ScratchScope scratch;
+    int64_t width = columns.contentEnd - columns.contentBegin;
+    float* upper = scratch.Allocate<float>(static_cast<size_t>(param.channel * width));
+    float* lower = scratch.Allocate<float>(static_cast<size_t>(param.channel * width));
+    float* buffer = scratch.Allocate<float>(static_cast<size_t>(param.outWidth));
+    int64_t upperRow = -1;
+    int64_t lowerRow = -1;
+    int64_t rowSize = param.inWidth * param.channel;
+    int64_t planeSize = param.outHeight * param.outWidth;
+    for (int64_t y = rowBegin; y < rowEnd; ++y) {
+        int64_t resizedY = y + param.cropTop;
+        bool padRow = resizedY < 0 || resizedY >= param.resizedHeight || width == 0;
+        int64_t row0 = 0;
+        int64_t row1 = 0;
+        float weight = 0;
+        if (!padRow) {
+            SourcePosition(resizedY, param.inHeight, param.resizedHeight, row0, row1, weight);
+            if (row0 == lowerRow) {
+                std::swap(upper, lower);
+                std::swap(upperRow, lowerRow);
+            }
+            if (row0 != upperRow) {
+                ResizeRow(image + row0 * rowSize, param, columns, upper);
+                upperRow = row0;
+            }
+            if (row1 != lowerRow) {
+                ResizeRow(image + row1 * rowSize, param, columns, lower);
+                lowerRow = row1;
+            }
+        }
+        for (int64_t c = 0; c < param.channel; ++c) {
+            T* target = output + c * planeSize + y * param.outWidth;
+            float* row = RowTarget(target, buffer);
+            float alpha = param.alpha[c];
+            float beta = param.beta[c];
+            float pad = param.padValue * alpha + beta;
+            if (padRow) {
+                std::fill(row, row + param.outWidth, pad);
+                StoreRow(row, target, param.outWidth, param);
+                continue;
+            }
+            std::fill(row, row + columns.contentBegin, pad);
+            std::fill(row + columns.contentEnd, row + param.outWidth, pad);
+            const float* top = upper + c * width;
+            const float* bottom = lower + c * width;
+            float* content = row + columns.contentBegin;
+#pragma omp simd
+            for (int64_t x = 0; x < width; ++x) {
+                content[x] = (top[x] + weight * (bottom[x] - top[x])) * alpha + beta;
+            }
+            StoreRow(row, target, param.outWidth, param);
+        }
+    }
+}
+
+int CheckPreprocessParam(const PreprocessParam& param)
+{
+    if (param.channel <= 0 || param.channel > PREPROCESS_MAX_CHANNEL) {
+        LOG_ERROR("Image preprocess supports 1 to %lld channels, got %lld.\n",
+            static_cast<long long>(PREPROCESS_MAX_CHANNEL), static_cast<long long>(param.channel));
+        return BAD_PARAMETERS_ERROR;
+    }
+    if (param.inHeight <= 0 || param.inWidth <= 0 || param.outHeight <= 0 || param.outWidth <= 0 ||
+        param.resizedHeight <= 0 || param.resizedWidth <= 0) {
+        LOG_ERROR("Image preprocess needs non empty input, output and resized images.\n");
+        return BAD_PARAMETERS_ERROR;
+    }
+    return SUCCESS;
+}
+
+template <typename T>
+int Preprocess(const uint8_t* images, const PreprocessParam& param, T* output)
+{
+    int ret = CheckPreprocessParam(param);
+    if (ret != SUCCESS) {
+        return ret;
+    }
+    int64_t imageSize = param.inHeight * param.inWidth * param.channel;
+    int64_t outputSize = param.channel * param.outHeight * param.outWidth;
+    ProfileScope profile("image_preprocess", param.batchSize * outputSize,
+        param.batchSize * (imageSize + outputSize * static_cast<int64_t>(sizeof(T))));
+    ScratchScope scratch;
+    ColumnTable columns = BuildColumnTable(param, scratch);
+    int64_t blockNum = (param.outHeight + PREPROCESS_ROW_BLOCK - 1) / PREPROCESS_ROW_BLOCK;
+    ParallelForTasks(param.batchSize * blockNum, [&](int64_t begin, int64_t end) {
+        for (int64_t task = begin; task < end; ++task) {
+            int64_t image = task / blockNum;
+            int64_t rowBegin = (task % blockNum) * PREPROCESS_ROW_BLOCK;
+            int64_t rowEnd = std::min(rowBegin + PREPROCESS_ROW_BLOCK, param.outHeight);
+            PreprocessRows(images + image * imageSize, param, columns, rowBegin, rowEnd,
+                output + image * outputSize);
+        }
+    });
+    return SUCCESS;
+}
+} // namespace
+
+int SetPreprocessGeometry(const std::string& mode, int64_t resizeShort, PreprocessParam& param)
+{
+    if (param.inHeight <= 0 || param.inWidth <= 0 || param.outHeight <= 0 || param.outWidth <= 0) {
+        LOG_ERROR("Image preprocess needs non empty input and output images.\n");
+        return BAD_PARAMETERS_ERROR;
+    }
+    double inHeight = static_cast<double>(param.inHeight);
+    double inWidth = static_cast<double>(param.inWidth);
+    if (mode == "letterbox") {
+        double ratio = std::min(param.outHeight / inHeight, param.outWidth / inWidth);
+        param.resizedHeight = std::max(static_cast<int64_t>(std::nearbyint(inHeight * ratio)), int64_t(1));
+        param.resizedWidth = std::max(static_cast<int64_t>(std::nearbyint(inWidth * ratio)), int64_t(1));
+        // same border split as letterbox(): round(dh - 0.1) on the top and left
+        param.cropTop = -static_cast<int64_t>(std::nearbyint((param.outHeight - param.resizedHeight) / 2.0 - 0.1));
+        param.cropLeft = -static_cast<int64_t>(std::nearbyint((param.outWidth - param.resizedWidth) / 2.0 - 0.1));
+    } else if (mode == "center_crop") {
+        int64_t shortSide = resizeShort > 0 ? resizeShort : std::min(param.outHeight, param.outWidth);
+        if (param.inHeight <= param.inWidth) {
+            param.resizedHeight = shortSide;
+            param.resizedWidth = static_cast<int64_t>(shortSide * inWidth / inHeight);
+        } else {
+            param.resizedWidth = shortSide;
+            param.resizedHeight = static_cast<int64_t>(shortSide * inHeight / inWidth);
+        }
+        param.cropTop = static_cast<int64_t>(std::nearbyint((param.resizedHeight - param.outHeight) / 2.0));
+        param.cropLeft = static_cast<int64_t>(std::nearbyint((param.resizedWidth - param.outWidth) / 2.0));
+    } else if (mode == "stretch") {
+        param.resizedHeight = param.outHeight;
+        param.resizedWidth = param.outWidth;
+        param.cropTop = 0;
+        param.cropLeft = 0;
+    } else {
+        LOG_ERROR("Image preprocess does not support resize_mode \"%s\".\n", mode.c_str());
+        return BAD_PARAMETERS_ERROR;
+    }
+    return SUCCESS;
+}
+
+int ImagePreprocess(const uint8_t* images, const PreprocessParam& param, float* output)
+{
+    return Preprocess(images, param, output);
+}
+
+int ImagePreprocessFp16(const uint8_t* images, const PreprocessParam& param, uint16_t* output)
+{
+    return Preprocess(images, param, output);
+}
+
+int ImagePreprocessInt8(const uint8_t* images, const PreprocessParam& param, int8_t* output)
+{
+    return Preprocess(images, param, output);
+}
+} // namespace AmctCommon
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief AMCT custom ops
+ *
+ * @file image_preprocess_kernel.cpp
+ *
+ * @version 1.0
+ */
+
+#include <algorithm>
+
+#include "amct_utils.h"
+#include "image_preprocess_kernel.h"
+#include "util.h"
+
+namespace {
+constexpr float DEFAULT_PAD_VALUE = 114.0f;
+constexpr float DEFAULT_PIXEL_SCALE = 1.0f / 255.0f;
+constexpr size_t IMAGE_DIM = 4;
+constexpr int CHANNEL_AXIS = 3;
+}
+
+ImagePreprocessKernel::ImagePreprocessKernel(const OrtApi &api, const OrtKernelInfo *info) : api_(api)
+{
+    AmctUtils::CheckStatus(api_, api_.KernelInfoGetAttribute_int64(info, "out_height", &outHeight_));
+    AmctUtils::CheckStatus(api_, api_.KernelInfoGetAttribute_int64(info, "out_width", &outWidth_));
+    resizeMode_ = AmctUtils::GetStringAttrOrDefault(api_, info, "resize_mode", "letterbox");
+    resizeShort_ = AmctUtils::GetInt64AttrOrDefault(api_, info, "resize_short", 0);
+    padValue_ = AmctUtils::GetFloatAttrOrDefault(api_, info, "pad_value", DEFAULT_PAD_VALUE);
+    pixelScale_ = AmctUtils::GetFloatAttrOrDefault(api_, info, "pixel_scale", DEFAULT_PIXEL_SCALE);
+    mean_ = AmctUtils::GetFloatsAttrOrDefault(api_, info, "mean", {0.0f});
+    std_ = AmctUtils::GetFloatsAttrOrDefault(api_, info, "std", {1.0f});
+    swapChannel_ = AmctUtils::GetInt64AttrOrDefault(api_, info, "swap_rb", 0) != 0;
+    quantScale_ = AmctUtils::GetFloatAttrOrDefault(api_, info, "scale", 1.0f);
+    quantOffset_ = AmctUtils::GetFloatAttrOrDefault(api_, info, "offset", 0.0f);
+    if (outHeight_ <= 0 || outWidth_ <= 0) {
+        ORT_CXX_API_THROW("ImagePreprocess out_height and out_width must be positive.", ORT_INVALID_ARGUMENT);
+    }
+    for (float value : std_) {
+        if (value == 0) {
+            ORT_CXX_API_THROW("ImagePreprocess std must not contain 0.", ORT_INVALID_ARGUMENT);
+        }
+    }
+}
+
+#if ORT_API_VERSION >= 16
+OrtStatusPtr ImagePreprocessKernel::ComputeV2(OrtKernelContext* context)
+{
+    Compute(context);
+    return api_.CreateStatus(ORT_OK, "Success");
+}
+#endif
+
+void ImagePreprocessKernel::Compute(OrtKernelContext* context)
+{
+    AmctCommon::ProfileOpScope profile("ImagePreprocess");
+    // Setup inputs input 0: uint8 images [batch, height, width, channel]
+    const OrtValue* inputX = AmctUtils::GetKernelInput(api_, context, 0);
+    OrtTensorTypeAndShapeInfo* inputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, inputX);
+    std::vector<int64_t> shape = AmctUtils::GetShape(api_, inputInfo);
+    api_.ReleaseTensorTypeAndShapeInfo(inputInfo);
+    if (shape.size() != IMAGE_DIM) {
+        ORT_CXX_API_THROW("ImagePreprocess input must be uint8 [batch, height, width, channel].", ORT_INVALID_ARGUMENT);
+    }
+    int64_t channel = shape[CHANNEL_AXIS];
+    if ((mean_.size() != 1 && static_cast<int64_t>(mean_.size()) != channel) ||
+        (std_.size() != 1 && static_cast<int64_t>(std_.size()) != channel)) {
+        ORT_CXX_API_THROW("ImagePreprocess mean and std need 1 or channel values.", ORT_INVALID_ARGUMENT);
+    }
+
+    AmctCommon::PreprocessParam param = {};
+    param.batchSize = shape[0];
+    param.inHeight = shape[1];
+    param.inWidth = shape[2];
+    param.channel = channel;
+    param.outHeight = outHeight_;
+    param.outWidth = outWidth_;
+    param.padValue = padValue_;
+    param.swapChannel = swapChannel_;
+    param.quantScale = quantScale_;
+    param.quantOffset = quantOffset_;
+    for (int64_t c = 0; c < std::min(channel, AmctCommon::PREPROCESS_MAX_CHANNEL); ++c) {
+        float meanValue = mean_[mean_.size() == 1 ? 0 : c];
+        float stdValue = std_[std_.size() == 1 ? 0 : c];
+        param.alpha[c] = pixelScale_ / stdValue;
+        param.beta[c] = -meanValue / stdValue;
+    }
+    int ret = AmctCommon::SetPreprocessGeometry(resizeMode_, resizeShort_, param);
+    if (ret != 0) {
+        ORT_CXX_API_THROW("ImagePreprocess cannot resize the input with the given attributes.", ORT_INVALID_ARGUMENT);
+    }
+    const uint8_t* images = AmctUtils::GetTensorData<uint8_t>(api_, inputX);
+
+    // Setup output [batch, channel, out_height, out_width]
+    std::vector<int64_t> outputShape = {param.batchSize, channel, outHeight_, outWidth_};
+    OrtValue* output = AmctUtils::GetKernelOutput(api_, context, 0, outputShape.data(), outputShape.size());
+    OrtTensorTypeAndShapeInfo* outputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, output);
+    ONNXTensorElementDataType outputTensorType = AmctUtils::GetTensorEleType(api_, outputInfo);
+    api_.ReleaseTensorTypeAndShapeInfo(outputInfo);
+    if (outputTensorType == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16) {
+        ret = AmctCommon::ImagePreprocessFp16(images, param, AmctUtils::GetTensorMutableData<uint16_t>(api_, output));
+    } else if (outputTensorType == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8) {
+        ret = AmctCommon::ImagePreprocessInt8(images, param, AmctUtils::GetTensorMutableData<int8_t>(api_, output));
+    } else {
+        ret = AmctCommon::ImagePreprocess(images, param, AmctUtils::GetTensorMutableData<float>(api_, output));
+    }
+    if (ret != 0) {
+        LOG_ERROR("Do ImagePreprocess compute failed, error code: %d.\n", ret);
+        return;
+    }
+}
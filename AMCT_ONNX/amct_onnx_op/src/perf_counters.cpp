@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief perf_counters C++ implementation
+ *
+ * @file perf_counters.cpp
+ *
+ * @version 1.0
+ */
+
+#include "perf_counters.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "util.h"
+
+namespace AmctCommon {
+namespace {
+std::atomic<bool> g_perfErrorLogged{false};
+thread_local PerfCounterValues g_workerCounts;
+
+#ifdef __linux__
+constexpr int COUNTER_NUM = 4;
+
+// cycles leads the group so that all counters are scheduled on and off the PMU together
+const uint64_t COUNTER_CONFIGS[COUNTER_NUM] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+int OpenCounter(uint64_t config, int groupFd)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = groupFd == -1 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+
+class PerfCounterGroup {
+public:
+    PerfCounterGroup()
+    {
+        int leader = OpenCounter(COUNTER_CONFIGS[0], -1);
+        if (leader < 0) {
+            LogOpenError();
+            return;
+        }
+        fds_[0] = leader;
+        slots_[0] = 0;
+        int opened = 1;
+        // a counter missing on this CPU, e.g. in a VM, reads as 0 instead of disabling the others
+        for (int i = 1; i < COUNTER_NUM; ++i) {
+            fds_[i] = OpenCounter(COUNTER_CONFIGS[i], leader);
+            if (fds_[i] >= 0) {
+                slots_[i] = opened++;
+            }
+        }
+        (void)ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        (void)ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    ~PerfCounterGroup()
+    {
+        for (int i = COUNTER_NUM - 1; i >= 0; --i) {
+            if (fds_[i] >= 0) {
+                (void)close(fds_[i]);
+            }
+        }
+    }
+
+    PerfCounterGroup(const PerfCounterGroup&) = delete;
+    PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+    bool Read(PerfCounterValues& values) const
+    {
+        if (fds_[0] < 0) {
+            return false;
+        }
+        // nr, time enabled, time running, then one value per opened counter
+        uint64_t buffer[3 + COUNTER_NUM] = {0};
+        if (read(fds_[0], buffer, sizeof(buffer)) <= 0) {
+            return false;
+        }
+        uint64_t enabled = buffer[1];
+        uint64_t running = buffer[2];
+        uint64_t counts[COUNTER_NUM] = {0};
+        for (int i = 0; i < COUNTER_NUM; ++i) {
+            if (slots_[i] < 0) {
+                continue;
+            }
+            uint64_t count = buffer[3 + slots_[i]];
+            if (running != 0 && running < enabled) {
+                count = static_cast<uint64_t>(static_cast<double>(count) * enabled / running);
+            }
+            counts[i] = count;
+        }
+        values.cycles = counts[0];
+        values.instructions = counts[1];
+        values.cacheMisses = counts[2];
+        values.branchMisses = counts[3];
+        return true;
+    }
+
+private:
+    static void LogOpenError()
+    {
+        if (!g_perfErrorLogged.exchange(true)) {
+            LOG_ERROR("Hardware counters are not available (%s), check /proc/sys/kernel/perf_event_paranoid.\n",
+                strerror(errno));
+        }
+    }
+
+    int fds_[COUNTER_NUM] = {-1, -1, -1, -1};
+    int slots_[COUNTER_NUM] = {-1, -1, -1, -1};
+};
+#endif
+}
+
+bool PerfCountersEnabled()
+{
+    static const bool enabled = [] {
+        const char* value = getenv(PERF_COUNTERS_ENV);
+        return value != nullptr && value[0] != '\0' && std::string(value) != "0";
+    }();
+    return enabled;
+}
+
+bool ReadPerfCounters(PerfCounterValues& values)
+{
+    if (!PerfCountersEnabled()) {
+        return false;
+    }
+#ifdef __linux__
+    thread_local PerfCounterGroup group;
+    if (!group.Read(values)) {
+        return false;
+    }
+    values.cycles += g_workerCounts.cycles;
+    values.instructions += g_workerCounts.instructions;
+    values.cacheMisses += g_workerCounts.cacheMisses;
+    values.branchMisses += g_workerCounts.branchMisses;
+    return true;
+#else
+    if (!g_perfErrorLogged.exchange(true)) {
+        LOG_ERROR("Hardware counters are only supported on Linux.\n");
+    }
+    (void)values;
+    return false;
+#endif
+}
+
+void AddWorkerPerfCounters(const PerfCounterValues& values)
+{
+    g_workerCounts.cycles += values.cycles;
+    g_workerCounts.instructions += values.instructions;
+    g_workerCounts.cacheMisses += values.cacheMisses;
+    g_workerCounts.branchMisses += values.branchMisses;
+}
+} // namespace AmctCommon
@@ -39,6 +39,7 @@ OrtStatusPtr QuantKernel::ComputeV2(OrtKernelContext* context)
 
 void QuantKernel::Compute(OrtKernelContext* context)
 {
+    AmctCommon::ProfileOpScope profile("Quant");
     // Setup inputs
     const OrtValue* input = AmctUtils::GetKernelInput(api_, context, 0);
 
@@ -0,0 +1,533 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief record_binary C++ implementation
+ *
+ * @file record_binary.cpp
+ *
+ * @version 1.0
+ */
+
+#include "record_binary.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace AmctCommon {
+namespace {
+constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+constexpr uint64_t SECTION_ALIGN = 8;
+constexpr int FLOAT_MIN_PRECISION = 6;
+// %g precision which round trips every float
+constexpr int FLOAT_ROUND_TRIP_PRECISION = 9;
+
+const std::set<std::string> FLOAT_FIELDS = {"scale_d", "scale_w", "scale_h", "tensor_balance_factor"};
+
+uint64_t AlignUp(uint64_t value)
+{
+    return (value + SECTION_ALIGN - 1) / SECTION_ALIGN * SECTION_ALIGN;
+}
+
+bool ParseIntLiteral(const std::string& literal, int32_t& value)
+{
+    if (literal.empty() || literal[0] == '"' || literal[0] == '\'' || literal[0] == '{') {
+        return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    long result = strtol(literal.c_str(), &end, 10);
+    if (errno != 0 || *end != '\0' || result < INT_MIN || result > INT_MAX) {
+        return false;
+    }
+    value = static_cast<int32_t>(result);
+    return true;
+}
+
+bool ParseFloatLiteral(const std::string& literal, float& value)
+{
+    if (literal.empty() || literal[0] == '"' || literal[0] == '\'' || literal[0] == '{') {
+        return false;
+    }
+    char* end = nullptr;
+    value = strtof(literal.c_str(), &end);
+    return *end == '\0';
+}
+
+RecordFieldType ClassifyFieldGroup(const std::vector<RecordField>& fields, size_t begin, size_t end)
+{
+    const std::string& name = fields[begin].name;
+    bool allInt = true;
+    bool allFloat = true;
+    for (size_t i = begin; i < end; i++) {
+        int32_t intValue = 0;
+        float floatValue = 0;
+        allInt = allInt && ParseIntLiteral(fields[i].value, intValue);
+        allFloat = allFloat && ParseFloatLiteral(fields[i].value, floatValue);
+    }
+    if (FLOAT_FIELDS.count(name) != 0) {
+        return allFloat ? RecordFieldType::FLOAT : RecordFieldType::TEXT;
+    }
+    // other non-integer literals may carry double precision, keep their text so they convert back unchanged
+    return allInt ? RecordFieldType::INT : RecordFieldType::TEXT;
+}
+
+class RecordBinaryBuilder {
+public:
+    void AddLayer(const LayerRecord& layer)
+    {
+        RecordBinaryLayer entry;
+        entry.keyHash = HashRecordKey(layer.key.data(), layer.key.size());
+        entry.keyOffset = AddString(layer.key);
+        entry.keyLength = static_cast<uint32_t>(layer.key.size());
+        entry.firstField = static_cast<uint32_t>(fields_.size());
+        size_t begin = 0;
+        while (begin < layer.fields.size()) {
+            size_t end = begin;
+            while (end < layer.fields.size() && layer.fields[end].name == layer.fields[begin].name) {
+                end++;
+            }
+            AddFieldGroup(layer.fields, begin, end);
+            begin = end;
+        }
+        entry.fieldNum = static_cast<uint32_t>(fields_.size()) - entry.firstField;
+        layers_.push_back(entry);
+    }
+
+    Status Write(const std::string& fileName) const
+    {
+        RecordBinaryHeader header;
+        (void)memset(&header, 0, sizeof(header));
+        (void)memcpy(header.magic, RECORD_BINARY_MAGIC, sizeof(header.magic));
+        header.version = RECORD_BINARY_VERSION;
+        header.endianTag = RECORD_BINARY_ENDIAN_TAG;
+        header.layerNum = static_cast<uint32_t>(layers_.size());
+        header.fieldNum = static_cast<uint32_t>(fields_.size());
+        std::vector<uint32_t> buckets = BuildBuckets();
+        header.bucketNum = static_cast<uint32_t>(buckets.size());
+        header.layerOffset = AlignUp(sizeof(header));
+        header.fieldOffset = AlignUp(header.layerOffset + layers_.size() * sizeof(RecordBinaryLayer));
+        header.bucketOffset = AlignUp(header.fieldOffset + fields_.size() * sizeof(RecordBinaryField));
+        header.stringOffset = AlignUp(header.bucketOffset + buckets.size() * sizeof(uint32_t));
+        header.stringSize = strings_.size();
+        header.floatOffset = AlignUp(header.stringOffset + strings_.size());
+        header.floatNum = floats_.size();
+        header.intOffset = AlignUp(header.floatOffset + floats_.size() * sizeof(float));
+        header.intNum = ints_.size();
+
+        std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            LOG_ERROR("Open binary record file %s failed.\n", fileName.c_str());
+            return RECORD_FILE_OPEN_ERROR;
+        }
+        WriteSection(out, &header, sizeof(header), 0);
+        WriteSection(out, layers_.data(), layers_.size() * sizeof(RecordBinaryLayer), header.layerOffset);
+        WriteSection(out, fields_.data(), fields_.size() * sizeof(RecordBinaryField), header.fieldOffset);
+        WriteSection(out, buckets.data(), buckets.size() * sizeof(uint32_t), header.bucketOffset);
+        WriteSection(out, strings_.data(), strings_.size(), header.stringOffset);
+        WriteSection(out, floats_.data(), floats_.size() * sizeof(float), header.floatOffset);
+        WriteSection(out, ints_.data(), ints_.size() * sizeof(int32_t), header.intOffset);
+        out.close();
+        if (out.fail()) {
+            LOG_ERROR("Write binary record file %s failed.\n", fileName.c_str());
+            return RECORD_FILE_ERROR;
+        }
+        return SUCCESS;
+    }
+
+private:
+    uint32_t AddString(const std::string& str)
+    {
+        uint32_t offset = static_cast<uint32_t>(strings_.size());
+        strings_.append(str);
+        return offset;
+    }
+
+    void AddFieldGroup(const std::vector<RecordField>& fields, size_t begin, size_t end)
+    {
+        RecordBinaryField field;
+        field.nameOffset = AddString(fields[begin].name);
+        field.nameLength = static_cast<uint32_t>(fields[begin].name.size());
+        field.type = ClassifyFieldGroup(fields, begin, end);
+        if (field.type == RecordFieldType::TEXT) {
+            for (size_t i = begin; i < end; i++) {
+                field.count = static_cast<uint32_t>(fields[i].value.size());
+                field.dataOffset = AddString(fields[i].value);
+                fields_.push_back(field);
+            }
+            return;
+        }
+        field.count = static_cast<uint32_t>(end - begin);
+        if (field.type == RecordFieldType::FLOAT) {
+            field.dataOffset = floats_.size();
+            for (size_t i = begin; i < end; i++) {
+                float value = 0;
+                (void)ParseFloatLiteral(fields[i].value, value);
+                floats_.push_back(value);
+            }
+        } else {
+            field.dataOffset = ints_.size();
+            for (size_t i = begin; i < end; i++) {
+                int32_t value = 0;
+                (void)ParseIntLiteral(fields[i].value, value);
+                ints_.push_back(value);
+            }
+        }
+        fields_.push_back(field);
+    }
+
+    std::vector<uint32_t> BuildBuckets() const
+    {
+        // power of two with a load factor of at most 0.5
+        size_t bucketNum = 1;
+        while (bucketNum < layers_.size() * util::BINARY) {
+            bucketNum *= util::BINARY;
+        }
+        std::vector<uint32_t> buckets(bucketNum, 0);
+        for (size_t i = 0; i < layers_.size(); i++) {
+            size_t pos = layers_[i].keyHash & (bucketNum - 1);
+            while (buckets[pos] != 0) {
+                pos = (pos + 1) & (bucketNum - 1);
+            }
+            buckets[pos] = static_cast<uint32_t>(i + 1);
+        }
+        return buckets;
+    }
+
+    static void WriteSection(std::ofstream& out, const void* data, size_t length, uint64_t offset)
+    {
+        static const char padding[SECTION_ALIGN] = {0};
+        uint64_t pos = static_cast<uint64_t>(out.tellp());
+        if (offset > pos) {
+            out.write(padding, static_cast<std::streamsize>(offset - pos));
+        }
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(length));
+    }
+
+    std::vector<RecordBinaryLayer> layers_;
+    std::vector<RecordBinaryField> fields_;
+    std::string strings_;
+    std::vector<float> floats_;
+    std::vector<int32_t> ints_;
+};
+
+// shortest literal which parses back to the same float
+std::string FormatFloatLiteral(float value)
+{
+    char buffer[32];
+    for (int precision = FLOAT_MIN_PRECISION; precision < FLOAT_ROUND_TRIP_PRECISION; precision++) {
+        (void)snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+        if (strtof(buffer, nullptr) == value) {
+            return buffer;
+        }
+    }
+    (void)snprintf(buffer, sizeof(buffer), "%.*g", FLOAT_ROUND_TRIP_PRECISION, value);
+    return buffer;
+}
+
+bool InRange(uint64_t offset, uint64_t length, uint64_t size)
+{
+    return offset <= size && length <= size - offset;
+}
+}
+
+uint64_t HashRecordKey(const char* key, size_t length)
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= static_cast<unsigned char>(key[i]);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+RecordBinaryReader::~RecordBinaryReader()
+{
+    Close();
+}
+
+Status RecordBinaryReader::Open(const std::string& fileName)
+{
+    Close();
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOG_ERROR("Open binary record file %s failed: %s.\n", fileName.c_str(), strerror(errno));
+        return RECORD_FILE_OPEN_ERROR;
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || static_cast<size_t>(fileStat.st_size) < sizeof(RecordBinaryHeader)) {
+        LOG_ERROR("Binary record file %s is too small.\n", fileName.c_str());
+        (void)close(fd);
+        return RECORD_FILE_PARSE_ERROR;
+    }
+    void* addr = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    (void)close(fd);
+    if (addr == MAP_FAILED) {
+        LOG_ERROR("Map binary record file %s failed: %s.\n", fileName.c_str(), strerror(errno));
+        return RECORD_FILE_OPEN_ERROR;
+    }
+    base_ = static_cast<const char*>(addr);
+    size_ = static_cast<size_t>(fileStat.st_size);
+    header_ = reinterpret_cast<const RecordBinaryHeader*>(base_);
+    Status ret = Validate();
+    if (ret != SUCCESS) {
+        LOG_ERROR("Binary record file %s is invalid.\n", fileName.c_str());
+        Close();
+        return ret;
+    }
+    layers_ = reinterpret_cast<const RecordBinaryLayer*>(base_ + header_->layerOffset);
+    fields_ = reinterpret_cast<const RecordBinaryField*>(base_ + header_->fieldOffset);
+    buckets_ = reinterpret_cast<const uint32_t*>(base_ + header_->bucketOffset);
+    strings_ = base_ + header_->stringOffset;
+    floats_ = reinterpret_cast<const float*>(base_ + header_->floatOffset);
+    ints_ = reinterpret_cast<const int32_t*>(base_ + header_->intOffset);
+    return SUCCESS;
+}
+
+void RecordBinaryReader::Close()
+{
+    if (base_ != nullptr) {
+        (void)munmap(const_cast<char*>(base_), size_);
+    }
+    base_ = nullptr;
+    size_ = 0;
+    header_ = nullptr;
+    layers_ = nullptr;
+    fields_ = nullptr;
+    buckets_ = nullptr;
+    strings_ = nullptr;
+    floats_ = nullptr;
+    ints_ = nullptr;
+}
+
+Status RecordBinaryReader::Validate() const
+{
+    const RecordBinaryHeader& header = *header_;
+    if (memcmp(header.magic, RECORD_BINARY_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != RECORD_BINARY_VERSION || header.endianTag != RECORD_BINARY_ENDIAN_TAG) {
+        return RECORD_FILE_PARSE_ERROR;
+    }
+    if (header.bucketNum == 0 || (header.bucketNum & (header.bucketNum - 1)) != 0 ||
+        header.bucketNum <= header.layerNum) {
+        return RECORD_FILE_PARSE_ERROR;
+    }
+    uint64_t offsets[] = {header.layerOffset, header.fieldOffset, header.bucketOffset, header.floatOffset,
+        header.intOffset};
+    for (auto offset : offsets) {
+        if (offset % SECTION_ALIGN != 0) {
+            return RECORD_FILE_PARSE_ERROR;
+        }
+    }
+    if (!InRange(header.layerOffset, static_cast<uint64_t>(header.layerNum) * sizeof(RecordBinaryLayer), size_) ||
+        !InRange(header.fieldOffset, static_cast<uint64_t>(header.fieldNum) * sizeof(RecordBinaryField), size_) ||
+        !InRange(header.bucketOffset, static_cast<uint64_t>(header.bucketNum) * sizeof(uint32_t), size_) ||
+        !InRange(header.stringOffset, header.stringSize, size_) ||
+        header.floatNum > size_ || !InRange(header.floatOffset, header.floatNum * sizeof(float), size_) ||
+        header.intNum > size_ || !InRange(header.intOffset, header.intNum * sizeof(int32_t), size_)) {
+        return RECORD_FILE_PARSE_ERROR;
+    }
+    auto layers = reinterpret_cast<const RecordBinaryLayer*>(base_ + header.layerOffset);
+    for (uint32_t i = 0; i < header.layerNum; i++) {
+        if (!InRange(layers[i].keyOffset, layers[i].keyLength, header.stringSize) ||
+            !InRange(layers[i].firstField, layers[i].fieldNum, header.fieldNum)) {
+            return RECORD_FILE_PARSE_ERROR;
+        }
+    }
+    auto fields = reinterpret_cast<const RecordBinaryField*>(base_ + header.fieldOffset);
+    for (uint32_t i = 0; i < header.fieldNum; i++) {
+        const RecordBinaryField& field = fields[i];
+        bool valid = InRange(field.nameOffset, field.nameLength, header.stringSize);
+        if (field.type == RecordFieldType::FLOAT) {
+            valid = valid && InRange(field.dataOffset, field.count, header.floatNum);
+        } else if (field.type == RecordFieldType::INT) {
+            valid = valid && InRange(field.dataOffset, field.count, header.intNum);
+        } else if (field.type == RecordFieldType::TEXT) {
+            valid = valid && InRange(field.dataOffset, field.count, header.stringSize);
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            return RECORD_FILE_PARSE_ERROR;
+        }
+    }
+    auto buckets = reinterpret_cast<const uint32_t*>(base_ + header.bucketOffset);
+    for (uint32_t i = 0; i < header.bucketNum; i++) {
+        if (buckets[i] > header.layerNum) {
+            return RECORD_FILE_PARSE_ERROR;
+        }
+    }
+    return SUCCESS;
+}
+
+std::string RecordBinaryReader::String(uint64_t offset, uint64_t length) const
+{
+    return std::string(strings_ + offset, length);
+}
+
+std::string RecordBinaryReader::LayerKey(uint32_t layer) const
+{
+    if (layer >= LayerNum()) {
+        return "";
+    }
+    return String(layers_[layer].keyOffset, layers_[layer].keyLength);
+}
+
+int64_t RecordBinaryReader::FindLayer(const std::string& key) const
+{
+    if (header_ == nullptr) {
+        return -1;
+    }
+    uint64_t hash = HashRecordKey(key.data(), key.size());
+    uint32_t mask = header_->bucketNum - 1;
+    for (uint32_t pos = hash & mask, probe = 0; probe < header_->bucketNum; pos = (pos + 1) & mask, probe++) {
+        if (buckets_[pos] == 0) {
+            return -1;
+        }
+        const RecordBinaryLayer& layer = layers_[buckets_[pos] - 1];
+        if (layer.keyHash == hash && layer.keyLength == key.size() &&
+            memcmp(strings_ + layer.keyOffset, key.data(), key.size()) == 0) {
+            return buckets_[pos] - 1;
+        }
+    }
+    return -1;
+}
+
+const RecordBinaryField* RecordBinaryReader::FindField(uint32_t layer, const std::string& name) const
+{
+    if (layer >= LayerNum()) {
+        return nullptr;
+    }
+    const RecordBinaryField* begin = fields_ + layers_[layer].firstField;
+    const RecordBinaryField* end = begin + layers_[layer].fieldNum;
+    for (const RecordBinaryField* field = begin; field < end; field++) {
+        if (field->nameLength == name.size() && memcmp(strings_ + field->nameOffset, name.data(), name.size()) == 0) {
+            return field;
+        }
+    }
+    return nullptr;
+}
+
+Status RecordBinaryReader::GetFloatField(uint32_t layer, const std::string& name, const float*& data,
+    size_t& count) const
+{
+    const RecordBinaryField* field = FindField(layer, name);
+    if (field == nullptr) {
+        return RECORD_NOT_EXIT_ERROR;
+    }
+    if (field->type != RecordFieldType::FLOAT) {
+        return BAD_FORMAT_ERROR;
+    }
+    data = floats_ + field->dataOffset;
+    count = field->count;
+    return SUCCESS;
+}
+
+Status RecordBinaryReader::GetIntField(uint32_t layer, const std::string& name, const int32_t*& data,
+    size_t& count) const
+{
+    const RecordBinaryField* field = FindField(layer, name);
+    if (field == nullptr) {
+        return RECORD_NOT_EXIT_ERROR;
+    }
+    if (field->type != RecordFieldType::INT) {
+        return BAD_FORMAT_ERROR;
+    }
+    data = ints_ + field->dataOffset;
+    count = field->count;
+    return SUCCESS;
+}
+
+Status RecordBinaryReader::ToRecordFile(RecordFile& recordFile) const
+{
+    if (header_ == nullptr) {
+        return NULL_PTR_ERROR;
+    }
+    for (uint32_t i = 0; i < header_->layerNum; i++) {
+        LayerRecord& layer = recordFile.GetOrAddLayer(LayerKey(i));
+        layer.fields.clear();
+        const RecordBinaryField* begin = fields_ + layers_[i].firstField;
+        for (const RecordBinaryField* field = begin; field < begin + layers_[i].fieldNum; field++) {
+            std::string name = String(field->nameOffset, field->nameLength);
+            if (field->type == RecordFieldType::TEXT) {
+                layer.fields.push_back({name, String(field->dataOffset, field->count)});
+                continue;
+            }
+            for (uint32_t j = 0; j < field->count; j++) {
+                if (field->type == RecordFieldType::FLOAT) {
+                    layer.fields.push_back({name, FormatFloatLiteral(floats_[field->dataOffset + j])});
+                } else {
+                    layer.fields.push_back({name, std::to_string(ints_[field->dataOffset + j])});
+                }
+            }
+        }
+    }
+    return SUCCESS;
+}
+
+Status WriteRecordBinary(const std::string& fileName, const RecordFile& recordFile)
+{
+    RecordBinaryBuilder builder;
+    for (auto& layer : recordFile.layers) {
+        builder.AddLayer(layer);
+    }
+    return builder.Write(fileName);
+}
+
+Status ConvertRecordTextToBinary(const std::string& textFileName, const std::string& binaryFileName)
+{
+    RecordFile recordFile;
+    Status ret = LoadRecordFile(textFileName, recordFile);
+    CHECK_OK(ret);
+    return WriteRecordBinary(binaryFileName, recordFile);
+}
+
+Status ConvertRecordBinaryToText(const std::string& binaryFileName, const std::string& textFileName)
+{
+    RecordBinaryReader reader;
+    Status ret = reader.Open(binaryFileName);
+    CHECK_OK(ret);
+    RecordFile recordFile;
+    ret = reader.ToRecordFile(recordFile);
+    CHECK_OK(ret);
+    std::ofstream out(textFileName, std::ios::trunc);
+    if (!out.is_open()) {
+        LOG_ERROR("Open record file %s failed.\n", textFileName.c_str());
+        return RECORD_FILE_OPEN_ERROR;
+    }
+    out << SerializeRecordText(recordFile);
+    out.close();
+    return out.fail() ? RECORD_FILE_ERROR : SUCCESS;
+}
+} // namespace AmctCommon
+
+int AmctRecordTextToBinary(const char* textFileName, const char* binaryFileName)
+{
+    NULLPTR_CHECK(textFileName);
+    NULLPTR_CHECK(binaryFileName);
+    return AmctCommon::ConvertRecordTextToBinary(textFileName, binaryFileName);
+}
+
+int AmctRecordBinaryToText(const char* binaryFileName, const char* textFileName)
+{
+    NULLPTR_CHECK(binaryFileName);
+    NULLPTR_CHECK(textFileName);
+    return AmctCommon::ConvertRecordBinaryToText(binaryFileName, textFileName);
+}
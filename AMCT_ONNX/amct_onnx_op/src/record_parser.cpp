@@ -0,0 +1,452 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief record_parser C++ implementation
+ *
+ * @file record_parser.cpp
+ *
+ * @version 1.0
+ */
+
+#include "record_parser.h"
+
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "record_binary.h"
+
+namespace AmctCommon {
+namespace {
+constexpr int MAX_FAST_DIGITS = 19;
+// powers of ten exactly representable as double
+constexpr int MAX_EXACT_POW10 = 22;
+constexpr double EXACT_POW10[MAX_EXACT_POW10 + 1] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+constexpr uint64_t MAX_EXACT_DOUBLE_INT = 1ULL << 53;
+// double mantissa bits dropped when rounding to float, and the pattern of a value half way between two floats
+constexpr uint64_t FLOAT_DROPPED_MASK = (1ULL << 29) - 1;
+constexpr uint64_t FLOAT_HALF_WAY = 1ULL << 28;
+constexpr size_t MAX_LITERAL_LENGTH = 128;
+constexpr int DECIMAL_BASE = 10;
+
+inline bool IsDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline bool IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool ParseFloatSlow(const char* begin, const char* end, float& value)
+{
+    char buffer[MAX_LITERAL_LENGTH];
+    size_t length = static_cast<size_t>(end - begin);
+    if (length == 0 || length >= sizeof(buffer)) {
+        return false;
+    }
+    (void)memcpy(buffer, begin, length);
+    buffer[length] = '\0';
+    char* parsed = nullptr;
+    value = strtof(buffer, &parsed);
+    return parsed == buffer + length;
+}
+
+class RecordScanner {
+public:
+    RecordScanner(const char* text, size_t length) : cur_(text), end_(text + length) {}
+
+    bool Next(StringRef& token)
+    {
+        SkipSpace();
+        if (cur_ >= end_) {
+            return false;
+        }
+        const char* begin = cur_;
+        if (*cur_ == '{' || *cur_ == '}' || *cur_ == ':') {
+            cur_++;
+        } else if (*cur_ == '"' || *cur_ == '\'') {
+            SkipString();
+        } else {
+            while (cur_ < end_ && !IsSpace(*cur_) && *cur_ != '{' && *cur_ != '}' && *cur_ != ':') {
+                cur_++;
+            }
+        }
+        token = StringRef(begin, static_cast<size_t>(cur_ - begin));
+        return true;
+    }
+
+    // nested message from its '{' (already consumed) to the matching '}'
+    bool RawBlock(StringRef& block)
+    {
+        const char* begin = cur_ - 1;
+        int depth = 1;
+        while (cur_ < end_ && depth > 0) {
+            if (*cur_ == '"' || *cur_ == '\'') {
+                SkipString();
+                continue;
+            }
+            depth += (*cur_ == '{') ? 1 : ((*cur_ == '}') ? -1 : 0);
+            cur_++;
+        }
+        block = StringRef(begin, static_cast<size_t>(cur_ - begin));
+        return depth == 0;
+    }
+
+private:
+    void SkipSpace()
+    {
+        while (cur_ < end_) {
+            if (IsSpace(*cur_)) {
+                cur_++;
+            } else if (*cur_ == '#') {
+                const char* lineEnd = static_cast<const char*>(memchr(cur_, '\n', static_cast<size_t>(end_ - cur_)));
+                cur_ = lineEnd == nullptr ? end_ : lineEnd;
+            } else {
+                break;
+            }
+        }
+    }
+
+    void SkipString()
+    {
+        char quote = *cur_++;
+        while (cur_ < end_ && *cur_ != quote) {
+            cur_ += (*cur_ == '\\') ? NUM_ESCAPE_CHARS : 1;
+        }
+        cur_ = cur_ < end_ ? cur_ + 1 : end_;
+    }
+
+    static constexpr int NUM_ESCAPE_CHARS = 2;
+    const char* cur_;
+    const char* end_;
+};
+
+inline bool IsToken(const StringRef& token, char c)
+{
+    return token.size == 1 && token.data[0] == c;
+}
+
+inline bool IsToken(const StringRef& token, const char* word)
+{
+    return token == StringRef(word, strlen(word));
+}
+
+StringRef StripQuotes(const StringRef& literal)
+{
+    if (literal.size >= util::BINARY && (literal.data[0] == '"' || literal.data[0] == '\'')) {
+        return StringRef(literal.data + 1, literal.size - util::BINARY);
+    }
+    return literal;
+}
+}
+
+bool ParseFloatFast(const char* begin, const char* end, float& value)
+{
+    const char* cur = begin;
+    bool negative = cur < end && *cur == '-';
+    cur += (cur < end && (*cur == '-' || *cur == '+')) ? 1 : 0;
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    const char* digitBegin = cur;
+    for (; cur < end && IsDigit(*cur); cur++) {
+        if (digits < MAX_FAST_DIGITS) {
+            mantissa = mantissa * DECIMAL_BASE + static_cast<uint64_t>(*cur - '0');
+            digits += (mantissa != 0) ? 1 : 0;
+        } else {
+            exponent++;
+            digits++;
+        }
+    }
+    if (cur < end && *cur == '.') {
+        for (cur++; cur < end && IsDigit(*cur); cur++) {
+            if (digits < MAX_FAST_DIGITS) {
+                mantissa = mantissa * DECIMAL_BASE + static_cast<uint64_t>(*cur - '0');
+                digits += (mantissa != 0) ? 1 : 0;
+                exponent--;
+            } else {
+                digits++;
+            }
+        }
+    }
+    if (cur == digitBegin || (cur == digitBegin + 1 && *digitBegin == '.')) {
+        // inf, nan, hex floats
+        return ParseFloatSlow(begin, end, value);
+    }
+    if (cur < end && (*cur == 'e' || *cur == 'E')) {
+        const char* expBegin = ++cur;
+        bool expNegative = cur < end && *cur == '-';
+        cur += (cur < end && (*cur == '-' || *cur == '+')) ? 1 : 0;
+        int expValue = 0;
+        for (; cur < end && IsDigit(*cur); cur++) {
+            expValue = expValue < INT_MAX / DECIMAL_BASE ? expValue * DECIMAL_BASE + (*cur - '0') : expValue;
+        }
+        if (cur == expBegin || !IsDigit(*(cur - 1))) {
+            return false;
+        }
+        exponent += expNegative ? -expValue : expValue;
+    }
+    if (cur != end) {
+        return false;
+    }
+    if (digits > MAX_FAST_DIGITS || mantissa > MAX_EXACT_DOUBLE_INT || exponent > MAX_EXACT_POW10 ||
+        exponent < -MAX_EXACT_POW10) {
+        return ParseFloatSlow(begin, end, value);
+    }
+    // exact operands, so the double is the correctly rounded value of the literal
+    double result = static_cast<double>(mantissa);
+    result = exponent < 0 ? result / EXACT_POW10[-exponent] : result * EXACT_POW10[exponent];
+    uint64_t bits = 0;
+    (void)memcpy(&bits, &result, sizeof(bits));
+    float rounded = static_cast<float>(result);
+    // a double half way between two floats (or a subnormal float) may round differently than strtof
+    if (mantissa != 0 && ((bits & FLOAT_DROPPED_MASK) == FLOAT_HALF_WAY || !std::isnormal(rounded))) {
+        return ParseFloatSlow(begin, end, value);
+    }
+    value = negative ? -rounded : rounded;
+    return true;
+}
+
+bool ParseIntFast(const char* begin, const char* end, int64_t& value)
+{
+    const char* cur = begin;
+    bool negative = cur < end && *cur == '-';
+    cur += (cur < end && (*cur == '-' || *cur == '+')) ? 1 : 0;
+    if (cur == end) {
+        return false;
+    }
+    uint64_t result = 0;
+    for (; cur < end; cur++) {
+        if (!IsDigit(*cur) || result > (static_cast<uint64_t>(INT64_MAX) - (*cur - '0')) / DECIMAL_BASE) {
+            return false;
+        }
+        result = result * DECIMAL_BASE + static_cast<uint64_t>(*cur - '0');
+    }
+    value = negative ? -static_cast<int64_t>(result) : static_cast<int64_t>(result);
+    return true;
+}
+
+RecordTextView::~RecordTextView()
+{
+    Close();
+}
+
+void RecordTextView::Close()
+{
+    if (mapped_ != nullptr) {
+        (void)munmap(const_cast<char*>(mapped_), mappedSize_);
+    }
+    mapped_ = nullptr;
+    mappedSize_ = 0;
+    layers_.clear();
+    fields_.clear();
+    buckets_.clear();
+}
+
+Status RecordTextView::Open(const std::string& fileName)
+{
+    Close();
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return RECORD_FILE_OPEN_ERROR;
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0) {
+        (void)close(fd);
+        return RECORD_FILE_OPEN_ERROR;
+    }
+    if (fileStat.st_size == 0) {
+        (void)close(fd);
+        return Parse("", 0);
+    }
+    void* addr = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    (void)close(fd);
+    if (addr == MAP_FAILED) {
+        LOG_ERROR("Map record file %s failed: %s.\n", fileName.c_str(), strerror(errno));
+        return RECORD_FILE_OPEN_ERROR;
+    }
+    (void)madvise(addr, static_cast<size_t>(fileStat.st_size), MADV_SEQUENTIAL);
+    Status ret = Parse(static_cast<const char*>(addr), static_cast<size_t>(fileStat.st_size));
+    mapped_ = static_cast<const char*>(addr);
+    mappedSize_ = static_cast<size_t>(fileStat.st_size);
+    if (ret != SUCCESS) {
+        LOG_ERROR("Parse record file %s failed.\n", fileName.c_str());
+        Close();
+    }
+    return ret;
+}
+
+Status RecordTextView::Parse(const char* text, size_t length)
+{
+    layers_.clear();
+    fields_.clear();
+    RecordScanner scanner(text, length);
+    StringRef token;
+    StringRef name;
+    while (scanner.Next(token)) {
+        if (!IsToken(token, "record") || !scanner.Next(token) || !IsToken(token, '{')) {
+            return RECORD_FILE_PARSE_ERROR;
+        }
+        RecordLayerView layer = {StringRef(), static_cast<uint32_t>(fields_.size()), 0};
+        bool closed = false;
+        while (!closed && scanner.Next(token)) {
+            if (IsToken(token, '}')) {
+                closed = true;
+            } else if (IsToken(token, "key")) {
+                if (!scanner.Next(token) || !IsToken(token, ':') || !scanner.Next(token)) {
+                    return RECORD_FILE_PARSE_ERROR;
+                }
+                layer.key = StripQuotes(token);
+            } else if (IsToken(token, "value")) {
+                if (!scanner.Next(token) || (IsToken(token, ':') && !scanner.Next(token)) || !IsToken(token, '{')) {
+                    return RECORD_FILE_PARSE_ERROR;
+                }
+                // fields of the value message up to its '}'
+                while (scanner.Next(name) && !IsToken(name, '}')) {
+                    if (!scanner.Next(token) || (IsToken(token, ':') && !scanner.Next(token)) ||
+                        (IsToken(token, '{') && !scanner.RawBlock(token))) {
+                        return RECORD_FILE_PARSE_ERROR;
+                    }
+                    fields_.push_back({name, token});
+                }
+            } else {
+                return RECORD_FILE_PARSE_ERROR;
+            }
+        }
+        if (!closed) {
+            return RECORD_FILE_PARSE_ERROR;
+        }
+        layer.fieldNum = static_cast<uint32_t>(fields_.size()) - layer.firstField;
+        layers_.push_back(layer);
+    }
+    BuildIndex();
+    return SUCCESS;
+}
+
+void RecordTextView::BuildIndex()
+{
+    size_t bucketNum = 1;
+    while (bucketNum < layers_.size() * util::BINARY) {
+        bucketNum *= util::BINARY;
+    }
+    buckets_.assign(bucketNum, 0);
+    for (size_t i = 0; i < layers_.size(); i++) {
+        size_t pos = HashRecordKey(layers_[i].key.data, layers_[i].key.size) & (bucketNum - 1);
+        bool duplicated = false;
+        while (buckets_[pos] != 0 && !duplicated) {
+            duplicated = layers_[buckets_[pos] - 1].key == layers_[i].key;
+            pos = (pos + 1) & (bucketNum - 1);
+        }
+        if (!duplicated) {
+            buckets_[pos] = static_cast<uint32_t>(i + 1);
+        }
+    }
+}
+
+const RecordLayerView* RecordTextView::FindLayer(const StringRef& key) const
+{
+    if (buckets_.empty()) {
+        return nullptr;
+    }
+    size_t mask = buckets_.size() - 1;
+    for (size_t pos = HashRecordKey(key.data, key.size) & mask; buckets_[pos] != 0; pos = (pos + 1) & mask) {
+        const RecordLayerView& layer = layers_[buckets_[pos] - 1];
+        if (layer.key == key) {
+            return &layer;
+        }
+    }
+    return nullptr;
+}
+
+const RecordFieldView* RecordTextView::FindField(const RecordLayerView& layer, const StringRef& name) const
+{
+    for (const RecordFieldView* field = FieldBegin(layer); field < FieldEnd(layer); field++) {
+        if (field->name == name) {
+            return field;
+        }
+    }
+    return nullptr;
+}
+
+Status RecordTextView::GetFloats(const RecordLayerView& layer, const StringRef& name, float* data, size_t capacity,
+    size_t& count) const
+{
+    count = 0;
+    for (const RecordFieldView* field = FieldBegin(layer); field < FieldEnd(layer); field++) {
+        if (field->name != name) {
+            continue;
+        }
+        float value = 0;
+        if (!ParseFloatFast(field->value.data, field->value.data + field->value.size, value)) {
+            return BAD_FORMAT_ERROR;
+        }
+        if (count < capacity) {
+            data[count] = value;
+        }
+        count++;
+    }
+    return count == 0 ? RECORD_NOT_EXIT_ERROR : SUCCESS;
+}
+
+Status RecordTextView::GetInts(const RecordLayerView& layer, const StringRef& name, int* data, size_t capacity,
+    size_t& count) const
+{
+    count = 0;
+    for (const RecordFieldView* field = FieldBegin(layer); field < FieldEnd(layer); field++) {
+        if (field->name != name) {
+            continue;
+        }
+        int64_t value = 0;
+        if (!ParseIntFast(field->value.data, field->value.data + field->value.size, value) ||
+            value < INT_MIN || value > INT_MAX) {
+            return BAD_FORMAT_ERROR;
+        }
+        if (count < capacity) {
+            data[count] = static_cast<int>(value);
+        }
+        count++;
+    }
+    return count == 0 ? RECORD_NOT_EXIT_ERROR : SUCCESS;
+}
+
+Status RecordTextView::GetFloats(const RecordLayerView& layer, const StringRef& name, std::vector<float>& data) const
+{
+    size_t count = 0;
+    Status ret = GetFloats(layer, name, data.data(), data.size(), count);
+    if (ret == SUCCESS && count > data.size()) {
+        data.resize(count);
+        ret = GetFloats(layer, name, data.data(), data.size(), count);
+    }
+    data.resize(ret == SUCCESS ? count : 0);
+    return ret;
+}
+
+Status RecordTextView::GetInts(const RecordLayerView& layer, const StringRef& name, std::vector<int>& data) const
+{
+    size_t count = 0;
+    Status ret = GetInts(layer, name, data.data(), data.size(), count);
+    if (ret == SUCCESS && count > data.size()) {
+        data.resize(count);
+        ret = GetInts(layer, name, data.data(), data.size(), count);
+    }
+    data.resize(ret == SUCCESS ? count : 0);
+    return ret;
+}
+} // namespace AmctCommon
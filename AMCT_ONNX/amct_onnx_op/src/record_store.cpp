@@ -0,0 +1,402 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief record_store C++ implementation
+ *
+ * @file record_store.cpp
+ *
+ * @version 1.0
+ */
+
+#include "record_store.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "amct_profiler.h"
+#include "record_parser.h"
+
+namespace AmctCommon {
+namespace {
+constexpr int RECORD_FLOAT_PRECISION = 10;
+constexpr int RECORD_TYPE_ID_FLOAT = 1;
+constexpr int RECORD_TYPE_ID_FLOAT16 = 10;
+constexpr int RECORD_TYPE_ID_BFLOAT16 = 16;
+constexpr mode_t RECORD_FILE_MODE = 0640;
+
+std::string FormatRecordValue(float value)
+{
+    char buffer[32];
+    (void)snprintf(buffer, sizeof(buffer), "%.*g", RECORD_FLOAT_PRECISION, value);
+    return buffer;
+}
+
+std::string FormatRecordValue(int value)
+{
+    return std::to_string(value);
+}
+
+std::string Quote(const std::string& str)
+{
+    std::string result = "\"";
+    for (auto c : str) {
+        if (c == '"' || c == '\\') {
+            result.push_back('\\');
+        }
+        result.push_back(c);
+    }
+    result.push_back('"');
+    return result;
+}
+
+// key literal without its quotes, escape sequences resolved
+std::string UnescapeKey(const StringRef& key)
+{
+    std::string result;
+    result.reserve(key.size);
+    for (size_t i = 0; i < key.size; i++) {
+        if (key.data[i] == '\\' && i + 1 < key.size) {
+            i++;
+        }
+        result.push_back(key.data[i]);
+    }
+    return result;
+}
+
+void AppendRecordView(const RecordTextView& view, RecordFile& recordFile)
+{
+    for (uint32_t i = 0; i < view.LayerNum(); i++) {
+        const RecordLayerView& layerView = view.Layer(i);
+        LayerRecord layer = {UnescapeKey(layerView.key), {}};
+        layer.fields.reserve(layerView.fieldNum);
+        for (const RecordFieldView* field = view.FieldBegin(layerView); field < view.FieldEnd(layerView); field++) {
+            layer.fields.push_back({field->name.ToString(), field->value.ToString()});
+        }
+        MergeLayerRecord(layer, recordFile.GetOrAddLayer(layer.key));
+    }
+}
+
+Status WriteFileAtomically(const std::string& fileName, const std::string& content)
+{
+    std::string tmpFileName = fileName + ".tmp." + std::to_string(getpid());
+    int fd = open(tmpFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, RECORD_FILE_MODE);
+    if (fd < 0) {
+        LOG_ERROR("Open record file %s failed: %s.\n", tmpFileName.c_str(), strerror(errno));
+        return RECORD_FILE_OPEN_ERROR;
+    }
+    size_t written = 0;
+    while (written < content.size()) {
+        ssize_t ret = write(fd, content.data() + written, content.size() - written);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            LOG_ERROR("Write record file %s failed: %s.\n", tmpFileName.c_str(), strerror(errno));
+            (void)close(fd);
+            (void)unlink(tmpFileName.c_str());
+            return RECORD_FILE_ERROR;
+        }
+        written += static_cast<size_t>(ret);
+    }
+    (void)fsync(fd);
+    (void)close(fd);
+    if (rename(tmpFileName.c_str(), fileName.c_str()) != 0) {
+        LOG_ERROR("Rename record file %s failed: %s.\n", fileName.c_str(), strerror(errno));
+        (void)unlink(tmpFileName.c_str());
+        return RECORD_FILE_ERROR;
+    }
+    return SUCCESS;
+}
+
+// advisory lock shared by every process writing the same record file
+class RecordFileLock {
+public:
+    explicit RecordFileLock(const std::string& fileName)
+    {
+        std::string lockFileName = fileName + ".lock";
+        fd_ = open(lockFileName.c_str(), O_RDWR | O_CREAT, RECORD_FILE_MODE);
+        if (fd_ >= 0 && flock(fd_, LOCK_EX) != 0) {
+            (void)close(fd_);
+            fd_ = -1;
+        }
+        if (fd_ < 0) {
+            LOG_ERROR("Lock record file %s failed: %s.\n", lockFileName.c_str(), strerror(errno));
+        }
+    }
+    ~RecordFileLock()
+    {
+        if (fd_ >= 0) {
+            (void)flock(fd_, LOCK_UN);
+            (void)close(fd_);
+        }
+    }
+    bool Locked() const
+    {
+        return fd_ >= 0;
+    }
+
+private:
+    int fd_{-1};
+};
+}
+
+LayerRecord& RecordFile::GetOrAddLayer(const std::string& key)
+{
+    auto item = layerIndex.find(key);
+    if (item != layerIndex.end()) {
+        return layers[item->second];
+    }
+    layerIndex[key] = layers.size();
+    layers.push_back({key, {}});
+    return layers.back();
+}
+
+const LayerRecord* RecordFile::FindLayer(const std::string& key) const
+{
+    auto item = layerIndex.find(key);
+    return item == layerIndex.end() ? nullptr : &layers[item->second];
+}
+
+void MergeLayerRecord(const LayerRecord& src, LayerRecord& dst)
+{
+    size_t begin = 0;
+    while (begin < src.fields.size()) {
+        // src fields with the same name form one group which replaces the dst group in place
+        const std::string& name = src.fields[begin].name;
+        size_t end = begin;
+        while (end < src.fields.size() && src.fields[end].name == name) {
+            end++;
+        }
+        size_t insertPos = dst.fields.size();
+        std::vector<RecordField> kept;
+        kept.reserve(dst.fields.size());
+        for (auto& field : dst.fields) {
+            if (field.name == name) {
+                insertPos = std::min(insertPos, kept.size());
+                continue;
+            }
+            kept.push_back(field);
+        }
+        kept.insert(kept.begin() + static_cast<std::ptrdiff_t>(std::min(insertPos, kept.size())),
+            src.fields.begin() + static_cast<std::ptrdiff_t>(begin),
+            src.fields.begin() + static_cast<std::ptrdiff_t>(end));
+        dst.fields.swap(kept);
+        begin = end;
+    }
+}
+
+Status ParseRecordText(const char* text, size_t length, RecordFile& recordFile)
+{
+    RecordTextView view;
+    Status ret = view.Parse(text, length);
+    CHECK_OK(ret);
+    AppendRecordView(view, recordFile);
+    return SUCCESS;
+}
+
+Status LoadRecordFile(const std::string& fileName, RecordFile& recordFile)
+{
+    RecordTextView view;
+    Status ret = view.Open(fileName);
+    CHECK_OK(ret);
+    AppendRecordView(view, recordFile);
+    return SUCCESS;
+}
+
+
+std::string SerializeRecordText(const RecordFile& recordFile)
+{
+    std::string text;
+    for (auto& layer : recordFile.layers) {
+        text.append("record {\n  key: ").append(Quote(layer.key)).append("\n  value {\n");
+        for (auto& field : layer.fields) {
+            bool isBlock = !field.value.empty() && field.value[0] == '{';
+            text.append("    ").append(field.name).append(isBlock ? " " : ": ").append(field.value).append("\n");
+        }
+        text.append("  }\n}\n");
+    }
+    return text;
+}
+
+RecordStore& RecordStore::Instance()
+{
+    static RecordStore store;
+    return store;
+}
+
+RecordStore::RecordStore()
+{
+    const char* value = getenv(RECORD_LAYER_FLUSH_ENV);
+    layerFlush_ = value != nullptr && value[0] != '\0' && std::string(value) != "0";
+}
+
+RecordStore::~RecordStore()
+{
+    (void)FlushAll();
+}
+
+RecordStore::FileEntry& RecordStore::GetEntry(const std::string& fileName)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = files_[fileName];
+    if (entry == nullptr) {
+        entry.reset(new FileEntry());
+    }
+    return *entry;
+}
+
+void RecordStore::AcquireWriter(const std::string& fileName)
+{
+    FileEntry& entry = GetEntry(fileName);
+    std::lock_guard<std::mutex> lock(entry.mutex);
+    entry.writers++;
+}
+
+Status RecordStore::ReleaseWriter(const std::string& fileName)
+{
+    FileEntry& entry = GetEntry(fileName);
+    std::lock_guard<std::mutex> lock(entry.mutex);
+    entry.writers = entry.writers > 0 ? entry.writers - 1 : 0;
+    if (entry.writers > 0) {
+        return SUCCESS;
+    }
+    return FlushEntry(fileName, entry);
+}
+
+Status RecordStore::RecordLayer(const std::string& fileName, const LayerRecord& layerRecord)
+{
+    FileEntry& entry = GetEntry(fileName);
+    std::lock_guard<std::mutex> lock(entry.mutex);
+    MergeLayerRecord(layerRecord, entry.pending.GetOrAddLayer(layerRecord.key));
+    // the file is rewritten once when its last writer is released, a record without a registered writer goes out
+    // at once as nothing would release it
+    if (layerFlush_ || entry.writers == 0) {
+        return FlushEntry(fileName, entry);
+    }
+    return SUCCESS;
+}
+
+template <typename T>
+Status RecordStore::RecordScaleOffset(const std::string& fileName, const std::string& layerName,
+    const util::RecordData<T>& recordData)
+{
+    LayerRecord layer = {layerName, {}};
+    std::string scaleName = "scale_d";
+    std::string offsetName = "offset_d";
+    if (recordData.dataType == "weight") {
+        scaleName = "scale_w";
+        offsetName = "offset_w";
+    } else if (recordData.dataType == "initial_h") {
+        scaleName = "scale_h";
+        offsetName = "offset_h";
+    }
+    layer.fields.push_back({scaleName, FormatRecordValue(recordData.scale)});
+    layer.fields.push_back({offsetName, FormatRecordValue(recordData.offset)});
+    std::string quantType = recordData.quantType.empty() ?
+        "\"INT" + std::to_string(recordData.numBits) + "\"" : Quote(recordData.quantType);
+    layer.fields.push_back({recordData.dataType == "weight" ? "wts_type" : "act_type", quantType});
+    if (recordData.opDtype == RECORD_TYPE_ID_FLOAT) {
+        layer.fields.push_back({"op_data_type", "'FLOAT32'"});
+    } else if (recordData.opDtype == RECORD_TYPE_ID_FLOAT16) {
+        layer.fields.push_back({"op_data_type", "'FLOAT16'"});
+    } else if (recordData.opDtype == RECORD_TYPE_ID_BFLOAT16) {
+        layer.fields.push_back({"op_data_type", "'BFLOAT16'"});
+    }
+    if (!recordData.fakequantPrecisionMode.empty() && recordData.fakequantPrecisionMode != "DEFAULT") {
+        layer.fields.push_back({"fakequant_precision_mode", Quote(recordData.fakequantPrecisionMode)});
+    }
+    return RecordLayer(fileName, layer);
+}
+
+template <typename T>
+Status RecordStore::RecordRepeatData(const std::string& fileName, const std::string& layerName,
+    const std::vector<T>& data, const std::string& dataType)
+{
+    if (data.empty()) {
+        return CONTAINER_EMPTY_ERROR;
+    }
+    LayerRecord layer = {layerName, {}};
+    layer.fields.reserve(data.size());
+    for (auto value : data) {
+        layer.fields.push_back({dataType, FormatRecordValue(value)});
+    }
+    return RecordLayer(fileName, layer);
+}
+
+Status RecordStore::Flush(const std::string& fileName)
+{
+    FileEntry& entry = GetEntry(fileName);
+    std::lock_guard<std::mutex> lock(entry.mutex);
+    return FlushEntry(fileName, entry);
+}
+
+Status RecordStore::FlushAll()
+{
+    std::vector<std::string> fileNames;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& item : files_) {
+            fileNames.push_back(item.first);
+        }
+    }
+    Status result = SUCCESS;
+    for (auto& fileName : fileNames) {
+        Status ret = Flush(fileName);
+        result = (ret != SUCCESS) ? ret : result;
+    }
+    return result;
+}
+
+Status RecordStore::FlushEntry(const std::string& fileName, FileEntry& entry)
+{
+    if (entry.pending.layers.empty()) {
+        return SUCCESS;
+    }
+    RecordFileLock fileLock(fileName);
+    if (!fileLock.Locked()) {
+        return RECORD_FILE_ERROR;
+    }
+    // records of other layers may have been written by python or by other processes since the last flush
+    RecordFile recordFile;
+    struct stat fileStat;
+    if (stat(fileName.c_str(), &fileStat) == 0) {
+        Status ret = LoadRecordFile(fileName, recordFile);
+        CHECK_OK(ret);
+    }
+    for (auto& layer : entry.pending.layers) {
+        MergeLayerRecord(layer, recordFile.GetOrAddLayer(layer.key));
+    }
+    std::string content = SerializeRecordText(recordFile);
+    ProfileScope profile("record_flush", 0, content.size());
+    Status ret = WriteFileAtomically(fileName, content);
+    CHECK_OK(ret);
+    entry.pending = RecordFile();
+    return SUCCESS;
+}
+
+template Status RecordStore::RecordScaleOffset<int>(const std::string& fileName, const std::string& layerName,
+    const util::RecordData<int>& recordData);
+template Status RecordStore::RecordRepeatData<int>(const std::string& fileName, const std::string& layerName,
+    const std::vector<int>& data, const std::string& dataType);
+template Status RecordStore::RecordRepeatData<float>(const std::string& fileName, const std::string& layerName,
+    const std::vector<float>& data, const std::string& dataType);
+} // namespace AmctCommon
+
+int AmctFlushRecordFiles()
+{
+    return AmctCommon::RecordStore::Instance().FlushAll();
+}
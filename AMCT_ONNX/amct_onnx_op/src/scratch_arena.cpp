@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief scratch_arena C++ implementation
+ *
+ * @file scratch_arena.cpp
+ *
+ * @version 1.0
+ */
+
+#include "scratch_arena.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <sys/mman.h>
+
+#include "amct_profiler.h"
+#include "util.h"
+
+namespace AmctCommon {
+namespace {
+constexpr size_t MIN_BLOCK_SIZE = 64 * 1024;
+
+size_t AlignUp(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+size_t ReadRetainLimit()
+{
+    const char* value = getenv(SCRATCH_RETAIN_ENV);
+    if (value == nullptr || value[0] == '\0') {
+        return DEFAULT_SCRATCH_RETAIN_MB * 1024 * 1024;
+    }
+    char* end = nullptr;
+    long long megaBytes = strtoll(value, &end, 10);
+    if (end == value || *end != '\0' || megaBytes < 0) {
+        LOG_ERROR("Ignore invalid %s=%s.\n", SCRATCH_RETAIN_ENV, value);
+        return DEFAULT_SCRATCH_RETAIN_MB * 1024 * 1024;
+    }
+    // a whole number of huge pages, so a retained block of the limit is not above it
+    return AlignUp(static_cast<size_t>(megaBytes) * 1024 * 1024, SCRATCH_HUGE_PAGE_SIZE);
+}
+}
+
+ScratchArena& ScratchArena::ThreadLocal()
+{
+    thread_local ScratchArena arena;
+    return arena;
+}
+
+ScratchArena::~ScratchArena()
+{
+    for (auto& block : blocks_) {
+        FreeBlock(block);
+    }
+}
+
+ScratchArena::Block ScratchArena::NewBlock(size_t size)
+{
+    Block block = {nullptr, 0, 0, false};
+    ProfileCountScratchBlock(size);
+    if (size >= SCRATCH_HUGE_PAGE_SIZE) {
+        block.size = AlignUp(size, SCRATCH_HUGE_PAGE_SIZE);
+        void* data = mmap(nullptr, block.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+#ifdef MADV_HUGEPAGE
+        (void)madvise(data, block.size, MADV_HUGEPAGE);
+#endif
+        block.data = static_cast<char*>(data);
+        block.mapped = true;
+        return block;
+    }
+    block.size = AlignUp(size, SCRATCH_ALIGNMENT);
+    void* data = nullptr;
+    if (posix_memalign(&data, SCRATCH_ALIGNMENT, block.size) != 0) {
+        throw std::bad_alloc();
+    }
+    block.data = static_cast<char*>(data);
+    return block;
+}
+
+void ScratchArena::FreeBlock(Block& block)
+{
+    if (block.mapped) {
+        (void)munmap(block.data, block.size);
+    } else {
+        free(block.data);
+    }
+    block.data = nullptr;
+}
+
+void* ScratchArena::Allocate(size_t size)
+{
+    size = AlignUp(size, SCRATCH_ALIGNMENT);
+    if (blocks_.empty()) {
+        blocks_.push_back(NewBlock(std::max(size, MIN_BLOCK_SIZE)));
+        current_ = 0;
+    }
+    while (true) {
+        Block& block = blocks_[current_];
+        if (block.used + size <= block.size) {
+            void* data = block.data + block.used;
+            block.used += size;
+            callPeak_ = std::max(callPeak_, Footprint());
+            return data;
+        }
+        if (current_ + 1 == blocks_.size()) {
+            blocks_.push_back(NewBlock(std::max(size, blocks_.back().size * 2)));
+        }
+        ++current_;
+        blocks_[current_].used = 0;
+    }
+}
+
+void ScratchArena::Release(const Mark& mark)
+{
+    if (blocks_.empty()) {
+        return;
+    }
+    for (size_t i = mark.block + 1; i < blocks_.size(); ++i) {
+        blocks_[i].used = 0;
+    }
+    current_ = mark.block;
+    blocks_[current_].used = mark.offset;
+    if (mark.block == 0 && mark.offset == 0) {
+        Recycle();
+    }
+}
+
+size_t ScratchArena::RetainLimit()
+{
+    static const size_t limit = ReadRetainLimit();
+    return limit;
+}
+
+size_t ScratchArena::Footprint() const
+{
+    size_t total = 0;
+    for (size_t i = 0; i <= current_; ++i) {
+        total += blocks_[i].used;
+    }
+    return total;
+}
+
+void ScratchArena::Recycle()
+{
+    intervalPeak_ = std::max(intervalPeak_, callPeak_);
+    callPeak_ = 0;
+    size_t keep = std::min(intervalPeak_, RetainLimit());
+    if (++idleCalls_ == SCRATCH_TRIM_INTERVAL) {
+        // high-water trim, the next interval starts from what this one needed
+        idleCalls_ = 0;
+        intervalPeak_ = 0;
+        if (Capacity() > std::max(keep, MIN_BLOCK_SIZE) * 2) {
+            Rebuild(keep);
+            return;
+        }
+    }
+    if (blocks_.size() > 1 || Capacity() > std::max(RetainLimit(), MIN_BLOCK_SIZE)) {
+        // merge the blocks so that the next call of the same size fits in one
+        Rebuild(keep);
+    }
+}
+
+void ScratchArena::Rebuild(size_t size)
+{
+    for (auto& block : blocks_) {
+        FreeBlock(block);
+    }
+    blocks_.clear();
+    current_ = 0;
+    if (size != 0) {
+        blocks_.push_back(NewBlock(std::max(size, MIN_BLOCK_SIZE)));
+    }
+}
+
+size_t ScratchArena::Capacity() const
+{
+    size_t total = 0;
+    for (const auto& block : blocks_) {
+        total += block.size;
+    }
+    return total;
+}
+} // namespace AmctCommon
@@ -23,6 +23,8 @@
 
 #include "amct_utils.h"
 #include "util.h"
+#include "record_store.h"
+#include "scratch_arena.h"
 
 using namespace util;
 
@@ -103,6 +105,13 @@ SearchNKernel::SearchNKernel(const OrtApi& api, const OrtKernelInfo* info)
         std::string layerName = AmctUtils::GetStringAttr(api_, info, attrName);
         objectLayerNames_.push_back(layerName);
     }
+    AmctCommon::RecordStore::Instance().AcquireWriter(AmctUtils::TrimTailSpace(recordFileName_));
+    AmctCommon::CalibrationState prototype;
+    GetCalibrationState(prototype);
+    // the search sums the data of a channel in order, keep the batches in batch order like a serial run
+    partials_.Init(prototype, AmctCommon::PartialsOrder::BATCH);
+    checkpoint_.Init(AmctCommon::CalibratorType::SEARCH_N, AmctUtils::TrimTailSpace(objectLayerNames_[0]));
+    ResumeFromCheckpoint();
 }
 
 void SearchNKernel::RecordShiftBit(const std::vector<int>& bestN)
@@ -110,17 +119,67 @@ void SearchNKernel::RecordShiftBit(const std::vector<int>& bestN)
     for (auto objectLayerName : objectLayerNames_) {
         std::string trimedRecordFilePath = AmctUtils::TrimTailSpace(recordFileName_);
         std::string trimedObjectLayerName = AmctUtils::TrimTailSpace(objectLayerName);
-        util::RecordRepeatData(trimedRecordFilePath, trimedObjectLayerName, bestN, "shift_bit");
+        AmctCommon::RecordStore::Instance().RecordRepeatData(trimedRecordFilePath, trimedObjectLayerName, bestN,
+            "shift_bit");
     }
+    ReleaseRecordWriter();
 }
 
-SearchNKernel::~SearchNKernel()
+void SearchNKernel::ReleaseRecordWriter()
+{
+    if (recordWriterReleased_) {
+        return;
+    }
+    recordWriterReleased_ = true;
+    int ret = AmctCommon::RecordStore::Instance().ReleaseWriter(AmctUtils::TrimTailSpace(recordFileName_));
+    if (ret != AmctCommon::SUCCESS) {
+        LOG_ERROR("Write record file %s failed, error code: %d.\n", recordFileName_.c_str(), ret);
+    }
+}
+
+void SearchNKernel::GetCalibrationState(AmctCommon::CalibrationState& state)
+{
+    state.type = AmctCommon::CalibratorType::SEARCH_N;
+    for (auto objectLayerName : objectLayerNames_) {
+        state.recordInfo.objectLayerNames.push_back(AmctUtils::TrimTailSpace(objectLayerName));
+    }
+}
+
+void SearchNKernel::SavePartialState(const AmctCommon::CalibrationState& state)
 {
-    // Release memory used for data accumulation
-    for (size_t channel = 0; channel < accumulateData_.size(); channel++) {
-        accumulateData_.clear();
-        accumulateData_.shrink_to_fit();
+    std::string stateDir = AmctCommon::GetPartialStateDir();
+    if (stateDir.empty()) {
+        return;
+    }
+    (void)AmctCommon::SavePartialCalibrationState(stateDir, state);
+}
+
+void SearchNKernel::SaveCheckpoint()
+{
+    AmctCommon::CalibrationState state;
+    GetCalibrationState(state);
+    if (partials_.Snapshot(state)) {
+        checkpoint_.Save(std::move(state));
+    }
+}
+
+void SearchNKernel::ResumeFromCheckpoint()
+{
+    if (!checkpoint_.Enabled()) {
+        return;
+    }
+    // deq_scale is an input of the final batch, checkpoints are saved without it
+    AmctCommon::CalibrationState state;
+    GetCalibrationState(state);
+    if (!checkpoint_.Resume(state, batchNum_)) {
+        return;
     }
+    partials_.Reset(static_cast<int64_t>(state.batchCount), std::move(state));
+}
+
+SearchNKernel::~SearchNKernel()
+{
+    ReleaseRecordWriter();
 }
 
 #if ORT_API_VERSION >= 16
@@ -133,10 +192,45 @@ OrtStatusPtr SearchNKernel::ComputeV2(OrtKernelContext* context)
 
 void SearchNKernel::Compute(OrtKernelContext* context)
 {
-    if (++current_batch_ > batchNum_) {
+    AmctCommon::ProfileOpScope profile("SearchN");
+    // Compute may run concurrently, each call owns one batch number
+    int64_t batch = partials_.Claim();
+    if (batch > batchNum_) {
+        return;
+    }
+    std::unique_ptr<SearchNBatch> batchData;
+    try {
+        batchData = PrepareBatch(context, batch);
+    } catch (...) {
+        // a failed batch must not hold back the final search
+        FinishBatch(partials_.Skip(batch));
+        throw;
+    }
+    if (batchData == nullptr) {
+        FinishBatch(partials_.Skip(batch));
         return;
     }
+    if (batch == batchNum_) {
+        deqScale_.swap(batchData->deqScale);
+    }
+    int64_t finishedBatches = partials_.Accumulate(batch,
+        [batchData = std::move(batchData)](AmctCommon::CalibrationState& state) {
+            std::vector<std::vector<float>>& channelData = state.channelData;
+            for (size_t channel = 0; channel < batchData->data.size(); channel++) {
+                if (channelData.size() == channel) {
+                    channelData.push_back(std::move(batchData->data[channel]));
+                } else {
+                    channelData[channel].insert(channelData[channel].end(), batchData->data[channel].begin(),
+                        batchData->data[channel].end());
+                }
+            }
+            state.batchCount++;
+        });
+    FinishBatch(finishedBatches);
+}
 
+std::unique_ptr<SearchNBatch> SearchNKernel::PrepareBatch(OrtKernelContext* context, int64_t batch)
+{
     // get scale_w
     const OrtValue* inputScaleW = AmctUtils::GetKernelInput(api_, context, 2);
     if (inputScaleW == nullptr) {
@@ -157,19 +251,26 @@ void SearchNKernel::Compute(OrtKernelContext* context)
     AmctUtils::CheckTensorNotEmpty(inputSize);
 
     if (CheckChannelNum(static_cast<size_t>(inputShape[0]), scaleWSize, objectLayerNames_[0]) != AmctCommon::SUCCESS) {
-        return;
+        return nullptr;
     }
     const void* x = AmctUtils::GetTensorData<void>(api_, inputX);
 
-    std::vector<float> inData(inputSize);
+    AmctCommon::ScratchScope scratch;
+    float* inData = scratch.Allocate<float>(inputSize);
     ONNXTensorElementDataType inputTypeId = AmctUtils::GetTensorEleType(api_, inputInfo);
-    AmctUtils::SaveInputDataToFloat32(x, inData.data(), inputSize, inputTypeId);
+    {
+        size_t inputBytes = (inputTypeId == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT ? sizeof(float) : sizeof(uint16_t)) *
+            inputSize;
+        AmctCommon::ProfileScope profile("input_to_fp32", inputSize, inputBytes + sizeof(float) * inputSize);
+        AmctUtils::SaveInputDataToFloat32(x, inData, inputSize, inputTypeId);
+    }
 
     // store data in ND
-    StoreInputTensorToND(inData.data(), inputSize, inputShape, accumulateData_, scaleWSize);
+    std::unique_ptr<SearchNBatch> batchData(new SearchNBatch());
+    StoreInputTensorToND(inData, inputSize, inputShape, batchData->data, scaleWSize);
 
-    if (current_batch_ != batchNum_) {
-        return;
+    if (batch != batchNum_) {
+        return batchData;
     }
     // get scale_d
     const OrtValue* inputScaleD = AmctUtils::GetKernelInput(api_, context, 1);
@@ -183,23 +284,51 @@ void SearchNKernel::Compute(OrtKernelContext* context)
     }
 
     const float* scaleD = AmctUtils::GetTensorData<float>(api_, inputScaleD);
-    std::vector<float> deqScale;
     for (size_t i = 0; i < scaleWSize; ++i) {
-        deqScale.push_back(scaleD[0] * scaleW[i]);
+        batchData->deqScale.push_back(scaleD[0] * scaleW[i]);
+    }
+    return batchData;
+}
+
+void SearchNKernel::FinishBatch(int64_t finishedBatches)
+{
+    if (finishedBatches == batchNum_) {
+        DoCalibration();
+    } else if (checkpoint_.Due(finishedBatches)) {
+        SaveCheckpoint();
+    }
+}
+
+void SearchNKernel::DoCalibration()
+{
+    AmctCommon::CalibrationState state;
+    GetCalibrationState(state);
+    if (partials_.Merge(state) != AmctCommon::SUCCESS || state.channelData.empty()) {
+        ORT_CXX_API_THROW("AMCT searchN op failed to merge its partial states", ORT_FAIL);
+    }
+    // deq_scale is an input of the final batch, checkpoints are saved without it
+    state.deqScale = deqScale_;
+    if (state.deqScale.size() != state.channelData.size()) {
+        ORT_CXX_API_THROW("AMCT searchN op did not get deq_scale of the final batch", ORT_FAIL);
     }
-    std::vector<std::vector<int>> int32Data(accumulateData_.size(), std::vector<int>(accumulateData_[0].size(), 0));
-    for (size_t i = 0; i < accumulateData_.size(); ++i) {
+    SavePartialState(state);
+    const std::vector<std::vector<float>>& accumulateData = state.channelData;
+    const std::vector<float>& deqScale = state.deqScale;
+    AmctCommon::ProfileScope profile("search_n", accumulateData.size() * accumulateData[0].size());
+    std::vector<std::vector<int>> int32Data(accumulateData.size(), std::vector<int>(accumulateData[0].size(), 0));
+    for (size_t i = 0; i < accumulateData.size(); ++i) {
         // prevent divide by zero. a number less than epsilon means that it can be treated as zero, but still
         // divisible by it.
         if (deqScale[i] == 0.0) {
             ORT_CXX_API_THROW("AMCT searchN op get zero deqScale", ORT_FAIL);
         }
-        for (size_t j = 0; j < accumulateData_[i].size(); ++j) {
-            int32Data[i][j] = round(accumulateData_[i][j] / deqScale[i]);
+        for (size_t j = 0; j < accumulateData[i].size(); ++j) {
+            int32Data[i][j] = round(accumulateData[i][j] / deqScale[i]);
         }
     }
 
     std::vector<int> bestN;
     AmctCommon::SearchShiftBits(int32Data, bestN);
     RecordShiftBit(bestN);
+    checkpoint_.Remove();
 }
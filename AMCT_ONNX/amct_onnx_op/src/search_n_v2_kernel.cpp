@@ -21,6 +21,8 @@
 #include "search_n_v2_kernel.h"
 #include "search_n_kernel.h"
 #include "util.h"
+#include "record_store.h"
+#include "scratch_arena.h"
 
 using namespace util;
 
@@ -43,8 +45,61 @@ void SearchNV2Kernel::RecordShiftBit(const std::vector<int>& bestN)
     for (auto objectLayerName : objectLayerNames_) {
         std::string trimedRecordFilePath = AmctUtils::TrimTailSpace(recordFileName_);
         std::string trimedObjectLayerName = AmctUtils::TrimTailSpace(objectLayerName);
-        util::RecordRepeatData(trimedRecordFilePath, trimedObjectLayerName, bestN, "shift_bit");
+        AmctCommon::RecordStore::Instance().RecordRepeatData(trimedRecordFilePath, trimedObjectLayerName, bestN,
+            "shift_bit");
     }
+    ReleaseRecordWriter();
+}
+
+void SearchNV2Kernel::ReleaseRecordWriter()
+{
+    if (recordWriterReleased_) {
+        return;
+    }
+    recordWriterReleased_ = true;
+    int ret = AmctCommon::RecordStore::Instance().ReleaseWriter(AmctUtils::TrimTailSpace(recordFileName_));
+    if (ret != AmctCommon::SUCCESS) {
+        LOG_ERROR("Write record file %s failed, error code: %d.\n", recordFileName_.c_str(), ret);
+    }
+}
+
+void SearchNV2Kernel::GetCalibrationState(AmctCommon::CalibrationState& state)
+{
+    state.type = AmctCommon::CalibratorType::SEARCH_N_V2;
+    for (auto objectLayerName : objectLayerNames_) {
+        state.recordInfo.objectLayerNames.push_back(AmctUtils::TrimTailSpace(objectLayerName));
+    }
+}
+
+void SearchNV2Kernel::SavePartialState(const AmctCommon::CalibrationState& state)
+{
+    std::string stateDir = AmctCommon::GetPartialStateDir();
+    if (stateDir.empty()) {
+        return;
+    }
+    (void)AmctCommon::SavePartialCalibrationState(stateDir, state);
+}
+
+void SearchNV2Kernel::SaveCheckpoint()
+{
+    AmctCommon::CalibrationState state;
+    GetCalibrationState(state);
+    if (partials_.Snapshot(state)) {
+        checkpoint_.Save(std::move(state));
+    }
+}
+
+void SearchNV2Kernel::ResumeFromCheckpoint()
+{
+    if (!checkpoint_.Enabled()) {
+        return;
+    }
+    AmctCommon::CalibrationState state;
+    GetCalibrationState(state);
+    if (!checkpoint_.Resume(state, batchNum_)) {
+        return;
+    }
+    partials_.Reset(static_cast<int64_t>(state.batchCount), std::move(state));
 }
 
 SearchNV2Kernel::SearchNV2Kernel(const OrtApi &api, const OrtKernelInfo *info) : api_(api)
@@ -60,15 +115,18 @@ SearchNV2Kernel::SearchNV2Kernel(const OrtApi &api, const OrtKernelInfo *info) :
         std::string layerName = AmctUtils::GetStringAttr(api_, info, attrName);
         objectLayerNames_.push_back(layerName);
     }
+    AmctCommon::RecordStore::Instance().AcquireWriter(AmctUtils::TrimTailSpace(recordFileName_));
+    AmctCommon::CalibrationState prototype;
+    GetCalibrationState(prototype);
+    // float error sums depend on the order of the batches, fold them in batch order like a serial run
+    partials_.Init(prototype, AmctCommon::PartialsOrder::BATCH);
+    checkpoint_.Init(AmctCommon::CalibratorType::SEARCH_N_V2, AmctUtils::TrimTailSpace(objectLayerNames_[0]));
+    ResumeFromCheckpoint();
 }
 
 SearchNV2Kernel::~SearchNV2Kernel()
 {
-    // Release memory used for accumulation error
-    for (size_t channel = 0; channel < searchNError_.size(); channel++) {
-        searchNError_.clear();
-        searchNError_.shrink_to_fit();
-    }
+    ReleaseRecordWriter();
 }
 
 #if ORT_API_VERSION >= 16
@@ -81,9 +139,33 @@ OrtStatusPtr SearchNV2Kernel::ComputeV2(OrtKernelContext* context)
 
 void SearchNV2Kernel::Compute(OrtKernelContext* context)
 {
-    if (++current_batch_ > batchNum_) {
+    AmctCommon::ProfileOpScope profile("SearchNv2");
+    // Compute may run concurrently, each call owns one batch number
+    int64_t batch = partials_.Claim();
+    if (batch > batchNum_) {
+        return;
+    }
+    std::unique_ptr<SearchNV2Batch> batchData;
+    try {
+        batchData = PrepareBatch(context);
+    } catch (...) {
+        // a failed batch must not hold back the final search
+        FinishBatch(partials_.Skip(batch));
+        throw;
+    }
+    if (batchData == nullptr) {
+        FinishBatch(partials_.Skip(batch));
         return;
     }
+    int64_t finishedBatches = partials_.Accumulate(batch,
+        [this, batchData = std::move(batchData)](AmctCommon::CalibrationState& state) {
+            AccumulateBatch(*batchData, state);
+        });
+    FinishBatch(finishedBatches);
+}
+
+std::unique_ptr<SearchNV2Batch> SearchNV2Kernel::PrepareBatch(OrtKernelContext* context)
+{
     // obtain input data
     const OrtValue* inputX = AmctUtils::GetKernelInput(api_, context, 0);
 
@@ -94,9 +176,15 @@ void SearchNV2Kernel::Compute(OrtKernelContext* context)
     AmctUtils::CheckTensorNotEmpty(inputSize);
 
     const void* x = AmctUtils::GetTensorData<void>(api_, inputX);
-    std::vector<float> inData(inputSize);
+    AmctCommon::ScratchScope scratch;
+    float* inData = scratch.Allocate<float>(inputSize);
     ONNXTensorElementDataType inputTypeId = AmctUtils::GetTensorEleType(api_, inputInfo);
-    AmctUtils::SaveInputDataToFloat32(x, inData.data(), inputSize, inputTypeId);
+    {
+        size_t inputBytes = (inputTypeId == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT ? sizeof(float) : sizeof(uint16_t)) *
+            inputSize;
+        AmctCommon::ProfileScope profile("input_to_fp32", inputSize, inputBytes + sizeof(float) * inputSize);
+        AmctUtils::SaveInputDataToFloat32(x, inData, inputSize, inputTypeId);
+    }
 
     // obtain scale_d
     const OrtValue* inputScaleD = AmctUtils::GetKernelInput(api_, context, 1);
@@ -107,7 +195,7 @@ void SearchNV2Kernel::Compute(OrtKernelContext* context)
     if (scaleDSize != 1) {
         LOG_ERROR("SEARCHN_V2 Op \"%s\" can only have 1 scale_d, but get %zu\n",
             objectLayerNames_[0].c_str(), scaleDSize);
-        return;
+        return nullptr;
     }
     const float* scaleD = AmctUtils::GetTensorData<float>(api_, inputScaleD);
 
@@ -120,38 +208,72 @@ void SearchNV2Kernel::Compute(OrtKernelContext* context)
     const float* scaleW = AmctUtils::GetTensorData<float>(api_, inputScaleW);
     // check channel
     if (CheckChannelNum(static_cast<size_t>(inputShape[0]), scaleWSize, objectLayerNames_[0]) != AmctCommon::SUCCESS) {
-        return;
+        return nullptr;
     }
 
     // calculate deqscale
-    std::vector<float> deqScale;
+    std::unique_ptr<SearchNV2Batch> batchData(new SearchNV2Batch());
     for (size_t i = 0; i < scaleWSize; ++i) {
-        deqScale.push_back(scaleD[0] * scaleW[i]);
+        batchData->deqScale.push_back(scaleD[0] * scaleW[i]);
     }
-    FloatData deqScaleCpu = {static_cast<uint>(scaleWSize), deqScale.data()};
 
     // store data in ND
-    std::vector<std::vector<float>> currentData;
-    StoreInputTensorToND(inData.data(), inputSize, inputShape, currentData, scaleWSize);
+    StoreInputTensorToND(inData, inputSize, inputShape, batchData->data, scaleWSize);
+    batchData->inputShape = inputShape;
+    return batchData;
+}
 
+void SearchNV2Kernel::AccumulateBatch(SearchNV2Batch& batchData, AmctCommon::CalibrationState& state)
+{
     // search_n_v2 calculate best N
-    if (current_batch_ == 1) {
-        bool channelWise = !(scaleWSize == 1);
-        InitSearchnError(searchNError_, inputShape, channelWise);
-        isBroadcast_ = (inputShape[NHWC_H_DIM] == 1) && (inputShape[NHWC_W_DIM] == 1);
+    if (state.channelData.empty()) {
+        bool channelWise = !(batchData.deqScale.size() == 1);
+        InitSearchnError(state.channelData, batchData.inputShape, channelWise);
+        state.isBroadcast = (batchData.inputShape[NHWC_H_DIM] == 1) && (batchData.inputShape[NHWC_W_DIM] == 1);
     }
 
-    if (AmctCommon::SearchNV2AccumulateError(currentData, searchNError_, deqScaleCpu, isBroadcast_) !=
-        AmctCommon::SUCCESS) {
+    FloatData deqScaleCpu = {static_cast<uint>(batchData.deqScale.size()), batchData.deqScale.data()};
+    int ret = AmctCommon::SUCCESS;
+    {
+        AmctCommon::ProfileScope profile("search_n_v2_accumulate");
+        for (const auto& channelData : batchData.data) {
+            profile.AddWork(channelData.size(), sizeof(float) * channelData.size());
+        }
+        ret = AmctCommon::SearchNV2AccumulateError(batchData.data, state.channelData, deqScaleCpu,
+            state.isBroadcast);
+    }
+    if (ret != AmctCommon::SUCCESS) {
         LOG_ERROR("Layer \"%s\" SearchNV2AccumulateError failed! \n", objectLayerNames_[0].c_str());
         return;
     }
+    state.batchCount++;
+}
+
+void SearchNV2Kernel::FinishBatch(int64_t finishedBatches)
+{
+    if (finishedBatches == batchNum_) {
+        DoCalibration();
+    } else if (checkpoint_.Due(finishedBatches)) {
+        SaveCheckpoint();
+    }
+}
 
-    if (current_batch_ == batchNum_) {
-        std::vector<int> bestN(searchNError_.size());
-        IntData bestNCpu = {static_cast<uint>(searchNError_.size()), bestN.data()};
-        AmctCommon::SearchNV2FindBestNCpu(searchNError_, bestNCpu, isBroadcast_);
-        // record best n
-        RecordShiftBit(bestN);
+void SearchNV2Kernel::DoCalibration()
+{
+    AmctCommon::CalibrationState state;
+    GetCalibrationState(state);
+    if (partials_.Merge(state) != AmctCommon::SUCCESS || state.channelData.empty()) {
+        LOG_ERROR("Layer \"%s\" failed to merge searchN errors of its batches! \n", objectLayerNames_[0].c_str());
+        return;
+    }
+    SavePartialState(state);
+    std::vector<int> bestN(state.channelData.size());
+    IntData bestNCpu = {static_cast<uint>(state.channelData.size()), bestN.data()};
+    {
+        AmctCommon::ProfileScope profile("search_n_v2_search");
+        AmctCommon::SearchNV2FindBestNCpu(state.channelData, bestNCpu, state.isBroadcast);
     }
+    // record best n
+    RecordShiftBit(bestN);
+    checkpoint_.Remove();
 }
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief softmax and top k classification post-processing C++ implement
+ *
+ * @file softmax_topk.cpp
+ *
+ * @version 1.0
+ */
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "softmax_topk.h"
+#include "amct_profiler.h"
+#include "amct_thread_pool.h"
+#include "error_codes.h"
+#include "util.h"
+
+namespace AmctCommon {
+namespace {
+// the k best logits of the row in descending order, a logit below the current k-th is rejected with one compare
+void SelectTopK(const float* logits, int64_t classNum, int64_t topK, float* values, int64_t* indices)
+{
+    int64_t count = 0;
+    for (int64_t cls = 0; cls < classNum; ++cls) {
+        float value = logits[cls];
+        if (count == topK && !(value > values[topK - 1])) {
+            continue;
+        }
+        int64_t position = count < topK ? count++ : topK - 1;
+        while (position > 0 && value > values[position - 1]) {
+            values[position] = values[position - 1];
+            indices[position] = indices[position - 1];
+            --position;
+        }
+        values[position] = value;
+        indices[position] = cls;
+    }
+}
+
+void SoftmaxTopKRow(const float* logits, int64_t classNum, int64_t topK, float* probabilities, int64_t* indices)
+{
+    float maxValue = -FLT_MAX;
+#pragma omp simd reduction(max:maxValue)
+    for (int64_t cls = 0; cls < classNum; ++cls) {
+        maxValue = logits[cls] > maxValue ? logits[cls] : maxValue;
+    }
+    float sum = 0;
+#pragma omp simd reduction(+:sum)
+    for (int64_t cls = 0; cls < classNum; ++cls) {
+        sum += std::exp(logits[cls] - maxValue);
+    }
+    // only the selected classes are normalized, the full probability row is never written
+    SelectTopK(logits, classNum, topK, probabilities, indices);
+    float inverseSum = 1.0f / sum;
+    for (int64_t i = 0; i < topK; ++i) {
+        probabilities[i] = std::exp(probabilities[i] - maxValue) * inverseSum;
+    }
+}
+} // namespace
+
+int SoftmaxTopK(const float* logits, int64_t rowNum, int64_t classNum, int64_t topK, float* probabilities,
+    int64_t* indices)
+{
+    if (classNum <= 0 || topK <= 0 || topK > classNum) {
+        LOG_ERROR("SoftmaxTopK needs 0 < k <= classes, got k %lld of %lld classes.\n", static_cast<long long>(topK),
+            static_cast<long long>(classNum));
+        return BAD_PARAMETERS_ERROR;
+    }
+    ProfileScope profile("softmax_topk", rowNum * classNum, rowNum * classNum * static_cast<int64_t>(sizeof(float)));
+    // enough rows per task to amortize the scheduling, a single row never splits
+    int64_t rowsPerTask = std::max<int64_t>(GetParallelConfig().grainSize / classNum, 1);
+    int64_t taskNum = (rowNum + rowsPerTask - 1) / rowsPerTask;
+    ParallelForTasks(taskNum, [&](int64_t begin, int64_t end) {
+        for (int64_t row = begin * rowsPerTask; row < std::min(end * rowsPerTask, rowNum); ++row) {
+            SoftmaxTopKRow(logits + row * classNum, classNum, topK, probabilities + row * topK, indices + row * topK);
+        }
+    });
+    return SUCCESS;
+}
+} // namespace AmctCommon
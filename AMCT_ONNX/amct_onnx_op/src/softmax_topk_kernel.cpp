@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief AMCT custom ops
+ *
+ * @file softmax_topk_kernel.cpp
+ *
+ * @version 1.0
+ */
+
+#include "amct_utils.h"
+#include "softmax_topk.h"
+#include "softmax_topk_kernel.h"
+#include "scratch_arena.h"
+#include "util.h"
+
+namespace {
+constexpr int64_t DEFAULT_TOP_K = 5;
+}
+
+SoftmaxTopKKernel::SoftmaxTopKKernel(const OrtApi &api, const OrtKernelInfo *info) : api_(api)
+{
+    topK_ = AmctUtils::GetInt64AttrOrDefault(api_, info, "k", DEFAULT_TOP_K);
+    if (topK_ <= 0) {
+        ORT_CXX_API_THROW("SoftmaxTopK k must be positive.", ORT_INVALID_ARGUMENT);
+    }
+}
+
+#if ORT_API_VERSION >= 16
+OrtStatusPtr SoftmaxTopKKernel::ComputeV2(OrtKernelContext* context)
+{
+    Compute(context);
+    return api_.CreateStatus(ORT_OK, "Success");
+}
+#endif
+
+void SoftmaxTopKKernel::Compute(OrtKernelContext* context)
+{
+    AmctCommon::ProfileOpScope profile("SoftmaxTopK");
+    // Setup inputs input 0: logits [..., classes]
+    const OrtValue* inputX = AmctUtils::GetKernelInput(api_, context, 0);
+    OrtTensorTypeAndShapeInfo* inputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, inputX);
+    ONNXTensorElementDataType inputTensorType = AmctUtils::GetTensorEleType(api_, inputInfo);
+    size_t inputSize = AmctUtils::GetElementCount(api_, inputInfo);
+    std::vector<int64_t> shape = AmctUtils::GetShape(api_, inputInfo);
+    api_.ReleaseTensorTypeAndShapeInfo(inputInfo);
+    AmctUtils::CheckTensorNotEmpty(inputSize);
+    if (shape.empty() || topK_ > shape.back()) {
+        ORT_CXX_API_THROW("SoftmaxTopK k must not exceed the classes of the last axis.", ORT_INVALID_ARGUMENT);
+    }
+    int64_t classNum = shape.back();
+    int64_t rowNum = static_cast<int64_t>(inputSize) / classNum;
+
+    AmctCommon::ScratchScope scratch;
+    const float* logits = nullptr;
+    const void* inputData = AmctUtils::GetTensorData<void>(api_, inputX);
+    if (inputTensorType == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+        logits = static_cast<const float*>(inputData);
+    } else {
+        float* converted = scratch.Allocate<float>(inputSize);
+        AmctUtils::SaveInputDataToFloat32(inputData, converted, inputSize, inputTensorType);
+        logits = converted;
+    }
+
+    // Setup outputs output 0: probabilities [..., k], output 1: class indices [..., k]
+    shape.back() = topK_;
+    OrtValue* probabilities = AmctUtils::GetKernelOutput(api_, context, 0, shape.data(), shape.size());
+    OrtValue* indices = AmctUtils::GetKernelOutput(api_, context, 1, shape.data(), shape.size());
+    int ret = AmctCommon::SoftmaxTopK(logits, rowNum, classNum, topK_,
+        AmctUtils::GetTensorMutableData<float>(api_, probabilities),
+        AmctUtils::GetTensorMutableData<int64_t>(api_, indices));
+    if (ret != 0) {
+        LOG_ERROR("Do SoftmaxTopK compute failed, error code: %d.\n", ret);
+        return;
+    }
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief yolo non max suppression C++ implement
+ *
+ * @file yolo_nms.cpp
+ *
+ * @version 1.0
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include "yolo_nms.h"
+#include "amct_profiler.h"
+#include "amct_thread_pool.h"
+#include "error_codes.h"
+#include "util.h"
+
+namespace AmctCommon {
+namespace {
+struct NmsCandidate {
+    float score;
+    int32_t row;
+    int32_t cls;
+};
+
+// kept boxes as separate arrays so that the IoU test against all of them vectorizes
+struct KeptBoxes {
+    std::vector<float> x1;
+    std::vector<float> y1;
+    std::vector<float> x2;
+    std::vector<float> y2;
+    std::vector<float> area;
+
+    void Reset(size_t capacity)
+    {
+        for (auto* column : {&x1, &y1, &x2, &y2, &area}) {
+            column->resize(capacity);
+        }
+    }
+};
+
+void CollectCandidates(const float* image, const YoloNmsParam& param, std::vector<NmsCandidate>& candidates)
+{
+    candidates.clear();
+    for (int64_t row = 0; row < param.boxNum; ++row) {
+        const float* prediction = image + row * param.rowSize;
+        float obj = prediction[4];
+        if (!(obj > param.confThres)) {
+            continue;
+        }
+        const float* classScore = prediction + NMS_BOX_SIZE;
+        if (param.multiLabel) {
+            for (int64_t cls = 0; cls < param.classNum; ++cls) {
+                float score = classScore[cls] * obj;
+                if (score > param.confThres) {
+                    candidates.push_back({score, static_cast<int32_t>(row), static_cast<int32_t>(cls)});
+                }
+            }
+            continue;
+        }
+        int64_t best = std::max_element(classScore, classScore + param.classNum) - classScore;
+        float score = classScore[best] * obj;
+        if (score > param.confThres) {
+            candidates.push_back({score, static_cast<int32_t>(row), static_cast<int32_t>(best)});
+        }
+    }
+}
+
+void SortCandidates(const YoloNmsParam& param, std::vector<NmsCandidate>& candidates)
+{
+    auto higher = [](const NmsCandidate& lhs, const NmsCandidate& rhs) {
+        return lhs.score > rhs.score || (lhs.score == rhs.score && lhs.row < rhs.row);
+    };
+    if (static_cast<int64_t>(candidates.size()) > param.maxNms) {
+        std::nth_element(candidates.begin(), candidates.begin() + param.maxNms, candidates.end(), higher);
+        candidates.resize(static_cast<size_t>(param.maxNms));
+    }
+    std::sort(candidates.begin(), candidates.end(), higher);
+}
+
+// returns true if the box overlaps one of the kept boxes by more than the threshold, iou > t as inter > t * union
+bool IsSuppressed(const KeptBoxes& kept, int64_t keptNum, const float* box, float area, float iouThres)
+{
+    const float* x1 = kept.x1.data();
+    const float* y1 = kept.y1.data();
+    const float* x2 = kept.x2.data();
+    const float* y2 = kept.y2.data();
+    const float* keptArea = kept.area.data();
+    int suppressed = 0;
+    for (int64_t i = 0; i < keptNum; ++i) {
+        float width = std::max(std::min(box[2], x2[i]) - std::max(box[0], x1[i]), 0.0f);
+        float height = std::max(std::min(box[3], y2[i]) - std::max(box[1], y1[i]), 0.0f);
+        float inter = width * height;
+        suppressed |= static_cast<int>(inter > iouThres * (area + keptArea[i] - inter));
+    }
+    return suppressed != 0;
+}
+
+int64_t NmsImage(const float* image, const YoloNmsParam& param, float* detections)
+{
+    thread_local std::vector<NmsCandidate> candidates;
+    thread_local KeptBoxes kept;
+    CollectCandidates(image, param, candidates);
+    SortCandidates(param, candidates);
+    kept.Reset(static_cast<size_t>(param.maxDet));
+
+    int64_t keptNum = 0;
+    for (const NmsCandidate& candidate : candidates) {
+        if (keptNum == param.maxDet) {
+            break;
+        }
+        const float* xywh = image + static_cast<int64_t>(candidate.row) * param.rowSize;
+        float offset = param.agnostic ? 0.0f : static_cast<float>(candidate.cls) * NMS_MAX_WH;
+        float halfWidth = xywh[2] / 2;
+        float halfHeight = xywh[3] / 2;
+        float box[NMS_DETECTION_SIZE] = {xywh[0] - halfWidth, xywh[1] - halfHeight, xywh[0] + halfWidth,
+            xywh[1] + halfHeight, candidate.score, static_cast<float>(candidate.cls)};
+        float shifted[NMS_BOX_SIZE - 1] = {box[0] + offset, box[1] + offset, box[2] + offset, box[3] + offset};
+        float area = (box[2] - box[0]) * (box[3] - box[1]);
+        if (IsSuppressed(kept, keptNum, shifted, area, param.iouThres)) {
+            continue;
+        }
+        kept.x1[keptNum] = shifted[0];
+        kept.y1[keptNum] = shifted[1];
+        kept.x2[keptNum] = shifted[2];
+        kept.y2[keptNum] = shifted[3];
+        kept.area[keptNum] = area;
+        std::copy(box, box + NMS_DETECTION_SIZE, detections + keptNum * NMS_DETECTION_SIZE);
+        ++keptNum;
+    }
+    return keptNum;
+}
+} // namespace
+
+int YoloNms(const float* prediction, const YoloNmsParam& param, float* detections, int64_t* detectionNum)
+{
+    if (param.classNum <= 0 || param.rowSize < NMS_BOX_SIZE + param.classNum) {
+        LOG_ERROR("YoloNms needs 5 + %lld columns per box, got %lld.\n", static_cast<long long>(param.classNum),
+            static_cast<long long>(param.rowSize));
+        return BAD_PARAMETERS_ERROR;
+    }
+    if (param.maxDet <= 0 || param.maxNms <= 0) {
+        LOG_ERROR("YoloNms max_det and max_nms must be positive.\n");
+        return BAD_PARAMETERS_ERROR;
+    }
+    int64_t imageSize = param.boxNum * param.rowSize;
+    int64_t detectionSize = param.maxDet * NMS_DETECTION_SIZE;
+    ProfileScope profile("yolo_nms", param.batchSize * param.boxNum,
+        param.batchSize * (imageSize + detectionSize) * static_cast<int64_t>(sizeof(float)));
+    ParallelForTasks(param.batchSize, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+            float* imageDetections = detections + i * detectionSize;
+            detectionNum[i] = NmsImage(prediction + i * imageSize, param, imageDetections);
+            int64_t used = detectionNum[i] * NMS_DETECTION_SIZE;
+            std::fill(imageDetections + used, imageDetections + detectionSize, 0.0f);
+        }
+    });
+    return SUCCESS;
+}
+} // namespace AmctCommon
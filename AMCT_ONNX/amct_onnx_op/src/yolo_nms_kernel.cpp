@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief AMCT custom ops
+ *
+ * @file yolo_nms_kernel.cpp
+ *
+ * @version 1.0
+ */
+
+#include "amct_utils.h"
+#include "yolo_nms_kernel.h"
+#include "scratch_arena.h"
+#include "util.h"
+
+namespace {
+constexpr float DEFAULT_CONF_THRES = 0.25f;
+constexpr float DEFAULT_IOU_THRES = 0.45f;
+constexpr int64_t DEFAULT_MAX_DET = 300;
+constexpr int64_t DEFAULT_MAX_NMS = 30000;
+constexpr size_t PREDICTION_DIM = 3;
+}
+
+YoloNmsKernel::YoloNmsKernel(const OrtApi &api, const OrtKernelInfo *info) : api_(api)
+{
+    confThres_ = AmctUtils::GetFloatAttrOrDefault(api_, info, "conf_thres", DEFAULT_CONF_THRES);
+    iouThres_ = AmctUtils::GetFloatAttrOrDefault(api_, info, "iou_thres", DEFAULT_IOU_THRES);
+    maxDet_ = AmctUtils::GetInt64AttrOrDefault(api_, info, "max_det", DEFAULT_MAX_DET);
+    maxNms_ = AmctUtils::GetInt64AttrOrDefault(api_, info, "max_nms", DEFAULT_MAX_NMS);
+    maskNum_ = AmctUtils::GetInt64AttrOrDefault(api_, info, "nm", 0);
+    multiLabel_ = AmctUtils::GetInt64AttrOrDefault(api_, info, "multi_label", 0) != 0;
+    agnostic_ = AmctUtils::GetInt64AttrOrDefault(api_, info, "agnostic", 0) != 0;
+    if (confThres_ < 0 || confThres_ > 1 || iouThres_ < 0 || iouThres_ > 1) {
+        ORT_CXX_API_THROW("YoloNms conf_thres and iou_thres must be between 0.0 and 1.0.", ORT_INVALID_ARGUMENT);
+    }
+    if (maxDet_ <= 0 || maxNms_ <= 0 || maskNum_ < 0) {
+        ORT_CXX_API_THROW("YoloNms max_det and max_nms must be positive, nm must not be negative.",
+            ORT_INVALID_ARGUMENT);
+    }
+}
+
+#if ORT_API_VERSION >= 16
+OrtStatusPtr YoloNmsKernel::ComputeV2(OrtKernelContext* context)
+{
+    Compute(context);
+    return api_.CreateStatus(ORT_OK, "Success");
+}
+#endif
+
+void YoloNmsKernel::Compute(OrtKernelContext* context)
+{
+    AmctCommon::ProfileOpScope profile("YoloNms");
+    // Setup inputs input 0: prediction [batch, boxes, 5 + classes + masks]
+    const OrtValue* inputX = AmctUtils::GetKernelInput(api_, context, 0);
+    OrtTensorTypeAndShapeInfo* inputInfo = AmctUtils::GetTensorTypeAndShapeInfo(api_, inputX);
+    ONNXTensorElementDataType inputTensorType = AmctUtils::GetTensorEleType(api_, inputInfo);
+    size_t inputSize = AmctUtils::GetElementCount(api_, inputInfo);
+    std::vector<int64_t> shape = AmctUtils::GetShape(api_, inputInfo);
+    api_.ReleaseTensorTypeAndShapeInfo(inputInfo);
+    if (shape.size() != PREDICTION_DIM) {
+        ORT_CXX_API_THROW("YoloNms input must be [batch, boxes, 5 + classes].", ORT_INVALID_ARGUMENT);
+    }
+
+    AmctCommon::YoloNmsParam param = {shape[0], shape[1], shape[2],
+        shape[2] - AmctCommon::NMS_BOX_SIZE - maskNum_, confThres_, iouThres_, maxDet_, maxNms_,
+        multiLabel_ && shape[2] - AmctCommon::NMS_BOX_SIZE - maskNum_ > 1, agnostic_};
+    AmctCommon::ScratchScope scratch;
+    const float* prediction = nullptr;
+    const void* inputData = AmctUtils::GetTensorData<void>(api_, inputX);
+    if (inputTensorType == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+        prediction = static_cast<const float*>(inputData);
+    } else {
+        float* converted = scratch.Allocate<float>(inputSize);
+        AmctUtils::SaveInputDataToFloat32(inputData, converted, inputSize, inputTensorType);
+        prediction = converted;
+    }
+
+    // Setup outputs output 0: detections [batch, max_det, 6], output 1: kept boxes of every image [batch]
+    std::vector<int64_t> detectionShape = {param.batchSize, maxDet_, AmctCommon::NMS_DETECTION_SIZE};
+    OrtValue* detections = AmctUtils::GetKernelOutput(api_, context, 0, detectionShape.data(), detectionShape.size());
+    OrtValue* detectionNum = AmctUtils::GetKernelOutput(api_, context, 1, &param.batchSize, 1);
+    int ret = AmctCommon::YoloNms(prediction, param, AmctUtils::GetTensorMutableData<float>(api_, detections),
+        AmctUtils::GetTensorMutableData<int64_t>(api_, detectionNum));
+    if (ret != 0) {
+        LOG_ERROR("Do YoloNms compute failed, error code: %d.\n", ret);
+        return;
+    }
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief tests of the merge order of CalibrationPartials with concurrent calling threads
+ *
+ * @file test_calibration_partials.cpp
+ *
+ * @version 1.0
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "calibration_partials.h"
+
+namespace {
+constexpr int64_t BATCH_NUM = 200;
+constexpr int THREAD_NUM = 8;
+
+AmctCommon::CalibrationState SearchNPrototype()
+{
+    AmctCommon::CalibrationState prototype;
+    prototype.type = AmctCommon::CalibratorType::SEARCH_N;
+    return prototype;
+}
+
+// every calling thread claims batches like a kernel Compute, the update appends the batch number to channel 0
+void RunBatches(AmctCommon::CalibrationPartials& partials, int threadNum, int64_t skippedBatch,
+    std::atomic<int64_t>& lastFinished)
+{
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadNum; ++t) {
+        threads.emplace_back([&partials, &lastFinished, skippedBatch, t]() {
+            for (int64_t batch = partials.Claim(); batch <= BATCH_NUM; batch = partials.Claim()) {
+                // uneven batch times let later batches finish before earlier ones
+                std::this_thread::sleep_for(std::chrono::microseconds((batch * 7 + t * 13) % 50));
+                int64_t finished = 0;
+                if (batch == skippedBatch) {
+                    finished = partials.Skip(batch);
+                } else {
+                    std::unique_ptr<float> value(new float(static_cast<float>(batch)));
+                    finished = partials.Accumulate(batch,
+                        [value = std::move(value)](AmctCommon::CalibrationState& state) {
+                            if (state.channelData.empty()) {
+                                state.channelData.resize(1);
+                            }
+                            state.channelData[0].push_back(*value);
+                            state.batchCount++;
+                        });
+                }
+                if (finished == BATCH_NUM) {
+                    lastFinished = batch;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+TEST(CalibrationPartialsTest, BatchOrderMatchesSerialRun)
+{
+    for (int threadNum : {1, THREAD_NUM}) {
+        AmctCommon::CalibrationPartials partials;
+        partials.Init(SearchNPrototype(), AmctCommon::PartialsOrder::BATCH);
+        std::atomic<int64_t> lastFinished{0};
+        RunBatches(partials, threadNum, 17, lastFinished);
+        EXPECT_NE(lastFinished.load(), 0);
+
+        AmctCommon::CalibrationState state = SearchNPrototype();
+        ASSERT_EQ(partials.Merge(state), AmctCommon::SUCCESS);
+        ASSERT_EQ(state.channelData.size(), 1U);
+        std::vector<float> expected;
+        for (int64_t batch = 1; batch <= BATCH_NUM; ++batch) {
+            if (batch != 17) {
+                expected.push_back(static_cast<float>(batch));
+            }
+        }
+        EXPECT_EQ(state.channelData[0], expected) << threadNum << " threads";
+        EXPECT_EQ(state.batchCount, static_cast<uint64_t>(BATCH_NUM - 1));
+    }
+}
+
+TEST(CalibrationPartialsTest, BatchOrderSnapshotIsPrefix)
+{
+    AmctCommon::CalibrationPartials partials;
+    partials.Init(SearchNPrototype(), AmctCommon::PartialsOrder::BATCH);
+    AmctCommon::CalibrationState state = SearchNPrototype();
+    EXPECT_FALSE(partials.Snapshot(state));
+
+    // batch 2 waits for batch 1, only then both are folded
+    EXPECT_EQ(partials.Claim(), 1);
+    EXPECT_EQ(partials.Claim(), 2);
+    auto append = [](float value) {
+        return [value](AmctCommon::CalibrationState& folded) {
+            folded.channelData.resize(1);
+            folded.channelData[0].push_back(value);
+        };
+    };
+    partials.Accumulate(2, append(2));
+    EXPECT_FALSE(partials.Snapshot(state));
+    partials.Accumulate(1, append(1));
+    ASSERT_TRUE(partials.Snapshot(state));
+    EXPECT_EQ(state.batchCount, 2U);
+    EXPECT_EQ(state.channelData[0], std::vector<float>({1, 2}));
+}
+
+TEST(CalibrationPartialsTest, BatchOrderResumesAfterInitial)
+{
+    AmctCommon::CalibrationPartials partials;
+    partials.Init(SearchNPrototype(), AmctCommon::PartialsOrder::BATCH);
+    AmctCommon::CalibrationState initial = SearchNPrototype();
+    initial.channelData = {{-1}};
+    initial.batchCount = 3;
+    partials.Reset(3, std::move(initial));
+    int64_t batch = partials.Claim();
+    EXPECT_EQ(batch, 4);
+    EXPECT_EQ(partials.Accumulate(batch, [](AmctCommon::CalibrationState& state) {
+        state.channelData[0].push_back(4);
+        state.batchCount++;
+    }), 4);
+    AmctCommon::CalibrationState state = SearchNPrototype();
+    ASSERT_EQ(partials.Merge(state), AmctCommon::SUCCESS);
+    EXPECT_EQ(state.channelData[0], std::vector<float>({-1, 4}));
+    EXPECT_EQ(state.batchCount, 4U);
+}
+
+TEST(CalibrationPartialsTest, AnyOrderKeepsEveryBatch)
+{
+    AmctCommon::CalibrationPartials partials;
+    partials.Init(SearchNPrototype(), AmctCommon::PartialsOrder::ANY);
+    std::atomic<int64_t> lastFinished{0};
+    RunBatches(partials, THREAD_NUM, 0, lastFinished);
+    EXPECT_NE(lastFinished.load(), 0);
+
+    AmctCommon::CalibrationState state = SearchNPrototype();
+    ASSERT_EQ(partials.Merge(state), AmctCommon::SUCCESS);
+    ASSERT_EQ(state.channelData.size(), 1U);
+    std::vector<float> merged = state.channelData[0];
+    std::sort(merged.begin(), merged.end());
+    ASSERT_EQ(merged.size(), static_cast<size_t>(BATCH_NUM));
+    for (int64_t batch = 1; batch <= BATCH_NUM; ++batch) {
+        EXPECT_EQ(merged[batch - 1], static_cast<float>(batch));
+    }
+}
+}
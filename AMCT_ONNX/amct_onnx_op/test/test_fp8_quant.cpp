@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief tests of the bit level fp8 rounding, encoding and decoding against the fp8 value tables
+ *
+ * @file test_fp8_quant.cpp
+ *
+ * @version 1.0
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fp8_quant.h"
+
+using AmctCommon::Fp8Format;
+
+namespace {
+constexpr int FP8_VALUE_NUM = 256;
+constexpr uint8_t FP8_SIGN_BIT = 0x80;
+constexpr uint8_t FP8_NAN = 0x7f;
+constexpr uint8_t E4M3_MAX_CODE = 0x7e;
+constexpr uint8_t E5M2_MAX_CODE = 0x7b;
+constexpr uint8_t E5M2_INF_CODE = 0x7c;
+const float INF = std::numeric_limits<float>::infinity();
+const float NAN_VALUE = std::numeric_limits<float>::quiet_NaN();
+
+uint8_t Encode(float value, Fp8Format format, float scale = 1.0f)
+{
+    uint8_t code = 0;
+    AmctCommon::Fp8EncodeKernel(&value, &code, 1, scale, format);
+    return code;
+}
+
+float Decode(uint8_t code, Fp8Format format, float scale = 1.0f)
+{
+    float value = 0;
+    AmctCommon::Fp8DecodeKernel(&code, &value, 1, scale, format);
+    return value;
+}
+
+float Round(float value, Fp8Format format, float scale = 1.0f)
+{
+    float rounded = 0;
+    AmctCommon::Fp8RoundKernel(&value, &rounded, 1, scale, format);
+    return rounded;
+}
+
+uint8_t MaxCode(Fp8Format format)
+{
+    return format == Fp8Format::E5M2 ? E5M2_MAX_CODE : E4M3_MAX_CODE;
+}
+
+// values of the positive finite codes, in code order
+std::vector<float> PositiveTable(Fp8Format format)
+{
+    std::vector<float> table;
+    for (int code = 0; code <= MaxCode(format); ++code) {
+        table.push_back(Decode(static_cast<uint8_t>(code), format));
+    }
+    return table;
+}
+
+// nearest positive finite code by search over the decode table, ties go to the even code (even mantissa)
+uint8_t ReferenceEncode(float value, const std::vector<float>& table)
+{
+    float magnitude = std::fabs(value);
+    size_t best = 0;
+    for (size_t code = 1; code < table.size(); ++code) {
+        float bestDistance = std::fabs(table[best] - magnitude);
+        float distance = std::fabs(table[code] - magnitude);
+        if (distance < bestDistance || (distance == bestDistance && code % 2 == 0)) {
+            best = code;
+        }
+    }
+    return static_cast<uint8_t>(std::signbit(value) ? (best | FP8_SIGN_BIT) : best);
+}
+
+class Fp8FormatTest : public ::testing::TestWithParam<Fp8Format> {};
+} // namespace
+
+TEST(Fp8QuantTest, DecodeTableE4M3)
+{
+    EXPECT_EQ(Decode(0x00, Fp8Format::E4M3), 0.0f);
+    EXPECT_TRUE(std::signbit(Decode(0x80, Fp8Format::E4M3)));
+    EXPECT_EQ(Decode(0x01, Fp8Format::E4M3), std::ldexp(1.0f, -9));
+    EXPECT_EQ(Decode(0x07, Fp8Format::E4M3), 7 * std::ldexp(1.0f, -9));
+    EXPECT_EQ(Decode(0x08, Fp8Format::E4M3), std::ldexp(1.0f, -6));
+    EXPECT_EQ(Decode(0x38, Fp8Format::E4M3), 1.0f);
+    EXPECT_EQ(Decode(0x3b, Fp8Format::E4M3), 1.375f);
+    EXPECT_EQ(Decode(0x78, Fp8Format::E4M3), 256.0f);
+    EXPECT_EQ(Decode(E4M3_MAX_CODE, Fp8Format::E4M3), 448.0f);
+    EXPECT_EQ(Decode(0xfe, Fp8Format::E4M3), -448.0f);
+    // no infinity in E4M3, only S.1111.111 is nan
+    EXPECT_TRUE(std::isnan(Decode(FP8_NAN, Fp8Format::E4M3)));
+    EXPECT_TRUE(std::isnan(Decode(0xff, Fp8Format::E4M3)));
+    EXPECT_EQ(Decode(0x38, Fp8Format::E4M3, 0.5f), 0.5f);
+}
+
+TEST(Fp8QuantTest, DecodeTableE5M2)
+{
+    EXPECT_EQ(Decode(0x00, Fp8Format::E5M2), 0.0f);
+    EXPECT_EQ(Decode(0x01, Fp8Format::E5M2), std::ldexp(1.0f, -16));
+    EXPECT_EQ(Decode(0x04, Fp8Format::E5M2), std::ldexp(1.0f, -14));
+    EXPECT_EQ(Decode(0x3c, Fp8Format::E5M2), 1.0f);
+    EXPECT_EQ(Decode(0x3f, Fp8Format::E5M2), 1.75f);
+    EXPECT_EQ(Decode(E5M2_MAX_CODE, Fp8Format::E5M2), 57344.0f);
+    EXPECT_EQ(Decode(E5M2_INF_CODE, Fp8Format::E5M2), INF);
+    EXPECT_EQ(Decode(0xfc, Fp8Format::E5M2), -INF);
+    for (uint8_t code : {0x7d, 0x7e, 0x7f, 0xfd, 0xfe, 0xff}) {
+        EXPECT_TRUE(std::isnan(Decode(code, Fp8Format::E5M2))) << static_cast<int>(code);
+    }
+}
+
+TEST(Fp8QuantTest, RoundTiesToEvenE4M3)
+{
+    // step 1/8 in [1, 2): 1 + 1/16 lies between 1.0 (even) and 1.125 (odd)
+    EXPECT_EQ(Encode(1.0625f, Fp8Format::E4M3), 0x38);
+    EXPECT_EQ(Encode(1.1875f, Fp8Format::E4M3), 0x3a);
+    EXPECT_EQ(Encode(std::nextafter(1.0625f, 2.0f), Fp8Format::E4M3), 0x39);
+    EXPECT_EQ(Round(1.0625f, Fp8Format::E4M3), 1.0f);
+    EXPECT_EQ(Round(-1.1875f, Fp8Format::E4M3), -1.25f);
+    // subnormal step 2^-9
+    float step = std::ldexp(1.0f, -9);
+    EXPECT_EQ(Encode(0.5f * step, Fp8Format::E4M3), 0x00);
+    EXPECT_EQ(Encode(1.5f * step, Fp8Format::E4M3), 0x02);
+    EXPECT_EQ(Encode(2.5f * step, Fp8Format::E4M3), 0x02);
+    // between the largest subnormal 7 * 2^-9 and the smallest normal 2^-6 = 8 * 2^-9
+    EXPECT_EQ(Encode(7.5f * step, Fp8Format::E4M3), 0x08);
+    // step 32 in [256, 448]: 432 lies between 416 (odd) and 448 (even)
+    EXPECT_EQ(Encode(432.0f, Fp8Format::E4M3), E4M3_MAX_CODE);
+    EXPECT_EQ(Encode(400.0f, Fp8Format::E4M3), 0x7c);
+}
+
+TEST(Fp8QuantTest, RoundTiesToEvenE5M2)
+{
+    // step 1/4 in [1, 2)
+    EXPECT_EQ(Encode(1.125f, Fp8Format::E5M2), 0x3c);
+    EXPECT_EQ(Encode(1.375f, Fp8Format::E5M2), 0x3e);
+    EXPECT_EQ(Round(1.625f, Fp8Format::E5M2), 1.5f);
+    EXPECT_EQ(Round(1.875f, Fp8Format::E5M2), 2.0f);
+    float step = std::ldexp(1.0f, -16);
+    EXPECT_EQ(Encode(0.5f * step, Fp8Format::E5M2), 0x00);
+    EXPECT_EQ(Encode(1.5f * step, Fp8Format::E5M2), 0x02);
+    EXPECT_EQ(Encode(-1.5f * step, Fp8Format::E5M2), 0x82);
+}
+
+TEST(Fp8QuantTest, SaturateE4M3)
+{
+    for (float value : {448.0f, 449.0f, 464.0f, 480.0f, 1e6f, 3e38f, INF}) {
+        EXPECT_EQ(Encode(value, Fp8Format::E4M3), E4M3_MAX_CODE) << value;
+        EXPECT_EQ(Encode(-value, Fp8Format::E4M3), E4M3_MAX_CODE | FP8_SIGN_BIT) << value;
+        EXPECT_EQ(Round(value, Fp8Format::E4M3), 448.0f) << value;
+        EXPECT_EQ(Round(-value, Fp8Format::E4M3), -448.0f) << value;
+    }
+    // the scale is applied before saturating
+    EXPECT_EQ(Round(1.0f, Fp8Format::E4M3, 1000.0f), 448.0f);
+}
+
+TEST(Fp8QuantTest, SaturateE5M2)
+{
+    for (float value : {57344.0f, 60000.0f, 61440.0f, 65536.0f, 1e9f, INF}) {
+        EXPECT_EQ(Encode(value, Fp8Format::E5M2), E5M2_MAX_CODE) << value;
+        EXPECT_EQ(Encode(-value, Fp8Format::E5M2), E5M2_MAX_CODE | FP8_SIGN_BIT) << value;
+        EXPECT_EQ(Round(value, Fp8Format::E5M2), 57344.0f) << value;
+        EXPECT_EQ(Round(-value, Fp8Format::E5M2), -57344.0f) << value;
+    }
+}
+
+TEST_P(Fp8FormatTest, NanStaysNan)
+{
+    Fp8Format format = GetParam();
+    EXPECT_EQ(Encode(NAN_VALUE, format), FP8_NAN);
+    EXPECT_EQ(Encode(-NAN_VALUE, format), FP8_NAN | FP8_SIGN_BIT);
+    EXPECT_TRUE(std::isnan(Round(NAN_VALUE, format)));
+    EXPECT_TRUE(std::isnan(Round(1.0f, format, NAN_VALUE)));
+    // nan in the middle of a vector does not disturb its neighbours
+    std::vector<float> in = {1.0f, NAN_VALUE, -2.0f};
+    std::vector<uint8_t> codes(in.size());
+    AmctCommon::Fp8EncodeKernel(in.data(), codes.data(), static_cast<int64_t>(in.size()), 1.0f, format);
+    EXPECT_EQ(Decode(codes[0], format), 1.0f);
+    EXPECT_EQ(codes[1], FP8_NAN);
+    EXPECT_EQ(Decode(codes[2], format), -2.0f);
+}
+
+TEST_P(Fp8FormatTest, DecodeEncodeRoundTrip)
+{
+    Fp8Format format = GetParam();
+    float previous = -1.0f;
+    for (int code = 0; code < FP8_VALUE_NUM; ++code) {
+        uint8_t fp8 = static_cast<uint8_t>(code);
+        float value = Decode(fp8, format);
+        if ((code & ~FP8_SIGN_BIT) > MaxCode(format)) {
+            continue;
+        }
+        EXPECT_EQ(Encode(value, format), fp8) << code;
+        EXPECT_EQ(Round(value, format), value) << code;
+        if (code < FP8_SIGN_BIT) {
+            // positive codes are ordered like their values
+            EXPECT_GT(value, previous) << code;
+            previous = value;
+        }
+    }
+    EXPECT_EQ(previous, AmctCommon::GetFp8MaxValue(format));
+}
+
+TEST_P(Fp8FormatTest, EncodeMatchesNearestTableValue)
+{
+    Fp8Format format = GetParam();
+    float maxValue = AmctCommon::GetFp8MaxValue(format);
+    std::vector<float> table = PositiveTable(format);
+    std::mt19937 rng(8);
+    std::uniform_real_distribution<float> exponent(-20.0f, std::log2(maxValue) + 1.0f);
+    std::vector<float> in;
+    for (int i = 0; i < 4096; ++i) {
+        float value = std::exp2(exponent(rng));
+        in.push_back(i % 2 == 0 ? value : -value);
+    }
+    // every midpoint between neighbouring codes is a tie
+    for (size_t code = 0; code + 1 < table.size(); ++code) {
+        in.push_back(0.5f * (table[code] + table[code + 1]));
+    }
+    std::vector<uint8_t> codes(in.size());
+    std::vector<float> rounded(in.size());
+    int64_t length = static_cast<int64_t>(in.size());
+    AmctCommon::Fp8EncodeKernel(in.data(), codes.data(), length, 1.0f, format);
+    AmctCommon::Fp8RoundKernel(in.data(), rounded.data(), length, 1.0f, format);
+    for (size_t i = 0; i < in.size(); ++i) {
+        uint8_t expected = std::fabs(in[i]) > maxValue ?
+            static_cast<uint8_t>(MaxCode(format) | (in[i] < 0 ? FP8_SIGN_BIT : 0)) : ReferenceEncode(in[i], table);
+        ASSERT_EQ(codes[i], expected) << in[i];
+        ASSERT_EQ(rounded[i], Decode(expected, format)) << in[i];
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Formats, Fp8FormatTest, ::testing::Values(Fp8Format::E4M3, Fp8Format::E5M2));
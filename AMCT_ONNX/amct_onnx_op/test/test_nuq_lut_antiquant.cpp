@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief tests of NuqLutAntiQuant against an element by element lookup
+ *
+ * @file test_nuq_lut_antiquant.cpp
+ *
+ * @version 1.0
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "cast_util.h"
+#include "dequant_quant.h"
+
+namespace {
+constexpr int64_t UINT8_TYPE_ID = 2;
+constexpr int64_t FLOAT_TYPE_ID = 1;
+constexpr int64_t FLOAT16_TYPE_ID = 10;
+constexpr int64_t PACKED_CODE_BITS = 4;
+constexpr int64_t BYTE_CODE_BITS = 8;
+
+struct NuqCase {
+    int64_t codeBits;
+    int64_t numSteps;
+    int64_t rowLength;
+    int64_t channelNum;
+    int64_t innerSize;
+    int64_t length;
+};
+
+int64_t CodeRowBytes(const NuqCase& nuq)
+{
+    return nuq.codeBits == PACKED_CODE_BITS ? (nuq.rowLength + 1) / 2 : nuq.rowLength;
+}
+
+// code of element e, two codes per byte low nibble first, every row starts on a new byte
+int64_t CodeOf(const std::vector<uint8_t>& codes, const NuqCase& nuq, int64_t e)
+{
+    int64_t row = e / nuq.rowLength;
+    int64_t j = e % nuq.rowLength;
+    if (nuq.codeBits == BYTE_CODE_BITS) {
+        return codes[row * nuq.rowLength + j];
+    }
+    return (codes[row * CodeRowBytes(nuq) + j / 2] >> (4 * (j % 2))) & 0xf;
+}
+
+// channels of [outer, channelNum, innerSize], with innerSize 1 the channel is the position in the row
+float Reference(const std::vector<uint8_t>& codes, const std::vector<float>& centroids, const NuqCase& nuq, int64_t e)
+{
+    int64_t code = std::min(CodeOf(codes, nuq, e), nuq.numSteps - 1);
+    int64_t channel = (e / nuq.innerSize) % nuq.channelNum;
+    return centroids[channel * nuq.numSteps + code];
+}
+
+class NuqLutAntiQuantTest : public ::testing::Test {
+protected:
+    void Fill(const NuqCase& nuq)
+    {
+        codes_.resize(nuq.length / nuq.rowLength * CodeRowBytes(nuq));
+        for (auto& code : codes_) {
+            code = static_cast<uint8_t>(rng_());
+        }
+        centroids_.resize(nuq.channelNum * nuq.numSteps);
+        for (auto& centroid : centroids_) {
+            centroid = static_cast<float>(static_cast<int>(rng_() % 10000) - 5000) / 64;
+        }
+    }
+
+    int Run(const NuqCase& nuq, void* out, int64_t outType)
+    {
+        NuqLutParam param = {nuq.numSteps, nuq.codeBits, nuq.rowLength, nuq.channelNum, nuq.innerSize,
+            centroids_.data()};
+        InputDataParam inputParam = {codes_.data(), out, UINT8_TYPE_ID, outType, static_cast<size_t>(nuq.length), 0};
+        return NuqLutAntiQuant(inputParam, param);
+    }
+
+    void ExpectLookup(const NuqCase& nuq)
+    {
+        Fill(nuq);
+        std::vector<float> out(nuq.length);
+        std::vector<uint16_t> outHalf(nuq.length);
+        ASSERT_EQ(Run(nuq, out.data(), FLOAT_TYPE_ID), 0);
+        ASSERT_EQ(Run(nuq, outHalf.data(), FLOAT16_TYPE_ID), 0);
+        for (int64_t e = 0; e < nuq.length; ++e) {
+            float expected = Reference(codes_, centroids_, nuq, e);
+            ASSERT_EQ(out[e], expected) << "element " << e;
+            ASSERT_EQ(outHalf[e], util::Fp32ToFp16(expected)) << "element " << e;
+        }
+    }
+
+    std::mt19937 rng_{2024};
+    std::vector<uint8_t> codes_;
+    std::vector<float> centroids_;
+};
+
+TEST_F(NuqLutAntiQuantTest, PerTensorTable)
+{
+    ExpectLookup({BYTE_CODE_BITS, 200, 33, 1, 3 * 4 * 33, 3 * 4 * 33});
+    ExpectLookup({PACKED_CODE_BITS, 16, 8, 1, 3 * 4 * 8, 3 * 4 * 8});
+}
+
+TEST_F(NuqLutAntiQuantTest, RowSharedTable)
+{
+    // [3, 5, 2, rowLength] with the table on axis 1, every row of a channel shares its table
+    ExpectLookup({BYTE_CODE_BITS, 200, 33, 5, 2 * 33, 3 * 5 * 2 * 33});
+    ExpectLookup({PACKED_CODE_BITS, 13, 8, 5, 2 * 8, 3 * 5 * 2 * 8});
+    ExpectLookup({BYTE_CODE_BITS, 7, 1, 5, 2, 3 * 5 * 2});
+}
+
+TEST_F(NuqLutAntiQuantTest, LastAxisTable)
+{
+    // [3, rowLength] with the table on the last axis, element j of a row takes table j
+    ExpectLookup({BYTE_CODE_BITS, 200, 33, 33, 1, 3 * 33});
+    ExpectLookup({PACKED_CODE_BITS, 13, 8, 8, 1, 3 * 8});
+}
+
+TEST_F(NuqLutAntiQuantTest, PackedOddRowLength)
+{
+    // the last byte of a row holds a single code, its high nibble is padding and rows start on a new byte
+    ExpectLookup({PACKED_CODE_BITS, 16, 7, 1, 4 * 7, 4 * 7});
+    ExpectLookup({PACKED_CODE_BITS, 16, 7, 3, 2 * 7, 4 * 3 * 2 * 7});
+    ExpectLookup({PACKED_CODE_BITS, 16, 7, 7, 1, 4 * 7});
+    ExpectLookup({PACKED_CODE_BITS, 16, 1, 5, 1, 5});
+
+    NuqCase nuq = {PACKED_CODE_BITS, 16, 3, 1, 6, 6};
+    Fill(nuq);
+    codes_ = {0x21, 0xf3, 0x54, 0xe6};
+    std::vector<float> out(nuq.length);
+    ASSERT_EQ(Run(nuq, out.data(), FLOAT_TYPE_ID), 0);
+    const int64_t expectedCodes[] = {1, 2, 3, 4, 5, 6};
+    for (int64_t e = 0; e < nuq.length; ++e) {
+        EXPECT_EQ(out[e], centroids_[expectedCodes[e]]) << "element " << e;
+    }
+}
+
+TEST_F(NuqLutAntiQuantTest, CodesPastNumSteps)
+{
+    // random codes cover the whole code range, those past the table take its last centroid
+    ExpectLookup({BYTE_CODE_BITS, 10, 33, 5, 2 * 33, 3 * 5 * 2 * 33});
+    ExpectLookup({BYTE_CODE_BITS, 10, 33, 33, 1, 3 * 33});
+    ExpectLookup({PACKED_CODE_BITS, 5, 7, 3, 2 * 7, 4 * 3 * 2 * 7});
+    ExpectLookup({PACKED_CODE_BITS, 5, 7, 7, 1, 4 * 7});
+
+    NuqCase nuq = {BYTE_CODE_BITS, 4, 4, 2, 4, 8};
+    Fill(nuq);
+    codes_ = {0, 3, 4, 255, 1, 2, 200, 3};
+    std::vector<float> out(nuq.length);
+    ASSERT_EQ(Run(nuq, out.data(), FLOAT_TYPE_ID), 0);
+    const int64_t expectedCodes[] = {0, 3, 3, 3, 1, 2, 3, 3};
+    for (int64_t e = 0; e < nuq.length; ++e) {
+        EXPECT_EQ(out[e], centroids_[(e / nuq.innerSize) * nuq.numSteps + expectedCodes[e]]) << "element " << e;
+    }
+}
+
+TEST_F(NuqLutAntiQuantTest, RejectsBadParam)
+{
+    std::vector<float> out(64);
+    const NuqCase badCases[] = {
+        {3, 8, 8, 1, 64, 64},                     // code width
+        {PACKED_CODE_BITS, 17, 8, 1, 64, 64},     // more steps than 4 bit codes
+        {BYTE_CODE_BITS, 257, 8, 1, 64, 64},      // more steps than 8 bit codes
+        {BYTE_CODE_BITS, 0, 8, 1, 64, 64},        // empty table
+        {BYTE_CODE_BITS, 16, 7, 1, 64, 64},       // length not whole rows
+        {BYTE_CODE_BITS, 16, 8, 3, 8, 64},        // length not whole channels
+        {BYTE_CODE_BITS, 16, 8, 4, 1, 64},        // last axis table with channelNum != rowLength
+        {BYTE_CODE_BITS, 16, 8, 4, 4, 64},        // row split across tables
+    };
+    for (const auto& nuq : badCases) {
+        Fill({BYTE_CODE_BITS, 1, 1, nuq.channelNum, 1, 64});
+        centroids_.resize(nuq.channelNum * std::max<int64_t>(nuq.numSteps, 1));
+        EXPECT_NE(Run(nuq, out.data(), FLOAT_TYPE_ID), 0) << "codeBits " << nuq.codeBits << " numSteps " <<
+            nuq.numSteps << " rowLength " << nuq.rowLength << " channelNum " << nuq.channelNum << " innerSize " <<
+            nuq.innerSize;
+    }
+}
+}
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief tests of Requant against the FakeDequant then FakeQuant composition it folds
+ *
+ * @file test_requant.cpp
+ *
+ * @version 1.0
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dequant_quant.h"
+
+namespace {
+constexpr int64_t FLOAT_TYPE_ID = 1;
+constexpr int64_t INT8_TYPE_ID = 3;
+constexpr int64_t INT32_TYPE_ID = 6;
+constexpr int64_t INT8_BITS = 8;
+constexpr int SHIFT_N_BITS = 32;
+
+// deq_scale in the low 32 bits and shift_n in the next 8, like the AscendDequant param input
+uint64_t PackParam(float deqScale, uint32_t shiftN)
+{
+    uint32_t deqScaleBits = 0;
+    memcpy(&deqScaleBits, &deqScale, sizeof(deqScaleBits));
+    return (static_cast<uint64_t>(shiftN) << SHIFT_N_BITS) | deqScaleBits;
+}
+
+// int32 data laid out as [outer, channelNum, innerSize], a single param is per-tensor
+struct RequantCase {
+    std::vector<int32_t> data;
+    std::vector<uint64_t> param;
+    int64_t innerSize;
+    float scale;
+    int64_t offset;
+};
+
+std::vector<int8_t> RunRequant(const RequantCase& requant)
+{
+    std::vector<int8_t> out(requant.data.size());
+    int64_t channelNum = static_cast<int64_t>(requant.param.size());
+    RequantParam param = {channelNum, channelNum == 1 ? static_cast<int64_t>(requant.data.size()) : requant.innerSize,
+        requant.param.data(), requant.scale, requant.offset};
+    InputDataParam inputParam = {requant.data.data(), out.data(), INT32_TYPE_ID, INT8_TYPE_ID, requant.data.size(), 0};
+    EXPECT_EQ(Requant(inputParam, param), 0);
+    return out;
+}
+
+// AscendDequant to float then AscendQuant to int8, as the unfused graph computes it
+std::vector<int8_t> RunComposition(const RequantCase& requant)
+{
+    size_t length = requant.data.size();
+    std::vector<float> data(requant.data.begin(), requant.data.end());
+    std::vector<float> dequantized(length);
+    std::vector<int8_t> out(length);
+    std::vector<float> shiftValue(requant.param.size());
+    std::vector<float> deqScale(requant.param.size());
+    bool channelWise = requant.param.size() != 1;
+    int64_t channelNum = static_cast<int64_t>(requant.param.size());
+    DequantParam dequantParam = {channelNum * requant.innerSize, requant.innerSize, CLIP_32, 0, 0, channelNum,
+        requant.param.data(), shiftValue.data(), deqScale.data(), nullptr, nullptr, channelWise};
+    EXPECT_EQ(ParseParamData(dequantParam), 0);
+    InputDataParam dequantInput = {data.data(), dequantized.data(), FLOAT_TYPE_ID, FLOAT_TYPE_ID, length, 0};
+    EXPECT_EQ(FakeDequant(dequantInput, dequantParam), 0);
+    InputDataParam quantInput = {dequantized.data(), out.data(), FLOAT_TYPE_ID, INT8_TYPE_ID, length, 0};
+    EXPECT_EQ(FakeQuant(quantInput, INT8_BITS, requant.scale, requant.offset), 0);
+    return out;
+}
+
+void ExpectSameAsComposition(const RequantCase& requant)
+{
+    std::vector<int8_t> fused = RunRequant(requant);
+    std::vector<int8_t> composed = RunComposition(requant);
+    for (size_t i = 0; i < fused.size(); ++i) {
+        ASSERT_EQ(fused[i], composed[i]) << "element " << i << " input " << requant.data[i];
+    }
+}
+
+std::vector<int32_t> Range(int32_t first, int32_t last, int32_t step = 1)
+{
+    std::vector<int32_t> data;
+    for (int32_t value = first; value <= last; value += step) {
+        data.push_back(value);
+    }
+    return data;
+}
+
+TEST(RequantTest, TiesRoundHalfToEven)
+{
+    // deq_scale 0.5 puts every odd input on a tie, rint rounds them to even in both directions
+    RequantCase requant = {Range(-9, 9), {PackParam(0.5f, 0)}, 1, 1.0f, 0};
+    std::vector<int8_t> fused = RunRequant(requant);
+    const int8_t expected[] = {-4, -4, -4, -3, -2, -2, -2, -1, 0, 0, 0, 1, 2, 2, 2, 3, 4, 4, 4};
+    for (size_t i = 0; i < fused.size(); ++i) {
+        EXPECT_EQ(fused[i], expected[i]) << "input " << requant.data[i];
+    }
+    ExpectSameAsComposition(requant);
+
+    // ties of the quant scale and the offset added after rounding
+    ExpectSameAsComposition({Range(-1000, 1000), {PackParam(0.25f, 0)}, 1, 0.5f, 3});
+    ExpectSameAsComposition({Range(-1000, 1000), {PackParam(0.375f, 0)}, 1, 0.25f, -5});
+}
+
+TEST(RequantTest, ShiftN)
+{
+    // shift_n floors the data before the int16 clip, the dequant scale then takes the shift back
+    std::vector<int32_t> data = Range(-70000, 70000, 7);
+    std::vector<int32_t> edges = {-140000, -131073, -131072, -131071, -5, -4, -3, -1, 0, 1, 3, 4, 5, 131067, 131068,
+        131072, 140000, INT32_MIN, INT32_MAX};
+    data.insert(data.end(), edges.begin(), edges.end());
+    ExpectSameAsComposition({data, {PackParam(0.25f, 2)}, 1, 1.0f / 64, 0});
+    ExpectSameAsComposition({data, {PackParam(0.125f, 3)}, 1, 1.0f / 32, 7});
+    ExpectSameAsComposition({data, {PackParam(1.0f, 1)}, 1, 1.0f / 256, -2});
+}
+
+TEST(RequantTest, PerChannel)
+{
+    // [3, 4, 6] with the params on axis 1, a single shift_n != 0 clips every channel to int16
+    std::vector<int32_t> data = Range(-12000, 12000, 167);
+    data.resize(3 * 4 * 6, 1001);
+    std::vector<uint64_t> param = {PackParam(0.5f, 0), PackParam(0.25f, 0), PackParam(0.375f, 0),
+        PackParam(0.125f, 0)};
+    ExpectSameAsComposition({data, param, 6, 1.0f / 16, 1});
+    param[3] = PackParam(0.125f, 3);
+    ExpectSameAsComposition({data, param, 6, 1.0f / 16, 1});
+
+    // [outer, channel] with the params on the last axis
+    std::vector<int32_t> rows = Range(-400, 400, 3);
+    rows.resize(rows.size() / 4 * 4);
+    ExpectSameAsComposition({rows, {PackParam(0.5f, 0), PackParam(0.25f, 1), PackParam(0.75f, 0),
+        PackParam(1.0f, 2)}, 1, 0.5f, 0});
+}
+
+TEST(RequantTest, RandomParams)
+{
+    // scales of any precision, only exact ties the float composition rounds off may come out one apart
+    std::mt19937 rng(2024);
+    std::uniform_int_distribution<int32_t> value(-300000, 300000);
+    std::uniform_real_distribution<float> factor(0.0005f, 0.05f);
+    for (int round = 0; round < 20; ++round) {
+        int64_t channelNum = round % 2 == 0 ? 1 : 5;
+        RequantCase requant = {std::vector<int32_t>(channelNum * 64 * 4), {}, 64, factor(rng) * 100, round - 10};
+        for (auto& x : requant.data) {
+            x = value(rng);
+        }
+        for (int64_t c = 0; c < channelNum; ++c) {
+            requant.param.push_back(PackParam(factor(rng), round % 4 == 1 ? 2 : 0));
+        }
+        std::vector<int8_t> fused = RunRequant(requant);
+        std::vector<int8_t> composed = RunComposition(requant);
+        for (size_t i = 0; i < fused.size(); ++i) {
+            EXPECT_LE(std::abs(fused[i] - composed[i]), 1) << "element " << i << " input " << requant.data[i];
+        }
+    }
+}
+
+TEST(RequantTest, RejectsBadParam)
+{
+    std::vector<int32_t> data(24);
+    std::vector<int8_t> out(24);
+    std::vector<uint64_t> param = {PackParam(0.5f, 0), PackParam(-0.5f, 0), PackParam(INFINITY, 0)};
+    InputDataParam inputParam = {data.data(), out.data(), INT32_TYPE_ID, INT8_TYPE_ID, data.size(), 0};
+    EXPECT_NE(Requant(inputParam, {1, 24, &param[1], 1.0f, 0}), 0);
+    EXPECT_NE(Requant(inputParam, {1, 24, &param[2], 1.0f, 0}), 0);
+    EXPECT_NE(Requant(inputParam, {5, 1, param.data(), 1.0f, 0}), 0);
+    InputDataParam floatInput = {data.data(), out.data(), FLOAT_TYPE_ID, INT8_TYPE_ID, data.size(), 0};
+    EXPECT_NE(Requant(floatInput, {1, 24, param.data(), 1.0f, 0}), 0);
+}
+}
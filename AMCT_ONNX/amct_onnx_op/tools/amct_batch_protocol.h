@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief unix socket framing shared by amct_batch_server and amct_load_generator.
+ * On connect the server sends an empty hello frame whose id is the bytes of one input sample; every request frame then
+ * carries one sample and is answered by a frame with the same id holding that sample's slice of every output.
+ *
+ * @file amct_batch_protocol.h
+ *
+ * @version 1.0
+ */
+
+#ifndef AMCT_BATCH_PROTOCOL_H
+#define AMCT_BATCH_PROTOCOL_H
+
+#include <cerrno>
+#include <cstdint>
+#include <vector>
+#include <unistd.h>
+
+namespace AmctBatch {
+constexpr uint32_t FRAME_MAGIC = 0x414d4354;
+constexpr uint32_t STATUS_OK = 0;
+constexpr uint32_t STATUS_ERROR = 1;
+constexpr const char* DEFAULT_SOCKET = "/tmp/amct_batch_server.sock";
+// largest payload a peer without a better bound accepts, e.g. the outputs of one sample read by the client
+constexpr uint64_t MAX_FRAME_SIZE = 256ULL * 1024 * 1024;
+
+struct FrameHeader {
+    uint32_t magic;
+    uint32_t status;
+    uint64_t id;
+    uint64_t size;
+};
+
+inline bool WriteAll(int fd, const void* data, size_t size)
+{
+    const char* begin = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = write(fd, begin, size);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        begin += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+inline bool ReadAll(int fd, void* data, size_t size)
+{
+    char* begin = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t got = read(fd, begin, size);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        begin += got;
+        size -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+inline bool WriteFrame(int fd, uint64_t id, uint32_t status, const void* payload, uint64_t size)
+{
+    FrameHeader header = {FRAME_MAGIC, status, id, size};
+    return WriteAll(fd, &header, sizeof(header)) && (size == 0 || WriteAll(fd, payload, size));
+}
+
+/**
+ * @brief: read one frame, the size in the header comes from the peer and is checked before anything is allocated.
+ * @param [in] maxSize: largest payload accepted, a larger frame fails the read and the stream must be closed
+ * @return false on a closed stream, a bad magic or an oversize frame
+ */
+inline bool ReadFrame(int fd, FrameHeader& header, std::vector<char>& payload, uint64_t maxSize)
+{
+    if (!ReadAll(fd, &header, sizeof(header)) || header.magic != FRAME_MAGIC || header.size > maxSize) {
+        return false;
+    }
+    payload.resize(header.size);
+    return header.size == 0 || ReadAll(fd, payload.data(), header.size);
+}
+} // namespace AmctBatch
+
+#endif // AMCT_BATCH_PROTOCOL_H
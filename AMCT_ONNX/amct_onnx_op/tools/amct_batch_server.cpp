@@ -0,0 +1,515 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief local dynamic batching inference server for models using the amct custom ops.
+ * Single sample requests arriving on a unix socket are coalesced into one batch until the batch is full or the
+ * oldest request reaches the max delay, run through one onnxruntime session and scattered back per request.
+ * The model needs one input whose leading dim is the batch. Built against onnxruntime by
+ * "make amct_batch_server ORT_DIR=<onnxruntime dir>" in this directory.
+ *
+ * @file amct_batch_server.cpp
+ *
+ * @version 1.0
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dlfcn.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "onnxruntime_cxx_api.h"
+#include "amct_batch_protocol.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+constexpr int POLL_INTERVAL_MS = 200;
+using RegisterCustomOpsFunc = OrtStatus* (*)(OrtSessionOptions* options, const OrtApiBase* api);
+
+std::atomic<bool> g_stop{false};
+
+struct ServerOptions {
+    const char* model = nullptr;
+    const char* customOpLibrary = nullptr;
+    const char* socketPath = AmctBatch::DEFAULT_SOCKET;
+    // sample shape without the batch dim, needed when the model has other dynamic dims
+    std::vector<int64_t> sampleShape;
+    int maxBatch = 16;
+    int64_t maxDelayUs = 2000;
+    int runners = 1;
+    int intraOpThreads = 0;
+};
+
+// a client socket, responses of different batches may be written concurrently
+struct Connection {
+    explicit Connection(int socketFd) : fd(socketFd) {}
+    ~Connection()
+    {
+        (void)close(fd);
+    }
+    int fd;
+    std::mutex writeMutex;
+};
+
+struct Request {
+    std::shared_ptr<Connection> connection;
+    uint64_t id;
+    std::vector<char> data;
+    Clock::time_point arrival;
+};
+
+class RequestQueue {
+public:
+    void Push(Request&& request)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            requests_.push_back(std::move(request));
+        }
+        cond_.notify_all();
+    }
+
+    /**
+     * @brief: wait for the first request, then until maxBatch requests are queued or the first one has waited
+     * maxDelay. Returns an empty batch on stop.
+     */
+    std::vector<Request> PopBatch(int maxBatch, std::chrono::microseconds maxDelay)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this] { return g_stop.load() || !requests_.empty(); });
+        if (requests_.empty()) {
+            return {};
+        }
+        Clock::time_point deadline = requests_.front().arrival + maxDelay;
+        cond_.wait_until(lock, deadline, [this, maxBatch] {
+            return g_stop.load() || static_cast<int>(requests_.size()) >= maxBatch;
+        });
+        size_t count = std::min(requests_.size(), static_cast<size_t>(maxBatch));
+        std::vector<Request> batch;
+        for (size_t i = 0; i < count; ++i) {
+            batch.push_back(std::move(requests_.front()));
+            requests_.pop_front();
+        }
+        return batch;
+    }
+
+    void Wake()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cond_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<Request> requests_;
+};
+
+struct ServerStats {
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> batches{0};
+    std::atomic<uint64_t> queueUs{0};
+    std::atomic<uint64_t> runUs{0};
+    std::vector<std::atomic<uint64_t>> batchSizes;
+    explicit ServerStats(int maxBatch) : batchSizes(static_cast<size_t>(maxBatch) + 1) {}
+};
+
+size_t ElementSize(ONNXTensorElementDataType type)
+{
+    switch (type) {
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_DOUBLE:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT64:
+            return sizeof(int64_t);
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT32:
+            return sizeof(int32_t);
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_BFLOAT16:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT16:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT16:
+            return sizeof(int16_t);
+        default:
+            return sizeof(int8_t);
+    }
+}
+
+std::string GetName(const Ort::Session& session, size_t index, bool isInput,
+    Ort::AllocatorWithDefaultOptions& allocator)
+{
+#if ORT_API_VERSION >= 13
+    Ort::AllocatedStringPtr name = isInput ? session.GetInputNameAllocated(index, allocator) :
+        session.GetOutputNameAllocated(index, allocator);
+    return std::string(name.get());
+#else
+    char* name = isInput ? session.GetInputName(index, allocator) : session.GetOutputName(index, allocator);
+    std::string result(name);
+    allocator.Free(name);
+    return result;
+#endif
+}
+
+class BatchRunner {
+public:
+    BatchRunner(Ort::Session& session, const ServerOptions& options, ServerStats& stats)
+        : session_(session), options_(options), stats_(stats),
+          memoryInfo_(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault))
+    {
+        Ort::AllocatorWithDefaultOptions allocator;
+        inputName_ = GetName(session_, 0, true, allocator);
+        for (size_t i = 0; i < session_.GetOutputCount(); ++i) {
+            outputNames_.push_back(GetName(session_, i, false, allocator));
+        }
+        for (const auto& name : outputNames_) {
+            outputNamePtrs_.push_back(name.c_str());
+        }
+        Ort::TypeInfo typeInfo = session_.GetInputTypeInfo(0);
+        auto tensorInfo = typeInfo.GetTensorTypeAndShapeInfo();
+        inputType_ = tensorInfo.GetElementType();
+        std::vector<int64_t> modelShape = tensorInfo.GetShape();
+        shape_ = {0};
+        if (!options_.sampleShape.empty()) {
+            shape_.insert(shape_.end(), options_.sampleShape.begin(), options_.sampleShape.end());
+        } else {
+            shape_.insert(shape_.end(), modelShape.begin() + std::min<size_t>(1, modelShape.size()), modelShape.end());
+        }
+        sampleBytes_ = ElementSize(inputType_);
+        for (size_t i = 1; i < shape_.size(); ++i) {
+            if (shape_[i] < 0) {
+                ORT_CXX_API_THROW("Input has dynamic dims besides the batch, set the sample shape with -s",
+                    ORT_INVALID_ARGUMENT);
+            }
+            sampleBytes_ *= static_cast<size_t>(shape_[i]);
+        }
+        // the batch buffer is allocated once for the largest batch
+        batchBuffer_.resize(sampleBytes_ * static_cast<size_t>(options_.maxBatch));
+    }
+
+    size_t SampleBytes() const
+    {
+        return sampleBytes_;
+    }
+
+    void Run(std::vector<Request>& batch)
+    {
+        Clock::time_point start = Clock::now();
+        auto invalid = std::stable_partition(batch.begin(), batch.end(),
+            [this](const Request& request) { return request.data.size() == sampleBytes_; });
+        for (auto it = invalid; it != batch.end(); ++it) {
+            Reply(*it, AmctBatch::STATUS_ERROR, nullptr, 0);
+        }
+        batch.erase(invalid, batch.end());
+        size_t count = batch.size();
+        if (count == 0) {
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            memcpy(batchBuffer_.data() + i * sampleBytes_, batch[i].data.data(), sampleBytes_);
+        }
+        shape_[0] = static_cast<int64_t>(count);
+        Ort::Value input = Ort::Value::CreateTensor(memoryInfo_, batchBuffer_.data(), count * sampleBytes_,
+            shape_.data(), shape_.size(), inputType_);
+        const char* inputName = inputName_.c_str();
+        std::vector<Ort::Value> outputs;
+        try {
+            outputs = session_.Run(Ort::RunOptions{nullptr}, &inputName, &input, 1, outputNamePtrs_.data(),
+                outputNamePtrs_.size());
+        } catch (const Ort::Exception& e) {
+            printf("Batch of %zu failed: %s\n", count, e.what());
+            for (auto& request : batch) {
+                Reply(request, AmctBatch::STATUS_ERROR, nullptr, 0);
+            }
+            return;
+        }
+        Clock::time_point end = Clock::now();
+        Scatter(batch, outputs);
+        uint64_t queueUs = 0;
+        for (const auto& request : batch) {
+            queueUs += static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(start - request.arrival).count());
+        }
+        stats_.requests.fetch_add(count);
+        stats_.batches.fetch_add(1);
+        stats_.queueUs.fetch_add(queueUs);
+        stats_.runUs.fetch_add(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()));
+        stats_.batchSizes[count].fetch_add(1);
+    }
+
+private:
+    // every output has the batch as leading dim, request i gets the i-th slice of each output in order
+    void Scatter(const std::vector<Request>& batch, std::vector<Ort::Value>& outputs)
+    {
+        size_t count = batch.size();
+        std::vector<size_t> sliceBytes;
+        size_t responseBytes = 0;
+        for (auto& output : outputs) {
+            auto info = output.GetTensorTypeAndShapeInfo();
+            size_t bytes = info.GetElementCount() * ElementSize(info.GetElementType());
+            sliceBytes.push_back(bytes / count);
+            responseBytes += bytes / count;
+        }
+        std::vector<char> response(responseBytes);
+        for (size_t i = 0; i < count; ++i) {
+            size_t offset = 0;
+            for (size_t j = 0; j < outputs.size(); ++j) {
+                const char* data = static_cast<const char*>(outputs[j].GetTensorMutableData<void>());
+                memcpy(response.data() + offset, data + i * sliceBytes[j], sliceBytes[j]);
+                offset += sliceBytes[j];
+            }
+            Reply(batch[i], AmctBatch::STATUS_OK, response.data(), response.size());
+        }
+    }
+
+    static void Reply(const Request& request, uint32_t status, const void* data, size_t size)
+    {
+        std::lock_guard<std::mutex> lock(request.connection->writeMutex);
+        (void)AmctBatch::WriteFrame(request.connection->fd, request.id, status, data, size);
+    }
+
+    Ort::Session& session_;
+    const ServerOptions& options_;
+    ServerStats& stats_;
+    Ort::MemoryInfo memoryInfo_;
+    std::string inputName_;
+    std::vector<std::string> outputNames_;
+    std::vector<const char*> outputNamePtrs_;
+    ONNXTensorElementDataType inputType_;
+    std::vector<int64_t> shape_;
+    size_t sampleBytes_{0};
+    std::vector<char> batchBuffer_;
+};
+
+void ServeConnection(std::shared_ptr<Connection> connection, size_t sampleBytes, RequestQueue& queue)
+{
+    {
+        std::lock_guard<std::mutex> lock(connection->writeMutex);
+        if (!AmctBatch::WriteFrame(connection->fd, sampleBytes, AmctBatch::STATUS_OK, nullptr, 0)) {
+            return;
+        }
+    }
+    AmctBatch::FrameHeader header;
+    std::vector<char> payload;
+    // a request is exactly one sample, anything larger ends the connection before it is allocated
+    while (!g_stop.load() && AmctBatch::ReadFrame(connection->fd, header, payload, sampleBytes)) {
+        queue.Push({connection, header.id, std::move(payload), Clock::now()});
+        payload = std::vector<char>();
+    }
+}
+
+int Listen(const char* socketPath)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath, sizeof(address.sun_path) - 1);
+    (void)unlink(socketPath);
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        (void)close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void PrintStats(const ServerStats& stats)
+{
+    uint64_t batches = stats.batches.load();
+    uint64_t requests = stats.requests.load();
+    if (batches == 0) {
+        printf("No request served.\n");
+        return;
+    }
+    printf("%llu requests in %llu batches, mean batch %.2f, mean queue %.1f us, mean run %.1f us\n",
+        static_cast<unsigned long long>(requests), static_cast<unsigned long long>(batches),
+        static_cast<double>(requests) / batches, static_cast<double>(stats.queueUs.load()) / requests,
+        static_cast<double>(stats.runUs.load()) / batches);
+    printf("batch size histogram:");
+    for (size_t size = 1; size < stats.batchSizes.size(); ++size) {
+        uint64_t count = stats.batchSizes[size].load();
+        if (count != 0) {
+            printf(" %zu:%llu", size, static_cast<unsigned long long>(count));
+        }
+    }
+    printf("\n");
+}
+
+void PrintUsage(const char* name)
+{
+    printf("Usage: %s -m <model.onnx> [-l <libamct_onnx_ops.so>] [options]\n", name);
+    printf("  -u socket        unix socket path, default %s\n", AmctBatch::DEFAULT_SOCKET);
+    printf("  -b max batch     requests per batch, default 16\n");
+    printf("  -d max delay us  longest wait of the first request of a batch, default 2000\n");
+    printf("  -r runners       batches run concurrently on the session, default 1\n");
+    printf("  -t threads       intra op threads, default onnxruntime's; the amct ops use AMCT_NUM_THREADS more,\n");
+    printf("                   keep the sum within the cores\n");
+    printf("  -s 3x224x224     sample shape without the batch, default the model's\n");
+}
+
+bool ParseOptions(int argc, char* argv[], ServerOptions& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* value = argv[i + 1];
+        if (strcmp(argv[i], "-m") == 0) {
+            options.model = value;
+        } else if (strcmp(argv[i], "-l") == 0) {
+            options.customOpLibrary = value;
+        } else if (strcmp(argv[i], "-u") == 0) {
+            options.socketPath = value;
+        } else if (strcmp(argv[i], "-b") == 0) {
+            options.maxBatch = std::max(atoi(value), 1);
+        } else if (strcmp(argv[i], "-d") == 0) {
+            options.maxDelayUs = std::max(atoll(value), 0LL);
+        } else if (strcmp(argv[i], "-r") == 0) {
+            options.runners = std::max(atoi(value), 1);
+        } else if (strcmp(argv[i], "-t") == 0) {
+            options.intraOpThreads = std::max(atoi(value), 0);
+        } else if (strcmp(argv[i], "-s") == 0) {
+            char* end = nullptr;
+            for (const char* p = value; *p != '\0'; p = (*end == 'x') ? end + 1 : end) {
+                options.sampleShape.push_back(strtoll(p, &end, 10));
+                if (end == p) {
+                    return false;
+                }
+            }
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && options.model != nullptr;
+}
+
+void HandleSignal(int)
+{
+    g_stop.store(true);
+}
+
+int Serve(const ServerOptions& options)
+{
+    Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "amct_batch_server");
+    Ort::SessionOptions sessionOptions;
+    if (options.intraOpThreads > 0) {
+        sessionOptions.SetIntraOpNumThreads(options.intraOpThreads);
+    }
+    if (options.customOpLibrary != nullptr) {
+        // kept loaded for the life of the process
+        void* library = dlopen(options.customOpLibrary, RTLD_NOW | RTLD_LOCAL);
+        auto registerCustomOps = library == nullptr ? nullptr :
+            reinterpret_cast<RegisterCustomOpsFunc>(dlsym(library, "RegisterCustomOps"));
+        if (registerCustomOps == nullptr) {
+            printf("Fail to load RegisterCustomOps from %s.\n", options.customOpLibrary);
+            return 1;
+        }
+        Ort::ThrowOnError(registerCustomOps(sessionOptions, OrtGetApiBase()));
+    }
+    Ort::Session session(env, options.model, sessionOptions);
+    ServerStats stats(options.maxBatch);
+    std::vector<std::unique_ptr<BatchRunner>> runners;
+    for (int i = 0; i < options.runners; ++i) {
+        runners.emplace_back(new BatchRunner(session, options, stats));
+    }
+
+    int listenFd = Listen(options.socketPath);
+    if (listenFd < 0) {
+        printf("Fail to listen on %s: %s.\n", options.socketPath, strerror(errno));
+        return 1;
+    }
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = HandleSignal;
+    (void)sigaction(SIGINT, &action, nullptr);
+    (void)sigaction(SIGTERM, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    RequestQueue queue;
+    std::vector<std::thread> runnerThreads;
+    for (auto& runner : runners) {
+        BatchRunner* batchRunner = runner.get();
+        runnerThreads.emplace_back([batchRunner, &queue, &options]() {
+            while (!g_stop.load()) {
+                std::vector<Request> batch = queue.PopBatch(options.maxBatch,
+                    std::chrono::microseconds(options.maxDelayUs));
+                if (!batch.empty()) {
+                    batchRunner->Run(batch);
+                }
+            }
+        });
+    }
+    printf("Serving %s on %s, max batch %d, max delay %lld us, sample %zu bytes.\n", options.model,
+        options.socketPath, options.maxBatch, static_cast<long long>(options.maxDelayUs), runners[0]->SampleBytes());
+    fflush(stdout);
+    std::vector<std::shared_ptr<Connection>> connections;
+    std::vector<std::thread> connectionThreads;
+    // the signal may land on any thread, the accept loop polls for the stop flag
+    struct pollfd listenPoll = {listenFd, POLLIN, 0};
+    while (!g_stop.load()) {
+        if (poll(&listenPoll, 1, POLL_INTERVAL_MS) <= 0) {
+            continue;
+        }
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+        connections.push_back(std::make_shared<Connection>(fd));
+        connectionThreads.emplace_back(ServeConnection, connections.back(), runners[0]->SampleBytes(),
+            std::ref(queue));
+    }
+    queue.Wake();
+    for (auto& thread : runnerThreads) {
+        thread.join();
+    }
+    // unblock the readers before the queue and the session go away
+    for (auto& connection : connections) {
+        (void)shutdown(connection->fd, SHUT_RDWR);
+    }
+    for (auto& thread : connectionThreads) {
+        thread.join();
+    }
+    (void)close(listenFd);
+    (void)unlink(options.socketPath);
+    PrintStats(stats);
+    return 0;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    ServerOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    try {
+        return Serve(options);
+    } catch (const Ort::Exception& e) {
+        printf("onnxruntime error: %s\n", e.what());
+        return 1;
+    }
+}
@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief load generator for amct_batch_server, sends single sample requests over several connections either
+ * closed loop (one outstanding request per connection) or open loop at a fixed total rate, and reports
+ * throughput and end to end latency. Run it against servers started with different -b and -d settings.
+ * Built by "make amct_load_generator" in this directory.
+ *
+ * @file amct_load_generator.cpp
+ *
+ * @version 1.0
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "amct_batch_protocol.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct LoadOptions {
+    const char* socketPath = AmctBatch::DEFAULT_SOCKET;
+    int connections = 16;
+    int requests = 2000;
+    // total requests per second over all connections, 0 for closed loop
+    double rate = 0;
+    const char* output = nullptr;
+};
+
+struct ClientResult {
+    std::vector<double> latencyUs;
+    uint64_t errors{0};
+};
+
+int Connect(const char* socketPath)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath, sizeof(address.sun_path) - 1);
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0) {
+        (void)close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief: one connection, the sender paces the requests and the receiver matches the responses by id, so that
+ * in open loop a slow response never delays the next request.
+ */
+void RunClient(int fd, const std::vector<char>& sample, int requests, double interval, ClientResult& result)
+{
+    std::mutex mutex;
+    std::unordered_map<uint64_t, Clock::time_point> pending;
+    std::atomic<int> inFlight{0};
+    std::thread receiver([&]() {
+        AmctBatch::FrameHeader header;
+        std::vector<char> payload;
+        for (int i = 0; i < requests; ++i) {
+            if (!AmctBatch::ReadFrame(fd, header, payload, AmctBatch::MAX_FRAME_SIZE)) {
+                result.errors += static_cast<uint64_t>(requests - i);
+                return;
+            }
+            Clock::time_point sent;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                sent = pending[header.id];
+                pending.erase(header.id);
+            }
+            --inFlight;
+            if (header.status != AmctBatch::STATUS_OK) {
+                ++result.errors;
+                continue;
+            }
+            result.latencyUs.push_back(std::chrono::duration<double, std::micro>(Clock::now() - sent).count());
+        }
+    });
+    Clock::time_point next = Clock::now();
+    for (int i = 0; i < requests; ++i) {
+        if (interval > 0) {
+            std::this_thread::sleep_until(next);
+            next += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(interval));
+        } else {
+            while (inFlight.load() != 0) {
+                std::this_thread::yield();
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending[static_cast<uint64_t>(i)] = Clock::now();
+        }
+        ++inFlight;
+        if (!AmctBatch::WriteFrame(fd, static_cast<uint64_t>(i), AmctBatch::STATUS_OK, sample.data(), sample.size())) {
+            break;
+        }
+    }
+    receiver.join();
+}
+
+double Percentile(const std::vector<double>& sorted, double ratio)
+{
+    size_t rank = static_cast<size_t>(ratio * static_cast<double>(sorted.size()) + 0.5);
+    return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+void PrintUsage(const char* name)
+{
+    printf("Usage: %s [-u socket] [-c connections] [-n requests] [-r rate] [-o output json]\n", name);
+    printf("  -c  concurrent connections, default 16\n");
+    printf("  -n  requests over all connections, default 2000\n");
+    printf("  -r  total requests per second, default 0 (closed loop, one outstanding request per connection)\n");
+}
+
+bool ParseOptions(int argc, char* argv[], LoadOptions& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* value = argv[i + 1];
+        if (strcmp(argv[i], "-u") == 0) {
+            options.socketPath = value;
+        } else if (strcmp(argv[i], "-c") == 0) {
+            options.connections = std::max(atoi(value), 1);
+        } else if (strcmp(argv[i], "-n") == 0) {
+            options.requests = std::max(atoi(value), 1);
+        } else if (strcmp(argv[i], "-r") == 0) {
+            options.rate = std::max(atof(value), 0.0);
+        } else if (strcmp(argv[i], "-o") == 0) {
+            options.output = value;
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    LoadOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    std::vector<int> fds;
+    size_t sampleBytes = 0;
+    for (int i = 0; i < options.connections; ++i) {
+        int fd = Connect(options.socketPath);
+        AmctBatch::FrameHeader hello;
+        std::vector<char> payload;
+        // the hello frame carries the sample size in its id and has no payload
+        if (fd < 0 || !AmctBatch::ReadFrame(fd, hello, payload, 0)) {
+            printf("Fail to connect to %s.\n", options.socketPath);
+            return 1;
+        }
+        sampleBytes = static_cast<size_t>(hello.id);
+        fds.push_back(fd);
+    }
+    std::vector<char> sample(sampleBytes);
+    std::mt19937 engine(0);
+    for (auto& byte : sample) {
+        byte = static_cast<char>(engine() % 64);
+    }
+    std::vector<ClientResult> results(fds.size());
+    std::vector<std::thread> clients;
+    double interval = options.rate > 0 ? options.connections / options.rate : 0;
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < fds.size(); ++i) {
+        int requests = options.requests / options.connections +
+            (static_cast<int>(i) < options.requests % options.connections ? 1 : 0);
+        clients.emplace_back(RunClient, fds[i], std::cref(sample), requests, interval, std::ref(results[i]));
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    for (int fd : fds) {
+        (void)close(fd);
+    }
+
+    std::vector<double> latencyUs;
+    uint64_t errors = 0;
+    for (const auto& result : results) {
+        latencyUs.insert(latencyUs.end(), result.latencyUs.begin(), result.latencyUs.end());
+        errors += result.errors;
+    }
+    if (latencyUs.empty()) {
+        printf("No request succeeded, %llu errors.\n", static_cast<unsigned long long>(errors));
+        return 1;
+    }
+    std::sort(latencyUs.begin(), latencyUs.end());
+    double throughput = latencyUs.size() / seconds;
+    char mode[64] = "closed loop";
+    if (options.rate > 0) {
+        (void)snprintf(mode, sizeof(mode), "open loop %.1f/s", options.rate);
+    }
+    printf("%zu requests of %zu bytes, %d connections, %s, %llu errors\n", latencyUs.size(), sampleBytes,
+        options.connections, mode, static_cast<unsigned long long>(errors));
+    printf("latency ms: p50 %.3f p90 %.3f p99 %.3f max %.3f\n", Percentile(latencyUs, 0.5) / 1e3,
+        Percentile(latencyUs, 0.9) / 1e3, Percentile(latencyUs, 0.99) / 1e3, latencyUs.back() / 1e3);
+    printf("throughput: %.2f requests/s\n", throughput);
+    if (options.output != nullptr) {
+        FILE* out = fopen(options.output, "w");
+        if (out != nullptr) {
+            fprintf(out, "{\"connections\": %d, \"rate\": %.2f, \"requests\": %zu, \"errors\": %llu, "
+                "\"p50_ms\": %.4f, \"p90_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f, \"requests_per_s\": %.3f}\n",
+                options.connections, options.rate, latencyUs.size(), static_cast<unsigned long long>(errors),
+                Percentile(latencyUs, 0.5) / 1e3, Percentile(latencyUs, 0.9) / 1e3, Percentile(latencyUs, 0.99) / 1e3,
+                latencyUs.back() / 1e3, throughput);
+            fclose(out);
+        }
+    }
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,481 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief native onnxruntime latency runner for fp32 and quantized models that use the amct custom ops.
+ * The custom op library is loaded with dlopen and registered through RegisterCustomOps; inputs and outputs are
+ * allocated once per worker and bound with IoBinding, so the measured time is Session::Run alone.
+ * Built against onnxruntime by "make amct_ort_runner ORT_DIR=<onnxruntime release>" in this directory, and
+ * "make smoke" runs it on the quantized resnet50 of the Resnet_AMCT_quant sample.
+ *
+ * @file amct_ort_runner.cpp
+ *
+ * @version 1.0
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dlfcn.h>
+
+#include "onnxruntime_cxx_api.h"
+
+namespace {
+constexpr double PERCENTILE_50 = 0.5;
+constexpr double PERCENTILE_90 = 0.9;
+constexpr double PERCENTILE_99 = 0.99;
+
+using RegisterCustomOpsFunc = OrtStatus* (*)(OrtSessionOptions* options, const OrtApiBase* api);
+
+struct RunnerOptions {
+    const char* model = nullptr;
+    const char* customOpLibrary = nullptr;
+    // input name to raw tensor file or shape, inputs without a file get random data
+    std::map<std::string, std::string> inputFiles;
+    std::map<std::string, std::vector<int64_t>> inputShapes;
+    int64_t batchSize = 1;
+    int warmup = 10;
+    int iterations = 100;
+    int concurrency = 1;
+    int intraOpThreads = 0;
+    int interOpThreads = 0;
+    const char* output = nullptr;
+};
+
+struct TensorSpec {
+    std::string name;
+    ONNXTensorElementDataType type;
+    std::vector<int64_t> shape;
+};
+
+// the buffers and binding of one worker, allocated before the measurement
+struct Worker {
+    std::vector<std::vector<char>> inputBuffers;
+    std::vector<std::vector<char>> outputBuffers;
+    std::vector<Ort::Value> values;
+    std::unique_ptr<Ort::IoBinding> binding;
+    std::vector<double> latencyUs;
+};
+
+size_t ElementSize(ONNXTensorElementDataType type)
+{
+    switch (type) {
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_DOUBLE:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT64:
+            return sizeof(int64_t);
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT32:
+            return sizeof(int32_t);
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_BFLOAT16:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT16:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT16:
+            return sizeof(int16_t);
+        default:
+            return sizeof(int8_t);
+    }
+}
+
+size_t ElementCount(const std::vector<int64_t>& shape)
+{
+    size_t count = 1;
+    for (int64_t dim : shape) {
+        count *= static_cast<size_t>(dim);
+    }
+    return count;
+}
+
+std::string ShapeToString(const std::vector<int64_t>& shape)
+{
+    std::string text;
+    for (size_t i = 0; i < shape.size(); ++i) {
+        text += (i == 0 ? "" : "x") + std::to_string(shape[i]);
+    }
+    return text.empty() ? "scalar" : text;
+}
+
+std::vector<int64_t> ParseShape(const std::string& text)
+{
+    std::vector<int64_t> shape;
+    size_t begin = 0;
+    while (begin < text.size()) {
+        size_t end = text.find('x', begin);
+        end = end == std::string::npos ? text.size() : end;
+        shape.push_back(atoll(text.substr(begin, end - begin).c_str()));
+        begin = end + 1;
+    }
+    return shape;
+}
+
+// round to nearest even is not needed for random data, the mantissa is truncated
+uint16_t FloatToHalf(float value)
+{
+    uint32_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xffu) - 127 + 15;
+    if (exponent <= 0) {
+        return static_cast<uint16_t>(sign);
+    }
+    return static_cast<uint16_t>(sign | (static_cast<uint32_t>(exponent) << 10) | ((bits >> 13) & 0x3ffu));
+}
+
+void FillRandom(ONNXTensorElementDataType type, std::vector<char>& buffer, unsigned int seed)
+{
+    std::mt19937 engine(seed);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    size_t count = buffer.size() / ElementSize(type);
+    for (size_t i = 0; i < count; ++i) {
+        float value = uniform(engine);
+        if (type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+            reinterpret_cast<float*>(buffer.data())[i] = value;
+        } else if (type == ONNX_TENSOR_ELEMENT_DATA_TYPE_DOUBLE) {
+            reinterpret_cast<double*>(buffer.data())[i] = value;
+        } else if (type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16) {
+            reinterpret_cast<uint16_t*>(buffer.data())[i] = FloatToHalf(value);
+        } else if (type == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64) {
+            reinterpret_cast<int64_t*>(buffer.data())[i] = static_cast<int64_t>(engine() % 10);
+        } else if (type == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32) {
+            reinterpret_cast<int32_t*>(buffer.data())[i] = static_cast<int32_t>(engine() % 10);
+        } else if (type == ONNX_TENSOR_ELEMENT_DATA_TYPE_BOOL) {
+            buffer[i] = static_cast<char>(engine() % 2);
+        } else {
+            // int8, uint8 and the other types are filled byte by byte
+            for (size_t byte = 0; byte < ElementSize(type); ++byte) {
+                buffer[i * ElementSize(type) + byte] = static_cast<char>(engine() % 128);
+            }
+        }
+    }
+}
+
+bool LoadInput(const TensorSpec& spec, const RunnerOptions& options, std::vector<char>& buffer)
+{
+    buffer.resize(ElementCount(spec.shape) * ElementSize(spec.type));
+    auto file = options.inputFiles.find(spec.name);
+    if (file == options.inputFiles.end()) {
+        FillRandom(spec.type, buffer, static_cast<unsigned int>(std::hash<std::string>()(spec.name)));
+        return true;
+    }
+    std::ifstream in(file->second, std::ios::binary | std::ios::ate);
+    if (!in.is_open() || static_cast<size_t>(in.tellg()) != buffer.size()) {
+        printf("Input %s needs a raw file of %zu bytes for shape %s: %s.\n", spec.name.c_str(), buffer.size(),
+            ShapeToString(spec.shape).c_str(), file->second.c_str());
+        return false;
+    }
+    in.seekg(0);
+    in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    return true;
+}
+
+std::string GetName(const Ort::Session& session, size_t index, bool isInput, Ort::AllocatorWithDefaultOptions& allocator)
+{
+#if ORT_API_VERSION >= 13
+    Ort::AllocatedStringPtr name = isInput ? session.GetInputNameAllocated(index, allocator) :
+        session.GetOutputNameAllocated(index, allocator);
+    return std::string(name.get());
+#else
+    char* name = isInput ? session.GetInputName(index, allocator) : session.GetOutputName(index, allocator);
+    std::string result(name);
+    allocator.Free(name);
+    return result;
+#endif
+}
+
+bool GetInputSpecs(const Ort::Session& session, const RunnerOptions& options, std::vector<TensorSpec>& specs)
+{
+    Ort::AllocatorWithDefaultOptions allocator;
+    for (size_t i = 0; i < session.GetInputCount(); ++i) {
+        TensorSpec spec;
+        spec.name = GetName(session, i, true, allocator);
+        Ort::TypeInfo typeInfo = session.GetInputTypeInfo(i);
+        auto tensorInfo = typeInfo.GetTensorTypeAndShapeInfo();
+        spec.type = tensorInfo.GetElementType();
+        spec.shape = tensorInfo.GetShape();
+        auto shape = options.inputShapes.find(spec.name);
+        if (shape != options.inputShapes.end()) {
+            spec.shape = shape->second;
+        }
+        // dynamic dims: the leading one is the batch, the others must be given with -s
+        for (size_t dim = 0; dim < spec.shape.size(); ++dim) {
+            if (spec.shape[dim] >= 0) {
+                continue;
+            }
+            if (dim != 0) {
+                printf("Input %s has a dynamic dim %zu, set its shape with -s %s:<shape>.\n", spec.name.c_str(), dim,
+                    spec.name.c_str());
+                return false;
+            }
+            spec.shape[dim] = options.batchSize;
+        }
+        specs.push_back(spec);
+    }
+    return true;
+}
+
+// output shapes may depend on the inputs, one run with ORT allocated outputs tells them
+std::vector<TensorSpec> GetOutputSpecs(Ort::Session& session, const std::vector<TensorSpec>& inputSpecs,
+    Worker& worker)
+{
+    Ort::AllocatorWithDefaultOptions allocator;
+    std::vector<std::string> outputNames;
+    for (size_t i = 0; i < session.GetOutputCount(); ++i) {
+        outputNames.push_back(GetName(session, i, false, allocator));
+    }
+    std::vector<const char*> inputNamePtrs;
+    for (const auto& spec : inputSpecs) {
+        inputNamePtrs.push_back(spec.name.c_str());
+    }
+    std::vector<const char*> outputNamePtrs;
+    for (const auto& name : outputNames) {
+        outputNamePtrs.push_back(name.c_str());
+    }
+    std::vector<Ort::Value> outputs = session.Run(Ort::RunOptions{nullptr}, inputNamePtrs.data(),
+        worker.values.data(), inputNamePtrs.size(), outputNamePtrs.data(), outputNamePtrs.size());
+    std::vector<TensorSpec> specs;
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        auto tensorInfo = outputs[i].GetTensorTypeAndShapeInfo();
+        specs.push_back({outputNames[i], tensorInfo.GetElementType(), tensorInfo.GetShape()});
+    }
+    return specs;
+}
+
+bool PrepareInputs(const std::vector<TensorSpec>& specs, const RunnerOptions& options,
+    const Ort::MemoryInfo& memoryInfo, Worker& worker)
+{
+    worker.inputBuffers.resize(specs.size());
+    for (size_t i = 0; i < specs.size(); ++i) {
+        if (!LoadInput(specs[i], options, worker.inputBuffers[i])) {
+            return false;
+        }
+        worker.values.push_back(Ort::Value::CreateTensor(memoryInfo, worker.inputBuffers[i].data(),
+            worker.inputBuffers[i].size(), specs[i].shape.data(), specs[i].shape.size(), specs[i].type));
+    }
+    return true;
+}
+
+void BindWorker(Ort::Session& session, const std::vector<TensorSpec>& inputSpecs,
+    const std::vector<TensorSpec>& outputSpecs, const Ort::MemoryInfo& memoryInfo, Worker& worker)
+{
+    worker.binding.reset(new Ort::IoBinding(session));
+    for (size_t i = 0; i < inputSpecs.size(); ++i) {
+        worker.binding->BindInput(inputSpecs[i].name.c_str(), worker.values[i]);
+    }
+    worker.outputBuffers.resize(outputSpecs.size());
+    for (size_t i = 0; i < outputSpecs.size(); ++i) {
+        const TensorSpec& spec = outputSpecs[i];
+        worker.outputBuffers[i].resize(ElementCount(spec.shape) * ElementSize(spec.type));
+        worker.values.push_back(Ort::Value::CreateTensor(memoryInfo, worker.outputBuffers[i].data(),
+            worker.outputBuffers[i].size(), spec.shape.data(), spec.shape.size(), spec.type));
+        worker.binding->BindOutput(spec.name.c_str(), worker.values.back());
+    }
+}
+
+double Percentile(const std::vector<double>& sorted, double ratio)
+{
+    size_t rank = static_cast<size_t>(ratio * static_cast<double>(sorted.size()) + 0.5);
+    return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+void PrintUsage(const char* name)
+{
+    printf("Usage: %s -m <model.onnx> [-l <libamct_onnx_ops.so>] [options]\n", name);
+    printf("  -i name:file     raw input tensor, inputs without a file get random data\n");
+    printf("  -s name:1x3x224x224  input shape, needed for dynamic dims other than the batch\n");
+    printf("  -b batch         leading dynamic dim, default 1\n");
+    printf("  -w warmup        warm up runs per worker, default 10\n");
+    printf("  -n iterations    measured runs over all workers, default 100\n");
+    printf("  -c concurrency   workers calling Run on the shared session, default 1\n");
+    printf("  -t threads       intra op threads, -T inter op threads, default onnxruntime's; the amct ops use\n");
+    printf("                   AMCT_NUM_THREADS more, keep the sum within the cores\n");
+    printf("  -o file          also write the result as JSON\n");
+}
+
+bool SplitPair(const char* text, std::string& key, std::string& value)
+{
+    const char* separator = strrchr(text, ':');
+    if (separator == nullptr || separator == text) {
+        return false;
+    }
+    key.assign(text, separator);
+    value.assign(separator + 1);
+    return true;
+}
+
+bool ParseOptions(int argc, char* argv[], RunnerOptions& options)
+{
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc || argv[i][0] != '-' || strlen(argv[i]) != 2) {
+            return false;
+        }
+        const char* value = argv[++i];
+        std::string key;
+        std::string item;
+        switch (argv[i - 1][1]) {
+            case 'm': options.model = value; break;
+            case 'l': options.customOpLibrary = value; break;
+            case 'b': options.batchSize = std::max(atoll(value), 1LL); break;
+            case 'w': options.warmup = std::max(atoi(value), 0); break;
+            case 'n': options.iterations = std::max(atoi(value), 1); break;
+            case 'c': options.concurrency = std::max(atoi(value), 1); break;
+            case 't': options.intraOpThreads = std::max(atoi(value), 0); break;
+            case 'T': options.interOpThreads = std::max(atoi(value), 0); break;
+            case 'o': options.output = value; break;
+            case 'i':
+                if (!SplitPair(value, key, item)) {
+                    return false;
+                }
+                options.inputFiles[key] = item;
+                break;
+            case 's':
+                if (!SplitPair(value, key, item)) {
+                    return false;
+                }
+                options.inputShapes[key] = ParseShape(item);
+                break;
+            default:
+                return false;
+        }
+    }
+    return options.model != nullptr;
+}
+
+int Run(const RunnerOptions& options)
+{
+    Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "amct_ort_runner");
+    Ort::SessionOptions sessionOptions;
+    if (options.intraOpThreads > 0) {
+        sessionOptions.SetIntraOpNumThreads(options.intraOpThreads);
+    }
+    if (options.interOpThreads > 0) {
+        sessionOptions.SetInterOpNumThreads(options.interOpThreads);
+        sessionOptions.SetExecutionMode(ORT_PARALLEL);
+    }
+    // the library must stay loaded while the session lives
+    void* library = nullptr;
+    if (options.customOpLibrary != nullptr) {
+        library = dlopen(options.customOpLibrary, RTLD_NOW | RTLD_LOCAL);
+        if (library == nullptr) {
+            printf("Fail to load %s: %s.\n", options.customOpLibrary, dlerror());
+            return 1;
+        }
+        auto registerCustomOps = reinterpret_cast<RegisterCustomOpsFunc>(dlsym(library, "RegisterCustomOps"));
+        if (registerCustomOps == nullptr) {
+            printf("%s has no RegisterCustomOps.\n", options.customOpLibrary);
+            return 1;
+        }
+        Ort::ThrowOnError(registerCustomOps(sessionOptions, OrtGetApiBase()));
+    }
+    Ort::Session session(env, options.model, sessionOptions);
+    Ort::MemoryInfo memoryInfo = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+
+    std::vector<TensorSpec> inputSpecs;
+    if (!GetInputSpecs(session, options, inputSpecs)) {
+        return 1;
+    }
+    std::vector<Worker> workers(options.concurrency);
+    for (auto& worker : workers) {
+        if (!PrepareInputs(inputSpecs, options, memoryInfo, worker)) {
+            return 1;
+        }
+    }
+    std::vector<TensorSpec> outputSpecs = GetOutputSpecs(session, inputSpecs, workers[0]);
+    for (auto& worker : workers) {
+        BindWorker(session, inputSpecs, outputSpecs, memoryInfo, worker);
+    }
+    for (const auto& spec : inputSpecs) {
+        printf("input  %-24s %s\n", spec.name.c_str(), ShapeToString(spec.shape).c_str());
+    }
+    for (const auto& spec : outputSpecs) {
+        printf("output %-24s %s\n", spec.name.c_str(), ShapeToString(spec.shape).c_str());
+    }
+
+    Ort::RunOptions runOptions;
+    for (auto& worker : workers) {
+        for (int i = 0; i < options.warmup; ++i) {
+            session.Run(runOptions, *worker.binding);
+        }
+    }
+    std::atomic<int> next{0};
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (auto& worker : workers) {
+        threads.emplace_back([&session, &runOptions, &worker, &next, &options]() {
+            while (next.fetch_add(1) < options.iterations) {
+                auto begin = std::chrono::steady_clock::now();
+                session.Run(runOptions, *worker.binding);
+                worker.latencyUs.push_back(
+                    std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> latencyUs;
+    for (const auto& worker : workers) {
+        latencyUs.insert(latencyUs.end(), worker.latencyUs.begin(), worker.latencyUs.end());
+    }
+    std::sort(latencyUs.begin(), latencyUs.end());
+    double meanUs = 0;
+    for (double latency : latencyUs) {
+        meanUs += latency / latencyUs.size();
+    }
+    int64_t batch = inputSpecs.empty() || inputSpecs[0].shape.empty() ? 1 : inputSpecs[0].shape[0];
+    double runsPerSecond = latencyUs.size() / wallSeconds;
+    printf("%zu runs, concurrency %d, batch %lld\n", latencyUs.size(), options.concurrency,
+        static_cast<long long>(batch));
+    printf("latency ms: mean %.3f p50 %.3f p90 %.3f p99 %.3f min %.3f max %.3f\n", meanUs / 1e3,
+        Percentile(latencyUs, PERCENTILE_50) / 1e3, Percentile(latencyUs, PERCENTILE_90) / 1e3,
+        Percentile(latencyUs, PERCENTILE_99) / 1e3, latencyUs.front() / 1e3, latencyUs.back() / 1e3);
+    printf("throughput: %.2f runs/s, %.2f samples/s\n", runsPerSecond, runsPerSecond * batch);
+    if (options.output != nullptr) {
+        std::ofstream out(options.output);
+        out << "{\"model\": \"" << options.model << "\", \"runs\": " << latencyUs.size()
+            << ", \"concurrency\": " << options.concurrency << ", \"batch\": " << batch
+            << ", \"intra_op_threads\": " << options.intraOpThreads
+            << ", \"inter_op_threads\": " << options.interOpThreads << ", \"mean_ms\": " << meanUs / 1e3
+            << ", \"p50_ms\": " << Percentile(latencyUs, PERCENTILE_50) / 1e3
+            << ", \"p90_ms\": " << Percentile(latencyUs, PERCENTILE_90) / 1e3
+            << ", \"p99_ms\": " << Percentile(latencyUs, PERCENTILE_99) / 1e3
+            << ", \"min_ms\": " << latencyUs.front() / 1e3 << ", \"max_ms\": " << latencyUs.back() / 1e3
+            << ", \"runs_per_s\": " << runsPerSecond << ", \"samples_per_s\": " << runsPerSecond * batch << "}\n";
+    }
+    return 0;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    RunnerOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    try {
+        return Run(options);
+    } catch (const Ort::Exception& e) {
+        printf("onnxruntime error: %s\n", e.what());
+        return 1;
+    }
+}
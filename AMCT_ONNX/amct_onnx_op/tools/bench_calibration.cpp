@@ -0,0 +1,420 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief benchmark of the calibration algorithms (IFMR, HFMG, SearchN, SearchNV2, DMQBalance) on synthetic
+ * activations, without ONNX models or python. Every calibrator and distribution runs in a forked child so that
+ * the peak RSS belongs to that run alone.
+ * Built against the installed amct custom op library by "make bench_calibration" in this directory.
+ *
+ * @file bench_calibration.cpp
+ *
+ * @version 1.0
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "dmq_balance.h"
+#include "hfmg.h"
+#include "ifmr.h"
+#include "search_n.h"
+#include "search_n_v2.h"
+#include "util.h"
+
+namespace {
+constexpr unsigned int QUANT_BITS = 8;
+constexpr unsigned int HFMG_BINS = 4096;
+constexpr float INT8_MAX_VALUE = 127.0f;
+constexpr float WEIGHT_SCALE = 0.01f;
+constexpr float MIGRATION_STRENGTH = 0.5f;
+constexpr unsigned int WEIGHT_PER_CHANNEL = 256;
+constexpr double OUTLIER_RATIO = 0.001;
+constexpr float OUTLIER_GAIN = 50.0f;
+constexpr int HEAVY_TAIL_DOF = 3;
+
+const char* const CALIBRATORS[] = {"ifmr", "hfmg", "search_n", "search_n_v2", "dmq_balance"};
+const char* const DISTRIBUTIONS[] = {"gaussian", "relu", "heavy_tail", "outlier"};
+
+struct BenchOptions {
+    std::vector<std::string> calibrators{std::begin(CALIBRATORS), std::end(CALIBRATORS)};
+    std::vector<std::string> distributions{std::begin(DISTRIBUTIONS), std::end(DISTRIBUTIONS)};
+    unsigned int layers = 4;
+    unsigned int batches = 8;
+    unsigned int elements = 65536;
+    unsigned int channels = 16;
+    const char* output = "bench_calibration.csv";
+};
+
+// what one layer calibrated to, only the fields of the calibrator are set
+struct BenchResult {
+    double accumulateMs = 0;
+    double finalizeMs = 0;
+    float scale = 0;
+    int offset = 0;
+    double meanShiftN = 0;
+    double meanBalanceFactor = 0;
+    int ret = AmctCommon::SUCCESS;
+};
+
+double ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::vector<std::string> SplitList(const char* text)
+{
+    std::vector<std::string> items;
+    std::string item;
+    for (const char* p = text;; ++p) {
+        if (*p == ',' || *p == '\0') {
+            if (!item.empty()) {
+                items.push_back(item);
+            }
+            item.clear();
+            if (*p == '\0') {
+                break;
+            }
+        } else {
+            item.push_back(*p);
+        }
+    }
+    return items;
+}
+
+/**
+ * @brief: one batch of a layer in [channel, elements / channel] layout, channels get different ranges.
+ * The seed makes every run of the same layer and batch see the same data.
+ */
+void GenerateBatch(const std::string& distribution, unsigned int layer, unsigned int batch,
+    const BenchOptions& options, std::vector<float>& data)
+{
+    std::mt19937 engine(layer * 1000003u + batch);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    std::student_t_distribution<float> heavyTail(HEAVY_TAIL_DOF);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    data.resize(options.elements);
+    unsigned int channelSize = std::max(options.elements / options.channels, 1u);
+    for (unsigned int i = 0; i < options.elements; ++i) {
+        float gain = 0.5f + static_cast<float>((i / channelSize) % options.channels) / options.channels;
+        float value = 0;
+        if (distribution == "relu") {
+            value = std::max(0.0f, normal(engine) + 0.2f);
+        } else if (distribution == "heavy_tail") {
+            value = heavyTail(engine);
+        } else {
+            value = normal(engine);
+            if (distribution == "outlier" && uniform(engine) < OUTLIER_RATIO) {
+                value *= OUTLIER_GAIN;
+            }
+        }
+        data[i] = value * gain;
+    }
+}
+
+void SplitChannels(const std::vector<float>& data, unsigned int channels, std::vector<std::vector<float>>& channelData)
+{
+    size_t channelSize = data.size() / channels;
+    channelData.resize(channels);
+    for (unsigned int channel = 0; channel < channels; ++channel) {
+        channelData[channel].insert(channelData[channel].end(), data.begin() + channel * channelSize,
+            data.begin() + (channel + 1) * channelSize);
+    }
+}
+
+std::vector<float> GetDeqScale(const std::vector<float>& data, unsigned int channels)
+{
+    float absMax = 0;
+    for (float value : data) {
+        absMax = std::max(absMax, std::fabs(value));
+    }
+    return std::vector<float>(channels, absMax / INT8_MAX_VALUE * WEIGHT_SCALE);
+}
+
+BenchResult RunIfmr(const std::string& distribution, unsigned int layer, const BenchOptions& options)
+{
+    BenchResult result;
+    std::vector<float> batchData;
+    std::vector<float> accumulateData;
+    for (unsigned int batch = 0; batch < options.batches; ++batch) {
+        GenerateBatch(distribution, layer, batch, options, batchData);
+        auto start = std::chrono::steady_clock::now();
+        accumulateData.insert(accumulateData.end(), batchData.begin(), batchData.end());
+        result.accumulateMs += ElapsedMs(start);
+    }
+    // the defaults of the IFMR quant config
+    AmctCommon::IfmrParam param = {0, QUANT_BITS, true, false, 0.7f, 1.3f, 0.01f, 0.999999f, 0.999999f};
+    util::FloatData scale = {1, &result.scale};
+    util::IntData offset = {1, &result.offset};
+    auto start = std::chrono::steady_clock::now();
+    result.ret = AmctCommon::IfmrQuant(accumulateData.data(), static_cast<unsigned int>(accumulateData.size()), param,
+        scale, offset);
+    result.finalizeMs = ElapsedMs(start);
+    return result;
+}
+
+BenchResult RunHfmg(const std::string& distribution, unsigned int layer, const BenchOptions& options)
+{
+    BenchResult result;
+    std::vector<float> batchData;
+    std::vector<AmctCommon::DataBin<float>> dataBins;
+    for (unsigned int batch = 0; batch < options.batches && result.ret == AmctCommon::SUCCESS; ++batch) {
+        GenerateBatch(distribution, layer, batch, options, batchData);
+        auto start = std::chrono::steady_clock::now();
+        AmctCommon::InputData<float> inputData(static_cast<unsigned int>(batchData.size()), batchData.data());
+        result.ret = AmctCommon::HfmgMerge(HFMG_BINS, dataBins, inputData);
+        result.accumulateMs += ElapsedMs(start);
+    }
+    if (result.ret != AmctCommon::SUCCESS) {
+        return result;
+    }
+    AmctCommon::HfmgAlgoParam param = {QUANT_BITS, true, HFMG_BINS};
+    auto start = std::chrono::steady_clock::now();
+    result.ret = AmctCommon::HfmgCompute(dataBins, result.scale, result.offset, param);
+    result.finalizeMs = ElapsedMs(start);
+    return result;
+}
+
+BenchResult RunSearchN(const std::string& distribution, unsigned int layer, const BenchOptions& options)
+{
+    BenchResult result;
+    std::vector<float> batchData;
+    std::vector<std::vector<float>> accumulateData;
+    for (unsigned int batch = 0; batch < options.batches; ++batch) {
+        GenerateBatch(distribution, layer, batch, options, batchData);
+        auto start = std::chrono::steady_clock::now();
+        SplitChannels(batchData, options.channels, accumulateData);
+        result.accumulateMs += ElapsedMs(start);
+    }
+    std::vector<float> deqScale = GetDeqScale(batchData, options.channels);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::vector<int>> int32Data(accumulateData.size());
+    for (size_t channel = 0; channel < accumulateData.size(); ++channel) {
+        int32Data[channel].reserve(accumulateData[channel].size());
+        for (float value : accumulateData[channel]) {
+            int32Data[channel].push_back(static_cast<int>(std::round(value / deqScale[channel])));
+        }
+    }
+    std::vector<int> bestN;
+    AmctCommon::SearchShiftBits(int32Data, bestN);
+    result.finalizeMs = ElapsedMs(start);
+    for (int n : bestN) {
+        result.meanShiftN += static_cast<double>(n) / bestN.size();
+    }
+    return result;
+}
+
+BenchResult RunSearchNV2(const std::string& distribution, unsigned int layer, const BenchOptions& options)
+{
+    BenchResult result;
+    std::vector<float> batchData;
+    std::vector<std::vector<float>> searchNError(options.channels, std::vector<float>(util::SHIFT_BITS));
+    for (unsigned int batch = 0; batch < options.batches && result.ret == AmctCommon::SUCCESS; ++batch) {
+        GenerateBatch(distribution, layer, batch, options, batchData);
+        std::vector<float> deqScale = GetDeqScale(batchData, options.channels);
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::vector<float>> channelData;
+        SplitChannels(batchData, options.channels, channelData);
+        util::FloatData deqScaleCpu = {static_cast<unsigned int>(deqScale.size()), deqScale.data()};
+        result.ret = AmctCommon::SearchNV2AccumulateError(channelData, searchNError, deqScaleCpu, false);
+        result.accumulateMs += ElapsedMs(start);
+    }
+    if (result.ret != AmctCommon::SUCCESS) {
+        return result;
+    }
+    std::vector<int> bestN(searchNError.size());
+    util::IntData bestNCpu = {static_cast<unsigned int>(bestN.size()), bestN.data()};
+    auto start = std::chrono::steady_clock::now();
+    result.ret = AmctCommon::SearchNV2FindBestNCpu(searchNError, bestNCpu, false);
+    result.finalizeMs = ElapsedMs(start);
+    for (int n : bestN) {
+        result.meanShiftN += static_cast<double>(n) / bestN.size();
+    }
+    return result;
+}
+
+BenchResult RunDmqBalance(const std::string& distribution, unsigned int layer, const BenchOptions& options)
+{
+    BenchResult result;
+    std::vector<float> actData;
+    std::vector<float> wtsData;
+    std::vector<float> balanceFactor(options.channels);
+    // the balance factor is computed for every batch, as DMQBalancer does
+    for (unsigned int batch = 0; batch < options.batches && result.ret == AmctCommon::SUCCESS; ++batch) {
+        GenerateBatch(distribution, layer, batch, options, actData);
+        GenerateBatch("gaussian", layer + options.layers, batch, options, wtsData);
+        wtsData.resize(options.channels * WEIGHT_PER_CHANNEL);
+        util::FloatData act = {static_cast<unsigned int>(actData.size()), actData.data()};
+        util::FloatData wts = {static_cast<unsigned int>(wtsData.size()), wtsData.data()};
+        auto start = std::chrono::steady_clock::now();
+        result.ret = AmctCommon::DMQBalance(act, wts, MIGRATION_STRENGTH, options.channels, balanceFactor.data());
+        result.finalizeMs += ElapsedMs(start);
+    }
+    for (float factor : balanceFactor) {
+        result.meanBalanceFactor += static_cast<double>(factor) / balanceFactor.size();
+    }
+    return result;
+}
+
+BenchResult RunLayer(const std::string& calibrator, const std::string& distribution, unsigned int layer,
+    const BenchOptions& options)
+{
+    if (calibrator == "ifmr") {
+        return RunIfmr(distribution, layer, options);
+    }
+    if (calibrator == "hfmg") {
+        return RunHfmg(distribution, layer, options);
+    }
+    if (calibrator == "search_n") {
+        return RunSearchN(distribution, layer, options);
+    }
+    if (calibrator == "search_n_v2") {
+        return RunSearchNV2(distribution, layer, options);
+    }
+    return RunDmqBalance(distribution, layer, options);
+}
+
+int RunCase(const std::string& calibrator, const std::string& distribution, const BenchOptions& options)
+{
+    FILE* output = fopen(options.output, "a");
+    if (output == nullptr) {
+        printf("Fail to open %s.\n", options.output);
+        return 1;
+    }
+    double accumulateMs = 0;
+    double finalizeMs = 0;
+    BenchResult first;
+    for (unsigned int layer = 0; layer < options.layers; ++layer) {
+        BenchResult result = RunLayer(calibrator, distribution, layer, options);
+        if (result.ret != AmctCommon::SUCCESS) {
+            printf("%s on %s layer %u failed, error code: %d.\n", calibrator.c_str(), distribution.c_str(), layer,
+                result.ret);
+            fclose(output);
+            return 1;
+        }
+        accumulateMs += result.accumulateMs;
+        finalizeMs += result.finalizeMs;
+        if (layer == 0) {
+            first = result;
+        }
+    }
+    struct rusage usage;
+    (void)getrusage(RUSAGE_SELF, &usage);
+    printf("%-12s %-11s %12.2f %12.2f %12.2f %10ld %12.6g %7d %8.3f %8.4f\n", calibrator.c_str(),
+        distribution.c_str(), accumulateMs, finalizeMs, accumulateMs + finalizeMs, usage.ru_maxrss, first.scale,
+        first.offset, first.meanShiftN, first.meanBalanceFactor);
+    fprintf(output, "%s,%s,%u,%u,%u,%u,%.3f,%.3f,%.3f,%ld,%.9g,%d,%.4f,%.6f\n", calibrator.c_str(),
+        distribution.c_str(), options.layers, options.batches, options.elements, options.channels, accumulateMs,
+        finalizeMs, accumulateMs + finalizeMs, usage.ru_maxrss, first.scale, first.offset, first.meanShiftN,
+        first.meanBalanceFactor);
+    fclose(output);
+    return 0;
+}
+
+void PrintUsage(const char* name)
+{
+    printf("Usage: %s [-c calibrators] [-d distributions] [-l layers] [-b batches] [-n elements] [-C channels] "
+        "[-o output csv]\n", name);
+    printf("  -c  comma separated, from ifmr,hfmg,search_n,search_n_v2,dmq_balance\n");
+    printf("  -d  comma separated, from gaussian,relu,heavy_tail,outlier\n");
+    printf("  -n  elements of one batch of one layer, -C channels of the channel wise calibrators\n");
+    printf("  The scale, offset, shift bits and balance factor columns are those of layer 0.\n");
+}
+
+bool ParseUint(const char* text, unsigned int& value)
+{
+    char* end = nullptr;
+    unsigned long result = strtoul(text, &end, 10);
+    if (end == text || *end != '\0' || result == 0) {
+        return false;
+    }
+    value = static_cast<unsigned int>(result);
+    return true;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    BenchOptions options;
+    bool valid = true;
+    for (int i = 1; i < argc && valid; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "-c") == 0 && hasValue) {
+            options.calibrators = SplitList(argv[++i]);
+        } else if (strcmp(argv[i], "-d") == 0 && hasValue) {
+            options.distributions = SplitList(argv[++i]);
+        } else if (strcmp(argv[i], "-l") == 0 && hasValue) {
+            valid = ParseUint(argv[++i], options.layers);
+        } else if (strcmp(argv[i], "-b") == 0 && hasValue) {
+            valid = ParseUint(argv[++i], options.batches);
+        } else if (strcmp(argv[i], "-n") == 0 && hasValue) {
+            valid = ParseUint(argv[++i], options.elements);
+        } else if (strcmp(argv[i], "-C") == 0 && hasValue) {
+            valid = ParseUint(argv[++i], options.channels);
+        } else if (strcmp(argv[i], "-o") == 0 && hasValue) {
+            options.output = argv[++i];
+        } else {
+            valid = false;
+        }
+    }
+    for (const auto& calibrator : options.calibrators) {
+        valid = valid && std::find(std::begin(CALIBRATORS), std::end(CALIBRATORS), calibrator) != std::end(CALIBRATORS);
+    }
+    for (const auto& distribution : options.distributions) {
+        valid = valid && std::find(std::begin(DISTRIBUTIONS), std::end(DISTRIBUTIONS), distribution) !=
+            std::end(DISTRIBUTIONS);
+    }
+    if (!valid || options.elements < options.channels) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    FILE* output = fopen(options.output, "w");
+    if (output == nullptr) {
+        printf("Fail to open %s.\n", options.output);
+        return 1;
+    }
+    fprintf(output, "calibrator,distribution,layers,batches,elements,channels,accumulate_ms,finalize_ms,total_ms,"
+        "peak_rss_kb,scale,offset,mean_shift_n,mean_balance_factor\n");
+    fclose(output);
+    printf("%u layers, %u batches of %u elements, %u channels\n", options.layers, options.batches, options.elements,
+        options.channels);
+    printf("%-12s %-11s %12s %12s %12s %10s %12s %7s %8s %8s\n", "calibrator", "data", "accumulate", "finalize",
+        "total_ms", "rss_kb", "scale", "offset", "shift_n", "factor");
+    for (const auto& calibrator : options.calibrators) {
+        for (const auto& distribution : options.distributions) {
+            fflush(stdout);
+            pid_t pid = fork();
+            if (pid < 0) {
+                printf("Fail to fork for %s.\n", calibrator.c_str());
+                return 1;
+            }
+            if (pid == 0) {
+                exit(RunCase(calibrator, distribution, options));
+            }
+            int status = 0;
+            if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                printf("Benchmark of %s on %s failed.\n", calibrator.c_str(), distribution.c_str());
+            }
+        }
+    }
+    printf("Results written to %s.\n", options.output);
+    return 0;
+}
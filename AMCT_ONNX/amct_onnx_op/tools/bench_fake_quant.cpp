@@ -0,0 +1,331 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief microbenchmark of the fake quant, dequant, antiquant and cast kernels against a memcpy roofline.
+ * Every thread count runs in a forked child with AMCT_NUM_THREADS set, as the pool size is fixed on first use.
+ * Built against the installed amct custom op library by "make bench_fake_quant" in this directory.
+ *
+ * @file bench_fake_quant.cpp
+ *
+ * @version 1.0
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "amct_thread_pool.h"
+#include "cast_util.h"
+#include "dequant_quant.h"
+#include "util.h"
+
+namespace {
+constexpr int FLOAT_TYPE_ID = 1;
+constexpr int INT8_TYPE_ID = 3;
+constexpr int FLOAT16_TYPE_ID = 10;
+constexpr int64_t QUANT_BITS = 8;
+constexpr int64_t CHANNEL_NUM = 64;
+constexpr double MIN_SECONDS = 0.2;
+constexpr int MIN_REPEATS = 3;
+
+struct BenchOptions {
+    // up to 64M elements so that the largest buffers are well beyond the last level cache
+    std::vector<int64_t> sizes = {1024, 16384, 262144, 4194304, 16777216, 67108864};
+    std::vector<int> threads;
+    std::string kernel;
+    const char* output = "bench_fake_quant.csv";
+};
+
+struct BenchCase {
+    std::string kernel;
+    int inType;
+    int outType;
+    int64_t precisionMode;
+    bool channelWise;
+};
+
+struct BenchBuffers {
+    std::vector<float> in32;
+    std::vector<uint16_t> in16;
+    std::vector<float> out32;
+    std::vector<uint64_t> param;
+    std::vector<float> shiftValue;
+    std::vector<float> deqScale;
+};
+
+const char* TypeName(int type)
+{
+    return type == FLOAT_TYPE_ID ? "fp32" : (type == FLOAT16_TYPE_ID ? "fp16" : "int8");
+}
+
+size_t TypeSize(int type)
+{
+    return type == FLOAT_TYPE_ID ? sizeof(float) : (type == FLOAT16_TYPE_ID ? sizeof(uint16_t) : sizeof(int8_t));
+}
+
+std::vector<int64_t> ParseList(const char* text)
+{
+    std::vector<int64_t> values;
+    std::string item;
+    for (const char* p = text;; ++p) {
+        if (*p == ',' || *p == '\0') {
+            if (!item.empty()) {
+                int64_t scale = 1;
+                char suffix = item.back();
+                if (suffix == 'K' || suffix == 'k' || suffix == 'M' || suffix == 'm') {
+                    scale = (suffix == 'K' || suffix == 'k') ? 1024 : 1024 * 1024;
+                    item.pop_back();
+                }
+                values.push_back(atoll(item.c_str()) * scale);
+            }
+            item.clear();
+            if (*p == '\0') {
+                break;
+            }
+        } else {
+            item.push_back(*p);
+        }
+    }
+    return values;
+}
+
+// median run time in microseconds, repeated for at least MIN_SECONDS after one warm up run
+double MeasureUs(const std::function<void()>& fn)
+{
+    fn();
+    std::vector<double> runs;
+    auto begin = std::chrono::steady_clock::now();
+    while (true) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        runs.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        if (static_cast<int>(runs.size()) >= MIN_REPEATS &&
+            std::chrono::duration<double>(end - begin).count() >= MIN_SECONDS) {
+            break;
+        }
+    }
+    std::nth_element(runs.begin(), runs.begin() + runs.size() / 2, runs.end());
+    return runs[runs.size() / 2];
+}
+
+std::vector<BenchCase> GetCases()
+{
+    std::vector<BenchCase> cases;
+    const int floatTypes[] = {FLOAT_TYPE_ID, FLOAT16_TYPE_ID};
+    const int64_t modes[] = {0, util::FORCE_FP16_QUANT};
+    for (int inType : floatTypes) {
+        for (int64_t mode : modes) {
+            for (int outType : {FLOAT_TYPE_ID, FLOAT16_TYPE_ID, INT8_TYPE_ID}) {
+                cases.push_back({"fake_quant", inType, outType, mode, false});
+            }
+            for (int outType : floatTypes) {
+                cases.push_back({"fake_dequant", inType, outType, mode, false});
+                cases.push_back({"fake_dequant", inType, outType, mode, true});
+            }
+        }
+        for (int outType : floatTypes) {
+            cases.push_back({"fake_antiquant", inType, outType, 0, false});
+        }
+    }
+    cases.push_back({"parse_param", FLOAT_TYPE_ID, FLOAT_TYPE_ID, 0, true});
+    cases.push_back({"cast_to_fp32", FLOAT16_TYPE_ID, FLOAT_TYPE_ID, 0, false});
+    cases.push_back({"cast_to_fp16", FLOAT_TYPE_ID, FLOAT16_TYPE_ID, 0, false});
+    return cases;
+}
+
+void FillBuffers(int64_t size, BenchBuffers& buffers)
+{
+    std::mt19937 engine(static_cast<unsigned int>(size));
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    buffers.in32.resize(size);
+    for (auto& value : buffers.in32) {
+        value = normal(engine);
+    }
+    buffers.in16.resize(size);
+    util::DataCastToFloat16Functor<util::CPUDevice, float>()(buffers.in32.data(), buffers.in16.data(),
+        static_cast<int>(size));
+    // the int8 output only needs a quarter, every output type fits in the float buffer
+    buffers.out32.resize(size);
+    // deq scale in the low word, shift bits in byte 4, see ParseParamData
+    const uint64_t shiftBits = 2;
+    float deqScale = 0.01f;
+    uint32_t deqScaleBits = 0;
+    memcpy(&deqScaleBits, &deqScale, sizeof(deqScaleBits));
+    buffers.param.assign(std::max<int64_t>(size, CHANNEL_NUM), (shiftBits << 32) | deqScaleBits);
+    buffers.shiftValue.resize(buffers.param.size());
+    buffers.deqScale.resize(buffers.param.size());
+}
+
+// bytes read and written by one run, the roofline compares them with memcpy of the same traffic
+int RunCase(const BenchCase& benchCase, int64_t size, BenchBuffers& buffers, size_t& bytes)
+{
+    const void* in = benchCase.inType == FLOAT_TYPE_ID ? static_cast<const void*>(buffers.in32.data()) :
+        static_cast<const void*>(buffers.in16.data());
+    InputDataParam param = {in, buffers.out32.data(), benchCase.inType, benchCase.outType,
+        static_cast<size_t>(size), benchCase.precisionMode};
+    bytes = static_cast<size_t>(size) * (TypeSize(benchCase.inType) + TypeSize(benchCase.outType));
+    // one batch of CHANNEL_NUM channels
+    DequantParam dequantParam = {size, std::max<int64_t>(size / CHANNEL_NUM, 1), CLIP_32, 0, 0,
+        benchCase.channelWise ? CHANNEL_NUM : 1, buffers.param.data(), buffers.shiftValue.data(),
+        buffers.deqScale.data(), nullptr, nullptr, benchCase.channelWise};
+    if (benchCase.kernel == "fake_quant") {
+        return FakeQuant(param, QUANT_BITS, 0.05f, 0);
+    }
+    if (benchCase.kernel == "fake_dequant") {
+        int ret = ParseParamData(dequantParam);
+        return ret != AmctCommon::SUCCESS ? ret : FakeDequant(param, dequantParam);
+    }
+    if (benchCase.kernel == "fake_antiquant") {
+        return FakeAntiQuant(param, 0.05f);
+    }
+    if (benchCase.kernel == "parse_param") {
+        dequantParam.paramSize = size;
+        bytes = static_cast<size_t>(size) * (sizeof(uint64_t) + sizeof(float) * 2);
+        return ParseParamData(dequantParam);
+    }
+    if (benchCase.kernel == "cast_to_fp32") {
+        util::DataCastToFloat32Functor<util::CPUDevice, uint16_t>()(buffers.in16.data(), buffers.out32.data(),
+            static_cast<int>(size));
+        return AmctCommon::SUCCESS;
+    }
+    util::DataCastToFloat16Functor<util::CPUDevice, float>()(buffers.in32.data(),
+        reinterpret_cast<uint16_t*>(buffers.out32.data()), static_cast<int>(size));
+    return AmctCommon::SUCCESS;
+}
+
+double MeasureMemcpy(size_t bytes)
+{
+    // half of the traffic is read, half written
+    size_t copyBytes = std::max<size_t>(bytes / 2, 1);
+    std::vector<char> src(copyBytes, 1);
+    std::vector<char> dst(copyBytes);
+    double us = MeasureUs([&]() { memcpy(dst.data(), src.data(), copyBytes); });
+    return static_cast<double>(copyBytes * 2) / us / 1e3;
+}
+
+int RunThreadCount(const BenchOptions& options, int threadNum)
+{
+    FILE* output = fopen(options.output, "a");
+    if (output == nullptr) {
+        printf("Fail to open %s.\n", options.output);
+        return 1;
+    }
+    printf("threads %d (AMCT_NUM_THREADS), pool %d\n", threadNum, AmctCommon::GetParallelConfig().numThreads);
+    printf("%-15s %-5s %-5s %-10s %-8s %10s %12s %10s %10s %8s\n", "kernel", "in", "out", "mode", "layout",
+        "elements", "median_us", "GB/s", "Gelem/s", "roofline");
+    BenchBuffers buffers;
+    std::vector<BenchCase> cases = GetCases();
+    for (int64_t size : options.sizes) {
+        FillBuffers(size, buffers);
+        std::map<size_t, double> memcpyGbps;
+        for (const auto& benchCase : cases) {
+            if (!options.kernel.empty() && benchCase.kernel.find(options.kernel) == std::string::npos) {
+                continue;
+            }
+            size_t bytes = 0;
+            int ret = AmctCommon::SUCCESS;
+            double us = MeasureUs([&]() { ret = RunCase(benchCase, size, buffers, bytes); });
+            if (ret != AmctCommon::SUCCESS) {
+                printf("%s failed with %d.\n", benchCase.kernel.c_str(), ret);
+                continue;
+            }
+            if (memcpyGbps.count(bytes) == 0) {
+                memcpyGbps[bytes] = MeasureMemcpy(bytes);
+            }
+            double roofline = memcpyGbps[bytes];
+            double gbps = static_cast<double>(bytes) / us / 1e3;
+            double gelems = static_cast<double>(size) / us / 1e3;
+            const char* mode = benchCase.precisionMode == util::FORCE_FP16_QUANT ? "force_fp16" : "default";
+            const char* layout = benchCase.channelWise ? "channel" : "tensor";
+            printf("%-15s %-5s %-5s %-10s %-8s %10lld %12.2f %10.2f %10.3f %7.1f%%\n", benchCase.kernel.c_str(),
+                TypeName(benchCase.inType), TypeName(benchCase.outType), mode, layout, static_cast<long long>(size),
+                us, gbps, gelems, 100.0 * gbps / roofline);
+            fprintf(output, "%d,%s,%s,%s,%s,%s,%lld,%zu,%.3f,%.4f,%.5f,%.4f\n", threadNum, benchCase.kernel.c_str(),
+                TypeName(benchCase.inType), TypeName(benchCase.outType), mode, layout, static_cast<long long>(size),
+                bytes, us, gbps, gelems, roofline);
+        }
+    }
+    fclose(output);
+    return 0;
+}
+
+void PrintUsage(const char* name)
+{
+    printf("Usage: %s [-s sizes] [-t threads] [-k kernel] [-o output csv]\n", name);
+    printf("  -s  comma separated element counts, K and M suffixes allowed, default 1K,16K,256K,4M,16M,64M\n");
+    printf("  -t  comma separated thread counts, default 1 and all cores\n");
+    printf("  -k  only kernels whose name contains this, e.g. quant, dequant, cast\n");
+}
+}
+
+int main(int argc, char* argv[])
+{
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            options.sizes = ParseList(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            for (int64_t threadNum : ParseList(argv[++i])) {
+                options.threads.push_back(static_cast<int>(std::max<int64_t>(threadNum, 1)));
+            }
+        } else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            options.kernel = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            options.output = argv[++i];
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.threads.empty()) {
+        int cores = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+        options.threads = cores > 1 ? std::vector<int>{1, cores} : std::vector<int>{1};
+    }
+    FILE* output = fopen(options.output, "w");
+    if (output == nullptr) {
+        printf("Fail to open %s.\n", options.output);
+        return 1;
+    }
+    fprintf(output, "threads,kernel,in_type,out_type,precision_mode,layout,elements,bytes,median_us,gbytes_per_s,"
+        "gelements_per_s,memcpy_gbytes_per_s\n");
+    fclose(output);
+    for (int threadNum : options.threads) {
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid < 0) {
+            printf("Fail to fork for %d threads.\n", threadNum);
+            return 1;
+        }
+        if (pid == 0) {
+            setenv(AmctCommon::NUM_THREADS_ENV, std::to_string(threadNum).c_str(), 1);
+            exit(RunThreadCount(options, threadNum));
+        }
+        int status = 0;
+        if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            printf("Benchmark with %d threads failed.\n", threadNum);
+            return 1;
+        }
+    }
+    printf("Results written to %s.\n", options.output);
+    return 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2024-2024. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @brief merge the partial calibration states written by sharded calibration processes
+ * (AMCT_PARTIAL_STATE_DIR) and write the final result of the op to a record file.
+ * Built against the installed amct custom op library by "make merge_calibration_state" in this directory.
+ *
+ * @file merge_calibration_state.cpp
+ *
+ * @version 1.0
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "calibration_state.h"
+
+namespace {
+void PrintUsage(const char* name)
+{
+    printf("Usage: %s -r <record file> [-o <merged state file>] <state file> [<state file> ...]\n", name);
+    printf("  State files of one op are merged in the given order and finalized once.\n");
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const char* recordFileName = nullptr;
+    const char* mergedStateFile = nullptr;
+    std::vector<const char*> stateFiles;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            recordFileName = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            mergedStateFile = argv[++i];
+        } else if (argv[i][0] == '-') {
+            PrintUsage(argv[0]);
+            return 1;
+        } else {
+            stateFiles.push_back(argv[i]);
+        }
+    }
+    if (recordFileName == nullptr || stateFiles.empty()) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    int ret = AmctMergeCalibrationStates(stateFiles.data(), static_cast<int>(stateFiles.size()), recordFileName,
+        mergedStateFile);
+    if (ret != AmctCommon::SUCCESS) {
+        printf("Merge %zu calibration states failed, error code: %d.\n", stateFiles.size(), ret);
+        return 1;
+    }
+    printf("Merged %zu calibration states into %s.\n", stateFiles.size(), recordFileName);
+    return 0;
+}